@@ -19,6 +19,58 @@
 
 #import <Foundation/Foundation.h>
 
+//Plain struct form of an event.  Copied between threads without retains or allocations, see RFBEventRing
+typedef enum {
+	RFBEventRecordNone,
+	RFBEventRecordPointer,
+	RFBEventRecordKey,
+	RFBEventRecordText,
+	RFBEventRecordKeyMacro
+} RFBEventRecordType;
+
+typedef struct {
+	NSTimeInterval dt;
+	float dx;
+	float dy;
+	float sx;
+	float sy;
+	CGPoint v;
+	BOOL button1;
+	BOOL button2;
+	int8_t scrollSensitivity;
+	int8_t buttonIterations;
+} RFBPointerRecord;
+
+typedef struct {
+	unichar keyPress;
+} RFBKeyRecord;
+
+typedef struct {
+	CFStringRef text; //Retained by the record, see RFBEventRecordRelease
+} RFBTextRecord;
+
+typedef struct {
+	CFDataRef messages; //Precompiled KeyMsgs, see RFBKeyMacro.  Retained by the record
+} RFBKeyMacroRecord;
+
+typedef struct {
+	RFBEventRecordType type;
+	uint64_t capturedAt; //mach_absolute_time, for latency stats.  0 = not stamped
+	uint64_t enqueuedAt;
+	union {
+		RFBPointerRecord pointer;
+		RFBKeyRecord key;
+		RFBTextRecord text;
+		RFBKeyMacroRecord keyMacro;
+	};
+} RFBEventRecord;
+
+//Release anything the record holds on to, once it's been sent or dropped
+void RFBEventRecordRelease(RFBEventRecord *record);
+
 @interface RFBEvent : NSObject
+@property (assign, nonatomic, readonly) uint64_t capturedAt; //mach_absolute_time the event was created, ie. when the gesture was handled
 - (id)init;
+//Subclasses override.  NO, with type RFBEventRecordNone, if the event has no record form
+-(BOOL)getRecord:(RFBEventRecord *)record;
 @end
@@ -21,6 +21,8 @@
 
 #import "RFBEvent.h"
 
+#import <mach/mach_time.h>
+
 @implementation RFBEvent
 //Override init to stop class being instantiated as it's supposed to be an abstract class
 -(id)init {
@@ -33,9 +35,26 @@
         self = [super init];
     
 	if (self) {
-		//init code here
+		_capturedAt = mach_absolute_time();
 	}
 	
 	return self;
 }
+
+-(BOOL)getRecord:(RFBEventRecord *)record {
+	record->type = RFBEventRecordNone;
+	record->capturedAt = self.capturedAt;
+	record->enqueuedAt = 0;
+	return NO;
+}
 @end
+
+void RFBEventRecordRelease(RFBEventRecord *record) {
+	if (record->type == RFBEventRecordText && record->text.text) {
+		CFRelease(record->text.text);
+		record->text.text = NULL;
+	} else if (record->type == RFBEventRecordKeyMacro && record->keyMacro.messages) {
+		CFRelease(record->keyMacro.messages);
+		record->keyMacro.messages = NULL;
+	}
+}
@@ -22,9 +22,14 @@
 
 @class RFBSocket, VersionMsg;
 
+//Called on the socket's delegate queue once the security handshake (including SecurityResult) is done
+typedef void (^RFBSecurityCompletion)(BOOL success, NSError *error);
+
 @interface RFBSecurity : NSObject
 + (uint8_t)type;
 + (NSString *)typeName;
+//Subclasses implement the asynchronous handshake.  Blocking version is a wrapper around it, don't call it from the socket's delegate queue.
+- (void)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Completion:(RFBSecurityCompletion)completion;
 - (BOOL)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Error:(NSError **)error;
 - (id)init; 
 @end
@@ -57,8 +57,25 @@
 	return nil;
 }
 
-- (BOOL)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Error:(NSError **)error {
+- (void)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Completion:(RFBSecurityCompletion)completion {
 	[[self class] abstractException];
-	return NO;
+}
+
+//Blocking wrapper for the asynchronous handshake
+- (BOOL)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Error:(NSError **)error {
+	dispatch_semaphore_t authDone = dispatch_semaphore_create(0);
+	__block BOOL authSuccess = NO;
+	__block NSError *authError = nil;
+	[self performAuthWithSocket:socket ForVersion:serverVersion Completion:^(BOOL success, NSError *blockError) {
+		authSuccess = success;
+		authError = blockError;
+		dispatch_semaphore_signal(authDone);
+	}];
+	dispatch_semaphore_wait(authDone, DISPATCH_TIME_FOREVER); //Socket read timeouts/disconnects guarantee a completion
+	dispatch_release(authDone);
+	
+	if (error && authError)
+		*error = authError;
+	return authSuccess;
 }
 @end
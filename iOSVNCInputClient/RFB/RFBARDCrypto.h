@@ -0,0 +1,37 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  ARD (Mac Authentication) credential encryption in one pass, from the server's DH parameters to the reply bytes:
+//  DH key agreement, MD5 of the shared secret, then AES128 of username[64]:password[64], written along with the public
+//  key straight into the caller's buffer, eg. an RFBSocket send buffer.  Intermediate values stay on the stack and are
+//  cleared afterwards.  The cipher and digest contexts and the peer key BIGNUM are kept per thread and reused.
+
+#import <Foundation/Foundation.h>
+
+@interface RFBARDCrypto : NSObject
+//Ciphertext then public key, 128 + keyLength bytes
++(NSUInteger)authReplyLengthForKeyLength:(NSUInteger)keyLength;
+
+//Fill reply (authReplyLengthForKeyLength: of the prime's length) for the generator, prime and server public key as read
+//from the server.  Key pairs come from RFBDHKeyPool when it has one ready.  NO with error otherwise
++(BOOL)encodeAuthReply:(uint8_t *)reply
+			 Generator:(NSData *)generator
+				 Prime:(NSData *)prime
+			   PeerKey:(NSData *)peerKey
+			  Username:(NSString *)username
+			  Password:(NSString *)password
+				 Error:(NSError **)error;
+@end
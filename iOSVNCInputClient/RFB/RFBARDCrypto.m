@@ -0,0 +1,192 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBARDCrypto.h"
+
+#import <pthread.h>
+#import <Security/SecRandom.h>
+
+#import "HandleErrors.h"
+#import "RFBDHKeyPool.h"
+
+//openssl libcrypto
+#import <bn.h>
+#import <dh.h>
+#import <md5.h>
+#import <evp.h>
+#import <crypto.h> //OPENSSL_cleanse
+
+#define CREDENTIALS_LENGTH 128 //username[64]:password[64]
+#define MAX_KEY_LENGTH 512 //4096 bit prime, stack buffer for the shared secret
+
+//Reused by every login on the thread, see threadContexts()
+typedef struct {
+	EVP_CIPHER_CTX *cipher;
+	EVP_MD_CTX *digest;
+	BIGNUM *peerKey;
+} RFBARDThreadContexts;
+
+static pthread_key_t threadContextsKey;
+
+static void freeThreadContexts(void *value) {
+	RFBARDThreadContexts *contexts = value;
+	if (!contexts)
+		return;
+	if (contexts->cipher)
+		EVP_CIPHER_CTX_free(contexts->cipher);
+	if (contexts->digest)
+		EVP_MD_CTX_destroy(contexts->digest);
+	BN_clear_free(contexts->peerKey);
+	free(contexts);
+}
+
+static void createThreadContextsKey(void) {
+	pthread_key_create(&threadContextsKey, freeThreadContexts);
+}
+
+//This thread's contexts, created on first use and freed when the thread exits.  NULL if they couldn't be created
+static RFBARDThreadContexts *threadContexts(void) {
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+	pthread_once(&once, createThreadContextsKey);
+	
+	RFBARDThreadContexts *contexts = pthread_getspecific(threadContextsKey);
+	if (contexts)
+		return contexts;
+	
+	contexts = calloc(1, sizeof(RFBARDThreadContexts));
+	if (!contexts)
+		return NULL;
+	contexts->cipher = EVP_CIPHER_CTX_new();
+	contexts->digest = EVP_MD_CTX_create();
+	contexts->peerKey = BN_new();
+	if (!contexts->cipher || !contexts->digest || !contexts->peerKey || pthread_setspecific(threadContextsKey, contexts) != 0) {
+		freeThreadContexts(contexts);
+		return NULL;
+	}
+	return contexts;
+}
+
+@implementation RFBARDCrypto
+#pragma mark - Auth Reply - Public
++(NSUInteger)authReplyLengthForKeyLength:(NSUInteger)keyLength {
+	return CREDENTIALS_LENGTH + keyLength;
+}
+
++(BOOL)encodeAuthReply:(uint8_t *)reply
+			 Generator:(NSData *)generator
+				 Prime:(NSData *)prime
+			   PeerKey:(NSData *)peerKey
+			  Username:(NSString *)username
+			  Password:(NSString *)password
+				 Error:(NSError **)error {
+	//Error handling block
+	HandleError he = [HandleErrors handleErrorBlock];
+	
+	int keyLength = (int)prime.length;
+	if (!reply || generator.length == 0 || keyLength == 0 || keyLength > MAX_KEY_LENGTH || peerKey.length != keyLength) {
+		DLogErr(@"generator: %@, keyLength: %i, peerKey length: %lu", generator, keyLength, (unsigned long)peerKey.length);
+		he(error,SecurityErrorDomain,SecurityEncryptError,NSLocalizedString(@"Invalid Diffie-Hellman parameters from server", @"RFBARDCrypto DH parameter error text"));
+		return NO;
+	}
+	RFBARDThreadContexts *contexts = threadContexts();
+	if (!contexts) {
+		he(error,SecurityErrorDomain,SecurityEncryptError,NSLocalizedString(@"Could not create openssl contexts", @"RFBARDCrypto context creation error text"));
+		return NO;
+	}
+	
+	// 2. Diffie-Hellman key agreement, with a key pair generated ahead of time if there is one
+	DH *dh = [[RFBDHKeyPool sharedPool] takeKeyForPrime:prime Generator:generator];
+	if (!dh)
+		dh = [RFBDHKeyPool generateKeyForPrime:prime Generator:generator];
+	if (!dh || DH_size(dh) != keyLength) {
+		he(error,SecurityErrorDomain,SecurityEncryptError,NSLocalizedString(@"Could not generate keys using supplied prime", @"RFBARDCrypto DH key generate error text"));
+		DH_free(dh);
+		return NO;
+	}
+	
+	uint8_t secret[MAX_KEY_LENGTH];
+	int secretLength = -1;
+	if (BN_bin2bn([peerKey bytes], keyLength, contexts->peerKey))
+		secretLength = DH_compute_key(secret, contexts->peerKey, dh);
+	//Public key goes after the ciphertext.  Pool and generated keys are always full length
+	BOOL agreed = (secretLength > 0 && secretLength <= keyLength &&
+				   BN_num_bytes(dh->pub_key) == keyLength &&
+				   BN_bn2bin(dh->pub_key, reply + CREDENTIALS_LENGTH) == keyLength);
+	DH_free(dh);
+	if (!agreed) {
+		OPENSSL_cleanse(secret, sizeof(secret));
+		he(error,SecurityErrorDomain,SecurityEncryptError,NSLocalizedString(@"Failed to compute shared secret",@"RFBSecurityARD DH key agreement error text"));
+		return NO;
+	}
+	//DH_compute_key drops leading zero bytes, the secret is hashed at the full key length
+	if (secretLength < keyLength) {
+		memmove(secret + (keyLength - secretLength), secret, secretLength);
+		memset(secret, 0, keyLength - secretLength);
+	}
+	
+	// 3. AES key = MD5 of the shared secret
+	uint8_t key[MD5_DIGEST_LENGTH];
+	unsigned int digestLength = 0;
+	BOOL hashed = (EVP_DigestInit_ex(contexts->digest, EVP_md5(), NULL) &&
+				   EVP_DigestUpdate(contexts->digest, secret, keyLength) &&
+				   EVP_DigestFinal_ex(contexts->digest, key, &digestLength) &&
+				   digestLength == MD5_DIGEST_LENGTH);
+	OPENSSL_cleanse(secret, sizeof(secret));
+	
+	// 4. ciphertext = AES128(key, username[64]:password[64]), straight into reply.  Unused bytes are random
+	uint8_t credentials[CREDENTIALS_LENGTH];
+	if (SecRandomCopyBytes(kSecRandomDefault, CREDENTIALS_LENGTH, credentials) != 0) {
+		DLogErr(@"RFBARDCrypto - Failed to generate random bytes into credentials");
+		he(error,SecurityErrorDomain,SecurityEncryptError,NSLocalizedString(@"Failed to generate random numbers needed as part of ARD auth", @"RFBSecurityARD PRNG function error text"));
+		OPENSSL_cleanse(key, sizeof(key));
+		return NO;
+	}
+	[self fillCredentials:credentials Half:0 WithString:username];
+	[self fillCredentials:credentials Half:1 WithString:password];
+	
+	int cipherLength = 0, finalLength = 0;
+	BOOL encrypted = (hashed &&
+					  EVP_EncryptInit_ex(contexts->cipher, EVP_aes_128_ecb(), NULL, key, NULL) &&
+					  EVP_CIPHER_CTX_set_padding(contexts->cipher, 0) &&
+					  EVP_EncryptUpdate(contexts->cipher, reply, &cipherLength, credentials, CREDENTIALS_LENGTH) &&
+					  EVP_EncryptFinal_ex(contexts->cipher, reply + cipherLength, &finalLength) &&
+					  cipherLength + finalLength == CREDENTIALS_LENGTH);
+	EVP_CIPHER_CTX_cleanup(contexts->cipher); //Wipes the expanded key, the context is reused for the next login
+	OPENSSL_cleanse(credentials, sizeof(credentials));
+	OPENSSL_cleanse(key, sizeof(key));
+	if (!encrypted) {
+		DLogErr(@"Failed to encrypt username and password... abort sending to server");
+		he(error,SecurityErrorDomain,SecurityEncryptError,NSLocalizedString(@"Failed to encrypt user credentials for authentication", @"RFBSecurityARD ciphertext encryption error text"));
+		return NO;
+	}
+	return YES;
+}
+
+#pragma mark - Auth Reply - Private
+//UTF8 string into one 64 byte half of credentials, capped at 63 bytes and null terminated
++(void)fillCredentials:(uint8_t *)credentials Half:(NSUInteger)half WithString:(NSString *)string {
+	uint8_t *start = credentials + half * (CREDENTIALS_LENGTH / 2);
+	NSUInteger length = 0;
+	[string getBytes:start
+		   maxLength:(CREDENTIALS_LENGTH / 2) - 1
+		  usedLength:&length
+			encoding:NSUTF8StringEncoding
+			 options:0
+			   range:NSMakeRange(0, string.length)
+	  remainingRange:NULL];
+	start[length] = '\0';
+}
+@end
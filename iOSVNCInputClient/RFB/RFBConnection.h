@@ -15,11 +15,56 @@
 
 #import <Foundation/Foundation.h>
 
-@class RFBSecurity, VersionMsg, RFBEvent;
+#import "RFBEvent.h"
+
+@class RFBSecurity, VersionMsg, RFBInputLatency, RFBEventLog, RFBEventLoop, RFBHandshakeCache;
+
+//Handshake progress, each state waits on the server for the named message
+typedef enum {
+	HandshakeIdle,
+	HandshakeVersion,       //ProtocolVersion
+	HandshakeSecurityList,  //Supported security types
+	HandshakeFailureReason, //Reason string sent instead of the security list
+	HandshakeAuthenticating,//Security type specific handshake up to SecurityResult
+	HandshakeServerInit,    //ServerInit and server name
+	HandshakeComplete,
+	HandshakeFailed,
+	HandshakeCancelled
+} RFBHandshakeState;
+
+//Called exactly once per handshake, on the socket's delegate queue (or the calling thread for immediate failures)
+typedef void (^RFBConnectCompletion)(BOOL success, NSError *error);
 
 @interface RFBConnection : NSObject
 #pragma mark - Properties - Public
 @property (nonatomic, assign) BOOL ard35Compatibility;
+//Pointer motion is gathered for up to this long (seconds) and sent as one write, 0 = send every event on its own
+@property (nonatomic, assign) NSTimeInterval writeCoalescingWindow;
+//Called (on a background queue) whenever everything sent so far has been written out
+@property (nonatomic, copy) dispatch_block_t sendCompletedHandler;
+//Flow control, bytes sent but not yet taken by the network stack before sending is degraded (see isSendDegraded).  0 = off
+@property (nonatomic, assign) NSUInteger writeHighWaterMark;
+//Called (on a background queue) whenever sending becomes, or stops being, degraded
+@property (nonatomic, copy) void (^sendDegradedHandler)(BOOL degraded);
+//Typed text goes out in one write by default (0).  Otherwise typingChunkLength characters every typingChunkInterval seconds,
+//for servers that drop keys sent too fast
+@property (nonatomic, assign) NSUInteger typingChunkLength;
+@property (nonatomic, assign) NSTimeInterval typingChunkInterval;
+//Text at least pasteThreshold characters long is put on the server's clipboard (ClientCutText) instead of typed, followed by
+//pasteChord (keysym NSNumbers pressed in order, eg. Control_L, v) if set.  0 = always type (default).  Text with characters
+//outside Latin-1 is always typed, ClientCutText can't carry them
+@property (nonatomic, assign) NSUInteger pasteThreshold;
+@property (nonatomic, strong) NSArray *pasteChord;
+//Every event sent is also appended to eventLog if set, see RFBEventLogReplayer.  Atomic, set from any thread
+@property (atomic, strong) RFBEventLog *eventLog;
+//Socket I/O and the handshake run on one of eventLoop's workers, shared with other connections, when set before
+//connecting.  nil = queues of its own (default)
+@property (nonatomic, strong) RFBEventLoop *eventLoop;
+//Last handshake with this server, eg. kept with its profile.  When fresh and it has the security type, the client's version
+//and security type are sent as soon as the socket connects instead of after the server's version and security list, a round
+//trip less.  The server's answers are still checked as they arrive, if they've changed the handshake starts over on a new
+//socket without it.  Replaced with the server's answers once a handshake or probe succeeds
+@property (atomic, strong) RFBHandshakeCache *handshakeCache;
 
 #pragma mark - Getters
 -(NSString *)serverName;
@@ -27,6 +72,11 @@
 -(NSData *)securityTypes;
 -(NSArray *)securityTypesList;
 -(CGSize)serverDisplaySize;
+//Cost of the last successful connect (seconds): wall clock time, and CPU time spent in the handshake's read completions on
+//the socket's delegate queue.  Not counted: the calling thread, and work done ahead elsewhere, eg. pooled DH key pairs
+-(NSTimeInterval)handshakeDuration;
+-(NSTimeInterval)handshakeCPUTime;
+-(BOOL)usedHandshakeCache; //Last successful connect was sent ahead from handshakeCache
 
 #pragma mark - Static defined values - Public
 + (int)DEFAULT_PORT;
@@ -41,13 +91,40 @@
 
 #pragma mark - Connectivity - Public
 -(BOOL)isConnected;
+//Socket I/O and the handshake run on this serial queue, nil before connecting.  With an eventLoop, events must be sent
+//from it (or a thread off the loop): a send from another loop queue waits on this one and can deadlock the workers
+-(dispatch_queue_t)socketQueue;
+-(RFBHandshakeState)handshakeState;
+//Asynchronous handshakes, no thread is held while waiting on the server
+-(void)probeSecurityWithCompletion:(RFBConnectCompletion)completion;
+-(void)connectWithCompletion:(RFBConnectCompletion)completion;
+-(void)cancelConnect;
+//Blocking wrappers of the above
 -(BOOL)probeSecurity:(NSError **)error;
 -(BOOL)connect:(NSError **)error;
--(void)disconnect;
+-(void)disconnect; //Also cancels a handshake in progress
 
 #pragma mark - RFB Event handling - Public
 -(BOOL)sendEvent:(RFBEvent *)event Error:(NSError **)error;
+//Events for one connection must be sent from one thread at a time, pointer position and scroll state aren't guarded
+-(BOOL)sendEventRecord:(const RFBEventRecord *)record Error:(NSError **)error;
+//Senders with a thread or queue of their own (RFBEventSender, RFBEventLogReplayer) claim the connection first, so
+//only one of them sends at a time.  NO if another sender holds it.  Claiming again as the holder succeeds
+-(BOOL)claimSendingFor:(id)sender;
+-(void)releaseSendingFor:(id)sender;
+-(BOOL)isSendBacklogged; //Earlier events not yet written out, eg. slow link
+-(BOOL)isSendDegraded; //Backlog above writeHighWaterMark, only clicks and keys should be sent as they come
 
 #pragma mark - Read Methods - Public
 -(void)discardIncomingData;
+//Server to client messages consumed (and ignored) since connecting
+-(unsigned long long)bytesDrained;
+-(unsigned long long)messagesDrained;
+
+#pragma mark - Write Coalescing Stats - Public
+-(unsigned long long)writesSavedByCoalescing;
+-(NSTimeInterval)averageCoalescingDelay; //seconds
+
+#pragma mark - Input Latency - Public
+-(RFBInputLatency *)inputLatency; //Gesture to socket write, by stage.  nil before the socket is set up
 @end
@@ -21,24 +21,26 @@
 #import "RFBSecurity.h"
 #import "VersionMsg.h"
 #import "RFBSocket.h"
+#import "RFBHandshakeCache.h"
 
 #import "RFBSecurityARD.h"
 #import "RFBSecurityNone.h"
 #import "RFBSecurityVNC.h"
 
 #import "RFBEvent.h"
-#import "RFBKeyEvent.h"
-#import "RFBPointerEvent.h"
+#import "RFBEventLog.h"
 
 #import "keysymdef.h"
 
 #define DEFAULT__PORT 5900
+#define DEFAULT_COALESCING_WINDOW 0.006 //seconds, a few ms gathers a fast pan into far fewer packets without being felt
+#define DEFAULT_WRITE_HIGH_WATER_MARK 4096 //bytes, ~680 pointer events the network stack hasn't taken yet
 
 @interface RFBConnection()
 @property (nonatomic, copy) NSString *address;
 @property (nonatomic, assign) int port;
 @property (nonatomic, strong) RFBSecurity *security;
-@property (nonatomic, strong) RFBSocket *rfbSocket;
+@property (atomic, strong) RFBSocket *rfbSocket; //Atomic, read from the event sender thread and main
 @property (nonatomic, strong) VersionMsg *serverVersion;
 @property (nonatomic, strong) NSData *securityTypes;
 @property (nonatomic, copy) NSString *serverName;
@@ -47,6 +49,17 @@
 @property (nonatomic, assign) float pointerX;
 @property (nonatomic, assign) float pointerY;
 @property (nonatomic, assign) float yDist;
+@property (nonatomic, assign) NSTimeInterval handshakeCPUTime;
+@property (nonatomic, assign) NSTimeInterval handshakeDuration;
+@property (nonatomic, assign) BOOL usedHandshakeCache;
+
+//Handshake state machine
+@property (nonatomic, assign) RFBHandshakeState handshakeState;
+@property (nonatomic, copy) RFBConnectCompletion handshakeCompletion; //Set while a handshake is in progress
+@property (nonatomic, assign) BOOL probeOnly; //Stop after reading the security list
+@property (nonatomic, strong) NSDate *handshakeStart;
+@property (nonatomic, assign) BOOL sentAhead; //Client version and security type written from handshakeCache
+@property (nonatomic, weak) id sendingClaimant; //Guarded by @synchronized(self)
 @end
 
 @implementation RFBConnection
@@ -61,6 +74,8 @@
 		_address = address;
 		_port = port;
 		_security = security;
+		_writeCoalescingWindow = DEFAULT_COALESCING_WINDOW;
+		_writeHighWaterMark = DEFAULT_WRITE_HIGH_WATER_MARK;
 	}
 	return self;
 }
@@ -144,139 +159,272 @@
 	return NO;
 }
 
--(BOOL)probeSecurity:(NSError **)error {
-	//Connect and establish protocol version
-	BOOL success = [self establishSocketAndRFBProtocol:error];
-	
-	if (!success) //Abort security probe
-		return NO;
-	
-	//Get the list of supported security types from the server
-	self.securityTypes = [self.rfbSocket readSecurity];
-	if (self.securityTypes.length == 0) {
-        HandleError he = [HandleErrors handleErrorBlock];
-        NSString *header = NSLocalizedString(@"Failed security read, error from server: ", @"RFBConn Security Probe Failed Header Error Text");
-        he(error,SocketErrorDomain,SocketReadError,[header stringByAppendingString:[self.rfbSocket readString]]);
-		return NO;
+-(dispatch_queue_t)socketQueue {
+	return [self.rfbSocket delegateQueue];
+}
+
+-(RFBHandshakeState)handshakeState {
+	@synchronized(self) {
+		return _handshakeState;
 	}
-	
-	//Disconnect
-	[self disconnect];
-	
-	return YES;
 }
 
-//FIXME: Could be refined... duplicates code from probeSecurity
+//Blocking wrappers around the asynchronous handshake.  Don't call from the socket's delegate queue.
+-(BOOL)probeSecurity:(NSError **)error {
+	return [self waitForHandshakeProbeOnly:YES Error:error];
+}
+
 -(BOOL)connect:(NSError **)error {
-	//Connect and establish protocol version
-	BOOL success = [self establishSocketAndRFBProtocol:error];
-	
-	if (!success) //Abort security probe
-		return NO;
+	return [self waitForHandshakeProbeOnly:NO Error:error];
+}
+
+//Connect, establish protocol version and read the list of supported security types, then disconnect
+-(void)probeSecurityWithCompletion:(RFBConnectCompletion)completion {
+	[self startHandshakeProbeOnly:YES Completion:completion];
+}
+
+//Full handshake: version, security, auth, then initialization.  No thread is held while waiting on the server.
+-(void)connectWithCompletion:(RFBConnectCompletion)completion {
+	[self startHandshakeProbeOnly:NO Completion:completion];
+}
+
+//Abandon an in-flight handshake.  Its completion is called straight away with a SocketCancelError
+-(void)cancelConnect {
+	HandleError he = [HandleErrors handleErrorBlock];
+	NSError *error = nil;
+	he(&error, SocketErrorDomain, SocketCancelError, NSLocalizedString(@"Connection attempt cancelled", @"RFBConn handshake cancelled error text"));
+	[self finishHandshakeInState:HandshakeCancelled Error:error];
+}
+
+-(void)disconnect {
+	//DLogInf(@"BWRFBSocket released");
+	[self cancelConnect]; //No-op unless a handshake is in progress
+    if (self.rfbSocket)
+        DLogInf(@"Coalescing saved %llu writes, average delay %.2f ms", [self.rfbSocket writesSavedByCoalescing], [self.rfbSocket averageCoalescingDelay] * 1000);
+    [self.rfbSocket disconnect]; //Must call to kill any existing pending network requests
+	self.rfbSocket = nil;
+}
+
+#pragma mark - Connectivity - Private
+-(BOOL)waitForHandshakeProbeOnly:(BOOL)probeOnly Error:(NSError **)error {
+	dispatch_semaphore_t handshakeDone = dispatch_semaphore_create(0);
+	__block BOOL handshakeSuccess = NO;
+	__block NSError *handshakeError = nil;
+	[self startHandshakeProbeOnly:probeOnly Completion:^(BOOL success, NSError *blockError) {
+		handshakeSuccess = success;
+		handshakeError = blockError;
+		dispatch_semaphore_signal(handshakeDone);
+	}];
+	dispatch_semaphore_wait(handshakeDone, DISPATCH_TIME_FOREVER); //Socket timeouts, disconnects and cancels all complete the handshake
+	dispatch_release(handshakeDone);
 	
+	if (error && handshakeError)
+		*error = handshakeError;
+	return handshakeSuccess;
+}
+
+-(void)startHandshakeProbeOnly:(BOOL)probeOnly Completion:(RFBConnectCompletion)completion {
 	//Error handling block
 	HandleError he = [HandleErrors handleErrorBlock];
-    
-	// security
-	// read the list of supported security types from the server
-	self.securityTypes = [self.rfbSocket readSecurity];
-	if (!self.securityTypes) {
-        NSString *header = NSLocalizedString(@"error from server: ", @"RFBConn Connect Security Failed Header Error Text");
-        he(error,SocketErrorDomain,SocketReadError,[header stringByAppendingString:[self.rfbSocket readString]]);
-		return NO;
-	}
-	
-    //Parse security types, determine if "None" and selected security type (self.security) is available.
-	BOOL securityNoneIsAvailable = NO;
-	BOOL preferredSecurityIsAvailable = NO;
-	uint sLength = (uint)self.securityTypes.length;
-	const uint8_t *securityTypes = [self.securityTypes bytes];
-    for (uint i = 0; i < sLength; i++) {
-		uint8_t securityType = securityTypes[i];
-		if (securityType == [RFBSecurityNone type]) {
-			securityNoneIsAvailable = YES;
-		}
-		if ([[self.security class] type] == securityType) { //Note: self.security should have been set when this obj init'ed
-			preferredSecurityIsAvailable = YES;
-		}
-    }
+	NSError *error = nil;
 	
-    //Attempt to use "None" security if selected auth method not available
-	if (! preferredSecurityIsAvailable) {
-		if (securityNoneIsAvailable) {
-			//FIXME: Send back an error msg when desired security type is not present?
-			self.security = [[RFBSecurityNone alloc] init]; //Replace with "None" Security
+	@synchronized(self) {
+		if (self.handshakeCompletion) {
+			he(&error,SocketErrorDomain,SocketConnectError,NSLocalizedString(@"Connection attempt already in progress", @"RFBConn handshake in progress error text"));
 		} else {
-            NSString *header = NSLocalizedString(@"The server does not support security type: ", @"RFBConn Connect Preferred Security Failed Header Error Text");            
-            he(error,SocketErrorDomain,SocketSecurityError,[header stringByAppendingString:[[self.security class] typeName]]);
-			return NO;
+			self.handshakeCompletion = completion;
+			self.probeOnly = probeOnly;
+			_handshakeState = HandshakeIdle;
 		}
 	}
-	
-	//Inform server of desired auth method
-	[self.rfbSocket writeSecurity:[[self.security class] type]];
-	
-	//perform the security handshake using given socket connection and protocol version
-    NSError *handshakeErr = nil;
-	if (![self.security performAuthWithSocket:self.rfbSocket ForVersion:self.serverVersion Error:&handshakeErr]) {
-        DLogErr(@"Security handshake problem: %@", [handshakeErr localizedDescription]); 
-        NSString *header = NSLocalizedString(@"Authentication with server failed: ", @"RFBConn Handshake Failed Header Error Text");
-		he(error, SocketErrorDomain, SocketSecurityError, [header stringByAppendingString:[handshakeErr localizedDescription]]);
-		return NO;
+	if (error) { //Leave the handshake in progress alone
+		completion(NO, error);
+		return;
 	}
 	
-	//Success - start connection initialization
-	NSArray *serverDetails = [self.rfbSocket performInitialization];
-	if (!serverDetails || serverDetails.count == 0) { //init failed
-		he(error, SocketErrorDomain, SocketConnectError, @"Failed to complete initialization phase");
-		return NO;
+	self.handshakeStart = [NSDate date];
+	if (![self establishSocket:&error]) {
+		[self finishHandshakeInState:HandshakeFailed Error:error];
+		return;
 	}
-    
-    //Set Connection Details
-	self.serverName = [serverDetails objectAtIndex:0];
-	self.width = [[serverDetails objectAtIndex:1] intValue];
-	self.height = [[serverDetails objectAtIndex:2] intValue];
-	self.pointerX = (float)self.width/2; //Start pointer location at the "centre" of the supplied screen dimensions
-	self.pointerY = (float)self.height/2;
 	
-	DLogInf(@"Reported server width: %i height %i, starting pointer x: %f, pointer y: %f", self.width, self.height, self.pointerX, self.pointerY);
+	self.sentAhead = !probeOnly && [self sendAheadFromCache];
+	[self enterHandshakeState:HandshakeVersion];
+}
+
+//Write the client's version and security type, as if the server had answered as it did last time.  Servers only read
+//them once they've sent their own, so they're waiting when it does.  Only if the cache is fresh and has the security type
+-(BOOL)sendAheadFromCache {
+	RFBHandshakeCache *cache = self.handshakeCache;
+	if (![cache isFreshForAddress:self.address Port:self.port] || ![cache hasSecurityType:[[self.security class] type]])
+		return NO;
 	
+	//Version reply as handleServerVersion picks it
+	int version = cache.serverVersion.isAppleRemoteDesktop ? 0x0307 : MIN([cache.serverVersion intValue], MAX_VERSION);
+	DLog(@"Sending version %i and security type %i ahead from handshake cache", version, [[self.security class] type]);
+	[self.rfbSocket writeVersion:version];
+	[self.rfbSocket writeSecurity:[[self.security class] type]]; //Nothing for 3.3, the server picks
 	return YES;
 }
 
--(void)disconnect {
-	//DLogInf(@"BWRFBSocket released");
-    [self.rfbSocket disconnect]; //Must call to kill any existing pending network requests
-	self.rfbSocket = nil;
+//The server's answers differ from handshakeCache, so what was sent ahead may be wrong.  Drop the cache and start over on
+//a new socket.  Called on the old socket's delegate queue, so the new socket is connected from off it: on an event loop
+//the new socket's queue can share this one's worker, and connecting dispatch_syncs onto it
+-(void)restartHandshakeWithoutCache {
+	DLogWar(@"Server's answers changed since %@, handshaking again without the cache", self.handshakeCache.negotiatedAt);
+	self.handshakeCache = nil;
+	self.sentAhead = NO;
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		@synchronized(self) {
+			if (!self.handshakeCompletion)
+				return; //Cancelled in the meantime
+		}
+		NSError *error = nil;
+		if (![self establishSocket:&error]) {
+			[self finishHandshakeInState:HandshakeFailed Error:error];
+			return;
+		}
+		[self enterHandshakeState:HandshakeVersion];
+	});
 }
 
-#pragma mark - Connectivity - Private
-//Connect and establish protocol version to use
--(BOOL)establishSocketAndRFBProtocol:(NSError**)error {
+//What the server answered this time.  Probes don't get as far as the name and size, those are kept from the last time
+-(void)updateHandshakeCache {
+	RFBHandshakeCache *previous = self.handshakeCache;
+	RFBHandshakeCache *cache = [[RFBHandshakeCache alloc] initWithAddress:self.address
+																	 Port:self.port
+															ServerVersion:self.serverVersion
+															SecurityTypes:self.securityTypes];
+	if (!self.probeOnly) {
+		cache.serverName = self.serverName;
+		cache.serverDisplaySize = [self serverDisplaySize];
+	} else if (previous.port == self.port && [previous.address isEqualToString:self.address]) {
+		cache.serverName = previous.serverName;
+		cache.serverDisplaySize = previous.serverDisplaySize;
+	}
+	self.handshakeCache = cache;
+}
+
+//Create the socket and start connecting to supplied address/port.  Reads issued before the connection completes are queued.
+-(BOOL)establishSocket:(NSError**)error {
 	//Error handling block
 	HandleError he = [HandleErrors handleErrorBlock];
     
+    [self.rfbSocket disconnect]; //Any socket left over from an earlier probe
     if (self.address && self.address.length > 0) {
 		self.rfbSocket = [[RFBSocket alloc] initWithAddress:self.address
-                                                       Port:self.port];
+                                                       Port:self.port
+                                                  EventLoop:self.eventLoop];
+		self.rfbSocket.coalescingWindow = self.writeCoalescingWindow;
+		self.rfbSocket.writesCompletedHandler = self.sendCompletedHandler;
+		self.rfbSocket.writeHighWaterMark = self.writeHighWaterMark;
+		self.rfbSocket.writeDegradedHandler = self.sendDegradedHandler;
 	} else {
         he(error,SocketErrorDomain,SocketConnectError,NSLocalizedString(@"Could not instantiate BWRFBStream object", @"RFBConn invalid address error text"));
 		return NO; //Skip rest of method
 	}
 	
 	//Connect to supplied address/port
-	BOOL connecting = [self.rfbSocket connect:error];
-	if (!connecting) {
-		return NO;
-    }
+	return [self.rfbSocket connect:error];
+}
+
+#pragma mark - Handshake State Machine - Private
+//Each state issues the read it waits on; the read's completion handles the result and moves on to the next state.
+//Handlers run on the socket's delegate queue and ignore results for any state other than the current one, eg. after a cancel.
+-(void)enterHandshakeState:(RFBHandshakeState)state {
+	@synchronized(self) {
+		if (!self.handshakeCompletion)
+			return; //Cancelled or finished in the meantime
+		_handshakeState = state;
+	}
+	
+	__weak RFBConnection *blockSafeSelf = self;
+	RFBSocket *socket = self.rfbSocket;
+	switch (state) {
+		case HandshakeVersion:
+			[socket readVersionWithCompletion:^(VersionMsg *version) {
+				[blockSafeSelf handleServerVersion:version];
+			}];
+			break;
+		case HandshakeSecurityList:
+			[socket readSecurityWithCompletion:^(NSData *securityTypes) {
+				[blockSafeSelf handleSecurityTypes:securityTypes];
+			}];
+			break;
+		case HandshakeFailureReason:
+			[socket readStringWithCompletion:^(NSString *reason) {
+				[blockSafeSelf handleFailureReason:reason];
+			}];
+			break;
+		case HandshakeAuthenticating:
+			//Inform server of desired auth method (unless sent ahead), then perform the security handshake using given socket connection and protocol version
+			if (!self.sentAhead)
+				[socket writeSecurity:[[self.security class] type]];
+			[self.security performAuthWithSocket:socket ForVersion:self.serverVersion Completion:^(BOOL success, NSError *authError) {
+				[blockSafeSelf handleAuthSuccess:success Error:authError];
+			}];
+			break;
+		case HandshakeServerInit:
+			[socket performInitializationWithCompletion:^(NSArray *serverDetails) {
+				[blockSafeSelf handleServerDetails:serverDetails];
+			}];
+			break;
+		default:
+			break;
+	}
+}
+
+-(BOOL)isInHandshakeState:(RFBHandshakeState)state {
+	@synchronized(self) {
+		return (self.handshakeCompletion && _handshakeState == state);
+	}
+}
+
+//Complete the handshake exactly once.  Failed, cancelled and probe-only handshakes drop the socket.
+-(void)finishHandshakeInState:(RFBHandshakeState)state Error:(NSError *)error {
+	RFBConnectCompletion completion;
+	@synchronized(self) {
+		completion = self.handshakeCompletion;
+		if (!completion)
+			return; //Nothing in progress
+		self.handshakeCompletion = nil;
+		_handshakeState = state;
+	}
+	
+	if (state == HandshakeComplete) {
+		self.usedHandshakeCache = self.sentAhead;
+		[self updateHandshakeCache];
+		self.handshakeDuration = -[self.handshakeStart timeIntervalSinceNow];
+		self.handshakeCPUTime = [self.rfbSocket readCompletionCPUTime];
+		DLogInf(@"Handshake took %.1f ms, CPU time %.2f ms", self.handshakeDuration * 1000, self.handshakeCPUTime * 1000);
+	}
+	if (state != HandshakeComplete || self.probeOnly) {
+		[self.rfbSocket disconnect];
+		self.rfbSocket = nil;
+	}
+	
+	completion(state == HandshakeComplete, error);
+}
+
+//Get server protocol version and reply with desired RFB protocol version
+-(void)handleServerVersion:(VersionMsg *)serverVer {
+	if (![self isInHandshakeState:HandshakeVersion])
+		return;
+	
+	//Error handling block
+	HandleError he = [HandleErrors handleErrorBlock];
+	NSError *error = nil;
 	
-	//Get server protocol version and reply with desired RFB protocol version
-    VersionMsg *serverVer = [self.rfbSocket readVersion];
     if (serverVer == nil) { //No version returned
-        he(error,SocketErrorDomain,SocketConnectError,NSLocalizedString(@"Could not negotiate connection.  Screen Sharing disabled?", @"RFBConn Server NIL Protocol Version Error text"));
-        return NO;
+        he(&error,SocketErrorDomain,SocketConnectError,NSLocalizedString(@"Could not negotiate connection.  Screen Sharing disabled?", @"RFBConn Server NIL Protocol Version Error text"));
+        [self finishHandshakeInState:HandshakeFailed Error:error];
+        return;
     }
     self.serverVersion = serverVer;
+    if (self.sentAhead && ![self.handshakeCache matchesServerVersion:serverVer]) {
+        [self restartHandshakeWithoutCache];
+        return;
+    }
     
 	int version = [self.serverVersion intValue];
     DLog(@"server version: %i", version);    
@@ -286,37 +434,209 @@
 		version = 0x0307;
 	} else {
 		if (version == 0) { //Likely not connected at all
-            he(error,SocketErrorDomain,SocketConnectError,NSLocalizedString(@"VNC Server/Screen Sharing Not Enabled or Invalid Server Address", @"RFBConn Server Protocol Version Error text"));			
-			return NO;
+            he(&error,SocketErrorDomain,SocketConnectError,NSLocalizedString(@"VNC Server/Screen Sharing Not Enabled or Invalid Server Address", @"RFBConn Server Protocol Version Error text"));
+			[self finishHandshakeInState:HandshakeFailed Error:error];
+			return;
 		}
 		if (version < MIN_VERSION) {
             NSString *header = NSLocalizedString(@"Cannot connect with RFB version  ", @"RFBConn Unsupported Protocol Version Header Error Text");
-            he(error,SocketErrorDomain,SocketConnectError,[NSString stringWithFormat:@"%@ %@", header,[self.serverVersion stringValue]]);
-			return NO;
+            he(&error,SocketErrorDomain,SocketConnectError,[NSString stringWithFormat:@"%@ %@", header,[self.serverVersion stringValue]]);
+			[self finishHandshakeInState:HandshakeFailed Error:error];
+			return;
 		}
 		if (version > MAX_VERSION) //Only allow up to client supported max protocol version
 			version = MAX_VERSION;
         
         //Set socket TCP_NODELAY to stop jerky mouse movements.  Not set for ARD as it seems unaffected
         if (![self.rfbSocket setTCPNoDelay:YES])
-            he(error,SocketErrorDomain,SocketConnectError,NSLocalizedString(@"Failed to set TCP_NODELAY", @"RFBConn failed tcp_nodelay set error text"));
+            DLogWar(@"Failed to set TCP_NODELAY");
 	}
 
     DLog(@"reported version: %i", version);
-	[self.rfbSocket writeVersion:version];
+	if (!self.sentAhead)
+		[self.rfbSocket writeVersion:version];
 	
-	return YES;
+	[self enterHandshakeState:HandshakeSecurityList];
+}
+
+//Read the list of supported security types from the server, then pick the one to authenticate with
+-(void)handleSecurityTypes:(NSData *)securityTypes {
+	if (![self isInHandshakeState:HandshakeSecurityList])
+		return;
+	
+	if (securityTypes.length == 0) { //Server sends a reason string instead of the list
+		[self enterHandshakeState:HandshakeFailureReason];
+		return;
+	}
+	self.securityTypes = securityTypes;
+	if (self.sentAhead && ![self.handshakeCache matchesSecurityTypes:securityTypes]) {
+		[self restartHandshakeWithoutCache];
+		return;
+	}
+	
+	if (self.probeOnly) { //Probe ends with the security list
+		[self finishHandshakeInState:HandshakeComplete Error:nil];
+		return;
+	}
+	
+	//Error handling block
+	HandleError he = [HandleErrors handleErrorBlock];
+	NSError *error = nil;
+	
+    //Parse security types, determine if "None" and selected security type (self.security) is available.
+	BOOL securityNoneIsAvailable = NO;
+	BOOL preferredSecurityIsAvailable = NO;
+	uint sLength = (uint)self.securityTypes.length;
+	const uint8_t *types = [self.securityTypes bytes];
+    for (uint i = 0; i < sLength; i++) {
+		uint8_t securityType = types[i];
+		if (securityType == [RFBSecurityNone type]) {
+			securityNoneIsAvailable = YES;
+		}
+		if ([[self.security class] type] == securityType) { //Note: self.security should have been set when this obj init'ed
+			preferredSecurityIsAvailable = YES;
+		}
+    }
+	
+    //Attempt to use "None" security if selected auth method not available
+	if (! preferredSecurityIsAvailable) {
+		if (securityNoneIsAvailable) {
+			//FIXME: Send back an error msg when desired security type is not present?
+			self.security = [[RFBSecurityNone alloc] init]; //Replace with "None" Security
+		} else {
+            NSString *header = NSLocalizedString(@"The server does not support security type: ", @"RFBConn Connect Preferred Security Failed Header Error Text");            
+            he(&error,SocketErrorDomain,SocketSecurityError,[header stringByAppendingString:[[self.security class] typeName]]);
+			[self finishHandshakeInState:HandshakeFailed Error:error];
+			return;
+		}
+	}
+	
+	[self enterHandshakeState:HandshakeAuthenticating];
+}
+
+-(void)handleFailureReason:(NSString *)reason {
+	if (![self isInHandshakeState:HandshakeFailureReason])
+		return;
+	
+	HandleError he = [HandleErrors handleErrorBlock];
+	NSError *error = nil;
+	NSString *header;
+	if (self.probeOnly)
+		header = NSLocalizedString(@"Failed security read, error from server: ", @"RFBConn Security Probe Failed Header Error Text");
+	else
+		header = NSLocalizedString(@"error from server: ", @"RFBConn Connect Security Failed Header Error Text");
+	he(&error,SocketErrorDomain,SocketReadError,[header stringByAppendingString:reason]);
+	[self finishHandshakeInState:HandshakeFailed Error:error];
+}
+
+-(void)handleAuthSuccess:(BOOL)success Error:(NSError *)authError {
+	if (![self isInHandshakeState:HandshakeAuthenticating])
+		return;
+	
+	if (!success) {
+        DLogErr(@"Security handshake problem: %@", [authError localizedDescription]);
+		HandleError he = [HandleErrors handleErrorBlock];
+		NSError *error = nil;
+        NSString *header = NSLocalizedString(@"Authentication with server failed: ", @"RFBConn Handshake Failed Header Error Text");
+        NSString *reason = authError ? [authError localizedDescription] : @"";
+		he(&error, SocketErrorDomain, SocketSecurityError, [header stringByAppendingString:reason]);
+		[self finishHandshakeInState:HandshakeFailed Error:error];
+		return;
+	}
+	
+	//Success - start connection initialization
+	[self enterHandshakeState:HandshakeServerInit];
+}
+
+-(void)handleServerDetails:(NSArray *)serverDetails {
+	if (![self isInHandshakeState:HandshakeServerInit])
+		return;
+	
+	if (!serverDetails || serverDetails.count == 0) { //init failed
+		HandleError he = [HandleErrors handleErrorBlock];
+		NSError *error = nil;
+		he(&error, SocketErrorDomain, SocketConnectError, @"Failed to complete initialization phase");
+		[self finishHandshakeInState:HandshakeFailed Error:error];
+		return;
+	}
+    
+    //Set Connection Details
+	self.serverName = [serverDetails objectAtIndex:0];
+	self.width = [[serverDetails objectAtIndex:1] intValue];
+	self.height = [[serverDetails objectAtIndex:2] intValue];
+	self.pointerX = (float)self.width/2; //Start pointer location at the "centre" of the supplied screen dimensions
+	self.pointerY = (float)self.height/2;
+	
+	DLogInf(@"Reported server width: %i height %i, starting pointer x: %f, pointer y: %f", self.width, self.height, self.pointerX, self.pointerY);
+	
+	//Server messages aren't used, but must be read so the server never blocks on a full receive window
+	[self.rfbSocket startDrainingServerMessages];
+	
+	[self finishHandshakeInState:HandshakeComplete Error:nil];
 }
 
 #pragma mark - Read Methods - Public
-//Gobble incoming data from server, if any
+//Gobble incoming data from server, if any.  Not needed once connected, server messages are drained continuously
 -(void)discardIncomingData {
 	[self.rfbSocket readAndDiscard];
 }
 
+-(unsigned long long)bytesDrained {
+	return [self.rfbSocket bytesDrained];
+}
+
+-(unsigned long long)messagesDrained {
+	return [self.rfbSocket messagesDrained];
+}
+
+#pragma mark - Write Coalescing - Public
+-(void)setWriteCoalescingWindow:(NSTimeInterval)writeCoalescingWindow {
+	_writeCoalescingWindow = writeCoalescingWindow;
+	self.rfbSocket.coalescingWindow = writeCoalescingWindow;
+}
+
+-(RFBInputLatency *)inputLatency {
+	return [self.rfbSocket inputLatency];
+}
+
+-(unsigned long long)writesSavedByCoalescing {
+	return [self.rfbSocket writesSavedByCoalescing];
+}
+
+-(NSTimeInterval)averageCoalescingDelay {
+	return [self.rfbSocket averageCoalescingDelay];
+}
+
 #pragma mark - RFB Event handling - Public
 //RFB event handling
 -(BOOL)sendEvent:(RFBEvent *)event Error:(NSError **)error {
+	RFBEventRecord record;
+	if (![event getRecord:&record])
+		return NO; //Should never happen
+	BOOL sent = [self sendEventRecord:&record
+								Error:error];
+	RFBEventRecordRelease(&record);
+	return sent;
+}
+
+-(BOOL)claimSendingFor:(id)sender {
+	@synchronized(self) {
+		id claimant = self.sendingClaimant;
+		if (claimant && claimant != sender)
+			return NO;
+		self.sendingClaimant = sender;
+		return YES;
+	}
+}
+
+-(void)releaseSendingFor:(id)sender {
+	@synchronized(self) {
+		if (self.sendingClaimant == sender)
+			self.sendingClaimant = nil;
+	}
+}
+
+-(BOOL)sendEventRecord:(const RFBEventRecord *)record Error:(NSError **)error {
 	HandleError he = [HandleErrors handleErrorBlock];
     
 	if (!self.rfbSocket || [self.rfbSocket isDisconnected]) {
@@ -324,30 +644,76 @@
 		return NO;
 	}
 	
-	if([event isMemberOfClass:[RFBKeyEvent class]]) {
-		return [self handleKeyEvent:(RFBKeyEvent *)event
-                              Error:error]; 
-	} else if ([event isMemberOfClass:[RFBPointerEvent class]]) {
-		return [self handlePointerEvent:(RFBPointerEvent *)event
-								  Error:error]; 
+	[self.eventLog appendRecord:record];
+	[self.rfbSocket stampNextEventCapturedAt:record->capturedAt EnqueuedAt:record->enqueuedAt];
+	switch (record->type) {
+		case RFBEventRecordKey:
+			return [self handleKeyRecord:&record->key
+								   Error:error];
+		case RFBEventRecordPointer:
+			return [self handlePointerRecord:&record->pointer
+									   Error:error];
+		case RFBEventRecordText:
+			return [self handleTextRecord:&record->text
+									Error:error];
+		case RFBEventRecordKeyMacro:
+			[self.rfbSocket sendKeyMessages:(__bridge NSData *)record->keyMacro.messages];
+			return YES;
+		default:
+			return NO; //Should never happen
 	}
+}
 
-	return NO; //Should never happen
+-(BOOL)isSendBacklogged {
+	return [self.rfbSocket hasOutstandingWrites];
+}
+
+-(void)setSendCompletedHandler:(dispatch_block_t)sendCompletedHandler {
+	_sendCompletedHandler = [sendCompletedHandler copy];
+	self.rfbSocket.writesCompletedHandler = _sendCompletedHandler;
+}
+
+-(BOOL)isSendDegraded {
+	return [self.rfbSocket isWriteDegraded];
+}
+
+-(void)setWriteHighWaterMark:(NSUInteger)writeHighWaterMark {
+	_writeHighWaterMark = writeHighWaterMark;
+	self.rfbSocket.writeHighWaterMark = writeHighWaterMark;
+}
+
+-(void)setSendDegradedHandler:(void (^)(BOOL))sendDegradedHandler {
+	_sendDegradedHandler = [sendDegradedHandler copy];
+	self.rfbSocket.writeDegradedHandler = _sendDegradedHandler;
 }
 
 #pragma mark - RFB Event handling - Private
--(BOOL)handleKeyEvent:(RFBKeyEvent *)keyEvent Error:(NSError **)error {
-    //No connection check again because done in sendEvent already
-	[self.rfbSocket sendKeyWithEvent:keyEvent];	
+-(BOOL)handleKeyRecord:(const RFBKeyRecord *)keyRecord Error:(NSError **)error {
+    //No connection check again because done in sendEventRecord already
+	[self.rfbSocket sendKeyPress:keyRecord->keyPress];
+	return YES;
+}
+
+-(BOOL)handleTextRecord:(const RFBTextRecord *)textRecord Error:(NSError **)error {
+	NSString *text = (__bridge NSString *)textRecord->text;
+	if (self.pasteThreshold > 0 && text.length >= self.pasteThreshold && [RFBSocket canSendAsCutText:text]) {
+		[self.rfbSocket sendCutText:text
+					   PasteKeysyms:self.pasteChord
+						 Completion:nil];
+	} else {
+		[self.rfbSocket sendText:text
+					 ChunkLength:self.typingChunkLength
+						Interval:self.typingChunkInterval];
+	}
 	return YES;
 }
 
--(BOOL)handlePointerEvent:(RFBPointerEvent *)pointerEvent Error:(NSError **)error {	
+-(BOOL)handlePointerRecord:(const RFBPointerRecord *)pointerRecord Error:(NSError **)error {	
 	//map movement
-	if ((pointerEvent.dx != 0 || pointerEvent.dy != 0) && !CGPointEqualToPoint(CGPointZero, pointerEvent.v)) {
+	if ((pointerRecord->dx != 0 || pointerRecord->dy != 0) && !CGPointEqualToPoint(CGPointZero, pointerRecord->v)) {
         //Adjust velocity to points per ?centisecond
-        float xSpeed = fabsf(pointerEvent.v.x/100);
-        float ySpeed = fabsf(pointerEvent.v.y/100);
+        float xSpeed = fabsf(pointerRecord->v.x/100);
+        float ySpeed = fabsf(pointerRecord->v.y/100);
         
         //Average speed...
         float speed = (xSpeed+ySpeed)/2;
@@ -357,8 +723,8 @@
             speed = 2;
         
         //Use velocity given as the speed scaler
-		self.pointerX += (pointerEvent.dx*speed);
-		self.pointerY += (pointerEvent.dy*speed);
+		self.pointerX += (pointerRecord->dx*speed);
+		self.pointerY += (pointerRecord->dy*speed);
         
         //Constrain movement to within reported screen borders
 		if (self.pointerX >= self.width) {
@@ -378,15 +744,15 @@
 		if (self.pointerY <= 0)
 			self.pointerY = 0;
         
-        DLog(@"vx vy: %f,%f avg v: %f dx dy: %f,%f New pXY: %f,%f, Sent pXY: %i,%i", xSpeed,ySpeed,speed, pointerEvent.dx,pointerEvent.dy, self.pointerX,self.pointerY, (int)self.pointerX, (int)self.pointerY);
+        DLog(@"vx vy: %f,%f avg v: %f dx dy: %f,%f New pXY: %f,%f, Sent pXY: %i,%i", xSpeed,ySpeed,speed, pointerRecord->dx,pointerRecord->dy, self.pointerX,self.pointerY, (int)self.pointerX, (int)self.pointerY);
 	}
 	
 	//map buttons
 	uint8_t buttonMask = 0x00;
-	if (pointerEvent.button1) {
+	if (pointerRecord->button1) {
 		buttonMask |= 0x01;
 	}
-	if (pointerEvent.button2) {
+	if (pointerRecord->button2) {
         //Apple Remote Desktop 3.5 button compatibility fix
 		if (self.ard35Compatibility) {
 			buttonMask |= 0x02;
@@ -410,9 +776,9 @@
     };
 
     int8_t scrollDirection = 0;
-    if (pointerEvent.sy != 0 && pointerEvent.scrollSensitivity != 0) {
-        self.yDist += pointerEvent.sy;
-        scrollDirection = shouldScroll(self.yDist, pointerEvent.scrollSensitivity);
+    if (pointerRecord->sy != 0 && pointerRecord->scrollSensitivity != 0) {
+        self.yDist += pointerRecord->sy;
+        scrollDirection = shouldScroll(self.yDist, pointerRecord->scrollSensitivity);
         if (scrollDirection != 0)
             self.yDist = 0; //reset
     }
@@ -440,7 +806,7 @@
 											   clearButtons:clearScrollButtonMask
                                                        XPos:(int)self.pointerX
                                                        YPos:(int)self.pointerY];
-	} else if (pointerEvent.buttonIterations >= 1) {
+	} else if (pointerRecord->buttonIterations >= 1) {
         //Setup clear button mask
 		uint8_t clearButtonMask = buttonMask;
         clearButtonMask &= (~(0x01 | 0x02 | 0x04));
@@ -449,7 +815,7 @@
         DLog(@"clearbtnmask: %i", clearButtonMask);
         
         //send multiple (button) pointer events
-		[self.rfbSocket sendMultiplePointerEventsForIterations:pointerEvent.buttonIterations
+		[self.rfbSocket sendMultiplePointerEventsForIterations:pointerRecord->buttonIterations
                                                     setButtons:buttonMask
                                                   clearButtons:clearButtonMask
                                                           XPos:(int)self.pointerX
@@ -0,0 +1,51 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Diffie-Hellman key pairs generated ahead of time for ARD (Mac Authentication).  Generating a key pair for the
+//  server's 1024 bit prime takes a few ms, and used to sit between reading the server's DH parameters and replying.
+//  Servers send the same prime and generator every time, so once a prime has been seen a few key pairs for it are kept
+//  ready, refilled on a background queue while the next connection's TCP connect and version exchange run.
+//  Each key pair is handed out once only.  The first login with a prime this process hasn't seen generates inline.
+
+#import <Foundation/Foundation.h>
+
+//openssl libcrypto
+#import <dh.h>
+
+@class RFBLatencyHistogram;
+
+@interface RFBDHKeyPool : NSObject
++(RFBDHKeyPool *)sharedPool;
+
+@property (assign, nonatomic) BOOL enabled; //NO = every take misses and nothing is generated.  Default YES
+@property (assign, nonatomic) NSUInteger depth; //Key pairs kept ready per prime, default 2
+
+//Top up every prime seen so far, in the background
+-(void)prefetch;
+//A key pair for prime and generator (big endian, as read from the server), or NULL if none is ready.  The caller owns
+//it (DH_free).  Public and private keys are both the length of the prime.  Starts a refill either way
+-(DH *)takeKeyForPrime:(NSData *)prime Generator:(NSData *)generator;
+//A new key pair generated now, on a miss.  Same key lengths as the pool's, NULL on error
++(DH *)generateKeyForPrime:(NSData *)prime Generator:(NSData *)generator;
+//Free every key pair ready, eg. before a benchmark without the pool.  Primes are still remembered
+-(void)drain;
+
+#pragma mark - Stats
+-(unsigned long long)hits;
+-(unsigned long long)misses;
+-(RFBLatencyHistogram *)generationTimes; //Per key pair, in the background
+-(NSTimeInterval)timeSaved; //Hits * mean generation time, handshake time not spent generating keys
+@end
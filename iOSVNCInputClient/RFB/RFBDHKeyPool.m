@@ -0,0 +1,268 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBDHKeyPool.h"
+
+#import <mach/mach_time.h>
+
+#import "RFBLatencyHistogram.h"
+
+//openssl libcrypto
+#import <bn.h>
+
+#define DEFAULT_DEPTH 2
+#define MAX_PRIMES 4 //Servers with different primes remembered
+#define GENERATE_ATTEMPTS 8 //Key pairs with a leading zero byte are regenerated, see generateKeyPair()
+
+//Generator length byte, generator, then prime.  Dictionary key for one set of DH parameters
+static NSData *parametersKey(NSData *prime, NSData *generator) {
+	uint8_t generatorLength = (uint8_t)MIN(generator.length, UINT8_MAX);
+	NSMutableData *key = [NSMutableData dataWithBytes:&generatorLength length:1];
+	[key appendBytes:[generator bytes] length:generatorLength];
+	[key appendData:prime];
+	return key;
+}
+
+//Key pair for the parameters in key, or NULL on error.  Pairs whose public or private key is shorter than the prime
+//are generated again, RFBSecurityARD can only send full length keys
+static DH *generateKeyPair(NSData *key) {
+	const uint8_t *bytes = [key bytes];
+	uint8_t generatorLength = bytes[0];
+	DH *dh = DH_new();
+	if (!dh)
+		return NULL;
+	dh->g = BN_bin2bn(bytes + 1, generatorLength, NULL);
+	dh->p = BN_bin2bn(bytes + 1 + generatorLength, (int)key.length - 1 - generatorLength, NULL);
+	if (!dh->g || !dh->p) {
+		DH_free(dh);
+		return NULL;
+	}
+	
+	int keyLength = DH_size(dh);
+	for (int i = 0; i < GENERATE_ATTEMPTS; i++) {
+		if (!DH_generate_key(dh))
+			break;
+		if (BN_num_bytes(dh->pub_key) == keyLength && BN_num_bytes(dh->priv_key) == keyLength)
+			return dh;
+		
+		//DH_generate_key only makes a new private key when there isn't one
+		BN_clear_free(dh->priv_key);
+		BN_free(dh->pub_key);
+		dh->priv_key = NULL;
+		dh->pub_key = NULL;
+	}
+	DH_free(dh);
+	return NULL;
+}
+
+@interface RFBDHKeyPool() {
+	dispatch_queue_t _queue; //Guards everything below
+	NSMutableDictionary *_keyPairs; //Parameters key to NSMutableArray of NSValue wrapped DH *
+	NSMutableSet *_refilling; //Parameters with a refill in flight
+	unsigned long long _hits;
+	unsigned long long _misses;
+	BOOL _enabled;
+	NSUInteger _depth;
+}
+@property (strong, nonatomic, readwrite) RFBLatencyHistogram *generationTimes;
+@end
+
+@implementation RFBDHKeyPool
+#pragma mark - Init
++(RFBDHKeyPool *)sharedPool {
+	static RFBDHKeyPool *sharedPool = nil;
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{
+		sharedPool = [[RFBDHKeyPool alloc] init];
+	});
+	return sharedPool;
+}
+
+-(id)init {
+	if ((self = [super init])) {
+		_queue = dispatch_queue_create("RFBDHKeyPool", DISPATCH_QUEUE_SERIAL);
+		_keyPairs = [NSMutableDictionary dictionary];
+		_refilling = [NSMutableSet set];
+		_enabled = YES;
+		_depth = DEFAULT_DEPTH;
+		_generationTimes = [[RFBLatencyHistogram alloc] init];
+	}
+	return self;
+}
+
+-(void)dealloc {
+	[self freeKeyPairs];
+	dispatch_release(_queue);
+}
+
+#pragma mark - Settings - Public
+-(BOOL)enabled {
+	__block BOOL enabled;
+	dispatch_sync(_queue, ^{
+		enabled = _enabled;
+	});
+	return enabled;
+}
+
+-(void)setEnabled:(BOOL)enabled {
+	dispatch_sync(_queue, ^{
+		_enabled = enabled;
+	});
+}
+
+-(NSUInteger)depth {
+	__block NSUInteger depth;
+	dispatch_sync(_queue, ^{
+		depth = _depth;
+	});
+	return depth;
+}
+
+-(void)setDepth:(NSUInteger)depth {
+	dispatch_sync(_queue, ^{
+		_depth = depth;
+	});
+}
+
+#pragma mark - Key Pairs - Public
+-(void)prefetch {
+	dispatch_async(_queue, ^{
+		for (NSData *key in [_keyPairs allKeys])
+			[self refillParameters:key];
+	});
+}
+
+-(DH *)takeKeyForPrime:(NSData *)prime Generator:(NSData *)generator {
+	if (prime.length == 0 || generator.length == 0)
+		return NULL;
+	
+	NSData *key = parametersKey(prime, generator);
+	__block DH *dh = NULL;
+	dispatch_sync(_queue, ^{
+		if (!_enabled)
+			return;
+		
+		NSMutableArray *ready = [_keyPairs objectForKey:key];
+		if (!ready) {
+			if (_keyPairs.count >= MAX_PRIMES)
+				[self freeKeyPairsForParameters:[[_keyPairs allKeys] objectAtIndex:0]];
+			ready = [NSMutableArray array];
+			[_keyPairs setObject:ready forKey:key];
+		}
+		if (ready.count > 0) {
+			dh = [[ready objectAtIndex:0] pointerValue];
+			[ready removeObjectAtIndex:0];
+			_hits++;
+		} else {
+			_misses++;
+		}
+		[self refillParameters:key];
+	});
+	return dh;
+}
+
++(DH *)generateKeyForPrime:(NSData *)prime Generator:(NSData *)generator {
+	if (prime.length == 0 || generator.length == 0)
+		return NULL;
+	return generateKeyPair(parametersKey(prime, generator));
+}
+
+-(void)drain {
+	dispatch_sync(_queue, ^{
+		for (NSMutableArray *ready in [_keyPairs allValues]) {
+			for (NSValue *wrapped in ready)
+				DH_free([wrapped pointerValue]);
+			[ready removeAllObjects];
+		}
+	});
+}
+
+#pragma mark - Stats - Public
+-(unsigned long long)hits {
+	__block unsigned long long hits;
+	dispatch_sync(_queue, ^{
+		hits = _hits;
+	});
+	return hits;
+}
+
+-(unsigned long long)misses {
+	__block unsigned long long misses;
+	dispatch_sync(_queue, ^{
+		misses = _misses;
+	});
+	return misses;
+}
+
+-(NSTimeInterval)timeSaved {
+	return [self hits] * [self.generationTimes mean];
+}
+
+#pragma mark - Refill - Private
+//On _queue.  Generates on a background queue until depth key pairs are ready, one refill per parameters at a time
+-(void)refillParameters:(NSData *)key {
+	if (!_enabled || [_refilling containsObject:key] || [[_keyPairs objectForKey:key] count] >= _depth)
+		return;
+	[_refilling addObject:key];
+	
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+		mach_timebase_info_data_t timebase;
+		mach_timebase_info(&timebase);
+		
+		while (YES) {
+			uint64_t start = mach_absolute_time();
+			DH *dh = generateKeyPair(key);
+			uint64_t elapsed = mach_absolute_time() - start;
+			if (!dh) {
+				DLogErr(@"Failed to generate DH key pair for %lu byte prime", (unsigned long)key.length);
+				dispatch_sync(_queue, ^{
+					[_refilling removeObject:key];
+				});
+				return;
+			}
+			[self.generationTimes recordNanoseconds:elapsed * timebase.numer / timebase.denom];
+			
+			__block BOOL full = NO;
+			dispatch_sync(_queue, ^{
+				NSMutableArray *ready = [_keyPairs objectForKey:key];
+				if (!ready || !_enabled) { //Prime forgotten or pool disabled meanwhile
+					DH_free(dh);
+					full = YES;
+				} else {
+					[ready addObject:[NSValue valueWithPointer:dh]];
+					full = ready.count >= _depth;
+				}
+				if (full)
+					[_refilling removeObject:key];
+			});
+			if (full)
+				return;
+		}
+	});
+}
+
+//On _queue, or from dealloc
+-(void)freeKeyPairsForParameters:(NSData *)key {
+	for (NSValue *wrapped in [_keyPairs objectForKey:key])
+		DH_free([wrapped pointerValue]);
+	[_keyPairs removeObjectForKey:key];
+}
+
+-(void)freeKeyPairs {
+	for (NSData *key in [_keyPairs allKeys])
+		[self freeKeyPairsForParameters:key];
+}
+@end
@@ -0,0 +1,52 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Append-only binary log of the input events sent on a connection, for replay with RFBEventLogReplayer.
+//  Format, little endian:
+//    Header: "RFBEVLOG", uint32 version
+//    Records: uint8 type (RFBEventRecordType), varint nanoseconds since the previous record (monotonic, from capturedAt),
+//             then by type:
+//             Pointer: float64 dt, float32 dx, dy, sx, sy, v.x, v.y, uint8 buttons (bit 0 = 1, bit 1 = 2),
+//                      int8 scrollSensitivity, int8 buttonIterations
+//             Key: uint16 unichar
+//             Text: varint length, UTF-8
+//             Key macro: varint length, encoded KeyMsgs
+//  Records are buffered and written out in blocks, so a crash loses at most the last block.
+
+#import <Foundation/Foundation.h>
+
+#import "RFBEvent.h"
+
+#define RFBEventLogMagic "RFBEVLOG"
+#define RFBEventLogMagicLength 8
+#define RFBEventLogVersion 1
+#define RFBEventLogPointerLength 35
+
+@interface RFBEventLog : NSObject
+@property (copy, nonatomic, readonly) NSString *path;
+
+//Creates the file, replacing any existing one
+-(id)initWithPath:(NSString *)path Error:(NSError **)error;
+
+//Thread safe.  Ignored once closed
+-(void)appendRecord:(const RFBEventRecord *)record;
+-(void)flush;
+-(void)close; //Also on dealloc
+
+#pragma mark - Stats
+-(unsigned long long)recordsWritten;
+-(unsigned long long)bytesWritten;
+@end
@@ -0,0 +1,210 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBEventLog.h"
+
+#import <mach/mach_time.h>
+
+#import "ErrorHandlingMacros.h"
+#import "HandleErrors.h"
+
+#define WRITE_BLOCK_LENGTH 16384 //Buffered records are written out once past this
+
+@interface RFBEventLog() {
+	uint64_t _lastTimestamp; //Nanoseconds
+	unsigned long long _recordsWritten;
+	unsigned long long _bytesWritten;
+}
+@property (copy, nonatomic, readwrite) NSString *path;
+@property (strong, nonatomic) NSFileHandle *file;
+@property (strong, nonatomic) NSMutableData *buffer;
+@end
+
+static void appendVarint(NSMutableData *data, uint64_t value) {
+	uint8_t bytes[10];
+	NSUInteger length = 0;
+	do {
+		bytes[length] = value & 0x7F;
+		value >>= 7;
+		if (value)
+			bytes[length] |= 0x80;
+		length++;
+	} while (value);
+	[data appendBytes:bytes length:length];
+}
+
+static void appendUInt16(NSMutableData *data, uint16_t value) {
+	value = CFSwapInt16HostToLittle(value);
+	[data appendBytes:&value length:sizeof(value)];
+}
+
+static void appendFloat32(NSMutableData *data, float value) {
+	union { float f; uint32_t i; } bits = { .f = value };
+	bits.i = CFSwapInt32HostToLittle(bits.i);
+	[data appendBytes:&bits.i length:sizeof(bits.i)];
+}
+
+static void appendFloat64(NSMutableData *data, double value) {
+	union { double f; uint64_t i; } bits = { .f = value };
+	bits.i = CFSwapInt64HostToLittle(bits.i);
+	[data appendBytes:&bits.i length:sizeof(bits.i)];
+}
+
+@implementation RFBEventLog
+#pragma mark - Init / Dealloc
+//Override, needs a path
+-(id)init {
+	return [self initWithPath:nil Error:nil];
+}
+
+-(id)initWithPath:(NSString *)path Error:(NSError **)error {
+	if ((self = [super init])) {
+		HandleError he = [HandleErrors handleErrorBlock];
+		if (path.length == 0 || ![[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil]) {
+			he(error, FileErrorDomain, FileSaveError, NSLocalizedString(@"Could not create event log file", @"RFBEventLog create error text"));
+			return nil;
+		}
+		_file = [NSFileHandle fileHandleForWritingAtPath:path];
+		if (!_file) {
+			he(error, FileErrorDomain, FileSaveError, NSLocalizedString(@"Could not open event log file", @"RFBEventLog open error text"));
+			return nil;
+		}
+		_path = [path copy];
+		_buffer = [NSMutableData dataWithCapacity:WRITE_BLOCK_LENGTH * 2];
+		
+		uint32_t version = CFSwapInt32HostToLittle(RFBEventLogVersion);
+		[_buffer appendBytes:RFBEventLogMagic length:RFBEventLogMagicLength];
+		[_buffer appendBytes:&version length:sizeof(version)];
+	}
+	return self;
+}
+
+-(void)dealloc {
+	[self close];
+}
+
+#pragma mark - Recording - Public
+-(void)appendRecord:(const RFBEventRecord *)record {
+	uint64_t timestamp = [RFBEventLog nanosecondsFromMachTime:record->capturedAt ? record->capturedAt : mach_absolute_time()];
+	
+	@synchronized(self) {
+		if (!self.file)
+			return;
+		
+		NSMutableData *buffer = self.buffer;
+		NSUInteger start = buffer.length;
+		uint8_t type = (uint8_t)record->type;
+		[buffer appendBytes:&type length:sizeof(type)];
+		//Merged motion can carry an older capture time than the record before it, keep the log monotonic
+		appendVarint(buffer, (_recordsWritten > 0 && timestamp > _lastTimestamp) ? timestamp - _lastTimestamp : 0);
+		if (_recordsWritten == 0 || timestamp > _lastTimestamp)
+			_lastTimestamp = timestamp;
+		
+		switch (record->type) {
+			case RFBEventRecordPointer: {
+				const RFBPointerRecord *pointer = &record->pointer;
+				uint8_t buttons = (pointer->button1 ? 1 : 0) | (pointer->button2 ? 2 : 0);
+				appendFloat64(buffer, pointer->dt);
+				appendFloat32(buffer, pointer->dx);
+				appendFloat32(buffer, pointer->dy);
+				appendFloat32(buffer, pointer->sx);
+				appendFloat32(buffer, pointer->sy);
+				appendFloat32(buffer, (float)pointer->v.x);
+				appendFloat32(buffer, (float)pointer->v.y);
+				[buffer appendBytes:&buttons length:sizeof(buttons)];
+				[buffer appendBytes:&pointer->scrollSensitivity length:sizeof(int8_t)];
+				[buffer appendBytes:&pointer->buttonIterations length:sizeof(int8_t)];
+				break;
+			}
+			case RFBEventRecordKey:
+				appendUInt16(buffer, record->key.keyPress);
+				break;
+			case RFBEventRecordText: {
+				NSData *utf8 = [(__bridge NSString *)record->text.text dataUsingEncoding:NSUTF8StringEncoding];
+				appendVarint(buffer, utf8.length);
+				[buffer appendData:utf8];
+				break;
+			}
+			case RFBEventRecordKeyMacro: {
+				NSData *messages = (__bridge NSData *)record->keyMacro.messages;
+				appendVarint(buffer, messages.length);
+				[buffer appendData:messages];
+				break;
+			}
+			default: //Nothing to replay
+				[buffer setLength:start];
+				return;
+		}
+		_recordsWritten++;
+		
+		if (buffer.length >= WRITE_BLOCK_LENGTH)
+			[self writeBuffer];
+	}
+}
+
+-(void)flush {
+	@synchronized(self) {
+		[self writeBuffer];
+	}
+}
+
+-(void)close {
+	@synchronized(self) {
+		[self writeBuffer];
+		[self.file closeFile];
+		self.file = nil;
+	}
+}
+
+#pragma mark - Stats - Public
+-(unsigned long long)recordsWritten {
+	@synchronized(self) {
+		return _recordsWritten;
+	}
+}
+
+-(unsigned long long)bytesWritten {
+	@synchronized(self) {
+		return _bytesWritten;
+	}
+}
+
+#pragma mark - Recording - Private
+//Call within @synchronized(self)
+-(void)writeBuffer {
+	if (!self.file || self.buffer.length == 0)
+		return;
+	@try {
+		[self.file writeData:self.buffer];
+		_bytesWritten += self.buffer.length;
+	}
+	@catch (NSException *exception) { //Eg. disk full, stop recording rather than take the sending thread down
+		DLogErr(@"Event log write failed, recording stopped: %@", exception);
+		[self.file closeFile];
+		self.file = nil;
+	}
+	[self.buffer setLength:0];
+}
+
++(uint64_t)nanosecondsFromMachTime:(uint64_t)machTime {
+	static mach_timebase_info_data_t timebase;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		mach_timebase_info(&timebase);
+	});
+	return machTime * timebase.numer / timebase.denom;
+}
+@end
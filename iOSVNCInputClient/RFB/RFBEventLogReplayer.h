@@ -0,0 +1,40 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Replays an RFBEventLog on a connection, through -[RFBConnection sendEventRecord:Error:] like live input, so the
+//  same encoding and write path is exercised.  Either paced by the recorded timestamps, or as fast as possible for
+//  load and regression runs.  The log is memory mapped and decoded a record at a time.
+
+#import <Foundation/Foundation.h>
+
+@class RFBConnection;
+
+//Called on the main queue.  error is the first decode or send error, which stops the replay
+typedef void (^RFBEventLogReplayCompletion)(NSUInteger eventsSent, NSTimeInterval duration, NSError *error);
+
+@interface RFBEventLogReplayer : NSObject
+//Checks the header, records are only decoded as they're replayed
+-(id)initWithPath:(NSString *)path Error:(NSError **)error;
+
+//Events are sent from the replayer's own queue.  The connection's sending is claimed for the replay, it fails straight
+//away if another sender (eg. a running RFBEventSender) holds it.
+//realTime = wait out the recorded gaps between events, otherwise send back to back.  One replay at a time
+-(void)replayOnConnection:(RFBConnection *)connection RealTime:(BOOL)realTime Completion:(RFBEventLogReplayCompletion)completion;
+//Blocking, sends on the calling thread.  Returns events sent, error is set if that's not the whole log
+-(NSUInteger)replayOnConnection:(RFBConnection *)connection RealTime:(BOOL)realTime Error:(NSError **)error;
+-(void)cancel; //Stops after the event being sent, completion is still called
+-(BOOL)isReplaying;
+@end
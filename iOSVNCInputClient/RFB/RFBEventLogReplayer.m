@@ -0,0 +1,271 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBEventLogReplayer.h"
+
+#import <mach/mach_time.h>
+#import <libkern/OSAtomic.h>
+
+#import "ErrorHandlingMacros.h"
+#import "HandleErrors.h"
+
+#import "RFBConnection.h"
+#import "RFBEventLog.h"
+
+@interface RFBEventLogReplayer() {
+	volatile int32_t _replaying;
+	volatile int32_t _cancelled;
+}
+@property (strong, nonatomic) NSData *log; //Memory mapped
+@property (assign, nonatomic) dispatch_queue_t replayQueue;
+@end
+
+typedef struct {
+	const uint8_t *bytes;
+	NSUInteger length;
+	NSUInteger position;
+} RFBLogCursor;
+
+static BOOL readVarint(RFBLogCursor *cursor, uint64_t *value) {
+	uint64_t result = 0;
+	for (NSUInteger shift = 0; shift < 64 && cursor->position < cursor->length; shift += 7) {
+		uint8_t byte = cursor->bytes[cursor->position++];
+		result |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			*value = result;
+			return YES;
+		}
+	}
+	return NO;
+}
+
+static BOOL readBytes(RFBLogCursor *cursor, void *bytes, NSUInteger length) {
+	if (cursor->length - cursor->position < length)
+		return NO;
+	memcpy(bytes, cursor->bytes + cursor->position, length);
+	cursor->position += length;
+	return YES;
+}
+
+static float readFloat32(RFBLogCursor *cursor) {
+	union { float f; uint32_t i; } bits;
+	readBytes(cursor, &bits.i, sizeof(bits.i)); //Length checked by the caller
+	bits.i = CFSwapInt32LittleToHost(bits.i);
+	return bits.f;
+}
+
+static double readFloat64(RFBLogCursor *cursor) {
+	union { double f; uint64_t i; } bits;
+	readBytes(cursor, &bits.i, sizeof(bits.i));
+	bits.i = CFSwapInt64LittleToHost(bits.i);
+	return bits.f;
+}
+
+//Payload of a variable length record, not copied
+static BOOL readPayload(RFBLogCursor *cursor, const uint8_t **payload, NSUInteger *length) {
+	uint64_t payloadLength;
+	if (!readVarint(cursor, &payloadLength) || payloadLength > cursor->length - cursor->position)
+		return NO;
+	*payload = cursor->bytes + cursor->position;
+	*length = (NSUInteger)payloadLength;
+	cursor->position += *length;
+	return YES;
+}
+
+//Decode the next record.  Text and key macro records hold a CF object, release with RFBEventRecordRelease
+static BOOL readRecord(RFBLogCursor *cursor, RFBEventRecord *record, uint64_t *delta) {
+	uint8_t type;
+	memset(record, 0, sizeof(*record));
+	if (!readBytes(cursor, &type, sizeof(type)) || !readVarint(cursor, delta))
+		return NO;
+	
+	record->type = type;
+	switch (type) {
+		case RFBEventRecordPointer: {
+			if (cursor->length - cursor->position < RFBEventLogPointerLength)
+				return NO;
+			RFBPointerRecord *pointer = &record->pointer;
+			uint8_t buttons;
+			pointer->dt = readFloat64(cursor);
+			pointer->dx = readFloat32(cursor);
+			pointer->dy = readFloat32(cursor);
+			pointer->sx = readFloat32(cursor);
+			pointer->sy = readFloat32(cursor);
+			pointer->v.x = readFloat32(cursor);
+			pointer->v.y = readFloat32(cursor);
+			readBytes(cursor, &buttons, sizeof(buttons));
+			readBytes(cursor, &pointer->scrollSensitivity, sizeof(int8_t));
+			readBytes(cursor, &pointer->buttonIterations, sizeof(int8_t));
+			pointer->button1 = (buttons & 1) != 0;
+			pointer->button2 = (buttons & 2) != 0;
+			return YES;
+		}
+		case RFBEventRecordKey: {
+			uint16_t keyPress;
+			if (!readBytes(cursor, &keyPress, sizeof(keyPress)))
+				return NO;
+			record->key.keyPress = CFSwapInt16LittleToHost(keyPress);
+			return YES;
+		}
+		case RFBEventRecordText: {
+			const uint8_t *payload;
+			NSUInteger length;
+			if (!readPayload(cursor, &payload, &length))
+				return NO;
+			record->text.text = CFStringCreateWithBytes(kCFAllocatorDefault, payload, length, kCFStringEncodingUTF8, false);
+			return record->text.text != NULL;
+		}
+		case RFBEventRecordKeyMacro: {
+			const uint8_t *payload;
+			NSUInteger length;
+			if (!readPayload(cursor, &payload, &length))
+				return NO;
+			record->keyMacro.messages = CFDataCreate(kCFAllocatorDefault, payload, length);
+			return record->keyMacro.messages != NULL;
+		}
+		default:
+			return NO;
+	}
+}
+
+@implementation RFBEventLogReplayer
+#pragma mark - Init / Dealloc
+//Override, needs a path
+-(id)init {
+	return [self initWithPath:nil Error:nil];
+}
+
+-(id)initWithPath:(NSString *)path Error:(NSError **)error {
+	if ((self = [super init])) {
+		HandleError he = [HandleErrors handleErrorBlock];
+		NSError *readError = nil;
+		NSData *log = path ? [NSData dataWithContentsOfFile:path options:NSDataReadingMappedAlways error:&readError] : nil;
+		if (!log) {
+			he(error, FileErrorDomain, FileExistReadError, NSLocalizedString(@"Could not open event log file", @"RFBEventLogReplayer open error text"));
+			return nil;
+		}
+		
+		uint32_t version = 0;
+		if (log.length >= RFBEventLogMagicLength + sizeof(version))
+			memcpy(&version, (const uint8_t *)log.bytes + RFBEventLogMagicLength, sizeof(version));
+		if (log.length < RFBEventLogMagicLength + sizeof(version) ||
+			memcmp(log.bytes, RFBEventLogMagic, RFBEventLogMagicLength) != 0 ||
+			CFSwapInt32LittleToHost(version) != RFBEventLogVersion) {
+			he(error, FileErrorDomain, FileReadError, NSLocalizedString(@"Not a supported event log file", @"RFBEventLogReplayer header error text"));
+			return nil;
+		}
+		
+		_log = log;
+		//Concurrent so a second replay fails as busy rather than waiting behind the first
+		_replayQueue = dispatch_queue_create("RFBEventLogReplayer.replay", DISPATCH_QUEUE_CONCURRENT);
+	}
+	return self;
+}
+
+-(void)dealloc {
+	if (_replayQueue)
+		dispatch_release(_replayQueue);
+}
+
+#pragma mark - Replay - Public
+-(void)replayOnConnection:(RFBConnection *)connection RealTime:(BOOL)realTime Completion:(RFBEventLogReplayCompletion)completion {
+	dispatch_async(self.replayQueue, ^{
+		NSError *error = nil;
+		uint64_t start = mach_absolute_time();
+		NSUInteger sent = [self replayOnConnection:connection RealTime:realTime Error:&error];
+		
+		mach_timebase_info_data_t timebase;
+		mach_timebase_info(&timebase);
+		NSTimeInterval duration = (double)(mach_absolute_time() - start) * timebase.numer / timebase.denom / NSEC_PER_SEC;
+		if (completion)
+			dispatch_async(dispatch_get_main_queue(), ^{
+				completion(sent, duration, error);
+			});
+	});
+}
+
+-(NSUInteger)replayOnConnection:(RFBConnection *)connection RealTime:(BOOL)realTime Error:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	if (!OSAtomicCompareAndSwap32Barrier(0, 1, &_replaying)) {
+		he(error, ObjectErrorDomain, ObjectMethodReturnError, NSLocalizedString(@"Already replaying", @"RFBEventLogReplayer busy error text"));
+		return 0;
+	}
+	//Sending isn't guarded inside the connection, a replay mustn't interleave with the live event sender
+	if (![connection claimSendingFor:self]) {
+		OSAtomicCompareAndSwap32Barrier(1, 0, &_replaying);
+		he(error, ObjectErrorDomain, ObjectMethodReturnError, NSLocalizedString(@"Events are already being sent on this connection", @"RFBEventLogReplayer sender busy error text"));
+		return 0;
+	}
+	OSAtomicCompareAndSwap32Barrier(1, 0, &_cancelled);
+	
+	uint64_t start = mach_absolute_time();
+	NSUInteger sent = [self sendRecordsOnConnection:connection RealTime:realTime Error:error];
+	
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info(&timebase);
+	DLogInf(@"Replayed %lu events in %.3fs", (unsigned long)sent, (double)(mach_absolute_time() - start) * timebase.numer / timebase.denom / NSEC_PER_SEC);
+	
+	[connection releaseSendingFor:self];
+	OSAtomicCompareAndSwap32Barrier(1, 0, &_replaying);
+	return sent;
+}
+
+-(void)cancel {
+	OSAtomicCompareAndSwap32Barrier(0, 1, &_cancelled);
+}
+
+-(BOOL)isReplaying {
+	return _replaying != 0;
+}
+
+#pragma mark - Replay - Private
+//With the connection claimed.  Returns events sent
+-(NSUInteger)sendRecordsOnConnection:(RFBConnection *)connection RealTime:(BOOL)realTime Error:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info(&timebase);
+	
+	RFBLogCursor cursor = { self.log.bytes, self.log.length, RFBEventLogMagicLength + sizeof(uint32_t) };
+	uint64_t start = mach_absolute_time();
+	uint64_t offset = 0; //Nanoseconds since the first record
+	NSUInteger sent = 0;
+	while (cursor.position < cursor.length && !_cancelled) {
+		RFBEventRecord record;
+		uint64_t delta;
+		if (!readRecord(&cursor, &record, &delta)) {
+			RFBEventRecordRelease(&record);
+			he(error, FileErrorDomain, FileReadError, [NSString stringWithFormat:NSLocalizedString(@"Event log is corrupt at byte %lu", @"RFBEventLogReplayer corrupt log error text"), (unsigned long)cursor.position]);
+			break;
+		}
+		
+		offset += delta;
+		if (realTime)
+			mach_wait_until(start + offset * timebase.denom / timebase.numer);
+		//Stamped as captured now, so latency stats cover the replay rather than the recording
+		record.capturedAt = mach_absolute_time();
+		record.enqueuedAt = record.capturedAt;
+		
+		BOOL eventSent = [connection sendEventRecord:&record
+											   Error:error];
+		RFBEventRecordRelease(&record);
+		if (!eventSent)
+			break;
+		sent++;
+	}
+	return sent;
+}
+@end
@@ -0,0 +1,34 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+//  A small pool of serial worker queues shared by many connections.  Each connection gets its own serial queue, for
+//  its socket I/O and handshake state machine, targeted at one of the workers, so a worker runs one event at a time for
+//  all of its connections like a kqueue/epoll loop on one thread.  GCD dispatch sources are kqueue backed already, so
+//  this bounds the threads in use to the number of workers however many connections there are.
+//  Never dispatch_sync from one connection's queue to another's on the same worker, the worker is already busy.
+
+#import <Foundation/Foundation.h>
+
+@interface RFBEventLoop : NSObject
+//One worker per active processor
++(RFBEventLoop *)sharedLoop;
+-(id)initWithWorkers:(NSUInteger)workers;
+
+-(NSUInteger)workers;
+//New serial queue on the next worker, round robin.  The caller releases it (dispatch_release)
+-(dispatch_queue_t)createConnectionQueueWithLabel:(const char *)label;
+//Connection queues created on each worker so far
+-(NSArray *)connectionsPerWorker;
+@end
@@ -0,0 +1,82 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+#import "RFBEventLoop.h"
+
+#import <libkern/OSAtomic.h>
+
+#define MAX_WORKERS 16
+
+@interface RFBEventLoop() {
+	dispatch_queue_t _workerQueues[MAX_WORKERS];
+	int32_t _connectionCounts[MAX_WORKERS];
+	NSUInteger _workers;
+	int32_t _nextWorker;
+}
+@end
+
+@implementation RFBEventLoop
+#pragma mark - Init
++(RFBEventLoop *)sharedLoop {
+	static RFBEventLoop *sharedLoop = nil;
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{
+		sharedLoop = [[RFBEventLoop alloc] initWithWorkers:[[NSProcessInfo processInfo] activeProcessorCount]];
+	});
+	return sharedLoop;
+}
+
+//Override
+-(id)init {
+	return [self initWithWorkers:1];
+}
+
+-(id)initWithWorkers:(NSUInteger)workers {
+	if ((self = [super init])) {
+		_workers = MIN(MAX(workers, 1), MAX_WORKERS);
+		for (NSUInteger i = 0; i < _workers; i++) {
+			_workerQueues[i] = dispatch_queue_create("RFBEventLoop.worker", DISPATCH_QUEUE_SERIAL);
+			dispatch_set_target_queue(_workerQueues[i], dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+		}
+	}
+	return self;
+}
+
+//Connection queues keep their worker alive (dispatch_set_target_queue retains it)
+-(void)dealloc {
+	for (NSUInteger i = 0; i < _workers; i++)
+		dispatch_release(_workerQueues[i]);
+}
+
+#pragma mark - Queues - Public
+-(NSUInteger)workers {
+	return _workers;
+}
+
+-(dispatch_queue_t)createConnectionQueueWithLabel:(const char *)label {
+	NSUInteger worker = (uint32_t)(OSAtomicIncrement32(&_nextWorker) - 1) % _workers;
+	OSAtomicIncrement32(&_connectionCounts[worker]);
+	dispatch_queue_t queue = dispatch_queue_create(label, DISPATCH_QUEUE_SERIAL);
+	dispatch_set_target_queue(queue, _workerQueues[worker]);
+	return queue;
+}
+
+-(NSArray *)connectionsPerWorker {
+	NSMutableArray *counts = [NSMutableArray arrayWithCapacity:_workers];
+	for (NSUInteger i = 0; i < _workers; i++)
+		[counts addObject:[NSNumber numberWithInt:_connectionCounts[i]]];
+	return counts;
+}
+@end
@@ -0,0 +1,34 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Lock free single producer, single consumer ring of event records.  One thread pushes, one other thread pops.
+//  Fixed capacity, nothing is locked or allocated after init.  Records come out in the order they went in.
+
+#import <Foundation/Foundation.h>
+
+#import "RFBEvent.h"
+
+@interface RFBEventRing : NSObject
+-(id)initWithCapacity:(NSUInteger)capacity; //Rounded up to a power of 2
+
+//Producer thread only.  NO, record not taken, if the ring is full
+-(BOOL)push:(const RFBEventRecord *)record;
+//Consumer thread only.  NO if the ring is empty
+-(BOOL)pop:(RFBEventRecord *)record;
+
+-(NSUInteger)capacity;
+-(NSUInteger)count; //Approximate when read off the producer or consumer thread
+@end
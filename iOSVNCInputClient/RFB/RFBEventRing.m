@@ -0,0 +1,93 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBEventRing.h"
+
+#import <libkern/OSAtomic.h> //OSMemoryBarrier
+
+#define DEFAULT_CAPACITY 256
+
+//_head is only written by the consumer and _tail only by the producer.  Both count up forever and wrap around uint32,
+//the slot is the count masked by capacity.  A barrier between filling/copying a slot and publishing the new count
+//stops the other side seeing the count before the slot.
+@interface RFBEventRing() {
+	RFBEventRecord *_slots;
+	uint32_t _capacity; //Always a power of 2
+	uint32_t _mask;
+	volatile uint32_t _head; //Next slot to pop
+	volatile uint32_t _tail; //Next slot to push
+}
+@end
+
+@implementation RFBEventRing
+#pragma mark - Init / Dealloc
+-(id)init {
+	return [self initWithCapacity:DEFAULT_CAPACITY];
+}
+
+-(id)initWithCapacity:(NSUInteger)capacity {
+	if ((self = [super init])) {
+		_capacity = 1;
+		while (_capacity < capacity && _capacity < (1u << 31))
+			_capacity <<= 1;
+		_mask = _capacity - 1;
+		_slots = calloc(_capacity, sizeof(RFBEventRecord));
+		if (!_slots)
+			return nil;
+	}
+	return self;
+}
+
+-(void)dealloc {
+	free(_slots);
+}
+
+#pragma mark - Push / Pop - Public
+-(BOOL)push:(const RFBEventRecord *)record {
+	uint32_t tail = _tail;
+	uint32_t head = _head;
+	OSMemoryBarrier(); //Don't overwrite the slot before the consumer has finished copying it out
+	if (tail - head >= _capacity)
+		return NO;
+	
+	_slots[tail & _mask] = *record;
+	OSMemoryBarrier(); //Slot filled before it's published
+	_tail = tail + 1;
+	return YES;
+}
+
+-(BOOL)pop:(RFBEventRecord *)record {
+	uint32_t head = _head;
+	uint32_t tail = _tail;
+	OSMemoryBarrier(); //Don't read the slot before it's been published
+	if (head == tail)
+		return NO;
+	
+	*record = _slots[head & _mask];
+	OSMemoryBarrier(); //Slot copied out before it's handed back
+	_head = head + 1;
+	return YES;
+}
+
+#pragma mark - State - Public
+-(NSUInteger)capacity {
+	return _capacity;
+}
+
+-(NSUInteger)count {
+	return _tail - _head;
+}
+@end
@@ -0,0 +1,51 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Sends input events to one connection from a dedicated I/O thread.  Events are handed over through a lock free ring
+//  as plain records, so they're sent in the order they were enqueued and only ever sent from that thread.  stop waits,
+//  for a bounded time, for the thread to exit so the connection isn't disconnected under a send.
+//  Pointer motion is merged, latest wins, while earlier writes are still outstanding.
+//  Results are reported in batches: errors at most every ERROR_REPORT_INTERVAL, otherwise at most every REPORT_INTERVAL.
+
+#import <Foundation/Foundation.h>
+
+#import "RFBEvent.h"
+
+@class RFBConnection;
+
+//Called on the main queue.  error = latest error since the last report, nil if everything since was sent
+typedef void (^RFBEventSenderReport)(NSError *error, NSUInteger eventsSent, NSUInteger eventsFailed);
+
+@interface RFBEventSender : NSObject
+@property (copy, nonatomic) RFBEventSenderReport reportHandler; //Set before start
+
+-(id)initWithConnection:(RFBConnection *)conn;
+-(void)start; //Claims the connection's sending, doesn't start while something else (eg. a replay) holds it
+//The thread exits without sending anything still enqueued, nothing is reported after this.  Waits a bounded time (well under
+//a second) for a send in progress.  NO if the thread is still stuck in it, eg. a blocked write: disconnect the connection
+//anyway, that fails the send and the thread exits after it
+-(BOOL)stop;
+
+//Single producer, only ever call from one thread (eg. main).  NO if the event was dropped, ie. the I/O thread has fallen far behind
+-(BOOL)enqueueEvent:(RFBEvent *)event;
+-(BOOL)enqueueRecord:(const RFBEventRecord *)record; //Takes over anything the record holds, unless dropped
+
+#pragma mark - Stats
+-(unsigned long long)eventsSent;
+-(unsigned long long)eventsDropped;
+-(unsigned long long)motionEventsMerged;
+-(unsigned long long)reportsMade; //Delegate notifications, compared to eventsSent
+@end
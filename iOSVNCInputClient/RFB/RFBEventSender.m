@@ -0,0 +1,294 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBEventSender.h"
+
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
+
+#import "ErrorHandlingMacros.h"
+#import "HandleErrors.h"
+
+#import "RFBConnection.h"
+#import "RFBEventRing.h"
+#import "RFBPointerEvent.h"
+
+#define RING_CAPACITY 256 //Several seconds of touch events at 60Hz
+#define REPORT_INTERVAL 1.0 //seconds
+#define ERROR_REPORT_INTERVAL 0.25
+#define THREAD_PRIORITY 0.75 //Above the main thread's default of 0.5, input shouldn't wait behind UI work
+#define STOP_TIMEOUT 0.5 //seconds stop waits for a send in progress, it's called on main
+
+@interface RFBEventSender() {
+	volatile int32_t _stopped;
+	volatile int32_t _writesCompleted; //Set by the socket's delegate queue, cleared by the I/O thread
+	volatile int32_t _eventsDropped; //Producer side
+	int32_t _droppedReported;
+}
+@property (strong, nonatomic) RFBConnection *rfbconn;
+@property (strong, nonatomic) RFBEventRing *ring;
+@property (assign, nonatomic) dispatch_semaphore_t wakeup; //Signalled on enqueue, write completion and stop
+@property (assign, nonatomic) dispatch_semaphore_t exited; //Signalled by the thread as it exits
+@property (strong, nonatomic) NSThread *thread;
+
+//I/O thread only
+@property (assign, nonatomic) BOOL hasPendingMotion; //Motion held back while earlier writes are outstanding
+@property (assign, nonatomic) RFBPointerRecord pendingMotion;
+@property (assign, nonatomic) uint64_t pendingMotionCapturedAt;
+@property (assign, nonatomic) uint64_t pendingMotionEnqueuedAt;
+@property (assign, nonatomic) BOOL lastButton1; //Button state of the last pointer event sent
+@property (assign, nonatomic) BOOL lastButton2;
+@property (assign, nonatomic) unsigned long long eventsSent;
+@property (assign, nonatomic) unsigned long long motionEventsMerged;
+@property (assign, nonatomic) unsigned long long reportsMade;
+@property (assign, nonatomic) NSUInteger unreportedSent;
+@property (assign, nonatomic) NSUInteger unreportedFailed;
+@property (strong, nonatomic) NSError *unreportedError;
+@property (assign, nonatomic) CFAbsoluteTime lastReport;
+@end
+
+@implementation RFBEventSender
+#pragma mark - Init / Dealloc
+//Override, not used.
+-(id)init {
+	return [self initWithConnection:nil];
+}
+
+-(id)initWithConnection:(RFBConnection *)conn {
+	if ((self = [super init])) {
+		_rfbconn = conn;
+		_ring = [[RFBEventRing alloc] initWithCapacity:RING_CAPACITY];
+		_wakeup = dispatch_semaphore_create(0);
+		_exited = dispatch_semaphore_create(0);
+		if (!_ring || !_wakeup || !_exited)
+			return nil;
+	}
+	return self;
+}
+
+-(void)dealloc {
+	RFBEventRecord record;
+	while ([_ring pop:&record]) //Never sent
+		RFBEventRecordRelease(&record);
+	if (_wakeup)
+		dispatch_release(_wakeup);
+	if (_exited)
+		dispatch_release(_exited);
+}
+
+#pragma mark - Thread Management - Public
+-(void)start {
+	if (self.thread)
+		return;
+	if (![self.rfbconn claimSendingFor:self]) {
+		DLogErr(@"Connection already has a sender, eg. an event log replay, not starting");
+		return;
+	}
+	
+	//Held back motion goes out once the link catches up
+	__weak RFBEventSender *blockSafeSelf = self;
+	self.rfbconn.sendCompletedHandler = ^{
+		[blockSafeSelf writesCompleted];
+	};
+	
+	//The thread keeps self alive until it exits
+	self.thread = [[NSThread alloc] initWithTarget:self selector:@selector(run) object:nil];
+	[self.thread setName:@"RFBEventSender.io"];
+	[self.thread setThreadPriority:THREAD_PRIORITY];
+	[self.thread start];
+}
+
+-(BOOL)stop {
+	self.rfbconn.sendCompletedHandler = nil;
+	OSAtomicCompareAndSwap32Barrier(0, 1, &_stopped);
+	dispatch_semaphore_signal(self.wakeup);
+	
+	//Join, the caller disconnects the connection next and it mustn't be mid send
+	NSThread *thread = self.thread;
+	self.thread = nil;
+	if (!thread || thread == [NSThread currentThread])
+		return YES;
+	if (dispatch_semaphore_wait(self.exited, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(STOP_TIMEOUT * NSEC_PER_SEC))) != 0) {
+		DLogWar(@"Event sender thread still sending after %.1f s", STOP_TIMEOUT);
+		return NO;
+	}
+	return YES;
+}
+
+-(BOOL)isStopped {
+	return _stopped != 0;
+}
+
+#pragma mark - Producer - Public
+-(BOOL)enqueueEvent:(RFBEvent *)event {
+	RFBEventRecord record;
+	if (![event getRecord:&record])
+		return NO;
+	if (![self enqueueRecord:&record]) {
+		RFBEventRecordRelease(&record);
+		return NO;
+	}
+	return YES;
+}
+
+-(BOOL)enqueueRecord:(const RFBEventRecord *)record {
+	RFBEventRecord stamped = *record;
+	stamped.enqueuedAt = mach_absolute_time();
+	if (![self.ring push:&stamped]) {
+		OSAtomicIncrement32Barrier(&_eventsDropped);
+		dispatch_semaphore_signal(self.wakeup); //Make sure the drop is reported
+		return NO;
+	}
+	dispatch_semaphore_signal(self.wakeup);
+	return YES;
+}
+
+#pragma mark - Stats - Public
+-(unsigned long long)eventsDropped {
+	return (uint32_t)_eventsDropped;
+}
+
+#pragma mark - I/O Thread - Private
+-(void)run {
+	while (!_stopped) {
+		@autoreleasepool {
+			dispatch_semaphore_wait(self.wakeup, [self nextReportTime]);
+			if (_stopped)
+				break;
+			
+			RFBEventRecord record;
+			while (!_stopped && [self.ring pop:&record]) {
+				[self processRecord:&record];
+				RFBEventRecordRelease(&record);
+			}
+			if (OSAtomicCompareAndSwap32Barrier(1, 0, &_writesCompleted))
+				[self sendPendingMotion];
+			[self reportIfDue];
+		}
+	}
+	DLogInf(@"Event sender thread exiting, %llu events sent, %llu motion events merged, %i dropped, %llu reports", self.eventsSent, self.motionEventsMerged, _eventsDropped, self.reportsMade);
+	[self.rfbconn releaseSendingFor:self];
+	dispatch_semaphore_signal(self.exited);
+}
+
+//Called on the socket's delegate queue
+-(void)writesCompleted {
+	OSAtomicCompareAndSwap32Barrier(0, 1, &_writesCompleted);
+	dispatch_semaphore_signal(self.wakeup);
+}
+
+//Latest wins for pointer motion.  While earlier writes are still outstanding, motion only events are merged into one held back event
+//instead of queueing a stale trail of positions.  While sending is degraded (past the connection's high-water mark) scrolling is merged too.
+//Anything else (button changes, clicks, keys) goes out in order, after held back motion.
+-(void)processRecord:(const RFBEventRecord *)record {
+	if (record->type == RFBEventRecordPointer) {
+		const RFBPointerRecord *pointer = &record->pointer;
+		BOOL sameButtons = (pointer->button1 == self.lastButton1 && pointer->button2 == self.lastButton2);
+		BOOL mergeable = RFBPointerRecordIsMotionOnly(pointer) || (RFBPointerRecordIsClickFree(pointer) && [self.rfbconn isSendDegraded]);
+		if (mergeable && sameButtons) {
+			if (self.hasPendingMotion) {
+				RFBPointerRecord motion = self.pendingMotion;
+				RFBPointerRecordAccumulateMotion(&motion, pointer);
+				self.pendingMotion = motion;
+				self.motionEventsMerged++;
+				return;
+			}
+			if ([self.rfbconn isSendBacklogged]) {
+				self.pendingMotion = *pointer;
+				self.pendingMotionCapturedAt = record->capturedAt;
+				self.pendingMotionEnqueuedAt = record->enqueuedAt;
+				self.hasPendingMotion = YES;
+				return;
+			}
+		}
+		self.lastButton1 = pointer->button1;
+		self.lastButton2 = pointer->button2;
+	}
+	
+	[self sendPendingMotion]; //Keep order, held back motion happened before this event
+	[self sendRecord:record];
+}
+
+-(void)sendPendingMotion {
+	if (!self.hasPendingMotion)
+		return;
+	self.hasPendingMotion = NO;
+	
+	RFBEventRecord record;
+	record.type = RFBEventRecordPointer;
+	record.capturedAt = self.pendingMotionCapturedAt; //The oldest merged touch
+	record.enqueuedAt = self.pendingMotionEnqueuedAt;
+	record.pointer = self.pendingMotion;
+	[self sendRecord:&record];
+}
+
+-(void)sendRecord:(const RFBEventRecord *)record {
+	NSError *error = nil;
+	if ([self.rfbconn sendEventRecord:record Error:&error]) {
+		self.eventsSent++;
+		self.unreportedSent++;
+	} else {
+		self.unreportedFailed++;
+		self.unreportedError = error;
+	}
+}
+
+#pragma mark - Reporting - Private
+//When the thread next needs to wake up to report, if nothing else wakes it first
+-(dispatch_time_t)nextReportTime {
+	if (self.unreportedFailed == 0 && self.unreportedSent == 0)
+		return DISPATCH_TIME_FOREVER;
+	NSTimeInterval interval = self.unreportedFailed ? ERROR_REPORT_INTERVAL : REPORT_INTERVAL;
+	NSTimeInterval wait = MAX(0, self.lastReport + interval - CFAbsoluteTimeGetCurrent());
+	return dispatch_time(DISPATCH_TIME_NOW, (int64_t)(wait * NSEC_PER_SEC));
+}
+
+-(void)reportIfDue {
+	int32_t dropped = _eventsDropped - _droppedReported;
+	if (dropped > 0) {
+		HandleError he = [HandleErrors handleErrorBlock];
+		NSError *error = nil;
+		he(&error, SocketErrorDomain, SocketEventDroppedError, NSLocalizedString(@"Input events dropped, sending has fallen behind", @"RFBEventSender ring full error text"));
+		self.unreportedFailed += dropped;
+		self.unreportedError = error;
+		_droppedReported += dropped;
+	}
+	if (self.unreportedFailed == 0 && self.unreportedSent == 0)
+		return;
+	
+	CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+	NSTimeInterval interval = self.unreportedFailed ? ERROR_REPORT_INTERVAL : REPORT_INTERVAL;
+	if (now - self.lastReport < interval)
+		return;
+	
+	RFBEventSenderReport handler = self.reportHandler;
+	if (handler) {
+		NSError *error = self.unreportedError;
+		NSUInteger sent = self.unreportedSent;
+		NSUInteger failed = self.unreportedFailed;
+		__weak RFBEventSender *blockSafeSelf = self;
+		dispatch_async(dispatch_get_main_queue(), ^{
+			if (blockSafeSelf && ![blockSafeSelf isStopped]) //stop is called on the main queue too
+				handler(error, sent, failed);
+		});
+		self.reportsMade++;
+	}
+	self.lastReport = now;
+	self.unreportedSent = 0;
+	self.unreportedFailed = 0;
+	self.unreportedError = nil;
+}
+@end
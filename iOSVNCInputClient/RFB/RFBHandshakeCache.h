@@ -0,0 +1,48 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  What a server answered during the last handshake with it: protocol version, security types offered, name and
+//  display size, and when.  Kept with the server profile so the next connection can send the client's version and
+//  security type straight away instead of waiting on the server's (see RFBConnection handshakeCache).  Checked against
+//  the server's answers as they arrive, a mismatch drops it.
+
+#import <Foundation/Foundation.h>
+
+@class VersionMsg;
+
+@interface RFBHandshakeCache : NSObject
+@property (copy, nonatomic, readonly) NSString *address; //Server it was negotiated with
+@property (assign, nonatomic, readonly) int port;
+@property (strong, nonatomic, readonly) VersionMsg *serverVersion;
+@property (copy, nonatomic, readonly) NSData *securityTypes; //As the server listed them
+@property (copy, nonatomic) NSString *serverName; //Empty if only the security types were probed
+@property (assign, nonatomic) CGSize serverDisplaySize; //Zero if only the security types were probed
+@property (strong, nonatomic, readonly) NSDate *negotiatedAt;
+
+-(id)initWithAddress:(NSString *)address Port:(int)port ServerVersion:(VersionMsg *)serverVersion SecurityTypes:(NSData *)securityTypes;
+//Saved form, see dictionaryRepresentation.  nil if incomplete
+-(id)initWithDictionary:(NSDictionary *)dictionary;
+-(NSDictionary *)dictionaryRepresentation; //Property list types only
+
+//Negotiated with this server within maxAge seconds.  Servers are reconfigured rarely, a week is the default
+-(BOOL)isFreshForAddress:(NSString *)address Port:(int)port;
+-(BOOL)isFreshForAddress:(NSString *)address Port:(int)port MaxAge:(NSTimeInterval)maxAge;
+-(BOOL)hasSecurityType:(uint8_t)securityType;
+-(NSArray *)securityTypesList; //NSNumbers, as RFBConnection's
+//Same server answers, time aside
+-(BOOL)matchesServerVersion:(VersionMsg *)serverVersion;
+-(BOOL)matchesSecurityTypes:(NSData *)securityTypes;
+@end
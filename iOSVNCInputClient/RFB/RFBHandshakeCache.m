@@ -0,0 +1,126 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBHandshakeCache.h"
+
+#import "VersionMsg.h"
+
+#define DEFAULT_MAX_AGE (7 * 24 * 60 * 60) //seconds
+
+//Saved dictionary keys
+#define KEY_ADDRESS @"Address"
+#define KEY_PORT @"Port"
+#define KEY_VERSION_MAJOR @"VersionMajor"
+#define KEY_VERSION_MINOR @"VersionMinor"
+#define KEY_SECURITY_TYPES @"SecurityTypes"
+#define KEY_SERVER_NAME @"ServerName"
+#define KEY_WIDTH @"Width"
+#define KEY_HEIGHT @"Height"
+#define KEY_NEGOTIATED_AT @"NegotiatedAt"
+
+@interface RFBHandshakeCache()
+@property (copy, nonatomic, readwrite) NSString *address;
+@property (assign, nonatomic, readwrite) int port;
+@property (strong, nonatomic, readwrite) VersionMsg *serverVersion;
+@property (copy, nonatomic, readwrite) NSData *securityTypes;
+@property (strong, nonatomic, readwrite) NSDate *negotiatedAt;
+@end
+
+@implementation RFBHandshakeCache
+#pragma mark - Init
+//Override, not used
+-(id)init {
+	return [self initWithAddress:nil Port:0 ServerVersion:nil SecurityTypes:nil];
+}
+
+-(id)initWithAddress:(NSString *)address Port:(int)port ServerVersion:(VersionMsg *)serverVersion SecurityTypes:(NSData *)securityTypes {
+	if (address.length == 0 || !serverVersion || securityTypes.length == 0)
+		return nil;
+	if ((self = [super init])) {
+		_address = [address copy];
+		_port = port;
+		_serverVersion = serverVersion;
+		_securityTypes = [securityTypes copy];
+		_serverName = @"";
+		_serverDisplaySize = CGSizeZero;
+		_negotiatedAt = [NSDate date];
+	}
+	return self;
+}
+
+-(id)initWithDictionary:(NSDictionary *)dictionary {
+	NSNumber *major = [dictionary objectForKey:KEY_VERSION_MAJOR];
+	NSNumber *minor = [dictionary objectForKey:KEY_VERSION_MINOR];
+	NSDate *negotiatedAt = [dictionary objectForKey:KEY_NEGOTIATED_AT];
+	if (!major || !minor || ![negotiatedAt isKindOfClass:[NSDate class]])
+		return nil;
+	VersionMsg *serverVersion = [[VersionMsg alloc] initWithMajor:[major intValue] Minor:[minor intValue]];
+	if ((self = [self initWithAddress:[dictionary objectForKey:KEY_ADDRESS]
+								 Port:[[dictionary objectForKey:KEY_PORT] intValue]
+						ServerVersion:serverVersion
+						SecurityTypes:[dictionary objectForKey:KEY_SECURITY_TYPES]])) {
+		NSString *serverName = [dictionary objectForKey:KEY_SERVER_NAME];
+		_serverName = serverName ? [serverName copy] : @"";
+		_serverDisplaySize = CGSizeMake([[dictionary objectForKey:KEY_WIDTH] intValue], [[dictionary objectForKey:KEY_HEIGHT] intValue]);
+		_negotiatedAt = negotiatedAt;
+	}
+	return self;
+}
+
+-(NSDictionary *)dictionaryRepresentation {
+	return @{KEY_ADDRESS:self.address,
+			 KEY_PORT:[NSNumber numberWithInt:self.port],
+			 KEY_VERSION_MAJOR:[NSNumber numberWithInt:self.serverVersion.major],
+			 KEY_VERSION_MINOR:[NSNumber numberWithInt:self.serverVersion.minor],
+			 KEY_SECURITY_TYPES:self.securityTypes,
+			 KEY_SERVER_NAME:(self.serverName ? self.serverName : @""),
+			 KEY_WIDTH:[NSNumber numberWithInt:(int)self.serverDisplaySize.width],
+			 KEY_HEIGHT:[NSNumber numberWithInt:(int)self.serverDisplaySize.height],
+			 KEY_NEGOTIATED_AT:self.negotiatedAt};
+}
+
+#pragma mark - Checks - Public
+-(BOOL)isFreshForAddress:(NSString *)address Port:(int)port {
+	return [self isFreshForAddress:address Port:port MaxAge:DEFAULT_MAX_AGE];
+}
+
+-(BOOL)isFreshForAddress:(NSString *)address Port:(int)port MaxAge:(NSTimeInterval)maxAge {
+	if (port != self.port || ![address isEqualToString:self.address])
+		return NO;
+	NSTimeInterval age = -[self.negotiatedAt timeIntervalSinceNow];
+	return age >= 0 && age <= maxAge; //Clock moved back, don't trust it
+}
+
+-(BOOL)hasSecurityType:(uint8_t)securityType {
+	return memchr(self.securityTypes.bytes, securityType, self.securityTypes.length) != NULL;
+}
+
+-(NSArray *)securityTypesList {
+	NSMutableArray *securityTypes = [NSMutableArray arrayWithCapacity:self.securityTypes.length];
+	const uint8_t *types = self.securityTypes.bytes;
+	for (NSUInteger i = 0; i < self.securityTypes.length; i++)
+		[securityTypes addObject:[NSNumber numberWithUnsignedChar:types[i]]];
+	return securityTypes;
+}
+
+-(BOOL)matchesServerVersion:(VersionMsg *)serverVersion {
+	return serverVersion.major == self.serverVersion.major && serverVersion.minor == self.serverVersion.minor;
+}
+
+-(BOOL)matchesSecurityTypes:(NSData *)securityTypes {
+	return [securityTypes isEqualToData:self.securityTypes];
+}
+@end
@@ -20,10 +20,12 @@ typedef enum {
 	CONNECTION_END,
 	DISCONNECTION_START,
 	DISCONNECTION_END,
-	INPUT_EVENT //TODO: For delegate to respond to event errors
+	INPUT_EVENT, //TODO: For delegate to respond to event errors
+	INPUT_DEGRADED_START, //Link backed up past the high-water mark, pointer motion and scrolling are merged
+	INPUT_DEGRADED_END
 } ActionList;
 
-@class ServerProfile, RFBEvent, RFBConnection;
+@class ServerProfile, RFBEvent, RFBConnection, RFBInputLatency;
 
 @protocol RFBInputConnManagerDelegate;
 
@@ -41,8 +43,14 @@ typedef enum {
 +(RFBConnection *)createConnectionWithProfile:(ServerProfile *)profile Error:(NSError **)error;
 
 #pragma mark - Input Event Management - Public
--(void)sendEvent:(RFBEvent *)event;
+-(void)sendEvent:(RFBEvent *)event; //Main thread only.  Sent in order, the delegate hears about results in batches (INPUT_EVENT)
 -(CGPoint)serverScaleFactor;
+-(BOOL)isInputDegraded; //See INPUT_DEGRADED_START
+//Latency of events sent on the current connection, query percentiles or dump for tuning
+-(RFBInputLatency *)inputLatency;
+//Append events sent on the current connection to a new log (replaced if it exists), for RFBEventLogReplayer
+-(BOOL)startRecordingToPath:(NSString *)path Error:(NSError **)error;
+-(void)stopRecording; //Also on stop
 @end
 
 #pragma mark - Protocol declaration
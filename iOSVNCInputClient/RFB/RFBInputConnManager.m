@@ -22,23 +22,24 @@
 #import "ErrorHandlingMacros.h"
 
 #import "ServerProfile.h"
+#import "ProfileSaverFetcher.h"
 #import "RFBConnection.h"
 
 #import "RFBSecurity.h"
 #import "RFBSecurityARD.h"
 #import "RFBSecurityVNC.h"
 #import "RFBSecurityNone.h"
+#import "RFBSecurityVeNCrypt.h"
 
-#import "RFBEvent.h"
-#import "RFBPointerEvent.h"
-#import "RFBKeyEvent.h"
+#import "RFBEventSender.h"
+#import "RFBInputLatency.h"
+#import "RFBEventLog.h"
 
 @interface RFBInputConnManager()
 @property (strong,nonatomic) ServerProfile *serverProfile;
 @property (strong,nonatomic) RFBConnection *rfbconn;
 @property (assign,nonatomic) CGPoint pointerScaleFactor;
-//@property (assign,nonatomic) dispatch_queue_t readQueue;
-//@property (strong,nonatomic) NSTimer *loopedTimer; //continuous read loop
+@property (strong,nonatomic) RFBEventSender *eventSender; //Sends events, in order, on the connection's own I/O thread
 @end
 
 @implementation RFBInputConnManager
@@ -94,23 +95,48 @@
 		return;
 	}
 	
-	//Connect
+	//Events are sent from the sender's thread, results come back in batches rather than per event
 	__weak RFBInputConnManager *blockSafeSelf = self;
-	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-		__block NSError *error = nil;
-		__block BOOL success = [blockSafeSelf.rfbconn connect:&error];
+	self.eventSender = [[RFBEventSender alloc] initWithConnection:self.rfbconn];
+	self.eventSender.reportHandler = ^(NSError *error, NSUInteger eventsSent, NSUInteger eventsFailed) {
+		if (blockSafeSelf.delegate)
+			[blockSafeSelf.delegate rfbInputConnManager:blockSafeSelf
+										performedAction:INPUT_EVENT
+									   encounteredError:error];
+	};
+	[self.eventSender start];
+	
+	//Flow control changes are rare, tell the delegate about each one
+	self.rfbconn.sendDegradedHandler = ^(BOOL degraded) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			if (blockSafeSelf.delegate)
+				[blockSafeSelf.delegate rfbInputConnManager:blockSafeSelf
+											performedAction:(degraded ? INPUT_DEGRADED_START : INPUT_DEGRADED_END)
+										   encounteredError:nil];
+		});
+	};
+	
+	//Connect.  Asynchronous, no thread is held while the handshake waits on the server
+	[self.rfbconn connectWithCompletion:^(BOOL success, NSError *error) {
 		dispatch_async(dispatch_get_main_queue(), ^{ //Tell delegate connection complete, do rest of startup
+			if ([[error domain] isEqualToString:SocketErrorDomain] && [error code] == SocketCancelError)
+				return; //Connection attempt abandoned by stop, delegate already told about the disconnection
+			
 			if (blockSafeSelf.delegate && !success) {
 				[blockSafeSelf.delegate rfbInputConnManager:blockSafeSelf
                                             performedAction:CONNECTION_END
                                            encounteredError:error];
 				return; 
 			}
+            blockSafeSelf.serverProfile.handshakeCache = blockSafeSelf.rfbconn.handshakeCache; //For the next connect
+            if (blockSafeSelf.serverProfile.tlsSecurity) {
+                NSDictionary *tlsSession = [RFBSecurityVeNCrypt savedSessionForCacheKey:[[blockSafeSelf class] tlsSessionCacheKeyForProfile:blockSafeSelf.serverProfile]];
+                if (tlsSession)
+                    blockSafeSelf.serverProfile.tlsSession = tlsSession;
+            }
+            [[blockSafeSelf class] saveConnectionStateOfProfile:blockSafeSelf.serverProfile];
             
-            //????: For gobbling any incoming server data, but not needed.
-            //Setup timed received data buffer cleaner as we don't need anything sent from the server
-            //self.readQueue = dispatch_queue_create("rfbReadQueue", NULL);
-            //dispatch_async(self.readQueue, ^{[blockSafeSelf readAndIgnore:blockSafeSelf];});
+            //Incoming server data isn't needed, RFBConnection drains it from here on
             
             //Setup scaling factor
             CGSize inputScreenSize = [UIScreen mainScreen].bounds.size;
@@ -120,7 +146,7 @@
             if (blockSafeSelf.delegate)
                 [blockSafeSelf.delegate rfbInputConnManager:blockSafeSelf performedAction:CONNECTION_END encounteredError:error];
 		});
-	});
+	}];
 }
 
 -(void)stop {
@@ -128,16 +154,15 @@
 	if (self.delegate && self.rfbconn) //check rfbconn to stop duplicate disconn firings due to calling method in dealloc and requiring user to call manually
 		[self.delegate rfbInputConnManager:self performedAction:DISCONNECTION_START encounteredError:nil];
 	
-	//Disconnect
+	//Disconnect, dropping any connection attempt still in progress
+    if (![self.eventSender stop]) //Normally returns once the I/O thread is done with the connection
+        DLogWar(@"Disconnecting under a stuck send");
+    self.eventSender = nil;
+    if ([self.rfbconn inputLatency])
+        DLogInf(@"Input latency:\n%@", [[self.rfbconn inputLatency] dump]);
+    [self stopRecording];
     [self.rfbconn disconnect];
 	self.rfbconn = nil;
-    
-    /*
-	if (self.readQueue) {
-		dispatch_release(self.readQueue);
-		self.readQueue = nil;		
-	}
-     */
 	
 	//Delegate notification end signal
 	if (self.delegate && !self.rfbconn)
@@ -146,27 +171,39 @@
 
 #pragma mark - Input Event Management - Public
 -(void)sendEvent:(RFBEvent *)event {
-	//Send event
-	__weak RFBInputConnManager *blockSafeSelf = self;
-	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-        __block NSError *error = nil;
-        [blockSafeSelf.rfbconn sendEvent:event
-                                   Error:&error];
-        //Delegate notification (in dispatch queue)
-		dispatch_async(dispatch_get_main_queue(), ^{
-			if (blockSafeSelf.delegate) {
-				[blockSafeSelf.delegate rfbInputConnManager:blockSafeSelf
-                                            performedAction:INPUT_EVENT
-                                           encounteredError:error];
-			}
-		});
-    });
+	//Handed to the I/O thread as a plain record, no queue hop or block per event
+	[self.eventSender enqueueEvent:event];
 }
 
 -(CGPoint)serverScaleFactor {
     return self.pointerScaleFactor;
 }
 
+-(BOOL)isInputDegraded {
+    return [self.rfbconn isSendDegraded];
+}
+
+-(RFBInputLatency *)inputLatency {
+    return [self.rfbconn inputLatency];
+}
+
+-(BOOL)startRecordingToPath:(NSString *)path Error:(NSError **)error {
+    RFBEventLog *eventLog = [[RFBEventLog alloc] initWithPath:path Error:error];
+    if (!eventLog)
+        return NO;
+    [self stopRecording];
+    self.rfbconn.eventLog = eventLog;
+    return YES;
+}
+
+-(void)stopRecording {
+    RFBEventLog *eventLog = self.rfbconn.eventLog;
+    self.rfbconn.eventLog = nil;
+    if (eventLog)
+        DLogInf(@"Recorded %llu events, %llu bytes to %@", [eventLog recordsWritten], [eventLog bytesWritten], eventLog.path);
+    [eventLog close];
+}
+
 #pragma mark - Input Event Management - Private
 -(BOOL)setScalingGivenInputScreenSize:(CGSize)ssize {
     //????: Use Scale instead?
@@ -188,7 +225,13 @@
 +(RFBConnection *)createConnectionWithProfile:(ServerProfile *)profile Error:(NSError **)error {
 	//determine appropriate RFBSecurity object
 	RFBSecurity *security;
-	if (profile.macAuthentication) { //Mac Auth
+	if (profile.tlsSecurity) { //VeNCrypt TLS, subtype picked with the server from the credentials given
+		RFBSecurityVeNCrypt *tls = [[RFBSecurityVeNCrypt alloc] initWithUsername:profile.username
+																		Password:profile.password];
+		tls.sessionCacheKey = [self tlsSessionCacheKeyForProfile:profile];
+		[RFBSecurityVeNCrypt restoreSavedSession:profile.tlsSession ForCacheKey:tls.sessionCacheKey]; //Kept from an earlier launch
+		security = tls;
+	} else if (profile.macAuthentication) { //Mac Auth
 		security = [[RFBSecurityARD alloc] initWithUsername:profile.username
 													 Password:profile.password];
 	} else if (profile.password.length > 0) { //VNC Auth
@@ -209,37 +252,22 @@
 		DLogWar(@"Could not create RFB Connection object with supplied details: %@, %i, %@", profile.address, profile.port, security);
 		return nil;
 	}
+	conn.handshakeCache = profile.handshakeCache; //Skips a round trip while the server answers as it did last time
 	
 	return conn;
 }
 
-#pragma mark - Server Read Management - Private
-/*
-//To be run inside a "read" thread only - don't run in main thread
--(void)readAndIgnore:(RFBInputConnManager *)blockSafeSelf {
-	//While RFBConnection is Connected...
-	NSMethodSignature *methSig = [RFBInputConnManager instanceMethodSignatureForSelector:@selector(timedReadUsingConnMgr:)];
-	NSInvocation *invoc = [NSInvocation invocationWithMethodSignature:methSig];
-	[invoc setSelector:@selector(timedReadUsingConnMgr:)];
-	[invoc setTarget:blockSafeSelf];
-	[invoc setArgument:&blockSafeSelf atIndex:2]; //indexes 0 and 1 are reserved for self and _cmd, respectively.
-	self.loopedTimer = [NSTimer scheduledTimerWithTimeInterval:2.0
-											   invocation:invoc
-												  repeats:YES];
-	[[NSRunLoop currentRunLoop] run];
-}
-//To be run inside a "read" thread only - don't run in main thread
--(void)timedReadUsingConnMgr:(RFBInputConnManager *)blockSafeSelf {
-	DLog(@"Read and discard - rfbconn: %@", blockSafeSelf.rfbconn);
-
-	//Stop read run loop
-	if (!blockSafeSelf.rfbconn) {
-		CFRunLoopStop(CFRunLoopGetCurrent()); //Stop runloop in current thread
-		[blockSafeSelf.loopedTimer invalidate]; //invalidate attached timer
-	}
-	
-	//Call read to gobble server data (and ignore)
-	[blockSafeSelf.rfbconn discardIncomingData];
+//Saved profile gets the refreshed handshake cache and TLS session, off main
++(void)saveConnectionStateOfProfile:(ServerProfile *)profile {
+	ServerProfile *snapshot = [profile copy];
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+		NSError *error = nil;
+		if (![ProfileSaverFetcher saveConnectionStateOfServerProfile:snapshot Error:&error])
+			DLogInf(@"Connection state not saved: %@", [error localizedDescription]);
+	});
+}
+
++(NSString *)tlsSessionCacheKeyForProfile:(ServerProfile *)profile {
+	return [NSString stringWithFormat:@"%@:%i", profile.address, profile.port];
 }
-*/
 @end
@@ -0,0 +1,40 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Input latency, broken down by stage.  Events are stamped with mach_absolute_time when created by the gesture handlers,
+//  when enqueued for the I/O thread, and when encoded into the send buffer.  The socket write carrying them is matched
+//  by its tag and each stage recorded once it has been written out.
+
+#import <Foundation/Foundation.h>
+
+@class RFBLatencyHistogram;
+
+typedef enum {
+	RFBLatencyCaptureToEnqueue,  //Gesture handler to RFBInputConnManager
+	RFBLatencyEnqueueToEncode,   //Waiting for, and processing on, the I/O thread
+	RFBLatencyEncodeToWritten,   //Coalescing window plus socket write
+	RFBLatencyCaptureToWritten,  //End to end
+	RFBLatencyStageCount
+} RFBLatencyStage;
+
+@interface RFBInputLatency : NSObject
+//Stamps in mach_absolute_time units.  0 for a stamp that was never taken skips the stages it starts or ends
+-(void)recordCapturedAt:(uint64_t)capturedAt EnqueuedAt:(uint64_t)enqueuedAt EncodedAt:(uint64_t)encodedAt WrittenAt:(uint64_t)writtenAt;
+-(void)reset;
+
+-(RFBLatencyHistogram *)histogramForStage:(RFBLatencyStage)stage;
+-(NSString *)dump; //One line per stage
+@end
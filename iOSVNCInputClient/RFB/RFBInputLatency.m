@@ -0,0 +1,77 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBInputLatency.h"
+
+#import <mach/mach_time.h>
+
+#import "RFBLatencyHistogram.h"
+
+@interface RFBInputLatency()
+@property (strong, nonatomic) NSArray *histograms; //Indexed by RFBLatencyStage
+@end
+
+@implementation RFBInputLatency
+#pragma mark - Init
+-(id)init {
+	if ((self = [super init])) {
+		NSMutableArray *histograms = [NSMutableArray arrayWithCapacity:RFBLatencyStageCount];
+		for (NSUInteger i = 0; i < RFBLatencyStageCount; i++)
+			[histograms addObject:[[RFBLatencyHistogram alloc] init]];
+		_histograms = histograms;
+	}
+	return self;
+}
+
+#pragma mark - Recording - Public
+-(void)recordCapturedAt:(uint64_t)capturedAt EnqueuedAt:(uint64_t)enqueuedAt EncodedAt:(uint64_t)encodedAt WrittenAt:(uint64_t)writtenAt {
+	[self recordStage:RFBLatencyCaptureToEnqueue From:capturedAt To:enqueuedAt];
+	[self recordStage:RFBLatencyEnqueueToEncode From:enqueuedAt To:encodedAt];
+	[self recordStage:RFBLatencyEncodeToWritten From:encodedAt To:writtenAt];
+	[self recordStage:RFBLatencyCaptureToWritten From:capturedAt To:writtenAt];
+}
+
+-(void)reset {
+	for (RFBLatencyHistogram *histogram in self.histograms)
+		[histogram reset];
+}
+
+#pragma mark - Queries - Public
+-(RFBLatencyHistogram *)histogramForStage:(RFBLatencyStage)stage {
+	if (stage >= RFBLatencyStageCount)
+		return nil;
+	return [self.histograms objectAtIndex:stage];
+}
+
+-(NSString *)dump {
+	NSArray *names = @[@"capture->enqueue", @"enqueue->encode", @"encode->written", @"capture->written"];
+	NSMutableString *dump = [NSMutableString string];
+	for (NSUInteger i = 0; i < RFBLatencyStageCount; i++)
+		[dump appendFormat:@"%@: %@\n", [names objectAtIndex:i], [[self.histograms objectAtIndex:i] summary]];
+	return dump;
+}
+
+#pragma mark - Recording - Private
+-(void)recordStage:(RFBLatencyStage)stage From:(uint64_t)start To:(uint64_t)end {
+	if (start == 0 || end == 0 || end < start)
+		return;
+	
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0)
+		mach_timebase_info(&timebase);
+	[[self.histograms objectAtIndex:stage] recordNanoseconds:(end - start) * timebase.numer / timebase.denom];
+}
+@end
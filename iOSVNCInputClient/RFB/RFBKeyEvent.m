@@ -27,4 +27,11 @@
 		_keyPress = keypress;
 	return self;
 }
+
+-(BOOL)getRecord:(RFBEventRecord *)record {
+	[super getRecord:record];
+	record->type = RFBEventRecordKey;
+	record->key.keyPress = self.keyPress;
+	return YES;
+}
 @end
@@ -0,0 +1,31 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  A shortcut such as "Control_L+Alt_L+Delete", compiled once into the KeyMsgs it sends.
+//  Steps are separated by spaces and run in order, eg. "Control_L+c Control_L+v".  Within a step the keys joined by '+'
+//  are pressed in order and released in reverse.  Keys are keysymdef.h names without the XK_ prefix, or single
+//  characters.  '+' itself is "plus".
+
+#import <Foundation/Foundation.h>
+
+@interface RFBKeyMacro : NSObject
+@property (copy, nonatomic, readonly) NSString *string;
+@property (strong, nonatomic, readonly) NSData *messages; //Key down/up KeyMsgs for every step, ready to write
+@property (assign, nonatomic, readonly) NSUInteger keyCount;
+
+//Compiled once per string, then cached.  nil with error if a key name is unknown or a step is empty
++(RFBKeyMacro *)macroWithString:(NSString *)string Error:(NSError **)error;
+@end
@@ -0,0 +1,108 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBKeyMacro.h"
+
+#import "ErrorHandlingMacros.h"
+#import "HandleErrors.h"
+
+#import "RFBSocket.h"
+#import "KeyMapping.h"
+
+@interface RFBKeyMacro()
+@property (copy, nonatomic, readwrite) NSString *string;
+@property (strong, nonatomic, readwrite) NSData *messages;
+@property (assign, nonatomic, readwrite) NSUInteger keyCount;
+@end
+
+@implementation RFBKeyMacro
+#pragma mark - Init
+//Override, an empty macro.  Use macroWithString:Error:
+-(id)init {
+	return [self initWithString:@"" Messages:[NSData data] KeyCount:0];
+}
+
+-(id)initWithString:(NSString *)string Messages:(NSData *)messages KeyCount:(NSUInteger)keyCount {
+	if ((self = [super init])) {
+		_string = [string copy];
+		_messages = messages;
+		_keyCount = keyCount;
+	}
+	return self;
+}
+
+#pragma mark - Compiling - Public
++(RFBKeyMacro *)macroWithString:(NSString *)string Error:(NSError **)error {
+	static NSCache *compiledMacros;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		compiledMacros = [[NSCache alloc] init];
+	});
+	
+	if (!string)
+		string = @"";
+	RFBKeyMacro *macro = [compiledMacros objectForKey:string];
+	if (macro)
+		return macro;
+	
+	macro = [self compileString:string Error:error];
+	if (macro)
+		[compiledMacros setObject:macro forKey:macro.string];
+	return macro;
+}
+
+#pragma mark - Compiling - Private
++(RFBKeyMacro *)compileString:(NSString *)string Error:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	
+	NSMutableData *messages = [NSMutableData data];
+	NSUInteger keyCount = 0;
+	NSArray *steps = [string componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+	for (NSString *step in steps) {
+		if (step.length == 0) //Repeated spaces
+			continue;
+		
+		NSArray *names = [step componentsSeparatedByString:@"+"];
+		UInt32 keysyms[names.count];
+		for (NSUInteger i = 0; i < names.count; i++) {
+			NSString *name = [names objectAtIndex:i];
+			keysyms[i] = [KeyMapping keySymForName:name];
+			if (keysyms[i] == 0) {
+				he(error, ObjectErrorDomain, ObjectNotFoundError, [NSString stringWithFormat:NSLocalizedString(@"Unknown key \"%@\" in shortcut %@", @"RFBKeyMacro unknown key name error text"), name, string]);
+				return nil;
+			}
+		}
+		
+		for (NSUInteger i = 0; i < names.count; i++) {
+			KeyMsg keyDownMsg = RFBKeyMsgMake(YES, keysyms[i]);
+			[messages appendBytes:&keyDownMsg length:KeyMsg_Size];
+		}
+		for (NSUInteger i = names.count; i > 0; i--) {
+			KeyMsg keyUpMsg = RFBKeyMsgMake(NO, keysyms[i - 1]);
+			[messages appendBytes:&keyUpMsg length:KeyMsg_Size];
+		}
+		keyCount += names.count;
+	}
+	
+	if (keyCount == 0) {
+		he(error, ObjectErrorDomain, ObjectInitError, NSLocalizedString(@"Shortcut has no keys", @"RFBKeyMacro empty shortcut error text"));
+		return nil;
+	}
+	return [[RFBKeyMacro alloc] initWithString:string
+									  Messages:[messages copy]
+									  KeyCount:keyCount];
+}
+@end
@@ -0,0 +1,35 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Fixed size latency histogram.  Buckets are log scaled, 4 per power of 2 from 1 microsecond up to ~70 minutes,
+//  so percentiles are accurate to within ~19%.  Recording doesn't allocate.  Thread safe.
+
+#import <Foundation/Foundation.h>
+
+@interface RFBLatencyHistogram : NSObject
+-(void)recordNanoseconds:(uint64_t)nanoseconds;
+-(void)reset;
+//Add every sample recorded in histogram, eg. to aggregate per connection histograms
+-(void)addHistogram:(RFBLatencyHistogram *)histogram;
+
+#pragma mark - Queries
+-(unsigned long long)count;
+//percentile 0-100, eg. 50 for the median.  Upper bound of the bucket it falls in, 0 if nothing recorded (seconds)
+-(NSTimeInterval)percentile:(double)percentile;
+-(NSTimeInterval)mean;
+-(NSTimeInterval)max;
+-(NSString *)summary; //Count, mean, p50, p90, p99, max
+@end
@@ -0,0 +1,154 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBLatencyHistogram.h"
+
+#import <libkern/OSAtomic.h> //OSSpinLock
+
+#define SUB_BUCKETS 4 //Per power of 2
+#define OCTAVES 32 //2^32 microseconds, ~70 minutes
+#define BUCKET_COUNT (SUB_BUCKETS * OCTAVES + 1) //Last bucket catches anything longer
+
+@interface RFBLatencyHistogram() {
+	OSSpinLock _lock; //Held for a few instructions, cheaper than @synchronized on the recording path
+	uint64_t _buckets[BUCKET_COUNT];
+	unsigned long long _count;
+	uint64_t _totalNanoseconds;
+	uint64_t _maxNanoseconds;
+}
+@end
+
+//Bucket 0 is < 1us.  After that each power of 2 is split into SUB_BUCKETS equal parts
+static NSUInteger bucketForMicroseconds(uint64_t microseconds) {
+	if (microseconds == 0)
+		return 0;
+	NSUInteger octave = 63 - __builtin_clzll(microseconds); //Index of the highest set bit
+	if (octave >= OCTAVES)
+		return BUCKET_COUNT - 1;
+	NSUInteger sub = 0;
+	if (octave >= 2)
+		sub = (NSUInteger)((microseconds >> (octave - 2)) & (SUB_BUCKETS - 1));
+	else
+		sub = (NSUInteger)((microseconds << (2 - octave)) & (SUB_BUCKETS - 1));
+	return 1 + octave * SUB_BUCKETS + sub;
+}
+
+static double upperBoundMicroseconds(NSUInteger bucket) {
+	if (bucket == 0)
+		return 1;
+	if (bucket >= BUCKET_COUNT - 1)
+		return INFINITY;
+	NSUInteger octave = (bucket - 1) / SUB_BUCKETS;
+	NSUInteger sub = (bucket - 1) % SUB_BUCKETS;
+	double base = (double)(1ULL << octave);
+	return base + base * (sub + 1) / SUB_BUCKETS;
+}
+
+@implementation RFBLatencyHistogram
+#pragma mark - Recording - Public
+-(void)recordNanoseconds:(uint64_t)nanoseconds {
+	NSUInteger bucket = bucketForMicroseconds(nanoseconds / NSEC_PER_USEC);
+	OSSpinLockLock(&_lock);
+	_buckets[bucket]++;
+	_count++;
+	_totalNanoseconds += nanoseconds;
+	if (nanoseconds > _maxNanoseconds)
+		_maxNanoseconds = nanoseconds;
+	OSSpinLockUnlock(&_lock);
+}
+
+-(void)reset {
+	OSSpinLockLock(&_lock);
+	memset(_buckets, 0, sizeof(_buckets));
+	_count = 0;
+	_totalNanoseconds = 0;
+	_maxNanoseconds = 0;
+	OSSpinLockUnlock(&_lock);
+}
+
+-(void)addHistogram:(RFBLatencyHistogram *)histogram {
+	if (!histogram || histogram == self)
+		return;
+	//Copied out first, the two locks are never held together
+	uint64_t buckets[BUCKET_COUNT];
+	OSSpinLockLock(&histogram->_lock);
+	memcpy(buckets, histogram->_buckets, sizeof(buckets));
+	unsigned long long count = histogram->_count;
+	uint64_t totalNanoseconds = histogram->_totalNanoseconds;
+	uint64_t maxNanoseconds = histogram->_maxNanoseconds;
+	OSSpinLockUnlock(&histogram->_lock);
+	
+	OSSpinLockLock(&_lock);
+	for (NSUInteger i = 0; i < BUCKET_COUNT; i++)
+		_buckets[i] += buckets[i];
+	_count += count;
+	_totalNanoseconds += totalNanoseconds;
+	if (maxNanoseconds > _maxNanoseconds)
+		_maxNanoseconds = maxNanoseconds;
+	OSSpinLockUnlock(&_lock);
+}
+
+#pragma mark - Queries - Public
+-(unsigned long long)count {
+	OSSpinLockLock(&_lock);
+	unsigned long long count = _count;
+	OSSpinLockUnlock(&_lock);
+	return count;
+}
+
+-(NSTimeInterval)percentile:(double)percentile {
+	uint64_t buckets[BUCKET_COUNT];
+	OSSpinLockLock(&_lock);
+	memcpy(buckets, _buckets, sizeof(buckets));
+	unsigned long long count = _count;
+	uint64_t maxNanoseconds = _maxNanoseconds;
+	OSSpinLockUnlock(&_lock);
+	
+	if (count == 0)
+		return 0;
+	
+	//Rank of the sample wanted, 1 based
+	unsigned long long rank = (unsigned long long)ceil(MIN(MAX(percentile, 0), 100) / 100.0 * count);
+	if (rank == 0)
+		rank = 1;
+	unsigned long long seen = 0;
+	for (NSUInteger i = 0; i < BUCKET_COUNT; i++) {
+		seen += buckets[i];
+		if (seen >= rank) //Never report more than the longest actually seen
+			return MIN(upperBoundMicroseconds(i) / (double)USEC_PER_SEC, maxNanoseconds / (double)NSEC_PER_SEC);
+	}
+	return maxNanoseconds / (double)NSEC_PER_SEC;
+}
+
+-(NSTimeInterval)mean {
+	OSSpinLockLock(&_lock);
+	NSTimeInterval mean = _count ? (_totalNanoseconds / (double)_count) / NSEC_PER_SEC : 0;
+	OSSpinLockUnlock(&_lock);
+	return mean;
+}
+
+-(NSTimeInterval)max {
+	OSSpinLockLock(&_lock);
+	uint64_t maxNanoseconds = _maxNanoseconds;
+	OSSpinLockUnlock(&_lock);
+	return maxNanoseconds / (double)NSEC_PER_SEC;
+}
+
+-(NSString *)summary {
+	return [NSString stringWithFormat:@"n=%llu mean=%.2fms p50=%.2fms p90=%.2fms p99=%.2fms max=%.2fms",
+			[self count], [self mean] * 1000, [self percentile:50] * 1000, [self percentile:90] * 1000, [self percentile:99] * 1000, [self max] * 1000];
+}
+@end
@@ -0,0 +1,83 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+//  Opens many input only connections to one server and drives each with a synthetic mix of pointer motion, clicks,
+//  scrolls and key presses at a target rate, to find how many clients a server host takes before input lags.
+//  Each client is paced by a GCD timer on its own serial queue, so hundreds of clients don't take hundreds of threads.
+//  With workers set, every client's sends, socket I/O and handshake share one RFBEventLoop instead, each client's timer
+//  on its connection's socket queue.
+//  Every client holds a socket, raise the open file limit (RLIMIT_NOFILE) first for more than a couple of hundred.
+
+#import <Foundation/Foundation.h>
+
+@class RFBSecurity, RFBLatencyHistogram, RFBHandshakeCache;
+
+//Relative weights of each kind of event, eg. {70, 5, 10, 15}.  All 0 = pointer motion only
+typedef struct {
+	NSUInteger pointer;
+	NSUInteger click;
+	NSUInteger scroll;
+	NSUInteger key;
+} RFBLoadMix;
+
+//Called once per client, security can't be shared between handshakes
+typedef RFBSecurity *(^RFBLoadSecurityFactory)(void);
+
+@interface RFBLoadClient : NSObject
+@property (assign, nonatomic, readonly) NSUInteger index;
+@property (assign, nonatomic, readonly) BOOL connected;
+@property (strong, nonatomic, readonly) NSError *error; //Why the handshake failed
+@property (assign, nonatomic, readonly) NSTimeInterval handshakeDuration;
+@property (assign, nonatomic, readonly) unsigned long long eventsSent;
+@property (assign, nonatomic, readonly) unsigned long long eventsFailed; //Connection dropped
+@property (assign, nonatomic, readonly) double achievedRate; //Events per second
+@property (strong, nonatomic, readonly) RFBLatencyHistogram *writeLatency; //Send to written out
+@end
+
+@interface RFBLoadGenerator : NSObject
+@property (assign, nonatomic) NSUInteger clients; //Default 1
+@property (assign, nonatomic) double eventsPerSecond; //Per client, default 60
+@property (assign, nonatomic) NSTimeInterval duration; //Seconds of input once every client has connected, default 10
+@property (assign, nonatomic) RFBLoadMix mix;
+//Handshakes in flight at once, so the server's listen backlog isn't overrun.  Default 32
+@property (assign, nonatomic) NSUInteger connectConcurrency;
+@property (assign, nonatomic) NSTimeInterval writeCoalescingWindow; //See RFBConnection, default 0
+@property (assign, nonatomic) NSTimeInterval drainTimeout; //Seconds to wait for the last writes once input stops, default 10
+//Clients share an RFBEventLoop with this many workers.  0 = every client on queues of its own (default)
+@property (assign, nonatomic) NSUInteger workers;
+//Given to every client's connection, eg. the server profile's, so each sends ahead from it, or handshakes again without
+//it if the server's answers have changed.  Default nil
+@property (strong, nonatomic) RFBHandshakeCache *handshakeCache;
+
+-(id)initWithHostname:(NSString *)address Port:(int)port SecurityFactory:(RFBLoadSecurityFactory)securityFactory;
+
+//Blocking: connect every client, send for duration, wait for the writes, disconnect.  NO with error if none connected
+-(BOOL)run:(NSError **)error;
+
+//"pointer=70,click=5,scroll=10,key=15", missing kinds are 0.  NO if a name or weight isn't recognised
++(BOOL)parseMix:(NSString *)string Mix:(RFBLoadMix *)mix;
+
+#pragma mark - Results
+-(NSArray *)clientResults; //RFBLoadClient, in connection order
+-(NSUInteger)clientsConnected;
+-(double)achievedRate; //Events per second, all clients
+-(RFBLatencyHistogram *)handshakeTimes; //Connected clients
+-(RFBLatencyHistogram *)writeLatency; //All clients
+//Cost per connected client: resident memory added by connecting, and process CPU time per second of input
+-(double)residentBytesPerConnection;
+-(double)cpuTimePerConnectionSecond;
+-(NSUInteger)threadsInUse; //Process threads near the end of the input
+-(NSString *)report; //One line per client, then the aggregate
+@end
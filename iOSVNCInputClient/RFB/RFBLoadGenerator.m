@@ -0,0 +1,378 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+#import "RFBLoadGenerator.h"
+
+#import <mach/mach.h> //task_info, task_threads
+#import <mach/mach_time.h>
+#import <sys/resource.h> //getrusage
+
+#import "ErrorHandlingMacros.h"
+#import "HandleErrors.h"
+
+#import "RFBConnection.h"
+#import "RFBSecurity.h"
+#import "RFBEvent.h"
+#import "RFBInputLatency.h"
+#import "RFBLatencyHistogram.h"
+#import "RFBEventLoop.h"
+
+#define DEFAULT_EVENTS_PER_SECOND 60
+#define DEFAULT_DURATION 10
+#define DEFAULT_CONNECT_CONCURRENCY 32
+#define DEFAULT_DRAIN_TIMEOUT 10
+#define DRAIN_POLL_INTERVAL (10 * NSEC_PER_MSEC)
+#define POINTER_STEP 8 //Largest random walk step, pixels
+//Pointer speed that -[RFBConnection handlePointerRecord:Error:] scales motion by 1
+#define UNSCALED_VELOCITY 100
+
+static double secondsFromMachTime(uint64_t machTime) {
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0)
+		mach_timebase_info(&timebase);
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static double residentBytes(void) {
+	struct task_basic_info info;
+	mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+		return 0;
+	return info.resident_size;
+}
+
+//User and system, all threads
+static NSTimeInterval processCPUTime(void) {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / (double)USEC_PER_SEC + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / (double)USEC_PER_SEC;
+}
+
+static NSUInteger threadCount(void) {
+	thread_act_array_t threads;
+	mach_msg_type_number_t count = 0;
+	if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS)
+		return 0;
+	for (mach_msg_type_number_t i = 0; i < count; i++)
+		mach_port_deallocate(mach_task_self(), threads[i]);
+	vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_act_t));
+	return count;
+}
+
+#pragma mark - RFBLoadClient
+@interface RFBLoadClient ()
+@property (assign, nonatomic, readwrite) NSUInteger index;
+@property (assign, nonatomic, readwrite) BOOL connected;
+@property (strong, nonatomic, readwrite) NSError *error;
+@property (assign, nonatomic, readwrite) NSTimeInterval handshakeDuration;
+@property (assign, nonatomic, readwrite) unsigned long long eventsSent;
+@property (assign, nonatomic, readwrite) unsigned long long eventsFailed;
+@property (assign, nonatomic, readwrite) double achievedRate;
+@property (strong, nonatomic, readwrite) RFBLatencyHistogram *writeLatency;
+
+@property (strong, nonatomic) RFBConnection *connection;
+@property (assign, nonatomic) dispatch_queue_t queue; //Sends for this connection, one at a time.  Its socket queue on an event loop
+@property (assign, nonatomic) dispatch_source_t timer;
+@property (assign, nonatomic) RFBLoadMix mix;
+@property (assign, nonatomic) uint64_t startedAt; //mach_absolute_time of the first send
+@property (assign, nonatomic) int8_t direction; //Random walk drifts back and forth, never pinned to an edge
+@end
+
+@implementation RFBLoadClient
+-(id)initWithIndex:(NSUInteger)index Connection:(RFBConnection *)connection Mix:(RFBLoadMix)mix {
+	if ((self = [super init])) {
+		_index = index;
+		_connection = connection;
+		_mix = mix;
+		_direction = 1;
+		_writeLatency = [[RFBLatencyHistogram alloc] init];
+	}
+	return self;
+}
+
+-(void)dealloc {
+	if (_timer) {
+		dispatch_source_cancel(_timer);
+		dispatch_release(_timer);
+	}
+	if (_queue)
+		dispatch_release(_queue);
+}
+
+//Timer fires every interval nanoseconds, starting somewhere within the first interval so clients don't send in lockstep
+//On an event loop sends run on the connection's socket queue, where the socket's dispatch_syncs run inline.  A queue of
+//the client's own on the loop would sync into another worker's queue, deadlocking when both wait on each other
+-(void)startSendingEvery:(uint64_t)interval {
+	dispatch_queue_t socketQueue = self.connection.eventLoop ? [self.connection socketQueue] : NULL;
+	if (socketQueue) {
+		dispatch_retain(socketQueue);
+		self.queue = socketQueue;
+	} else {
+		self.queue = dispatch_queue_create("RFBLoadClient", DISPATCH_QUEUE_SERIAL);
+	}
+	self.timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.queue);
+	__weak RFBLoadClient *blockSafeSelf = self;
+	dispatch_source_set_event_handler(self.timer, ^{
+		[blockSafeSelf sendNextEvent];
+	});
+	uint64_t offset = (interval > 1) ? arc4random_uniform((uint32_t)MIN(interval, UINT32_MAX)) : 0;
+	dispatch_source_set_timer(self.timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)offset), interval, interval / 10);
+	dispatch_resume(self.timer);
+}
+
+//Returns once no send is in progress and none will start
+-(void)stopSending {
+	if (!self.timer)
+		return;
+	dispatch_source_cancel(self.timer);
+	dispatch_sync(self.queue, ^{
+		double seconds = self.startedAt ? secondsFromMachTime(mach_absolute_time() - self.startedAt) : 0;
+		self.achievedRate = (seconds > 0) ? self.eventsSent / seconds : 0;
+	});
+}
+
+//On queue
+-(void)sendNextEvent {
+	RFBEventRecord record;
+	memset(&record, 0, sizeof(record));
+	record.type = RFBEventRecordPointer;
+
+	RFBLoadMix mix = self.mix;
+	NSUInteger total = mix.pointer + mix.click + mix.scroll + mix.key;
+	uint32_t pick = total ? arc4random_uniform((uint32_t)total) : 0;
+	if (total == 0 || pick < mix.pointer) {
+		if (arc4random_uniform(64) == 0)
+			self.direction = -self.direction;
+		record.pointer.dx = self.direction * (int)(1 + arc4random_uniform(POINTER_STEP));
+		record.pointer.dy = self.direction * (int)(1 + arc4random_uniform(POINTER_STEP));
+		record.pointer.v = CGPointMake(UNSCALED_VELOCITY, UNSCALED_VELOCITY);
+	} else if (pick < mix.pointer + mix.click) {
+		record.pointer.button1 = YES;
+		record.pointer.buttonIterations = 1;
+	} else if (pick < mix.pointer + mix.click + mix.scroll) {
+		record.pointer.sy = arc4random_uniform(2) ? 1 : -1;
+		record.pointer.scrollSensitivity = 1;
+	} else {
+		record.type = RFBEventRecordKey;
+		record.key.keyPress = 'a' + arc4random_uniform(26);
+	}
+
+	uint64_t now = mach_absolute_time();
+	if (self.startedAt == 0)
+		self.startedAt = now;
+	record.capturedAt = now;
+	record.enqueuedAt = now;
+	if ([self.connection sendEventRecord:&record Error:nil])
+		self.eventsSent++;
+	else
+		self.eventsFailed++;
+}
+@end
+
+#pragma mark - RFBLoadGenerator
+@interface RFBLoadGenerator ()
+@property (copy, nonatomic) NSString *address;
+@property (assign, nonatomic) int port;
+@property (copy, nonatomic) RFBLoadSecurityFactory securityFactory;
+@property (strong, nonatomic) NSArray *clientResults;
+@property (strong, nonatomic) RFBLatencyHistogram *handshakeTimes;
+@property (strong, nonatomic) RFBLatencyHistogram *writeLatency;
+@property (assign, nonatomic) double residentBytesPerConnection;
+@property (assign, nonatomic) double cpuTimePerConnectionSecond;
+@property (assign, nonatomic) NSUInteger threadsInUse;
+@end
+
+@implementation RFBLoadGenerator
+#pragma mark - Init
+//Override
+-(id)init {
+	return [self initWithHostname:nil Port:0 SecurityFactory:nil];
+}
+
+-(id)initWithHostname:(NSString *)address Port:(int)port SecurityFactory:(RFBLoadSecurityFactory)securityFactory {
+	if (!address || !securityFactory)
+		return nil;
+	if ((self = [super init])) {
+		_address = [address copy];
+		_port = port;
+		_securityFactory = [securityFactory copy];
+		_clients = 1;
+		_eventsPerSecond = DEFAULT_EVENTS_PER_SECOND;
+		_duration = DEFAULT_DURATION;
+		_connectConcurrency = DEFAULT_CONNECT_CONCURRENCY;
+		_drainTimeout = DEFAULT_DRAIN_TIMEOUT;
+		_clientResults = @[];
+		_handshakeTimes = [[RFBLatencyHistogram alloc] init];
+		_writeLatency = [[RFBLatencyHistogram alloc] init];
+	}
+	return self;
+}
+
+#pragma mark - Load - Public
+-(BOOL)run:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	[self.handshakeTimes reset];
+	[self.writeLatency reset];
+	RFBEventLoop *eventLoop = (self.workers > 0) ? [[RFBEventLoop alloc] initWithWorkers:self.workers] : nil;
+	double residentBefore = residentBytes();
+
+	NSMutableArray *clients = [NSMutableArray arrayWithCapacity:self.clients];
+	for (NSUInteger i = 0; i < self.clients; i++) {
+		RFBConnection *connection = [[RFBConnection alloc] initWithHostname:self.address
+																	   Port:self.port
+																   Security:self.securityFactory()];
+		connection.writeCoalescingWindow = self.writeCoalescingWindow;
+		connection.eventLoop = eventLoop;
+		connection.handshakeCache = self.handshakeCache;
+		[clients addObject:[[RFBLoadClient alloc] initWithIndex:i Connection:connection Mix:self.mix]];
+	}
+	self.clientResults = clients;
+
+	[self connectClients:clients];
+	NSArray *connected = [clients filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"connected == YES"]];
+	if (connected.count == 0) {
+		NSError *lastError = [[clients lastObject] error];
+		he(error, SocketErrorDomain, SocketConnectError, [NSString stringWithFormat:@"No client connected to %@:%i%@", self.address, self.port,
+														   lastError ? [@", " stringByAppendingString:[lastError localizedDescription]] : @""]);
+		return NO;
+	}
+	DLogInf(@"Load generator: %lu of %lu clients connected", (unsigned long)connected.count, (unsigned long)clients.count);
+
+	self.residentBytesPerConnection = MAX(residentBytes() - residentBefore, 0) / connected.count;
+
+	uint64_t interval = (self.eventsPerSecond > 0) ? (uint64_t)(NSEC_PER_SEC / self.eventsPerSecond) : NSEC_PER_SEC;
+	NSTimeInterval cpuBefore = processCPUTime();
+	uint64_t inputStart = mach_absolute_time();
+	for (RFBLoadClient *client in connected)
+		[client startSendingEvery:MAX(interval, 1)];
+	[NSThread sleepForTimeInterval:self.duration];
+	self.threadsInUse = threadCount();
+	for (RFBLoadClient *client in connected)
+		[client stopSending];
+	double inputSeconds = secondsFromMachTime(mach_absolute_time() - inputStart);
+	self.cpuTimePerConnectionSecond = (inputSeconds > 0) ? (processCPUTime() - cpuBefore) / connected.count / inputSeconds : 0;
+
+	//Written out or given up on, then the stats are taken before they go with the socket
+	NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:self.drainTimeout];
+	for (RFBLoadClient *client in connected) {
+		while ([client.connection isSendBacklogged] && [deadline timeIntervalSinceNow] > 0)
+			[NSThread sleepForTimeInterval:(double)DRAIN_POLL_INTERVAL / NSEC_PER_SEC];
+	}
+	for (RFBLoadClient *client in clients) {
+		if (client.connected) {
+			[client.writeLatency addHistogram:[[client.connection inputLatency] histogramForStage:RFBLatencyCaptureToWritten]];
+			[self.writeLatency addHistogram:client.writeLatency];
+		}
+		[client.connection disconnect];
+		client.connection = nil;
+	}
+	return YES;
+}
+
++(BOOL)parseMix:(NSString *)string Mix:(RFBLoadMix *)mix {
+	RFBLoadMix parsed;
+	memset(&parsed, 0, sizeof(parsed));
+	for (NSString *part in [string componentsSeparatedByString:@","]) {
+		NSArray *pair = [part componentsSeparatedByString:@"="];
+		if (pair.count != 2)
+			return NO;
+		NSString *name = [[pair objectAtIndex:0] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+		NSScanner *scanner = [NSScanner scannerWithString:[pair objectAtIndex:1]];
+		NSInteger weight;
+		if (![scanner scanInteger:&weight] || ![scanner isAtEnd] || weight < 0)
+			return NO;
+
+		if ([name isEqualToString:@"pointer"] || [name isEqualToString:@"move"])
+			parsed.pointer = weight;
+		else if ([name isEqualToString:@"click"])
+			parsed.click = weight;
+		else if ([name isEqualToString:@"scroll"])
+			parsed.scroll = weight;
+		else if ([name isEqualToString:@"key"])
+			parsed.key = weight;
+		else
+			return NO;
+	}
+	*mix = parsed;
+	return YES;
+}
+
+#pragma mark - Results - Public
+-(NSUInteger)clientsConnected {
+	NSUInteger connected = 0;
+	for (RFBLoadClient *client in self.clientResults)
+		if (client.connected)
+			connected++;
+	return connected;
+}
+
+-(double)achievedRate {
+	double rate = 0;
+	for (RFBLoadClient *client in self.clientResults)
+		rate += client.achievedRate;
+	return rate;
+}
+
+-(NSString *)report {
+	NSMutableString *report = [NSMutableString string];
+	unsigned long long sent = 0, failed = 0;
+	for (RFBLoadClient *client in self.clientResults) {
+		sent += client.eventsSent;
+		failed += client.eventsFailed;
+		if (!client.connected) {
+			[report appendFormat:@"client %4lu  not connected: %@\n", (unsigned long)client.index, [client.error localizedDescription]];
+			continue;
+		}
+		[report appendFormat:@"client %4lu  handshake %7.2fms  %8.1f/s  sent %llu failed %llu  write p50 %.2fms p99 %.2fms max %.2fms\n",
+		 (unsigned long)client.index, client.handshakeDuration * 1000, client.achievedRate, client.eventsSent, client.eventsFailed,
+		 [client.writeLatency percentile:50] * 1000, [client.writeLatency percentile:99] * 1000, [client.writeLatency max] * 1000];
+	}
+	[report appendFormat:@"aggregate    %lu/%lu connected, %.1f/s (target %.1f/s), sent %llu failed %llu\n",
+	 (unsigned long)[self clientsConnected], (unsigned long)self.clientResults.count, [self achievedRate],
+	 self.eventsPerSecond * [self clientsConnected], sent, failed];
+	[report appendFormat:@"  handshake  %@\n", [self.handshakeTimes summary]];
+	[report appendFormat:@"  write      %@\n", [self.writeLatency summary]];
+	[report appendFormat:@"  cost       %.1f KB resident and %.3f ms CPU per second per connection, %lu threads, %@\n",
+	 self.residentBytesPerConnection / 1024, self.cpuTimePerConnectionSecond * 1000, (unsigned long)self.threadsInUse,
+	 self.workers > 0 ? [NSString stringWithFormat:@"%lu event loop workers", (unsigned long)self.workers] : @"queues per connection"];
+	return report;
+}
+
+#pragma mark - Load - Private
+//Asynchronous handshakes, at most connectConcurrency in flight.  Returns once every one has finished
+-(void)connectClients:(NSArray *)clients {
+	dispatch_semaphore_t slots = dispatch_semaphore_create(MAX(self.connectConcurrency, 1));
+	dispatch_group_t group = dispatch_group_create();
+	RFBLatencyHistogram *handshakeTimes = self.handshakeTimes;
+	for (RFBLoadClient *client in clients) {
+		dispatch_semaphore_wait(slots, DISPATCH_TIME_FOREVER);
+		dispatch_group_enter(group);
+		[client.connection connectWithCompletion:^(BOOL success, NSError *error) {
+			client.connected = success;
+			client.error = error;
+			if (success) {
+				client.handshakeDuration = [client.connection handshakeDuration];
+				[handshakeTimes recordNanoseconds:(uint64_t)(client.handshakeDuration * NSEC_PER_SEC)];
+			}
+			dispatch_semaphore_signal(slots);
+			dispatch_group_leave(group);
+		}];
+	}
+	dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+	dispatch_release(group);
+	dispatch_release(slots);
+}
+@end
@@ -0,0 +1,45 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+//  Consumes server to client messages after the handshake, so the server is never blocked by a full receive window.
+//  Only message framing is parsed, payloads (pixels, colour maps, cut text) are skipped as they arrive and never held.
+//  Incremental, picks up mid message wherever the previous call ran out of data.  Use from a single (serial) queue.
+
+#import <Foundation/Foundation.h>
+
+@class RFBReceiveBuffer;
+
+//Server to client message types
+#define FramebufferUpdate_MsgType 0
+#define SetColourMapEntries_MsgType 1
+#define Bell_MsgType 2
+#define ServerCutText_MsgType 3
+
+@interface RFBMessageDrain : NSObject
+-(id)initWithBitsPerPixel:(uint8_t)bitsPerPixel; //From the ServerInit pixel format
+
+//Consume as much of buffer as possible
+-(void)drainBuffer:(RFBReceiveBuffer *)buffer;
+
+#pragma mark - Stats
+-(unsigned long long)bytesDrained;
+-(unsigned long long)messagesDrained; //Complete messages, all types
+-(unsigned long long)framebufferUpdates;
+-(unsigned long long)colourMapUpdates;
+-(unsigned long long)bells;
+-(unsigned long long)cutTexts;
+//Message or rectangle encoding that can't be framed.  Everything received after it is discarded unparsed
+-(BOOL)lostSync;
+@end
@@ -0,0 +1,370 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+#import "RFBMessageDrain.h"
+
+#import "RFBReceiveBuffer.h"
+
+//Rectangle encodings with a payload length that can be worked out without decoding
+#define RawEncoding 0
+#define CopyRectEncoding 1
+#define RREEncoding 2
+#define HextileEncoding 5
+#define ZRLEEncoding 16
+#define CursorPseudoEncoding -239
+#define DesktopSizePseudoEncoding -223
+#define LastRectPseudoEncoding -224
+#define PointerPosPseudoEncoding -232
+
+//Hextile tile subencoding flags
+#define HextileRaw 1
+#define HextileBackgroundSpecified 2
+#define HextileForegroundSpecified 4
+#define HextileAnySubrects 8
+#define HextileSubrectsColoured 16
+#define HextileTileSize 16
+
+//Each state waits for the named fields
+typedef enum {
+	DrainMessageType,
+	DrainUpdateHeader,      //Padding, number of rectangles
+	DrainRectHeader,        //x, y, width, height, encoding
+	DrainRREHeader,         //Number of subrectangles, background pixel
+	DrainZRLELength,
+	DrainHextileTile,       //Tile subencoding
+	DrainHextileTileHeader, //Background, foreground, number of subrectangles
+	DrainColourMapHeader,   //Padding, first colour, number of colours
+	DrainCutTextHeader,     //Padding, length
+	DrainSkip,              //Payload, skipped as it arrives
+	DrainLostSync
+} RFBDrainState;
+
+@interface RFBMessageDrain() {
+	RFBDrainState _state;
+	RFBDrainState _stateAfterSkip;
+	unsigned long long _skipRemaining;
+	NSUInteger _bytesPerPixel;
+	uint8_t _messageType;
+
+	//FramebufferUpdate in progress
+	uint16_t _rectsRemaining;
+	uint16_t _rectWidth;
+	uint16_t _rectHeight;
+	uint32_t _tileX; //Hextile tile position within the rectangle
+	uint32_t _tileY;
+	uint8_t _tileSubencoding;
+
+	unsigned long long _bytesDrained;
+	unsigned long long _messagesDrained;
+	unsigned long long _framebufferUpdates;
+	unsigned long long _colourMapUpdates;
+	unsigned long long _bells;
+	unsigned long long _cutTexts;
+	BOOL _lostSync;
+}
+@end
+
+@implementation RFBMessageDrain
+#pragma mark - Init
+//Override, assumes 32 bit pixels
+-(id)init {
+	return [self initWithBitsPerPixel:32];
+}
+
+-(id)initWithBitsPerPixel:(uint8_t)bitsPerPixel {
+	if ((self = [super init])) {
+		_bytesPerPixel = bitsPerPixel / 8;
+		if (_bytesPerPixel == 0)
+			_bytesPerPixel = 4;
+		_state = DrainMessageType;
+	}
+	return self;
+}
+
+#pragma mark - Draining - Public
+-(void)drainBuffer:(RFBReceiveBuffer *)buffer {
+	unsigned long long startPosition = [buffer bytesRead];
+	while ([self drainStepWithBuffer:buffer])
+		;
+	_bytesDrained += [buffer bytesRead] - startPosition;
+}
+
+#pragma mark - Stats - Public
+-(unsigned long long)bytesDrained {
+	return _bytesDrained;
+}
+
+-(unsigned long long)messagesDrained {
+	return _messagesDrained;
+}
+
+-(unsigned long long)framebufferUpdates {
+	return _framebufferUpdates;
+}
+
+-(unsigned long long)colourMapUpdates {
+	return _colourMapUpdates;
+}
+
+-(unsigned long long)bells {
+	return _bells;
+}
+
+-(unsigned long long)cutTexts {
+	return _cutTexts;
+}
+
+-(BOOL)lostSync {
+	return _lostSync;
+}
+
+#pragma mark - Draining - Private
+//Consume the fields the current state waits on and move to the next.  NO when more data is needed
+-(BOOL)drainStepWithBuffer:(RFBReceiveBuffer *)buffer {
+	switch (_state) {
+		case DrainMessageType: {
+			if (![buffer readUInt8:&_messageType])
+				return NO;
+			switch (_messageType) {
+				case FramebufferUpdate_MsgType:
+					_state = DrainUpdateHeader;
+					break;
+				case SetColourMapEntries_MsgType:
+					_state = DrainColourMapHeader;
+					break;
+				case Bell_MsgType: //No payload
+					[self finishMessage];
+					break;
+				case ServerCutText_MsgType:
+					_state = DrainCutTextHeader;
+					break;
+				default:
+					[self loseSyncWithReason:[NSString stringWithFormat:@"unknown message type %i", _messageType]];
+					break;
+			}
+			return YES;
+		}
+		case DrainUpdateHeader: {
+			if ([buffer bytesAvailable] < 3)
+				return NO;
+			[buffer skipBytes:1]; //Padding
+			[buffer readUInt16:&_rectsRemaining];
+			[self nextRect];
+			return YES;
+		}
+		case DrainRectHeader: {
+			if ([buffer bytesAvailable] < 12)
+				return NO;
+			uint32_t encoding;
+			[buffer skipBytes:4]; //x, y
+			[buffer readUInt16:&_rectWidth];
+			[buffer readUInt16:&_rectHeight];
+			[buffer readUInt32:&encoding];
+			_rectsRemaining--;
+			[self startRectWithEncoding:(int32_t)encoding];
+			return YES;
+		}
+		case DrainRREHeader: {
+			if ([buffer bytesAvailable] < 4 + _bytesPerPixel)
+				return NO;
+			uint32_t subrects;
+			[buffer readUInt32:&subrects];
+			[buffer skipBytes:_bytesPerPixel]; //Background pixel
+			[self skip:(unsigned long long)subrects * (_bytesPerPixel + 8) Then:DrainRectHeader];
+			return YES;
+		}
+		case DrainZRLELength: {
+			uint32_t length;
+			if (![buffer readUInt32:&length])
+				return NO;
+			[self skip:length Then:DrainRectHeader];
+			return YES;
+		}
+		case DrainHextileTile: {
+			if (![buffer readUInt8:&_tileSubencoding])
+				return NO;
+			if (_tileSubencoding & HextileRaw) {
+				unsigned long long tileWidth = MIN(HextileTileSize, _rectWidth - _tileX);
+				unsigned long long tileHeight = MIN(HextileTileSize, _rectHeight - _tileY);
+				[self skip:tileWidth * tileHeight * _bytesPerPixel Then:DrainHextileTile];
+			} else {
+				_state = DrainHextileTileHeader;
+			}
+			return YES;
+		}
+		case DrainHextileTileHeader: {
+			NSUInteger colours = 0;
+			if (_tileSubencoding & HextileBackgroundSpecified)
+				colours += _bytesPerPixel;
+			if (_tileSubencoding & HextileForegroundSpecified)
+				colours += _bytesPerPixel;
+			NSUInteger headerLength = colours + ((_tileSubencoding & HextileAnySubrects) ? 1 : 0);
+			if ([buffer bytesAvailable] < headerLength)
+				return NO;
+
+			[buffer skipBytes:colours];
+			uint8_t subrects = 0;
+			if (_tileSubencoding & HextileAnySubrects)
+				[buffer readUInt8:&subrects];
+			NSUInteger subrectLength = (_tileSubencoding & HextileSubrectsColoured) ? _bytesPerPixel + 2 : 2;
+			[self skip:subrects * subrectLength Then:DrainHextileTile];
+			return YES;
+		}
+		case DrainColourMapHeader: {
+			if ([buffer bytesAvailable] < 5)
+				return NO;
+			uint16_t colours;
+			[buffer skipBytes:3]; //Padding, first colour
+			[buffer readUInt16:&colours];
+			[self skip:colours * 6 Then:DrainMessageType]; //U16 red, green, blue
+			return YES;
+		}
+		case DrainCutTextHeader: {
+			if ([buffer bytesAvailable] < 7)
+				return NO;
+			uint32_t length;
+			[buffer skipBytes:3]; //Padding
+			[buffer readUInt32:&length];
+			[self skip:length Then:DrainMessageType];
+			return YES;
+		}
+		case DrainSkip: {
+			NSUInteger available = [buffer bytesAvailable];
+			if (available == 0)
+				return NO;
+			_skipRemaining -= [buffer skipBytes:(NSUInteger)MIN(_skipRemaining, available)];
+			if (_skipRemaining == 0)
+				[self skipFinished];
+			return YES;
+		}
+		case DrainLostSync:
+			[buffer skipBytes:[buffer bytesAvailable]];
+			return NO;
+	}
+	return NO;
+}
+
+-(void)startRectWithEncoding:(int32_t)encoding {
+	unsigned long long pixels = (unsigned long long)_rectWidth * _rectHeight;
+	switch (encoding) {
+		case RawEncoding:
+			[self skip:pixels * _bytesPerPixel Then:DrainRectHeader];
+			break;
+		case CopyRectEncoding:
+			[self skip:4 Then:DrainRectHeader]; //Source x, y
+			break;
+		case RREEncoding:
+			_state = DrainRREHeader;
+			break;
+		case HextileEncoding:
+			_tileX = 0;
+			_tileY = 0;
+			if (pixels == 0)
+				[self nextRect];
+			else
+				_state = DrainHextileTile;
+			break;
+		case ZRLEEncoding:
+			_state = DrainZRLELength;
+			break;
+		case CursorPseudoEncoding: //Pixels then bitmask
+			[self skip:pixels * _bytesPerPixel + ((_rectWidth + 7) / 8) * _rectHeight Then:DrainRectHeader];
+			break;
+		case DesktopSizePseudoEncoding:
+		case PointerPosPseudoEncoding:
+			[self nextRect];
+			break;
+		case LastRectPseudoEncoding:
+			_rectsRemaining = 0;
+			[self nextRect];
+			break;
+		default:
+			[self loseSyncWithReason:[NSString stringWithFormat:@"unknown rectangle encoding %i", encoding]];
+			break;
+	}
+}
+
+//Skip length bytes, then carry on in state
+-(void)skip:(unsigned long long)length Then:(RFBDrainState)state {
+	_stateAfterSkip = state;
+	_skipRemaining = length;
+	if (length == 0)
+		[self skipFinished];
+	else
+		_state = DrainSkip;
+}
+
+-(void)skipFinished {
+	switch (_stateAfterSkip) {
+		case DrainRectHeader:
+			[self nextRect];
+			break;
+		case DrainHextileTile:
+			[self nextTile];
+			break;
+		case DrainMessageType:
+			[self finishMessage];
+			break;
+		default:
+			_state = _stateAfterSkip;
+			break;
+	}
+}
+
+-(void)nextRect {
+	if (_rectsRemaining > 0)
+		_state = DrainRectHeader;
+	else
+		[self finishMessage];
+}
+
+//Tiles run left to right, top to bottom
+-(void)nextTile {
+	_tileX += HextileTileSize;
+	if (_tileX >= _rectWidth) {
+		_tileX = 0;
+		_tileY += HextileTileSize;
+	}
+	if (_tileY >= _rectHeight)
+		[self nextRect];
+	else
+		_state = DrainHextileTile;
+}
+
+-(void)finishMessage {
+	switch (_messageType) {
+		case FramebufferUpdate_MsgType:
+			_framebufferUpdates++;
+			break;
+		case SetColourMapEntries_MsgType:
+			_colourMapUpdates++;
+			break;
+		case Bell_MsgType:
+			_bells++;
+			break;
+		case ServerCutText_MsgType:
+			_cutTexts++;
+			break;
+	}
+	_messagesDrained++;
+	_state = DrainMessageType;
+}
+
+-(void)loseSyncWithReason:(NSString *)reason {
+	DLogErr(@"Can't parse server messages past %@, discarding the rest", reason);
+	_lostSync = YES;
+	_state = DrainLostSync;
+}
+@end
@@ -29,4 +29,13 @@
 
 -(id)init;
 -(id)initWithDt:(NSTimeInterval)dt Dx:(float)dx Dy:(float)dy Sx:(float)sx Sy:(float)sy V:(CGPoint)v Button1Pressed:(BOOL)button1 Button2Pressed:(BOOL)button2 ScrollSensitivity:(int8_t)sS ButtonPresses:(int8_t)btnIts;
+
 @end
+
+#pragma mark - Coalescing
+//No scrolling or automated clicks, ie. can be merged with other motion sharing the same button state
+BOOL RFBPointerRecordIsMotionOnly(const RFBPointerRecord *record);
+//No automated clicks, ie. motion and scrolling that can be merged while sending is degraded
+BOOL RFBPointerRecordIsClickFree(const RFBPointerRecord *record);
+//Fold a later click free record into this one.  Deltas and scrolling accumulate, the latest velocity wins
+void RFBPointerRecordAccumulateMotion(RFBPointerRecord *record, const RFBPointerRecord *laterRecord);
@@ -34,4 +34,40 @@
 	
 	return self;
 }
+
+-(BOOL)getRecord:(RFBEventRecord *)record {
+	[super getRecord:record];
+	record->type = RFBEventRecordPointer;
+	record->pointer.dt = self.dt;
+	record->pointer.dx = self.dx;
+	record->pointer.dy = self.dy;
+	record->pointer.sx = self.sx;
+	record->pointer.sy = self.sy;
+	record->pointer.v = self.v;
+	record->pointer.button1 = self.button1;
+	record->pointer.button2 = self.button2;
+	record->pointer.scrollSensitivity = self.scrollSensitivity;
+	record->pointer.buttonIterations = self.buttonIterations;
+	return YES;
+}
 @end
+
+#pragma mark - Coalescing
+BOOL RFBPointerRecordIsMotionOnly(const RFBPointerRecord *record) {
+	return (record->sx == 0 && record->sy == 0 && record->buttonIterations < 1);
+}
+
+BOOL RFBPointerRecordIsClickFree(const RFBPointerRecord *record) {
+	return (record->buttonIterations < 1);
+}
+
+void RFBPointerRecordAccumulateMotion(RFBPointerRecord *record, const RFBPointerRecord *laterRecord) {
+	record->dt += laterRecord->dt;
+	record->dx += laterRecord->dx;
+	record->dy += laterRecord->dy;
+	record->sx += laterRecord->sx;
+	record->sy += laterRecord->sy;
+	if (laterRecord->scrollSensitivity != 0)
+		record->scrollSensitivity = laterRecord->scrollSensitivity;
+	record->v = laterRecord->v;
+}
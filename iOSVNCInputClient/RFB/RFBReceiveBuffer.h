@@ -0,0 +1,46 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+//  Ring buffer for bytes received from the server.  Socket data is appended at the tail, RFB fields are parsed
+//  off the head (read cursor) without creating an NSData per field.  Grows as needed.
+//  Not thread safe, use from a single (serial) queue.
+
+#import <Foundation/Foundation.h>
+
+@interface RFBReceiveBuffer : NSObject
+-(id)initWithCapacity:(NSUInteger)capacity; //Rounded up to a power of 2
+
+#pragma mark - State
+-(NSUInteger)bytesAvailable; //Received, not yet read
+-(unsigned long long)bytesRead; //Read cursor position since the buffer was created/reset
+-(unsigned long long)bytesReceived;
+-(void)reset;
+
+#pragma mark - Writing (socket side)
+-(BOOL)appendBytes:(const void *)bytes Length:(NSUInteger)length; //NO if the buffer could not grow
+
+#pragma mark - Reading (parser side)
+//Each returns NO, consuming nothing, if not enough bytes are available.  Multi byte integers are converted from network order.
+-(BOOL)readUInt8:(uint8_t *)value;
+-(BOOL)readUInt16:(uint16_t *)value;
+-(BOOL)readUInt32:(uint32_t *)value;
+-(BOOL)readBytes:(void *)bytes Length:(NSUInteger)length;
+-(BOOL)peekBytes:(void *)bytes Length:(NSUInteger)length; //As readBytes without moving the cursor
+-(NSUInteger)skipBytes:(NSUInteger)length; //Returns number of bytes skipped, may be less than length
+
+//For fields that end up as objects anyway.  nil if not enough bytes are available
+-(NSData *)readDataOfLength:(NSUInteger)length;
+-(NSString *)readStringOfLength:(NSUInteger)length; //UTF8, falls back to Latin1 for invalid UTF8
+@end
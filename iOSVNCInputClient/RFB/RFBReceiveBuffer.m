@@ -0,0 +1,199 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+#import "RFBReceiveBuffer.h"
+
+#import <arpa/inet.h> //ntohs, ntohl
+
+#define DEFAULT_CAPACITY 4096
+
+@interface RFBReceiveBuffer() {
+	uint8_t *_storage;
+	NSUInteger _capacity; //Always a power of 2, so positions wrap with a mask
+	NSUInteger _head; //Read cursor, index into _storage
+	NSUInteger _count; //Bytes between head and tail
+	unsigned long long _bytesRead;
+	unsigned long long _bytesReceived;
+}
+@end
+
+@implementation RFBReceiveBuffer
+#pragma mark - Init / Dealloc
+-(id)init {
+	return [self initWithCapacity:DEFAULT_CAPACITY];
+}
+
+-(id)initWithCapacity:(NSUInteger)capacity {
+	if ((self = [super init])) {
+		_capacity = 1;
+		while (_capacity < capacity)
+			_capacity <<= 1;
+		_storage = malloc(_capacity);
+		if (!_storage)
+			return nil;
+	}
+	return self;
+}
+
+-(void)dealloc {
+	free(_storage);
+}
+
+#pragma mark - State - Public
+-(NSUInteger)bytesAvailable {
+	return _count;
+}
+
+-(unsigned long long)bytesRead {
+	return _bytesRead;
+}
+
+-(unsigned long long)bytesReceived {
+	return _bytesReceived;
+}
+
+-(void)reset {
+	_head = 0;
+	_count = 0;
+	_bytesRead = 0;
+	_bytesReceived = 0;
+}
+
+#pragma mark - Writing - Public
+-(BOOL)appendBytes:(const void *)bytes Length:(NSUInteger)length {
+	if (length == 0)
+		return YES;
+	if (_count + length > _capacity && ![self growToFit:_count + length])
+		return NO;
+
+	//Copy in up to two pieces, tail to end of storage then wrapped around to the start
+	NSUInteger tail = (_head + _count) & (_capacity - 1);
+	NSUInteger firstPiece = MIN(length, _capacity - tail);
+	memcpy(_storage + tail, bytes, firstPiece);
+	if (firstPiece < length)
+		memcpy(_storage, (const uint8_t *)bytes + firstPiece, length - firstPiece);
+
+	_count += length;
+	_bytesReceived += length;
+	return YES;
+}
+
+#pragma mark - Reading - Public
+-(BOOL)readUInt8:(uint8_t *)value {
+	if (_count < 1)
+		return NO;
+	*value = _storage[_head];
+	[self advance:1];
+	return YES;
+}
+
+-(BOOL)readUInt16:(uint16_t *)value {
+	uint16_t networkValue;
+	if (![self readBytes:&networkValue Length:sizeof(networkValue)])
+		return NO;
+	*value = ntohs(networkValue);
+	return YES;
+}
+
+-(BOOL)readUInt32:(uint32_t *)value {
+	uint32_t networkValue;
+	if (![self readBytes:&networkValue Length:sizeof(networkValue)])
+		return NO;
+	*value = ntohl(networkValue);
+	return YES;
+}
+
+-(BOOL)readBytes:(void *)bytes Length:(NSUInteger)length {
+	if (![self peekBytes:bytes Length:length])
+		return NO;
+	[self advance:length];
+	return YES;
+}
+
+-(BOOL)peekBytes:(void *)bytes Length:(NSUInteger)length {
+	if (_count < length)
+		return NO;
+
+	NSUInteger firstPiece = MIN(length, _capacity - _head);
+	memcpy(bytes, _storage + _head, firstPiece);
+	if (firstPiece < length)
+		memcpy((uint8_t *)bytes + firstPiece, _storage, length - firstPiece);
+	return YES;
+}
+
+-(NSUInteger)skipBytes:(NSUInteger)length {
+	NSUInteger skipped = MIN(length, _count);
+	[self advance:skipped];
+	return skipped;
+}
+
+-(NSData *)readDataOfLength:(NSUInteger)length {
+	if (_count < length)
+		return nil;
+
+	NSMutableData *data = [NSMutableData dataWithLength:length];
+	[self readBytes:[data mutableBytes] Length:length];
+	return data;
+}
+
+-(NSString *)readStringOfLength:(NSUInteger)length {
+	if (_count < length)
+		return nil;
+	if (length == 0)
+		return @"";
+
+	NSString *string;
+	if (_head + length <= _capacity) { //Contiguous, decode in place
+		string = [[NSString alloc] initWithBytes:_storage + _head length:length encoding:NSUTF8StringEncoding];
+		if (!string)
+			string = [[NSString alloc] initWithBytes:_storage + _head length:length encoding:NSISOLatin1StringEncoding];
+		[self advance:length];
+	} else {
+		NSData *data = [self readDataOfLength:length];
+		string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+		if (!string)
+			string = [[NSString alloc] initWithData:data encoding:NSISOLatin1StringEncoding];
+	}
+	return string;
+}
+
+#pragma mark - Private
+-(void)advance:(NSUInteger)length {
+	_head = (_head + length) & (_capacity - 1);
+	_count -= length;
+	_bytesRead += length;
+	if (_count == 0)
+		_head = 0; //Keep the next fields contiguous where possible
+}
+
+//Grow to the next power of 2 that fits, unwrapping the contents to the start of the new storage
+-(BOOL)growToFit:(NSUInteger)required {
+	NSUInteger newCapacity = _capacity;
+	while (newCapacity < required)
+		newCapacity <<= 1;
+
+	uint8_t *newStorage = malloc(newCapacity);
+	if (!newStorage) {
+		DLogErr(@"Receive buffer could not grow to %lu bytes", (unsigned long)newCapacity);
+		return NO;
+	}
+	[self peekBytes:newStorage Length:_count];
+	free(_storage);
+	_storage = newStorage;
+	_capacity = newCapacity;
+	_head = 0;
+	return YES;
+}
+@end
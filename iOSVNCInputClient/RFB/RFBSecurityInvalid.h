@@ -17,6 +17,6 @@
 @interface RFBSecurityInvalid : RFBSecurity
 + (uint8_t)type;
 + (NSString *)typeName;
-- (BOOL)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Error:(NSError **)error;
+- (void)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Completion:(RFBSecurityCompletion)completion;
 - (id)init;
 @end
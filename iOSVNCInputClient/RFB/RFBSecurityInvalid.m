@@ -35,8 +35,8 @@
 	return RFBNAME;
 }
 
-- (BOOL)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Error:(NSError **)error {
+- (void)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Completion:(RFBSecurityCompletion)completion {
 	//Nothing to do
-	return YES;
+	completion(YES, nil);
 }
 @end
@@ -47,20 +47,30 @@
     DLogInf(@"RFBSecNone dealloc");
 }
 
-- (BOOL)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Error:(NSError **)error {
-    //Error handling block
-	HandleError he = [HandleErrors handleErrorBlock];
-    
+- (void)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Completion:(RFBSecurityCompletion)completion {
     //3.8+ auth behaviour for "None" Security - Read SecurityResult message
     int version = [serverVersion intValue];
-    if (version >= MAX_VERSION) {
-        if ([socket readSecurityResult] == 1) { // failure - should never happen
-            NSString *header = NSLocalizedString(@"Security handshake with server failed, reason:  ", @"None Security 3.8+ Handshake Failed Header Error Text");
-            he(error,SocketErrorDomain,SocketConnectError,[header stringByAppendingString:[socket readString]]);
-            return NO;
-        }
+    if (version < MAX_VERSION) {
+        completion(YES, nil);
+        return;
     }
-	
-	return YES;
+    
+    __weak RFBSocket *blockSafeSocket = socket;
+    [socket readSecurityResultWithCompletion:^(BOOL ok, uint32_t result) {
+        if (ok && result == 0) {
+            completion(YES, nil);
+            return;
+        }
+        
+        // failure - should never happen
+        [blockSafeSocket readStringWithCompletion:^(NSString *reason) {
+            //Error handling block
+            HandleError he = [HandleErrors handleErrorBlock];
+            NSError *error = nil;
+            NSString *header = NSLocalizedString(@"Security handshake with server failed, reason:  ", @"None Security 3.8+ Handshake Failed Header Error Text");
+            he(&error,SocketErrorDomain,SocketConnectError,[header stringByAppendingString:reason]);
+            completion(NO, error);
+        }];
+    }];
 }
 @end
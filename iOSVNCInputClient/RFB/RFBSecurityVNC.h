@@ -18,6 +18,6 @@
 @interface RFBSecurityVNC : RFBSecurity
 + (uint8_t)type;
 + (NSString *)typeName;
-- (BOOL)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Error:(NSError **)error;
+- (void)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Completion:(RFBSecurityCompletion)completion;
 - (id)initWithPassword:(NSString *)password;
 @end
@@ -58,38 +58,53 @@
 	return RFBNAME;
 }
 
-- (BOOL)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Error:(NSError **)error {
-	if ([socket isDisconnected])
-		return NO;
-	
-	NSData *challenge = [socket readReceived:VNCAuthChallengeLength];
-	NSData *response = [Des encryptChallenge:challenge
-                                  withPassword:self.password];
-
-    //Error handling block
-	HandleError he = [HandleErrors handleErrorBlock];
-    
-	//Abort if invalid response
-	if (response.length == 0) {
-        DLogErr(@"RFBSecurityVNC - could not generate response with supplied challenge and password");
-        he(error, SecurityErrorDomain, SecurityEncryptError, NSLocalizedString(@"VNC Auth negotiation failed - unable to generate response", @"RFBSecurityVNC response generation error text"));
-		return NO;
-    }
-	
-    DLogInf(@"VNC Auth Response Sending");
-	[socket writeBytes:response];
-    
-    //Read SecurityResult
-    if ([socket readSecurityResult] == 1) { // failure
-        int version = [serverVersion intValue];
-        if (version >= MAX_VERSION) {//3.8+ auth failure behaviour
-            NSString *header = NSLocalizedString(@"Security handshake with server failed, reason:  ", @"VNC Security 3.8+ Handshake Failed Header Error Text");
-            he(error,SocketErrorDomain,SocketConnectError,[header stringByAppendingString:[socket readString]]);
-        } else //Version 3.3 and 3.7 auth failure behaviour
-            he(error,SocketErrorDomain,SocketConnectError,NSLocalizedString(@"Security handshake with server failed. Incorrect username and password?", @"VNC Security 3.3 3.7 Handshake Failed Error Text"));
-        return NO;
-    }
+- (void)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Completion:(RFBSecurityCompletion)completion {
+	if ([socket isDisconnected]) {
+		completion(NO, nil);
+		return;
+	}
 	
-	return YES;
+	__weak RFBSocket *blockSafeSocket = socket;
+	NSString *password = self.password;
+	[socket readLength:VNCAuthChallengeLength Completion:^(NSData *challenge) {
+		//Error handling block
+		HandleError he = [HandleErrors handleErrorBlock];
+		NSError *error = nil;
+		
+		NSData *response = (challenge.length == VNCAuthChallengeLength) ? [Des encryptChallenge:challenge withPassword:password] : nil;
+		
+		//Abort if invalid response
+		if (response.length == 0) {
+			DLogErr(@"RFBSecurityVNC - could not generate response with supplied challenge and password");
+			he(&error, SecurityErrorDomain, SecurityEncryptError, NSLocalizedString(@"VNC Auth negotiation failed - unable to generate response", @"RFBSecurityVNC response generation error text"));
+			completion(NO, error);
+			return;
+		}
+		
+		DLogInf(@"VNC Auth Response Sending");
+		[blockSafeSocket writeBytes:response];
+		
+		//Read SecurityResult
+		[blockSafeSocket readSecurityResultWithCompletion:^(BOOL ok, uint32_t result) {
+			if (ok && result == 0) {
+				completion(YES, nil);
+				return;
+			}
+			
+			// failure
+			int version = [serverVersion intValue];
+			if (ok && version >= MAX_VERSION) { //3.8+ auth failure behaviour
+				[blockSafeSocket readStringWithCompletion:^(NSString *reason) {
+					NSError *error = nil;
+					NSString *header = NSLocalizedString(@"Security handshake with server failed, reason:  ", @"VNC Security 3.8+ Handshake Failed Header Error Text");
+					he(&error,SocketErrorDomain,SocketConnectError,[header stringByAppendingString:reason]);
+					completion(NO, error);
+				}];
+			} else { //Version 3.3 and 3.7 auth failure behaviour
+				he(&error,SocketErrorDomain,SocketConnectError,NSLocalizedString(@"Security handshake with server failed. Incorrect username and password?", @"VNC Security 3.3 3.7 Handshake Failed Error Text"));
+				completion(NO, error);
+			}
+		}];
+	}];
 }
 @end
@@ -0,0 +1,44 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBSecurity.h"
+
+//VeNCrypt subtypes supported, all anonymous TLS (the X509 ones need a trust store)
+#define VENCRYPT_TLS_NONE 257
+#define VENCRYPT_TLS_VNC 258
+#define VENCRYPT_TLS_PLAIN 259
+
+@interface RFBSecurityVeNCrypt : RFBSecurity
+//TLS sessions are cached and resumed under this key, eg. the profile's "address:port".  Default the connected host and port
+@property (copy, nonatomic) NSString *sessionCacheKey;
+//TLS here is anonymous so a man in the middle sees TLSPlain's password in the clear.  NO (default) uses TLSPlain only when
+//it's the only usable subtype the server offers, YES ranks it right after TLSVnc
+@property (assign, nonatomic) BOOL allowPlainCredentials;
+@property (assign, nonatomic, readonly) uint32_t subtype; //Picked with the server, 0 until then
+@property (assign, nonatomic, readonly) BOOL resumedSession; //TLS handshake resumed a cached session
+
+//The session cache lasts as long as the process.  Save the last session for a key, eg. with the profile, and restore
+//it before the next connect to resume across launches.  nil if there's none
++ (NSDictionary *)savedSessionForCacheKey:(NSString *)cacheKey;
++ (void)restoreSavedSession:(NSDictionary *)savedSession ForCacheKey:(NSString *)cacheKey;
+
++ (uint8_t)type;
++ (NSString *)typeName;
+- (void)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Completion:(RFBSecurityCompletion)completion;
+//Password only (TLSVnc) if set, else none (TLSNone).  Username and password (TLSPlain) if both are set and allowPlainCredentials
+//or the server offers nothing else usable
+- (id)initWithUsername:(NSString *)username Password:(NSString *)password;
+@end
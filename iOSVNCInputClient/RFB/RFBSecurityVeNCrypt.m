@@ -0,0 +1,211 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+/**
+ * VeNCrypt: picks a TLS subtype with the server, runs the rest of the handshake inside TLS, then the subtype's own auth.
+ */
+
+#import "RFBSecurityVeNCrypt.h"
+#import "RFBSecurityNone.h"
+#import "RFBSecurityVNC.h"
+#import "RFBSocket.h"
+#import "RFBTLSSession.h"
+#import "VersionMsg.h"
+#import "HandleErrors.h"
+
+#define SECURITY__VENCRYPT 19
+#define RFBNAME @"VeNCrypt TLS"
+#define VENCRYPT_MAJOR 0
+#define VENCRYPT_MINOR 2
+
+@interface RFBSecurityVeNCrypt()
+@property (copy,nonatomic) NSString *username;
+@property (copy,nonatomic) NSString *password;
+@property (assign, nonatomic, readwrite) uint32_t subtype;
+@property (assign, nonatomic, readwrite) BOOL resumedSession;
+@end
+
+@implementation RFBSecurityVeNCrypt
+//override of abstract superclass
+- (id)init {
+	return [self initWithUsername:nil Password:nil];
+}
+
+- (id)initWithUsername:(NSString *)username Password:(NSString *)password {
+	self = [super init];
+	if (self) {
+		_username = username;
+		_password = password;
+	}
+	return self;
+}
+
+- (void)dealloc {
+    DLogInf(@"RFBSecurityVeNCrypt dealloc");
+}
+
++ (uint8_t)type {
+	return SECURITY__VENCRYPT;
+}
+
++ (NSString *)typeName {
+	return RFBNAME;
+}
+
+#pragma mark - Authentication - Public
+- (void)performAuthWithSocket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Completion:(RFBSecurityCompletion)completion {
+	HandleError he = [HandleErrors handleErrorBlock];
+	void (^fail)(NSString *) = ^(NSString *message) {
+		NSError *error = nil;
+		he(&error,SocketErrorDomain,SocketSecurityError,message);
+		completion(NO, error);
+	};
+	
+	// 1. VeNCrypt version, 0.2 is the only one with the 32 bit subtypes
+	__weak RFBSecurityVeNCrypt *blockSafeSelf = self;
+	__weak RFBSocket *blockSafeSocket = socket;
+	[socket readLength:2 Completion:^(NSData *versionWrapped) {
+		const uint8_t *version = versionWrapped.bytes;
+		if (versionWrapped.length != 2 || version[0] != VENCRYPT_MAJOR || version[1] < VENCRYPT_MINOR) {
+			DLogErr(@"VeNCrypt version: %@", versionWrapped);
+			fail(NSLocalizedString(@"Server's VeNCrypt version isn't supported", @"VeNCrypt version error text"));
+			return;
+		}
+		uint8_t clientVersion[2] = {VENCRYPT_MAJOR, VENCRYPT_MINOR};
+		[blockSafeSocket writeBytes:[NSData dataWithBytes:clientVersion length:sizeof(clientVersion)]];
+		
+		[blockSafeSocket readLength:1 Completion:^(NSData *versionAck) {
+			if (versionAck.length != 1 || ((const uint8_t *)versionAck.bytes)[0] != 0) {
+				fail(NSLocalizedString(@"Server's VeNCrypt version isn't supported", @"VeNCrypt version error text"));
+				return;
+			}
+			
+			// 2. Subtypes offered, pick one
+			[blockSafeSocket readLength:1 Completion:^(NSData *countWrapped) {
+				NSUInteger count = countWrapped.length == 1 ? ((const uint8_t *)countWrapped.bytes)[0] : 0;
+				if (count == 0) {
+					fail(NSLocalizedString(@"Server offered no VeNCrypt subtypes", @"VeNCrypt subtypes error text"));
+					return;
+				}
+				[blockSafeSocket readLength:count * 4 Completion:^(NSData *subtypesWrapped) {
+					uint32_t subtype = [blockSafeSelf pickSubtype:subtypesWrapped];
+					if (subtype == 0) {
+						DLogErr(@"VeNCrypt subtypes: %@", subtypesWrapped);
+						fail(NSLocalizedString(@"Server requires a VeNCrypt subtype that isn't supported (X509 certificates?)", @"VeNCrypt no subtype error text"));
+						return;
+					}
+					blockSafeSelf.subtype = subtype;
+					uint32_t subtypeWire = CFSwapInt32HostToBig(subtype);
+					[blockSafeSocket writeBytes:[NSData dataWithBytes:&subtypeWire length:sizeof(subtypeWire)]];
+					
+					[blockSafeSocket readLength:1 Completion:^(NSData *subtypeAck) {
+						if (subtypeAck.length != 1 || ((const uint8_t *)subtypeAck.bytes)[0] != 1) {
+							fail(NSLocalizedString(@"Server refused the VeNCrypt subtype", @"VeNCrypt subtype refused error text"));
+							return;
+						}
+						
+						// 3. TLS, resuming the last session with this server if there is one
+						RFBTLSSession *tls = [[RFBTLSSession alloc] initClientWithCacheKey:[blockSafeSelf cacheKeyForSocket:blockSafeSocket]];
+						[blockSafeSocket startTLS:tls Completion:^(BOOL ok) {
+							if (!ok) {
+								fail(NSLocalizedString(@"TLS handshake with server failed", @"VeNCrypt TLS handshake error text"));
+								return;
+							}
+							blockSafeSelf.resumedSession = [tls isResumed];
+							DLogInf(@"VeNCrypt TLS %@", blockSafeSelf.resumedSession ? @"resumed" : @"full handshake");
+							
+							// 4. Subtype's auth, inside TLS
+							[blockSafeSelf authenticateSubtype:subtype Socket:blockSafeSocket ForVersion:serverVersion Completion:completion];
+						}];
+					}];
+				}];
+			}];
+		}];
+	}];
+}
+
+#pragma mark - Saved Sessions - Public
++ (NSDictionary *)savedSessionForCacheKey:(NSString *)cacheKey {
+	return [RFBTLSSession savedSessionForKey:cacheKey];
+}
+
++ (void)restoreSavedSession:(NSDictionary *)savedSession ForCacheKey:(NSString *)cacheKey {
+	if ([RFBTLSSession restoreSavedSession:savedSession ForKey:cacheKey])
+		DLogInf(@"Restored saved TLS session for %@", cacheKey);
+}
+
+#pragma mark - Authentication - Private
+//Most preferred subtype the server offers, 0 if none supported
+- (uint32_t)pickSubtype:(NSData *)subtypesWrapped {
+	//Plain goes last unless allowed, the TLS is anonymous so it's only worth the exposure when nothing else will do
+	BOOL hasCredentials = self.username.length > 0 && self.password.length > 0;
+	uint32_t preferred[3];
+	NSUInteger preferredCount = 0;
+	if (self.password.length > 0) {
+		preferred[preferredCount++] = VENCRYPT_TLS_VNC;
+		if (hasCredentials && self.allowPlainCredentials)
+			preferred[preferredCount++] = VENCRYPT_TLS_PLAIN;
+		preferred[preferredCount++] = VENCRYPT_TLS_NONE;
+		if (hasCredentials && !self.allowPlainCredentials)
+			preferred[preferredCount++] = VENCRYPT_TLS_PLAIN;
+	} else {
+		preferred[preferredCount++] = VENCRYPT_TLS_NONE;
+		preferred[preferredCount++] = VENCRYPT_TLS_VNC;
+	}
+	
+	const uint32_t *offered = subtypesWrapped.bytes;
+	NSUInteger offeredCount = subtypesWrapped.length / 4;
+	for (NSUInteger i = 0; i < preferredCount; i++) {
+		for (NSUInteger j = 0; j < offeredCount; j++) {
+			if (CFSwapInt32BigToHost(offered[j]) == preferred[i])
+				return preferred[i];
+		}
+	}
+	return 0;
+}
+
+- (NSString *)cacheKeyForSocket:(RFBSocket *)socket {
+	if (self.sessionCacheKey)
+		return self.sessionCacheKey;
+	return [NSString stringWithFormat:@"%@:%u", [socket connectedHost], [socket connectedPort]];
+}
+
+//VeNCrypt servers always send SecurityResult and a failure reason, whatever the RFB version
+- (void)authenticateSubtype:(uint32_t)subtype Socket:(RFBSocket *)socket ForVersion:(VersionMsg *)serverVersion Completion:(RFBSecurityCompletion)completion {
+	VersionMsg *resultVersion = [serverVersion intValue] < MAX_VERSION ? [[VersionMsg alloc] initWithVersion:MAX_VERSION] : serverVersion;
+	switch (subtype) {
+		case VENCRYPT_TLS_VNC:
+			[[[RFBSecurityVNC alloc] initWithPassword:self.password] performAuthWithSocket:socket ForVersion:resultVersion Completion:completion];
+			break;
+		case VENCRYPT_TLS_PLAIN: {
+			//U32 username length, U32 password length, username, password
+			NSData *username = [self.username dataUsingEncoding:NSUTF8StringEncoding];
+			NSData *password = [self.password dataUsingEncoding:NSUTF8StringEncoding];
+			uint32_t lengths[2] = {CFSwapInt32HostToBig((uint32_t)username.length), CFSwapInt32HostToBig((uint32_t)password.length)};
+			NSMutableData *credentials = [NSMutableData dataWithCapacity:sizeof(lengths) + username.length + password.length];
+			[credentials appendBytes:lengths length:sizeof(lengths)];
+			[credentials appendData:username];
+			[credentials appendData:password];
+			[socket writeBytes:credentials];
+			//Fall through for SecurityResult
+		}
+		case VENCRYPT_TLS_NONE:
+		default:
+			[[[RFBSecurityNone alloc] init] performAuthWithSocket:socket ForVersion:resultVersion Completion:completion];
+			break;
+	}
+}
+@end
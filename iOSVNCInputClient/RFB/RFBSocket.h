@@ -35,6 +35,14 @@ typedef struct {
 }KeyMsg;
 
 
+#define ClientCutTextMsg_Size 8 //Followed by length bytes of Latin-1 text
+#define ClientCutText_MsgType 6
+typedef struct {
+    uint8_t msgType;    //ClientCutText_MsgType
+    uint8_t padding[3];
+    uint32_t length;
+}ClientCutTextMsg;
+
 #define PixelFormatMsg_Size 16
 typedef struct {
     uint8_t bitsPerPixel;
@@ -47,33 +55,107 @@ typedef struct {
     uint8_t redShift;
     uint8_t greenShift;
     uint8_t blueShift;
-    uint16_t paddingTwoBytes;
-    uint8_t paddingOneByte;
+    uint8_t padding[3];
 }PixelFormatMsg;
 
-#define PixelFormatClientMsg_Size 19
+#define PixelFormatClientMsg_Size 20
 #define PixelFormatClient_MsgType 0
 typedef struct {
     uint8_t msgType;    //Must be PixelFormatClient_MsgType
-    uint8_t paddingOneByte;
-    uint16_t paddingTwoBytes;
+    uint8_t padding[3];
     PixelFormatMsg pixelFormat;
 }PixelFormatClientMsg;
 
+//The structs are written to the socket as is, so their layout must match the wire format exactly
+_Static_assert(sizeof(PointerMsg) == PointerMsg_Size, "PointerMsg does not match its wire size");
+_Static_assert(offsetof(PointerMsg, xPosition) == 2 && offsetof(PointerMsg, yPosition) == 4, "PointerMsg field offsets");
+_Static_assert(sizeof(KeyMsg) == KeyMsg_Size, "KeyMsg does not match its wire size");
+_Static_assert(offsetof(KeyMsg, keyX11) == 4, "KeyMsg field offsets");
+_Static_assert(sizeof(ClientCutTextMsg) == ClientCutTextMsg_Size, "ClientCutTextMsg does not match its wire size");
+_Static_assert(sizeof(PixelFormatMsg) == PixelFormatMsg_Size, "PixelFormatMsg does not match its wire size");
+_Static_assert(sizeof(PixelFormatClientMsg) == PixelFormatClientMsg_Size, "PixelFormatClientMsg does not match its wire size");
+
+//Serializers, fill in every byte with multi byte fields in network (big endian) order
+static inline PointerMsg RFBPointerMsgMake(uint8_t buttons, uint16_t x, uint16_t y) {
+    PointerMsg msg;
+    msg.msgType = PointerEvt_MsgType;
+    msg.btnMask = buttons;
+    msg.xPosition = CFSwapInt16HostToBig(x);
+    msg.yPosition = CFSwapInt16HostToBig(y);
+    return msg;
+}
+
+static inline KeyMsg RFBKeyMsgMake(BOOL down, uint32_t keysym) {
+    KeyMsg msg;
+    msg.msgType = KeyEvt_MsgType;
+    msg.downFlag = down ? 1 : 0;
+    msg.padding = 0;
+    msg.keyX11 = CFSwapInt32HostToBig(keysym);
+    return msg;
+}
+
+static inline ClientCutTextMsg RFBClientCutTextMsgMake(uint32_t length) {
+    ClientCutTextMsg msg;
+    msg.msgType = ClientCutText_MsgType;
+    msg.padding[0] = msg.padding[1] = msg.padding[2] = 0;
+    msg.length = CFSwapInt32HostToBig(length);
+    return msg;
+}
+
 /*RFB Protocol Structs End*/
 
-@class VersionMsg, RFBKeyEvent;
+@class VersionMsg, RFBKeyEvent, RFBInputLatency, RFBEventLoop, RFBTLSSession;
+
+//Asynchronous read completions.  Called on the socket's serial delegate queue, in the order the reads were requested.
+//ok/nil result = read failed, timed out or the socket disconnected
+typedef void (^RFBReadCompletion)(NSData *data);
+typedef void (^RFBReadIntCompletion)(BOOL ok, uint32_t value);
+typedef void (^RFBReadStringCompletion)(NSString *string);
 
 @interface RFBSocket : NSObject
+#pragma mark - Properties - Public
+//Write coalescing.  Pointer motion is gathered for up to coalescingWindow seconds, or coalescingThreshold bytes, and sent as one write.
+//Button changes, keys and handshake writes are sent straight away along with anything gathered before them.  0 = off (default)
+@property (assign, nonatomic) NSTimeInterval coalescingWindow;
+@property (assign, nonatomic) NSUInteger coalescingThreshold;
+//Called on the delegate queue whenever the last outstanding write has been written out
+@property (copy, nonatomic) dispatch_block_t writesCompletedHandler;
+//Flow control.  More than writeHighWaterMark bytes handed to the socket but not yet written out = degraded, until back down
+//to half of it.  0 = off (default).  The handler is called on the delegate queue whenever the state changes
+@property (assign, nonatomic) NSUInteger writeHighWaterMark;
+@property (copy, nonatomic) void (^writeDegradedHandler)(BOOL degraded);
+//Per stage latency of events sent through this socket, see stampNextEventCapturedAt:EnqueuedAt:
+@property (strong, nonatomic, readonly) RFBInputLatency *inputLatency;
+
 #pragma mark - Init, Connection
 -(id)initWithAddress:(NSString *)address Port:(int)port;
+//Socket I/O and reads run on a queue from eventLoop, shared with other connections.  nil = a queue of its own
+-(id)initWithAddress:(NSString *)address Port:(int)port EventLoop:(RFBEventLoop *)eventLoop;
 -(BOOL)connect:(NSError **)connErr;
 -(void)disconnect;
 
+#pragma mark - Stats
+//CPU time spent in asynchronous read completions, ie. client side handshake work (seconds)
+-(NSTimeInterval)readCompletionCPUTime;
+-(unsigned long long)bytesReceived;
+-(unsigned long long)bytesDrained; //Server messages consumed by the drain, see startDrainingServerMessages
+-(unsigned long long)messagesDrained;
+//Socket writes avoided by coalescing, and the average time a coalesced message waited (seconds)
+-(unsigned long long)writesSavedByCoalescing;
+-(NSTimeInterval)averageCoalescingDelay;
+-(NSTimeInterval)maxCoalescingDelay;
+-(unsigned long long)messagesEncoded;
+-(NSUInteger)sendBuffersAllocated; //Pooled send buffers ever allocated.  Stays small once the pool has warmed up
+
 #pragma mark - GCDAsyncSocket underlying Socket Options
 -(BOOL)setTCPNoDelay:(BOOL)on;
+//Run everything from here on through tls, eg. once VeNCrypt has picked a TLS subtype.  Call when the server is waiting
+//for the client to speak, so nothing unread is buffered.  Completion is called on the delegate queue once the handshake
+//is done, ok = NO if it failed or the socket disconnected first.  Reads queued meanwhile wait for it
+-(void)startTLS:(RFBTLSSession *)tls Completion:(void (^)(BOOL ok))completion;
 
 #pragma mark - Read methods
+//Blocking, don't call from a read completion.  Data from the server is buffered as it arrives, so reads may complete straight away.
 -(NSString *)readString;
 -(NSData *)readReceived:(int)length;
 -(uint16_t)readShort;
@@ -81,16 +163,38 @@ typedef struct {
 -(VersionMsg *)readVersion;
 -(NSData *)readSecurity;
 -(uint32_t)readSecurityResult;
--(void)readAndDiscard;
+-(void)readAndDiscard; //Drop received data nobody has asked for
+//Keep consuming server messages (FramebufferUpdate, Bell, etc.) so the server never stalls on a full receive window
+-(void)startDrainingServerMessages;
+
+#pragma mark - Asynchronous read methods
+//Non-blocking equivalents of the read methods above.  Every completion is called exactly once, pending reads fail on disconnect.
+-(void)readLength:(NSUInteger)length Completion:(RFBReadCompletion)completion;
+-(void)readShortWithCompletion:(RFBReadIntCompletion)completion;
+-(void)readIntWithCompletion:(RFBReadIntCompletion)completion;
+-(void)readStringWithCompletion:(RFBReadStringCompletion)completion;
+-(void)readVersionWithCompletion:(void (^)(VersionMsg *version))completion;
+-(void)readSecurityWithCompletion:(RFBReadCompletion)completion;
+-(void)readSecurityResultWithCompletion:(RFBReadIntCompletion)completion;
 
 #pragma mark - Write methods
 -(void)writeBytes:(NSData *)wrapper;
+//Encode length bytes straight into a pooled send buffer, then write them at once like writeBytes:.  The encoder fills
+//every byte and is called on the caller's thread, outside the socket lock.  Encoder returns NO = nothing is sent
+-(BOOL)writeLength:(NSUInteger)length Encoder:(BOOL (^)(uint8_t *bytes))encoder;
+-(void)flushWrites; //Send anything waiting on the coalescing window now
+-(BOOL)hasOutstandingWrites; //Written, or waiting to be, but not yet taken by the network stack
+-(NSUInteger)outstandingWriteBytes;
+-(BOOL)isWriteDegraded; //See writeHighWaterMark
+//Latency stamps (mach_absolute_time) for the next message encoded, recorded in inputLatency once it has been written out
+-(void)stampNextEventCapturedAt:(uint64_t)capturedAt EnqueuedAt:(uint64_t)enqueuedAt;
 
 -(void)writeVersion:(int)version;
 -(void)writeSecurity:(uint8_t)securityType;
 
 #pragma mark - RFB Event Methods
 -(NSArray *)performInitialization;
+-(void)performInitializationWithCompletion:(void (^)(NSArray *serverDetails))completion;
 //-(void)sendSetPixelFormat:(PixelFormatMsg *)pfMsg;
 
 -(void)sendPointerEventWithButtons:(uint8_t)btns XPos:(int)x YPos:(int)y;
@@ -98,10 +202,25 @@ typedef struct {
 -(void)sendMultiplePointerEventsForIterations:(int)iterations setButtons:(uint8_t)buttons clearButtons:(uint8_t)clearBtns XPos:(int)x YPos:(int)y;
 
 -(void)sendKeyWithEvent:(RFBKeyEvent *)keyEvent;
+-(void)sendKeyPress:(unichar)keyPress; //Key down and up
+//Type a whole string, a key down and up per character.  chunkLength 0 = everything in one write, otherwise chunkLength
+//characters per write every interval seconds, for servers that drop fast input.  Keys sent meanwhile go out between chunks
+-(void)sendText:(NSString *)text ChunkLength:(NSUInteger)chunkLength Interval:(NSTimeInterval)interval;
+//Put text on the server's clipboard with one ClientCutText message, then press and release pasteKeysyms (NSNumbers, eg. Control, V)
+//if given.  Sent in bounded chunks, other events wait until it's done.  ClientCutText is Latin-1 only, text that isn't is
+//refused (type it instead).  One paste at a time.  Completion (optional) is called on the delegate queue, sent = NO if
+//refused, busy or disconnected first
+-(void)sendCutText:(NSString *)text PasteKeysyms:(NSArray *)pasteKeysyms Completion:(void (^)(BOOL sent))completion;
++(BOOL)canSendAsCutText:(NSString *)text; //All Latin-1.  Scans in bounded chunks, no copy of the text
 -(void)sendKeyDown:(int)keysym;
 -(void)sendKeyUp:(int)keysym;
+//Already encoded KeyMsgs, eg. RFBKeyMacro messages, copied into the send buffer and written at once
+-(void)sendKeyMessages:(NSData *)messages;
 
 #pragma mark - Wrapper Getters for some CocoaAsyncSocket properties - Public
+//Serial queue reads complete on.  On an event loop the socket's own work runs on it too, so calls into the socket from it
+//never dispatch_sync to another queue
+-(dispatch_queue_t)delegateQueue;
 -(BOOL)isConnected;
 -(BOOL)isDisconnected;
 -(NSString *)connectedHost;
@@ -20,28 +20,164 @@
 #import <arpa/inet.h> //htons, ntohs, etc
 #import <netinet/in.h> //IPPROTO_TCP
 #import <netinet/tcp.h> //TCP_NODELAY
+#import <mach/mach.h> //thread_info
+#import <mach/mach_time.h> //mach_absolute_time
 
 #import "RFBConnection.h"
 #import "RFBMessage.h"
 #import "VersionMsg.h"
+#import "RFBReceiveBuffer.h"
+#import "RFBMessageDrain.h"
+#import "RFBInputLatency.h"
+#import "RFBEventLoop.h"
+#import "RFBTLSSession.h"
 
 #import "RFBSecurityInvalid.h"
 
 #import "RFBKeyEvent.h"
 #import "KeyMapping.h"
+#import "keysymdef.h"
 
 #define TIMEOUT 10 //seconds
+#define RECEIVE_TAG -1 //Tag of the socket read that feeds the receive buffer
+#define WRITE_TAG 1 //Tag of socket writes of caller supplied data, eg. handshake
+#define CUT_TEXT_TAG -2 //Tag of ClientCutText chunk writes
+#define TLS_TAG -3 //Tag of TLS handshake and alert writes, not caller data
+#define SEND_BUFFER_TAG 2 //Tag of the first send buffer write.  Each one after counts up from here, to match latency samples to completions
+#define MAX_FREE_SEND_BUFFERS 8
+#define MAX_LATENCY_SAMPLES 512 //Events encoded but not yet written out, further events go unsampled
+#define MAX_POOLED_SEND_BUFFER (64 * 1024) //Bigger send buffers, eg. from typing a long text, aren't kept once written
+#define TEXT_DECODE_CHUNK 256 //UTF16 units copied out of a string at a time
+#define CUT_TEXT_CHUNK (64 * 1024) //Bytes of text per write while pasting
+#define CUT_TEXT_CHUNKS_IN_FLIGHT 2 //Bounds the memory a paste takes, however long the text
+#define RECEIVE_CHUNK 16384 //Max bytes taken from the socket per read
+#define MAX_READ_LENGTH (16 * 1024 * 1024) //Sanity limit for server supplied lengths, eg. strings
+#define MAX_UNCLAIMED_LENGTH (256 * 1024) //Received data nobody has asked for is dropped past this, before the message drain starts
+#define SERVERINIT_LENGTH 20 //U16 width, height + 16 byte pixel format, excluding name
+#define DEFAULT_COALESCING_THRESHOLD 1400 //bytes, about one TCP segment
+#define COALESCING_TIMER_LEEWAY (1 * NSEC_PER_MSEC)
 
-@interface RFBSocket()
+//Identifies a socket's own delegate queue, see isOnDelegateQueue
+static char RFBSocketDelegateQueueKey;
+
+//CPU time (user + system) used so far by the calling thread, in seconds
+//One pass over text, a chunk at a time so nothing the size of the text is allocated.  Length in bytes once CRLF and lone
+//CR line endings become LF, as cut text wants.  NO if a character is outside Latin-1
+static BOOL scanCutText(NSString *text, NSUInteger *encodedLength) {
+	unichar chars[TEXT_DECODE_CHUNK];
+	NSUInteger length = text.length, crlfs = 0;
+	unichar previous = 0;
+	for (NSUInteger location = 0; location < length; location += TEXT_DECODE_CHUNK) {
+		NSUInteger units = MIN(TEXT_DECODE_CHUNK, length - location);
+		[text getCharacters:chars range:NSMakeRange(location, units)];
+		for (NSUInteger i = 0; i < units; i++) {
+			if (chars[i] > 0xFF)
+				return NO;
+			if (chars[i] == '\n' && previous == '\r')
+				crlfs++;
+			previous = chars[i];
+		}
+	}
+	if (encodedLength)
+		*encodedLength = length - crlfs;
+	return YES;
+}
+
+static NSTimeInterval threadCPUTime(void) {
+	thread_basic_info_data_t info;
+	mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+	mach_port_t thread = mach_thread_self();
+	kern_return_t result = thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info, &count);
+	mach_port_deallocate(mach_task_self(), thread);
+	if (result != KERN_SUCCESS)
+		return 0;
+	return (info.user_time.seconds + info.system_time.seconds) + (info.user_time.microseconds + info.system_time.microseconds) / 1000000.0;
+}
+
+//Parses a field straight out of the receive buffer once enough bytes have arrived.  nil buffer = read failed
+typedef void (^RFBBufferedRead)(RFBReceiveBuffer *buffer);
+
+//A read waiting for its bytes to arrive
+@interface RFBPendingRead : NSObject
+@property (assign, nonatomic) NSUInteger length;
+@property (copy, nonatomic) RFBBufferedRead handler;
+@property (assign, nonatomic) CFAbsoluteTime queuedAt;
+@end
+
+@implementation RFBPendingRead
+@end
+
+//Latency stamps of an event encoded into the send buffer written with tag
+typedef struct {
+	long tag;
+	uint64_t capturedAt;
+	uint64_t enqueuedAt;
+	uint64_t encodedAt;
+} RFBLatencySample;
+
+@interface RFBSocket() {
+	//Guarded by @synchronized(self).  Oldest first, completed as their send buffer writes complete
+	RFBLatencySample _latencySamples[MAX_LATENCY_SAMPLES];
+	NSUInteger _latencySampleHead;
+	NSUInteger _latencySampleCount;
+	uint64_t _nextCapturedAt; //Stamps for the next message encoded
+	uint64_t _nextEnqueuedAt;
+}
 @property (assign, nonatomic) int version;
 
 @property (copy, nonatomic) NSString *address; //ip or domain name
 @property (assign, nonatomic) int port;
 @property (strong, nonatomic) GCDAsyncSocket *socket;
 
-//Read temp data buffers for CocoaAsyncSocket to read data from
-@property (strong, nonatomic) NSData *readBuffer;
-@property (assign, nonatomic) BOOL requestReadyOrTimedOut;
+//Everything the server sends is read into the receive buffer as it arrives, reads are parsed off its read cursor
+@property (strong, nonatomic) RFBReceiveBuffer *receiveBuffer;
+@property (strong, nonatomic) NSMutableData *socketReadBuffer; //Reused by GCDAsyncSocket for each receive read
+//Reads waiting on data, oldest first.  Only served from the delegate queue
+@property (strong, nonatomic) NSMutableArray *pendingReads;
+@property (assign, nonatomic) BOOL draining; //Serving pending reads, reads queued meanwhile are picked up by the same loop
+//Consumes server messages once the handshake is done, whenever no read is pending
+@property (strong, nonatomic) RFBMessageDrain *messageDrain;
+@property (assign, nonatomic) uint8_t serverBitsPerPixel; //From ServerInit
+@property (assign, nonatomic) dispatch_queue_t delegateQueue;
+@property (assign, nonatomic) BOOL closed; //Disconnected after a connect attempt, further reads can never complete
+@property (assign, nonatomic) NSTimeInterval readCompletionCPUTime;
+//Once set, received data is decrypted into the receive buffer and every write is encrypted.  Set once, on the delegate queue
+@property (strong, nonatomic) RFBTLSSession *tls;
+@property (strong, nonatomic) NSMutableData *tlsPlaintext; //Reused for each receive
+//Completes when the TLS handshake does.  Guarded by @synchronized(self.pendingReads), failed along with the pending reads
+@property (strong, nonatomic) RFBPendingRead *tlsHandshakeRead;
+
+//Write coalescing.  Guarded by @synchronized(self) so writes reach the socket in the order they were made
+//Messages are encoded straight into a pooled send buffer, which is written as is and recycled once written out
+@property (strong, nonatomic) NSMutableData *sendBuffer; //Being filled, eg. waiting for the coalescing window to close
+@property (strong, nonatomic) NSMutableArray *inFlightWrites; //Data handed to the socket, oldest first.  Writes complete in order
+@property (strong, nonatomic) NSMutableArray *freeSendBuffers;
+@property (assign, nonatomic) NSUInteger sendBuffersAllocated;
+@property (assign, nonatomic) unsigned long long messagesEncoded;
+@property (assign, nonatomic) long nextSendBufferTag;
+@property (strong, nonatomic) RFBInputLatency *inputLatency;
+@property (assign, nonatomic) dispatch_source_t coalescingTimer;
+@property (assign, nonatomic) NSUInteger pendingMessages; //Coalesced messages in sendBuffer
+@property (assign, nonatomic) CFAbsoluteTime pendingQueuedAtSum; //Sum of their queue times, for the average delay
+@property (assign, nonatomic) CFAbsoluteTime firstPendingQueuedAt;
+@property (assign, nonatomic) uint8_t lastButtonMask; //Button changes are sent straight away
+@property (assign, nonatomic) unsigned long long coalescedMessages; //Messages that went through the coalescer
+@property (assign, nonatomic) unsigned long long coalescedFlushes; //Socket writes made for them
+@property (assign, nonatomic) NSTimeInterval coalescingDelayTotal;
+@property (assign, nonatomic) NSTimeInterval maxCoalescingDelay;
+@property (assign, nonatomic) NSUInteger outstandingWrites; //Handed to the socket, not yet written out
+@property (assign, nonatomic) NSUInteger outstandingWriteBytes;
+@property (assign, nonatomic) BOOL writeDegraded;
+
+//ClientCutText paste in progress.  Guarded by @synchronized(self), the send buffer is held back until it's done
+@property (copy, nonatomic) NSString *cutText;
+@property (assign, nonatomic) NSUInteger cutTextLocation; //Next character to encode
+@property (assign, nonatomic) NSUInteger cutTextLength; //Bytes once line endings are converted, as sent in the header
+@property (assign, nonatomic) NSUInteger cutTextEncoded; //Bytes encoded so far
+@property (assign, nonatomic) BOOL cutTextHeaderSent;
+@property (assign, nonatomic) NSUInteger cutTextChunksInFlight;
+@property (strong, nonatomic) NSArray *cutTextPasteKeysyms;
+@property (copy, nonatomic) void (^cutTextCompletion)(BOOL sent);
 @end
 
 @implementation RFBSocket 
@@ -52,12 +188,38 @@
 }
 
 -(id)initWithAddress:(NSString *)address Port:(int)port {
+	return [self initWithAddress:address Port:port EventLoop:nil];
+}
+
+-(id)initWithAddress:(NSString *)address Port:(int)port EventLoop:(RFBEventLoop *)eventLoop {
 	if ((self = [super init]) ) {
 		_version = 0;
 		_address = address;
 		_port = port;
-        dispatch_queue_t socketQ = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0);
-		_socket = [[GCDAsyncSocket alloc] initWithDelegate:self delegateQueue:socketQ];
+		_receiveBuffer = [[RFBReceiveBuffer alloc] init];
+		_socketReadBuffer = [NSMutableData dataWithCapacity:RECEIVE_CHUNK];
+		_pendingReads = [NSMutableArray array];
+		//Serial, so reads are served one at a time and in order
+		if (eventLoop) {
+			_delegateQueue = [eventLoop createConnectionQueueWithLabel:"RFBSocket.delegate"];
+		} else {
+			_delegateQueue = dispatch_queue_create("RFBSocket.delegate", DISPATCH_QUEUE_SERIAL);
+			dispatch_set_target_queue(_delegateQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+		}
+		dispatch_queue_set_specific(_delegateQueue, &RFBSocketDelegateQueueKey, (__bridge void *)self, NULL);
+		//On an event loop the socket's own work shares the delegate queue too.  A socket queue of its own would target
+		//the same worker, and the socket's dispatch_syncs to it from the delegate queue would deadlock
+		_socket = [[GCDAsyncSocket alloc] initWithDelegate:self
+											 delegateQueue:_delegateQueue
+											   socketQueue:(eventLoop ? _delegateQueue : NULL)];
+		_coalescingWindow = 0; //Off until asked for
+		_coalescingThreshold = DEFAULT_COALESCING_THRESHOLD;
+		_sendBuffer = [NSMutableData dataWithCapacity:DEFAULT_COALESCING_THRESHOLD];
+		_sendBuffersAllocated = 1;
+		_nextSendBufferTag = SEND_BUFFER_TAG;
+		_inputLatency = [[RFBInputLatency alloc] init];
+		_inFlightWrites = [NSMutableArray arrayWithCapacity:MAX_FREE_SEND_BUFFERS];
+		_freeSendBuffers = [NSMutableArray arrayWithCapacity:MAX_FREE_SEND_BUFFERS];
 	}
 	return self;
 }
@@ -66,6 +228,12 @@
 	DLogInf(@"BWRFBStream dealloc");
 	[self disconnect];
     self.socket = nil;
+    if (_coalescingTimer) {
+        dispatch_source_cancel(_coalescingTimer);
+        dispatch_release(_coalescingTimer);
+    }
+    if (_delegateQueue)
+        dispatch_release(_delegateQueue);
 }
 
 #pragma mark - Socket Options - Public
@@ -83,62 +251,413 @@
     return ok;
 }
 
-#pragma mark - Read Methods - Private
--(uint8_t)readByte {
-	NSData *received =[self readReceived:1];
-	if (!received || received.length == 0)
-		return 0; //Read failed or empty
-	const uint8_t *recvBytes = [received bytes];
-	return recvBytes[0];
+-(void)startTLS:(RFBTLSSession *)tls Completion:(void (^)(BOOL ok))completion {
+	RFBPendingRead *handshakeRead = [[RFBPendingRead alloc] init];
+	handshakeRead.handler = ^(RFBReceiveBuffer *buffer) {
+		completion(buffer != nil);
+	};
+	handshakeRead.queuedAt = CFAbsoluteTimeGetCurrent();
+	
+	[self performOnDelegateQueue:^{
+		if (!tls || self.tls || [self.receiveBuffer bytesAvailable] > 0) { //The server speaks second, anything unread isn't TLS
+			DLogErr(@"Can't start TLS, %lu bytes unread", (unsigned long)[self.receiveBuffer bytesAvailable]);
+			handshakeRead.handler(nil);
+			return;
+		}
+		BOOL queued = NO;
+		@synchronized(self.pendingReads) {
+			if (!self.closed) {
+				self.tlsHandshakeRead = handshakeRead;
+				queued = YES;
+			}
+		}
+		if (!queued) {
+			handshakeRead.handler(nil);
+			return;
+		}
+		
+		BOOL started;
+		@synchronized(self) {
+			self.tls = tls;
+			self.tlsPlaintext = [NSMutableData dataWithCapacity:RECEIVE_CHUNK];
+			started = [tls startHandshake];
+			[self writeTLSCiphertext]; //ClientHello
+		}
+		if (!started)
+			[self.socket disconnect]; //Fails the handshake read
+	}];
+}
+
+#pragma mark - Stats - Public
+-(unsigned long long)bytesReceived {
+	return [self.receiveBuffer bytesReceived];
+}
+
+-(unsigned long long)bytesDrained {
+	return [self.messageDrain bytesDrained];
+}
+
+-(unsigned long long)messagesDrained {
+	return [self.messageDrain messagesDrained];
 }
 
--(uint32_t)readInt {
-	NSData *received = [self readReceived:4]; //4 bytes, U32
-	if (!received || received.length == 0)
-		return 0; //Read failed or empty
-    const uint32_t *recvBytes = [received bytes];
-    return ntohl(*recvBytes);
+-(unsigned long long)writesSavedByCoalescing {
+	@synchronized(self) {
+		return self.coalescedMessages - self.coalescedFlushes;
+	}
+}
+
+-(NSUInteger)sendBuffersAllocated {
+	@synchronized(self) {
+		return _sendBuffersAllocated;
+	}
+}
+
+-(unsigned long long)messagesEncoded {
+	@synchronized(self) {
+		return _messagesEncoded;
+	}
+}
+
+-(NSTimeInterval)averageCoalescingDelay {
+	@synchronized(self) {
+		if (self.coalescedMessages == 0)
+			return 0;
+		return self.coalescingDelayTotal / self.coalescedMessages;
+	}
 }
 
 #pragma mark - Read Methods - Public
+//Blocking wrappers around the asynchronous reads.  The calling thread sleeps until the read completes, times out or the socket disconnects.
 //For reading error messages, etc from the server
 -(NSString *)readString {
-	uint32_t length = [self readInt]; //Length of string
-	NSData *received = [self readReceived:length]; //Contents, U8 array
+	__block NSString *received = @"";
+	[self waitForRead:^(dispatch_block_t readFinished) {
+		[self readStringWithCompletion:^(NSString *string) {
+			received = string;
+			readFinished();
+		}];
+	}];
+	return received;
+}
+
+-(NSData *)readReceived:(int)length {
+	__block NSData *received = nil;
+	[self waitForRead:^(dispatch_block_t readFinished) {
+		[self readLength:length Completion:^(NSData *data) {
+			received = data;
+			readFinished();
+		}];
+	}];
 	
-	if (length == 0 || !received)
-		return @""; //If nothing sent or blank string
+	if (!received)
+		return [NSData data]; //Timed out or disconnected
+	return received;
+}
+
+-(uint16_t)readShort {
+	__block uint16_t received = 0;
+	[self waitForRead:^(dispatch_block_t readFinished) {
+		[self readShortWithCompletion:^(BOOL ok, uint32_t value) {
+			received = value;
+			readFinished();
+		}];
+	}];
+	return received;
+}
+
+-(VersionMsg *)readVersion {
+	__block VersionMsg *received = nil;
+	[self waitForRead:^(dispatch_block_t readFinished) {
+		[self readVersionWithCompletion:^(VersionMsg *version) {
+			received = version;
+			readFinished();
+		}];
+	}];
+	return received;
+}
+
+-(NSData *)readSecurity {
+	__block NSData *received = nil;
+	[self waitForRead:^(dispatch_block_t readFinished) {
+		[self readSecurityWithCompletion:^(NSData *securityTypes) {
+			received = securityTypes;
+			readFinished();
+		}];
+	}];
+	return received;
+}
+
+-(uint32_t)readSecurityResult {
+	__block uint32_t received = 0;
+	[self waitForRead:^(dispatch_block_t readFinished) {
+		[self readSecurityResultWithCompletion:^(BOOL ok, uint32_t value) {
+			received = value;
+			readFinished();
+		}];
+	}];
+	return received;
+}
+
+//Start consuming server to client messages, eg. after initialization.  Their payloads are skipped as they arrive.
+-(void)startDrainingServerMessages {
+	[self performOnDelegateQueue:^{
+		if (!self.messageDrain)
+			self.messageDrain = [[RFBMessageDrain alloc] initWithBitsPerPixel:self.serverBitsPerPixel];
+		[self drainServerMessages];
+	}];
+}
+
+//Drop whatever has been received but not asked for
+-(void)readAndDiscard {
+	[self performOnDelegateQueue:^{
+		@synchronized(self.pendingReads) {
+			if (self.pendingReads.count > 0)
+				return; //Part of a field still being read
+		}
+		[self.receiveBuffer skipBytes:[self.receiveBuffer bytesAvailable]];
+	}];
+}
+
+#pragma mark - Read Methods - Private
+//Never call on the socket's delegate queue, the read being waited on could never be served
+-(BOOL)waitForRead:(void (^)(dispatch_block_t readFinished))startRead {
+	if ([self isOnDelegateQueue]) {
+		DLogErr(@"Blocking read attempted on the socket delegate queue");
+		return NO;
+	}
 	
-	return [[NSString alloc] initWithData:received encoding:NSUTF8StringEncoding];
+	dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+	startRead(^{
+		dispatch_semaphore_signal(finished);
+	});
+	dispatch_semaphore_wait(finished, DISPATCH_TIME_FOREVER); //Every read completes, socket timeouts and disconnects fail them
+	dispatch_release(finished);
+	return YES;
 }
 
-//GCDAsyncSocket reads are forced to be *SYNCHRONOUS* using the while loop
--(NSData *)readReceived:(int)length {
-	if ([self isDisconnected])
-		return nil;
+#pragma mark - Asynchronous Read Methods - Public
+-(void)readLength:(NSUInteger)length Completion:(RFBReadCompletion)completion {
+	[self queueRead:length AtFront:NO Handler:^(RFBReceiveBuffer *buffer) {
+		completion(buffer ? [buffer readDataOfLength:length] : nil);
+	}];
+}
+
+-(void)readShortWithCompletion:(RFBReadIntCompletion)completion {
+	[self queueRead:sizeof(uint16_t) AtFront:NO Handler:^(RFBReceiveBuffer *buffer) {
+		uint16_t value = 0;
+		BOOL ok = (buffer && [buffer readUInt16:&value]);
+		completion(ok, value);
+	}];
+}
+
+-(void)readIntWithCompletion:(RFBReadIntCompletion)completion {
+	[self queueRead:sizeof(uint32_t) AtFront:NO Handler:^(RFBReceiveBuffer *buffer) {
+		uint32_t value = 0;
+		BOOL ok = (buffer && [buffer readUInt32:&value]);
+		completion(ok, value);
+	}];
+}
+
+//For reading error messages, etc from the server.  Blank string if nothing could be read
+-(void)readStringWithCompletion:(RFBReadStringCompletion)completion {
+	[self readStringAtFront:NO Completion:completion];
+}
+
+-(void)readVersionWithCompletion:(void (^)(VersionMsg *version))completion {
+	[self queueRead:RFB_VERSION_DATA_LENGTH AtFront:NO Handler:^(RFBReceiveBuffer *buffer) {
+		char version[RFB_VERSION_DATA_LENGTH];
+		if (!buffer || ![buffer readBytes:version Length:sizeof(version)]) {
+			completion(nil);
+			return;
+		}
+		completion([[VersionMsg alloc] initWithBytes:version Length:sizeof(version)]);
+	}];
+}
+
+//nil if server reported a connection failure, read the reason with readStringWithCompletion:
+-(void)readSecurityWithCompletion:(RFBReadCompletion)completion {
+	__weak RFBSocket *blockSafeSelf = self; //Alive whenever a buffer is passed, as it is serving the read
+	if (self.version >= 0x0307) {
+		[self queueRead:1 AtFront:NO Handler:^(RFBReceiveBuffer *buffer) {
+			uint8_t numSecTypes = 0;
+			if (!buffer || ![buffer readUInt8:&numSecTypes] || numSecTypes == 0) { //Connection failed response, eg. unsupported protocol version
+				completion(nil);
+				return;
+			}
+			[blockSafeSelf queueRead:numSecTypes AtFront:YES Handler:^(RFBReceiveBuffer *typesBuffer) {
+				completion([typesBuffer readDataOfLength:numSecTypes]); //Supported security types
+			}];
+		}];
+	} else { //V 3.3 protocol
+		[self readIntWithCompletion:^(BOOL ok, uint32_t securityType) {
+			if (!ok || securityType == [RFBSecurityInvalid type]) {
+				completion(nil);
+				return;
+			}
+			uint8_t type = (uint8_t)securityType; //Server chosen type, reported as a single entry list
+			completion([NSData dataWithBytes:&type length:sizeof(type)]);
+		}];
+	}
+}
+
+-(void)readSecurityResultWithCompletion:(RFBReadIntCompletion)completion {
+	[self readIntWithCompletion:completion];
+}
+
+#pragma mark - Asynchronous Read Methods - Private
+//U32 length followed by the string.  The contents are read ahead of anything queued since the length was requested
+-(void)readStringAtFront:(BOOL)atFront Completion:(RFBReadStringCompletion)completion {
+	__weak RFBSocket *blockSafeSelf = self;
+	[self queueRead:sizeof(uint32_t) AtFront:atFront Handler:^(RFBReceiveBuffer *buffer) {
+		uint32_t length = 0;
+		if (!buffer || ![buffer readUInt32:&length] || length == 0) {
+			completion(@"");
+			return;
+		}
+		[blockSafeSelf queueRead:length AtFront:YES Handler:^(RFBReceiveBuffer *stringBuffer) {
+			NSString *string = [stringBuffer readStringOfLength:length];
+			completion(string ? string : @"");
+		}];
+	}];
+}
+
+//Queue a read of length bytes.  The handler parses them straight out of the receive buffer, on the delegate queue, once they have arrived (maybe already).
+//AtFront for the remainder of a field already being parsed, eg. a string's contents after its length.
+-(void)queueRead:(NSUInteger)length AtFront:(BOOL)atFront Handler:(RFBBufferedRead)handler {
+	RFBPendingRead *read = [[RFBPendingRead alloc] init];
+	read.length = length;
+	read.handler = handler;
+	read.queuedAt = CFAbsoluteTimeGetCurrent();
 	
-	[self.socket readDataToLength:length
-                      withTimeout:TIMEOUT //Set a timeout for this to allow loop to exit nicely
-                              tag:0];
+	[self performOnDelegateQueue:^{
+		if (length > MAX_READ_LENGTH) {
+			DLogErr(@"Refusing read of %lu bytes", (unsigned long)length);
+			handler(nil);
+			return;
+		}
+		
+		BOOL queued = NO;
+		@synchronized(self.pendingReads) {
+			if (!self.closed) { //Would never be served
+				if (atFront)
+					[self.pendingReads insertObject:read atIndex:0];
+				else
+					[self.pendingReads addObject:read];
+				queued = YES;
+			}
+		}
+		if (!queued) {
+			handler(nil);
+			return;
+		}
+		[self drainPendingReads];
+		[self drainServerMessages];
+	}];
+}
+
+//Serve pending reads, oldest first, for as long as the receive buffer holds enough bytes
+-(void)drainPendingReads {
+	if (self.draining)
+		return; //Picked up by the loop already running further up the stack
+	self.draining = YES;
 	
-	self.requestReadyOrTimedOut = NO;
-	while (!self.requestReadyOrTimedOut) {
-		//DLog(@"Waiting for request to complete...");
-		if (self.readBuffer.length == length)
-			self.requestReadyOrTimedOut = YES;
+	while (YES) {
+		RFBPendingRead *read = nil;
+		@synchronized(self.pendingReads) {
+			if (self.pendingReads.count > 0 && [[self.pendingReads objectAtIndex:0] length] <= [self.receiveBuffer bytesAvailable]) {
+				read = [self.pendingReads objectAtIndex:0];
+				[self.pendingReads removeObjectAtIndex:0];
+			}
+		}
+		if (!read)
+			break;
+		
+		NSTimeInterval startCPU = threadCPUTime();
+		read.handler(self.receiveBuffer);
+		self.readCompletionCPUTime += threadCPUTime() - startCPU;
 	}
 	
-	NSData *read = [NSData dataWithData:self.readBuffer];
-	self.readBuffer = nil; //purge previously received socket data, otherwise may end up accidentally re-reading previous received data.  THis is because we don't have a 'bytes read' counter and we're forcing synchronous reads...
-	return read; //Assuming method only returns when data of specified length is read
+	self.draining = NO;
 }
 
--(uint16_t)readShort {
-	NSData *received = [self readReceived:2];
-	if (!received || received.length == 0)
-		return 0; //Read failed or empty
-    const uint16_t *recvBytes = [received bytes];
-    return ntohs(*recvBytes);
+//Once the socket disconnects, no pending read can complete and new ones fail straight away.  Returns the pending reads for failing.
+-(NSArray *)closeAndTakePendingReads {
+	NSArray *pending;
+	@synchronized(self.pendingReads) {
+		self.closed = YES;
+		pending = [self.pendingReads copy];
+		[self.pendingReads removeAllObjects];
+		if (self.tlsHandshakeRead) {
+			pending = [pending arrayByAddingObject:self.tlsHandshakeRead];
+			self.tlsHandshakeRead = nil;
+		}
+	}
+	return pending;
+}
+
+//Received data not claimed by a pending read is server messages, or unrequested data to drop if not draining yet
+-(void)drainServerMessages {
+	@synchronized(self.pendingReads) {
+		if (self.pendingReads.count > 0)
+			return;
+	}
+	
+	if (self.messageDrain) {
+		[self.messageDrain drainBuffer:self.receiveBuffer];
+	} else if ([self.receiveBuffer bytesAvailable] > MAX_UNCLAIMED_LENGTH) {
+		DLogWar(@"Dropping %lu unread bytes from server", (unsigned long)[self.receiveBuffer bytesAvailable]);
+		[self.receiveBuffer skipBytes:[self.receiveBuffer bytesAvailable]];
+	}
+}
+
+//Received ciphertext.  Decrypted into the receive buffer, or advances the handshake started by startTLS:Completion:
+-(void)receiveTLSData:(NSData *)data {
+	[self.tlsPlaintext setLength:0];
+	BOOL ok = [self.tls receiveCiphertext:[data bytes] Length:data.length Plaintext:self.tlsPlaintext];
+	[self.socketReadBuffer setLength:0]; //data points into it
+	@synchronized(self) {
+		[self writeTLSCiphertext]; //Handshake replies, or an alert on failure
+	}
+	if (!ok || ![self.receiveBuffer appendBytes:[self.tlsPlaintext bytes] Length:self.tlsPlaintext.length]) {
+		[self.socket disconnectAfterWriting]; //Fails the pending reads
+		return;
+	}
+	[self readFromSocket];
+	
+	RFBPendingRead *handshakeRead = nil;
+	if ([self.tls isHandshakeComplete]) {
+		@synchronized(self.pendingReads) {
+			handshakeRead = self.tlsHandshakeRead;
+			self.tlsHandshakeRead = nil;
+		}
+	}
+	if (handshakeRead)
+		handshakeRead.handler(self.receiveBuffer);
+	[self drainPendingReads];
+	[self drainServerMessages];
+}
+
+//Keep one read outstanding on the socket at all times.  Data is buffered whether or not anyone has asked for it yet.
+-(void)readFromSocket {
+	[self.socket readDataWithTimeout:TIMEOUT
+							  buffer:self.socketReadBuffer
+						bufferOffset:0
+						   maxLength:RECEIVE_CHUNK
+								 tag:RECEIVE_TAG];
+}
+
+#pragma mark - Delegate Queue - Private
+-(BOOL)isOnDelegateQueue {
+	return dispatch_get_specific(&RFBSocketDelegateQueueKey) == (__bridge void *)self;
+}
+
+//Run inline when already on the delegate queue, so reads queued by a read's handler stay in order
+-(void)performOnDelegateQueue:(dispatch_block_t)block {
+	if ([self isOnDelegateQueue])
+		block();
+	else
+		dispatch_async(self.delegateQueue, block);
 }
 
 #pragma mark - Write methods - Private
@@ -151,15 +670,275 @@
     [self writeBytes:[msg data]];
 }
 
+//Encode a message into the send buffer.  Flush writes it, and anything coalesced before it, straight away.
+//Otherwise it waits for the coalescing window to close or the threshold to be reached.  Call within @synchronized(self)
+-(void)sendMessage:(const void *)message Length:(NSUInteger)length Flush:(BOOL)flush {
+	[self sendMessages:message Length:length Count:1 Flush:flush];
+}
+
+//As above for count messages back to back, eg. a key macro
+-(void)sendMessages:(const void *)messages Length:(NSUInteger)length Count:(NSUInteger)count Flush:(BOOL)flush {
+	[self appendMessages:messages Length:length Count:count];
+	if (flush || self.coalescingWindow <= 0 || self.sendBuffer.length >= self.coalescingThreshold)
+		[self flushCoalescedWrites];
+}
+
+-(void)stampNextEventCapturedAt:(uint64_t)capturedAt EnqueuedAt:(uint64_t)enqueuedAt {
+	@synchronized(self) {
+		_nextCapturedAt = capturedAt;
+		_nextEnqueuedAt = enqueuedAt;
+	}
+}
+
+//Call within @synchronized(self)
+-(void)appendMessage:(const void *)message Length:(NSUInteger)length {
+	[self appendMessages:message Length:length Count:1];
+}
+
+//count messages, length bytes in all.  Call within @synchronized(self)
+-(void)appendMessages:(const void *)messages Length:(NSUInteger)length Count:(NSUInteger)count {
+	if (self.coalescingWindow > 0) {
+		CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+		if (self.sendBuffer.length == 0) {
+			self.firstPendingQueuedAt = now;
+			[self startCoalescingTimer];
+		}
+		self.pendingMessages += count;
+		self.pendingQueuedAtSum += now * count;
+	}
+	[self.sendBuffer appendBytes:messages length:length]; //Within the buffer's capacity, doesn't allocate
+	self.messagesEncoded += count;
+	
+	if (_nextCapturedAt || _nextEnqueuedAt) { //First message of a stamped event
+		if (_latencySampleCount < MAX_LATENCY_SAMPLES) {
+			RFBLatencySample *sample = &_latencySamples[(_latencySampleHead + _latencySampleCount) % MAX_LATENCY_SAMPLES];
+			sample->tag = self.nextSendBufferTag;
+			sample->capturedAt = _nextCapturedAt;
+			sample->enqueuedAt = _nextEnqueuedAt;
+			sample->encodedAt = mach_absolute_time();
+			_latencySampleCount++;
+		}
+		_nextCapturedAt = 0;
+		_nextEnqueuedAt = 0;
+	}
+}
+
+//Call within @synchronized(self)
+-(void)writeToSocket:(NSData *)data Tag:(long)tag {
+	[self.inFlightWrites addObject:data];
+	self.outstandingWrites++;
+	self.outstandingWriteBytes += data.length;
+	[self updateWriteDegraded];
+	
+	NSData *wire = data;
+	if (self.tls) { //The plaintext stays in flight for the accounting and the pool, its ciphertext goes in the one socket write
+		wire = [self.tls sendPlaintext:[data bytes] Length:data.length] ? [self.tls takeCiphertext] : nil;
+		if (!wire) {
+			DLogErr(@"Couldn't encrypt %lu bytes, disconnecting", (unsigned long)data.length);
+			[self.socket disconnect];
+			return;
+		}
+	}
+	[self.socket writeData:wire
+			   withTimeout:TIMEOUT
+					   tag:tag];
+}
+
+//Anything the TLS session has for the server that isn't caller data, eg. handshake records.  Call within @synchronized(self)
+-(void)writeTLSCiphertext {
+	NSData *ciphertext = [self.tls takeCiphertext];
+	if (ciphertext)
+		[self.socket writeData:ciphertext withTimeout:TIMEOUT tag:TLS_TAG];
+}
+
+//Write everything in the send buffer as one socket write.  The socket holds on to the buffer until written, the next one is taken from the pool.
+//Call within @synchronized(self)
+-(void)flushCoalescedWrites {
+	if (self.sendBuffer.length == 0 || self.cutText) //Paste in progress, can't split its message
+		return;
+
+	if (self.pendingMessages > 0) {
+		CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+		self.coalescedMessages += self.pendingMessages;
+		self.coalescedFlushes++;
+		self.coalescingDelayTotal += (self.pendingMessages * now) - self.pendingQueuedAtSum;
+		self.maxCoalescingDelay = MAX(self.maxCoalescingDelay, now - self.firstPendingQueuedAt);
+		self.pendingMessages = 0;
+		self.pendingQueuedAtSum = 0;
+	}
+
+	NSMutableData *buffer = self.sendBuffer;
+	self.sendBuffer = [self takeSendBuffer];
+	[self writeToSocket:buffer Tag:self.nextSendBufferTag];
+	self.nextSendBufferTag++;
+}
+
+//Reuse a written out send buffer, only allocating while more writes than ever before are in flight
+-(NSMutableData *)takeSendBuffer {
+	NSMutableData *buffer = [self.freeSendBuffers lastObject];
+	if (buffer) {
+		[self.freeSendBuffers removeLastObject];
+		return buffer;
+	}
+	self.sendBuffersAllocated++;
+	return [NSMutableData dataWithCapacity:MAX(self.coalescingThreshold, DEFAULT_COALESCING_THRESHOLD)];
+}
+
+//Writes complete in the order they were made, so every sample up to tag has been written.  Call within @synchronized(self)
+-(void)completeLatencySamplesForTag:(long)tag {
+	uint64_t writtenAt = mach_absolute_time();
+	while (_latencySampleCount > 0) {
+		RFBLatencySample *sample = &_latencySamples[_latencySampleHead];
+		if (sample->tag > tag) //Not yet written
+			break;
+		[self.inputLatency recordCapturedAt:sample->capturedAt EnqueuedAt:sample->enqueuedAt EncodedAt:sample->encodedAt WrittenAt:writtenAt];
+		_latencySampleHead = (_latencySampleHead + 1) % MAX_LATENCY_SAMPLES;
+		_latencySampleCount--;
+	}
+}
+
+//Writes complete in the order they were made, the oldest in flight is the one written.  Send buffers go back to the pool.
+//Call within @synchronized(self)
+-(void)completeOldestWriteWithTag:(long)tag {
+	if (self.inFlightWrites.count == 0)
+		return;
+	NSData *data = [self.inFlightWrites objectAtIndex:0];
+	[self.inFlightWrites removeObjectAtIndex:0];
+	self.outstandingWrites--;
+	self.outstandingWriteBytes -= MIN(data.length, self.outstandingWriteBytes);
+	[self updateWriteDegraded];
+	
+	if (tag >= SEND_BUFFER_TAG && self.freeSendBuffers.count < MAX_FREE_SEND_BUFFERS && data.length <= MAX_POOLED_SEND_BUFFER) {
+		NSMutableData *buffer = (NSMutableData *)data;
+		[buffer setLength:0];
+		[self.freeSendBuffers addObject:buffer];
+	}
+}
+
+//Degraded above the high-water mark, until back down to half of it.  Call within @synchronized(self)
+-(void)updateWriteDegraded {
+	BOOL degraded = self.writeDegraded;
+	if (self.writeHighWaterMark == 0)
+		degraded = NO;
+	else if (self.outstandingWriteBytes > self.writeHighWaterMark)
+		degraded = YES;
+	else if (self.outstandingWriteBytes <= self.writeHighWaterMark / 2)
+		degraded = NO;
+	if (degraded == self.writeDegraded)
+		return;
+	
+	self.writeDegraded = degraded;
+	DLogWar(@"Writes %@, %lu bytes in %lu writes outstanding", degraded ? @"backed up" : @"caught up", (unsigned long)self.outstandingWriteBytes, (unsigned long)self.outstandingWrites);
+	void (^handler)(BOOL degraded) = self.writeDegradedHandler;
+	if (handler) //Async, as the caller holds the lock
+		dispatch_async(self.delegateQueue, ^{
+			handler(degraded);
+		});
+}
+
+//One shot timer closing the coalescing window.  Call within @synchronized(self)
+-(void)startCoalescingTimer {
+	if (!self.coalescingTimer) {
+		self.coalescingTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.delegateQueue);
+		__weak RFBSocket *blockSafeSelf = self;
+		dispatch_source_set_event_handler(self.coalescingTimer, ^{
+			RFBSocket *strongSelf = blockSafeSelf;
+			if (!strongSelf)
+				return;
+			@synchronized(strongSelf) {
+				[strongSelf flushCoalescedWrites];
+			}
+		});
+		dispatch_resume(self.coalescingTimer);
+	}
+	dispatch_source_set_timer(self.coalescingTimer,
+							  dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.coalescingWindow * NSEC_PER_SEC)),
+							  DISPATCH_TIME_FOREVER,
+							  COALESCING_TIMER_LEEWAY);
+}
+
 #pragma mark - Write methods - Public
-//ASYNCHRONOUS
+-(void)setCoalescingWindow:(NSTimeInterval)coalescingWindow {
+	@synchronized(self) {
+		_coalescingWindow = coalescingWindow;
+		if (coalescingWindow <= 0)
+			[self flushCoalescedWrites]; //Turned off, nothing left waiting on the timer
+	}
+}
+
+-(void)setCoalescingThreshold:(NSUInteger)coalescingThreshold {
+	@synchronized(self) {
+		_coalescingThreshold = coalescingThreshold;
+	}
+}
+
+-(void)setWriteHighWaterMark:(NSUInteger)writeHighWaterMark {
+	@synchronized(self) {
+		_writeHighWaterMark = writeHighWaterMark;
+		[self updateWriteDegraded];
+	}
+}
+
+-(BOOL)isWriteDegraded {
+	@synchronized(self) {
+		return self.writeDegraded;
+	}
+}
+
+-(NSUInteger)outstandingWriteBytes {
+	@synchronized(self) {
+		return _outstandingWriteBytes;
+	}
+}
+
+//ASYNCHRONOUS, sent straight away along with anything coalesced before it
 -(void)writeBytes:(NSData *)wrapper {
     if (!wrapper)
         return; //Do nothing if nil data to send
     
-	[self.socket writeData:wrapper
-               withTimeout:TIMEOUT
-                       tag:0]; //TODO: Implement tagging for writes?
+	@synchronized(self) {
+		[self flushCoalescedWrites]; //Keep order
+		[self writeToSocket:wrapper Tag:WRITE_TAG];
+	}
+}
+
+-(BOOL)writeLength:(NSUInteger)length Encoder:(BOOL (^)(uint8_t *bytes))encoder {
+	if (length == 0 || !encoder)
+		return NO;
+	
+	NSMutableData *buffer;
+	@synchronized(self) {
+		buffer = [self takeSendBuffer];
+	}
+	[buffer setLength:length];
+	BOOL encoded = encoder([buffer mutableBytes]);
+	
+	@synchronized(self) {
+		if (!encoded) {
+			[buffer resetBytesInRange:NSMakeRange(0, length)]; //May hold part of a credential reply
+			[buffer setLength:0];
+			if (self.freeSendBuffers.count < MAX_FREE_SEND_BUFFERS)
+				[self.freeSendBuffers addObject:buffer];
+			return NO;
+		}
+		[self flushCoalescedWrites]; //Keep order
+		[self writeToSocket:buffer Tag:self.nextSendBufferTag]; //Back to the pool once written
+		self.nextSendBufferTag++;
+	}
+	return YES;
+}
+
+-(void)flushWrites {
+	@synchronized(self) {
+		[self flushCoalescedWrites];
+	}
+}
+
+//Writes waiting on the coalescing window count too, they are just as stale if the link is slow
+-(BOOL)hasOutstandingWrites {
+	@synchronized(self) {
+		return (self.outstandingWrites > 0 || self.sendBuffer.length > 0);
+	}
 }
 
 #pragma mark - Connection Methods - Public
@@ -170,6 +949,7 @@
 							onPort:self.port
 					   withTimeout:TIMEOUT
 							 error:&error]) {
+		[self readFromSocket]; //Queued until connected
 		return YES;
     }
 	
@@ -180,47 +960,25 @@
 
 -(void)disconnect {
     DLog(@"rfbstream socket disconn called");
-    //Set timeout property to YES to avoid getting stuck in a loop
-    self.requestReadyOrTimedOut = YES;
+    //Fail pending reads on the delegate queue, as the delegate is detached below.  Self not captured as this runs from dealloc too
+    NSArray *failed = [self closeAndTakePendingReads];
+    void (^cutTextCompletion)(BOOL sent) = nil;
+    @synchronized(self) {
+        cutTextCompletion = [self cancelCutText];
+    }
+    if (failed.count > 0 || cutTextCompletion) {
+        dispatch_async(self.delegateQueue, ^{
+            for (RFBPendingRead *read in failed)
+                read.handler(nil);
+            if (cutTextCompletion)
+                cutTextCompletion(NO);
+        });
+    }
     //release socket in recommended manner.  
 	[self.socket setDelegate:nil delegateQueue:NULL];
 	[self.socket disconnect];
 }
 
-#pragma mark - Read Methods - Public
--(VersionMsg *)readVersion {
-	NSData *dataBuffer = [self readReceived:12];
-	VersionMsg *version = [[VersionMsg alloc] initWithData:dataBuffer];
-	return version;
-}
-
--(NSData *)readSecurity {
-	if (self.version >= 0x0307) {
-		uint8_t numSecTypes = [self readByte];
-		//DLog(@"numSecTypes: %i", numSecTypes);
-		if (numSecTypes == 0) //Connection failed response, eg. unsupported protocol version
-			return nil;
-		return [self readReceived:numSecTypes]; //Read supported security types
-	} else { //V 3.3 protocol
-		uint32_t buff = [self readInt];
-		if (buff == [RFBSecurityInvalid type])
-			return nil;
-		else {
-			return [NSData dataWithBytes:&buff length:sizeof(buff)];
-		}
-	}
-}
-
--(uint32_t)readSecurityResult {
-	uint32_t results =[self readInt];
-	return results;
-}
-
--(void)readAndDiscard {
-	//Read first available bytes available to socket... and do nothing with it
-	[self.socket readDataWithTimeout:TIMEOUT tag:0];
-}
-
 #pragma mark - Other Write Methods - Public
 -(void)writeVersion:(int)version {
 	self.version = version;
@@ -229,115 +987,314 @@
 }
 
 -(void)writeSecurity:(uint8_t)securityType {
+    if (self.version < 0x0307)
+        return; //3.3 server picks the type itself, a reply would be read as the ClientInit shared flag
     [self writeByte:securityType];
 }
 
 #pragma mark - RFB Event Methods - Public
-//RFB initialization phase
+//RFB initialization phase.  Blocking equivalent of performInitializationWithCompletion:
 -(NSArray *)performInitialization {
+	__block NSArray *received = nil;
+	[self waitForRead:^(dispatch_block_t readFinished) {
+		[self performInitializationWithCompletion:^(NSArray *serverDetails) {
+			received = serverDetails;
+			readFinished();
+		}];
+	}];
+	return received;
+}
+
+-(void)performInitializationWithCompletion:(void (^)(NSArray *serverDetails))completion {
 	//shared-flag = 1, ie. no sharing with other clients
     [self writeByte:0x01];
 	
-	// read the ServerInit
-	NSData *displayInfo = [self readReceived:20];
-	NSString *name = [self readString];
-	
-	if (displayInfo.length == 0)
-		return nil;
-	
-	// parse the server display info. 
-    uint16_t dimensions[(sizeof(uint16_t) * 2)]; //U16 width, height
-    [displayInfo getBytes:&dimensions length:sizeof(dimensions)];
-    uint16_t width = ntohs(dimensions[0]);
-    uint16_t height = ntohs(dimensions[1]);
-    
-    PixelFormatMsg pixelFormat; //Not used, but parsed anyways for debugging
-    [displayInfo getBytes:&pixelFormat range:NSMakeRange((sizeof(uint16_t) * 2), PixelFormatMsg_Size)];
-    DLog(@"pixelFormat - bitsperpixel %i, depth %i, BEflag %i, TCflag %i, redMax %i, grMax %i, bluMax %i, redShif %i, greenShift %i, bluShift %i", pixelFormat.bitsPerPixel, pixelFormat.depth, pixelFormat.bigEndianFlag, pixelFormat.trueColourFlag, pixelFormat.redMax, pixelFormat.greenMax, pixelFormat.blueMax, pixelFormat.redShift, pixelFormat.greenShift, pixelFormat.blueShift);
-	
-	//return only the server name, width, height AND pixel format
-	return @[name, [NSNumber numberWithUnsignedInt:width], [NSNumber numberWithUnsignedInt:height]];
+	// read the ServerInit, then the name following it
+	__weak RFBSocket *blockSafeSelf = self;
+	[self queueRead:SERVERINIT_LENGTH AtFront:NO Handler:^(RFBReceiveBuffer *buffer) {
+		if (!buffer) {
+			completion(nil);
+			return;
+		}
+		
+		// parse the server display info. 
+		uint16_t width = 0, height = 0; //U16 width, height
+		[buffer readUInt16:&width];
+		[buffer readUInt16:&height];
+		
+		PixelFormatMsg pixelFormat; //Only bits per pixel used, for framing server messages later
+		[buffer readBytes:&pixelFormat Length:PixelFormatMsg_Size];
+		blockSafeSelf.serverBitsPerPixel = pixelFormat.bitsPerPixel;
+		DLog(@"pixelFormat - bitsperpixel %i, depth %i, BEflag %i, TCflag %i, redMax %i, grMax %i, bluMax %i, redShif %i, greenShift %i, bluShift %i", pixelFormat.bitsPerPixel, pixelFormat.depth, pixelFormat.bigEndianFlag, pixelFormat.trueColourFlag, pixelFormat.redMax, pixelFormat.greenMax, pixelFormat.blueMax, pixelFormat.redShift, pixelFormat.greenShift, pixelFormat.blueShift);
+		
+		[blockSafeSelf readStringAtFront:YES Completion:^(NSString *name) {
+			//return only the server name, width, height
+			completion(@[name, [NSNumber numberWithUnsignedInt:width], [NSNumber numberWithUnsignedInt:height]]);
+		}];
+	}];
 }
 
+#pragma mark - RFB Event Methods - Private
 /*
 -(void)sendSetPixelFormat:(PixelFormatMsg *)pfMsg {
     PixelFormatClientMsg clientPixelFormat;
     clientPixelFormat.msgType = PixelFormatClient_MsgType;
-    clientPixelFormat.paddingOneByte = 0;
-    clientPixelFormat.paddingTwoBytes = 0;
+    memset(clientPixelFormat.padding, 0, sizeof(clientPixelFormat.padding));
     clientPixelFormat.pixelFormat = *pfMsg;
     NSData *wrapper = [NSData dataWithBytes:&clientPixelFormat
                                      length:PixelFormatClientMsg_Size];
     [self writeBytes:wrapper];
 }*/
 
+//Messages are encoded on the stack and copied into the send buffer, nothing is allocated per event
 -(void)sendPointerEventWithButtons:(uint8_t)btns XPos:(int)x YPos:(int)y {
-    PointerMsg pointerEvent;
-    pointerEvent.msgType = PointerEvt_MsgType;
-    pointerEvent.btnMask = btns;
-    pointerEvent.xPosition = htons(x); //All multiple byte integers are Big Endian order except pixel values
-    pointerEvent.yPosition = htons(y);
-	NSData *wrapper = [NSData dataWithBytes:&pointerEvent
-									 length:PointerMsg_Size];
-    [self writeBytes:wrapper];
+    PointerMsg pointerEvent = RFBPointerMsgMake(btns, x, y); //All multiple byte integers are Big Endian order except pixel values
+    @synchronized(self) {
+        //Motion only events can wait for the coalescing window, button presses and releases go straight away
+        BOOL buttonsChanged = (btns != self.lastButtonMask);
+        self.lastButtonMask = btns;
+        [self sendMessage:&pointerEvent Length:PointerMsg_Size Flush:buttonsChanged];
+    }
 }
 
 -(void)sendMultiplePointerEventsForIterations:(int)iterations setButtons:(uint8_t)buttons clearButtons:(uint8_t)clearBtns XPos:(int)x YPos:(int)y {
-    PointerMsg pressedMsg, liftedMsg;
-    pressedMsg.msgType = PointerEvt_MsgType;
-    pressedMsg.btnMask = buttons;
-    pressedMsg.xPosition = htons(x);
-    pressedMsg.yPosition = htons(y);
-    
-    //Lifted
-    liftedMsg.msgType = PointerEvt_MsgType;
-    liftedMsg.btnMask = clearBtns;
-    liftedMsg.xPosition = pressedMsg.xPosition; //No change in x/y when lifting mouse btn
-    liftedMsg.yPosition = pressedMsg.yPosition; //No change in x/y when lifting mouse btn
+    PointerMsg pressedMsg = RFBPointerMsgMake(buttons, x, y);
+    PointerMsg liftedMsg = RFBPointerMsgMake(clearBtns, x, y); //No change in x/y when lifting mouse btn
     
-    NSMutableData *wrapper = [NSMutableData dataWithCapacity:(2*iterations*PointerMsg_Size)];
-    for (int i=0; i<iterations; i++) {
-        [wrapper appendBytes:&pressedMsg
-                      length:PointerMsg_Size];
-        [wrapper appendBytes:&liftedMsg
-                      length:PointerMsg_Size]; //Send both events 'together'
+    //More efficient to bundle multiple msgs in a single packet before sending.  Clicks and scrolls go straight away
+    @synchronized(self) {
+        for (int i=0; i<iterations; i++) {
+            [self appendMessage:&pressedMsg Length:PointerMsg_Size];
+            [self appendMessage:&liftedMsg Length:PointerMsg_Size]; //Send both events 'together'
+        }
+        self.lastButtonMask = clearBtns;
+        [self flushCoalescedWrites];
     }
-    
-    //More efficient to bundle multiple msgs in a single packet before sending
-    [self writeBytes:wrapper];
 }
 
 -(void)sendKeyWithEvent:(RFBKeyEvent *)keyEvent {
+	[self sendKeyPress:keyEvent.keyPress];
+}
+
+-(void)sendKeyPress:(unichar)keyPress {
 	//TODO: Probably doesn't handle certain keys like modifiers and special characters
 	
 	//resolve the keysym
-	int keysym = [KeyMapping unicharToX11KeySym:keyEvent.keyPress];
-	[self sendKeyDown:keysym];
-	[self sendKeyUp:keysym];
+	int keysym = [KeyMapping unicharToX11KeySym:keyPress];
+	KeyMsg keyDownMsg = RFBKeyMsgMake(YES, keysym);
+	KeyMsg keyUpMsg = RFBKeyMsgMake(NO, keysym);
+	@synchronized(self) { //Press and release together in one write
+		[self appendMessage:&keyDownMsg Length:KeyMsg_Size];
+		[self sendMessage:&keyUpMsg Length:KeyMsg_Size Flush:YES];
+	}
+}
+
+-(void)sendText:(NSString *)text ChunkLength:(NSUInteger)chunkLength Interval:(NSTimeInterval)interval {
+	if (text.length == 0)
+		return;
+	
+	if (chunkLength == 0 || chunkLength >= text.length || interval <= 0) { //All of it in one write
+		@synchronized(self) {
+			[self appendText:text Range:NSMakeRange(0, text.length)];
+			[self flushCoalescedWrites];
+		}
+		return;
+	}
+	[self sendText:[text copy] From:0 ChunkLength:chunkLength Interval:interval];
+}
+
+-(void)sendCutText:(NSString *)text PasteKeysyms:(NSArray *)pasteKeysyms Completion:(void (^)(BOOL sent))completion {
+	//Line endings are converted as each chunk is encoded, only the length is worked out up front
+	NSString *cutText = text ? [text copy] : @"";
+	NSUInteger cutTextLength = 0;
+	BOOL latin1 = scanCutText(cutText, &cutTextLength);
+	@synchronized(self) {
+		if (!latin1)
+			DLogWar(@"Cut text isn't Latin-1, not sent");
+		if (!latin1 || self.cutText || [self isDisconnected]) {
+			if (completion)
+				dispatch_async(self.delegateQueue, ^{
+					completion(NO);
+				});
+			return;
+		}
+		
+		[self flushCoalescedWrites]; //Anything sent before the paste goes first
+		self.cutText = cutText;
+		self.cutTextLocation = 0;
+		self.cutTextLength = cutTextLength;
+		self.cutTextEncoded = 0;
+		self.cutTextHeaderSent = NO;
+		self.cutTextPasteKeysyms = pasteKeysyms;
+		self.cutTextCompletion = completion;
+		for (NSUInteger i = 0; i < CUT_TEXT_CHUNKS_IN_FLIGHT; i++)
+			if (![self writeNextCutTextChunk])
+				break;
+	}
+}
+
++(BOOL)canSendAsCutText:(NSString *)text {
+	return scanCutText(text, NULL);
 }
 
 -(void)sendKeyDown:(int)keysym {
-    KeyMsg keyDownMsg;
-    keyDownMsg.msgType = KeyEvt_MsgType;
-    keyDownMsg.downFlag = 1;
-    keyDownMsg.padding = 0; //For clarity
-    keyDownMsg.keyX11 = htonl(keysym);
-
-	NSData *wrapper = [NSData dataWithBytes:&keyDownMsg
-									 length:KeyMsg_Size];
-    [self writeBytes:wrapper];
+	KeyMsg keyDownMsg = RFBKeyMsgMake(YES, keysym);
+	@synchronized(self) {
+		[self sendMessage:&keyDownMsg Length:KeyMsg_Size Flush:YES];
+	}
 }
 
 -(void)sendKeyUp:(int)keysym {
-    KeyMsg keyUpMsg;
-    keyUpMsg.msgType = KeyEvt_MsgType;
-    keyUpMsg.downFlag = 0;
-    keyUpMsg.padding = 0; //For clarity
-    keyUpMsg.keyX11 = htonl(keysym);
-
-	NSData *wrapper = [NSData dataWithBytes:&keyUpMsg
-									 length:KeyMsg_Size];
-    [self writeBytes:wrapper];
+	KeyMsg keyUpMsg = RFBKeyMsgMake(NO, keysym);
+	@synchronized(self) {
+		[self sendMessage:&keyUpMsg Length:KeyMsg_Size Flush:YES];
+	}
+}
+
+-(void)sendKeyMessages:(NSData *)messages {
+	if (messages.length == 0)
+		return;
+	@synchronized(self) {
+		[self sendMessages:messages.bytes Length:messages.length Count:messages.length / KeyMsg_Size Flush:YES];
+	}
+}
+
+#pragma mark - Typing - Private
+//Paced typing.  A chunk now, the next from the delegate queue once interval has passed.  Stops if the socket disconnects
+-(void)sendText:(NSString *)text From:(NSUInteger)location ChunkLength:(NSUInteger)chunkLength Interval:(NSTimeInterval)interval {
+	if ([self isDisconnected])
+		return;
+	
+	NSRange range = NSMakeRange(location, MIN(chunkLength, text.length - location));
+	range = [text rangeOfComposedCharacterSequencesForRange:range]; //Don't split surrogate pairs between chunks
+	@synchronized(self) {
+		[self appendText:text Range:range];
+		[self flushCoalescedWrites];
+	}
+	
+	NSUInteger next = NSMaxRange(range);
+	if (next >= text.length)
+		return;
+	__weak RFBSocket *blockSafeSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)), self.delegateQueue, ^{
+		[blockSafeSelf sendText:text From:next ChunkLength:chunkLength Interval:interval];
+	});
+}
+
+//Encode a key press and release for each character in range, decoding surrogate pairs.  CR LF is typed as a single Return.
+//Call within @synchronized(self)
+-(void)appendText:(NSString *)text Range:(NSRange)range {
+	unichar chars[TEXT_DECODE_CHUNK];
+	unichar highSurrogate = 0;
+	BOOL afterReturn = NO;
+	NSUInteger location = range.location;
+	NSUInteger end = NSMaxRange(range);
+	while (location < end) {
+		NSUInteger count = MIN(TEXT_DECODE_CHUNK, end - location);
+		[text getCharacters:chars range:NSMakeRange(location, count)];
+		location += count;
+		
+		for (NSUInteger i = 0; i < count; i++) {
+			unichar ch = chars[i];
+			UTF32Char codePoint = ch;
+			if (CFStringIsSurrogateHighCharacter(ch)) {
+				highSurrogate = ch;
+				continue;
+			} else if (CFStringIsSurrogateLowCharacter(ch)) {
+				if (!highSurrogate)
+					continue; //Unpaired, nothing to type
+				codePoint = CFStringGetLongCharacterForSurrogatePair(highSurrogate, ch);
+			} else if (ch == '\n' && afterReturn) {
+				afterReturn = NO;
+				continue;
+			}
+			highSurrogate = 0;
+			afterReturn = (ch == '\r');
+			
+			UInt32 keysym = [KeyMapping codePointToX11KeySym:codePoint];
+			KeyMsg keyDownMsg = RFBKeyMsgMake(YES, keysym);
+			KeyMsg keyUpMsg = RFBKeyMsgMake(NO, keysym);
+			[self appendMessage:&keyDownMsg Length:KeyMsg_Size];
+			[self appendMessage:&keyUpMsg Length:KeyMsg_Size];
+		}
+	}
+}
+
+#pragma mark - Pasting - Private
+//Encode and write the next chunk of cut text, the first one starting with the message header.
+//NO once all of it has been handed to the socket.  Call within @synchronized(self)
+-(BOOL)writeNextCutTextChunk {
+	NSString *text = self.cutText;
+	NSUInteger length = text.length;
+	if (self.cutTextHeaderSent && self.cutTextEncoded >= self.cutTextLength)
+		return NO;
+	
+	NSUInteger count = MIN(CUT_TEXT_CHUNK, self.cutTextLength - self.cutTextEncoded);
+	NSMutableData *chunk = [NSMutableData dataWithLength:count + (self.cutTextHeaderSent ? 0 : ClientCutTextMsg_Size)];
+	uint8_t *bytes = [chunk mutableBytes];
+	if (!self.cutTextHeaderSent) {
+		ClientCutTextMsg header = RFBClientCutTextMsgMake((uint32_t)self.cutTextLength);
+		memcpy(bytes, &header, ClientCutTextMsg_Size);
+		bytes += ClientCutTextMsg_Size;
+		self.cutTextHeaderSent = YES;
+	}
+	
+	//Latin-1 (checked up front), a byte per UTF16 unit.  CRLF becomes LF by dropping the CR, a lone CR becomes LF
+	unichar chars[TEXT_DECODE_CHUNK];
+	NSUInteger location = self.cutTextLocation;
+	uint8_t *end = bytes + count;
+	while (bytes < end && location < length) {
+		NSUInteger units = MIN(TEXT_DECODE_CHUNK, length - location);
+		[text getCharacters:chars range:NSMakeRange(location, units)];
+		NSUInteger i = 0;
+		for (; i < units && bytes < end; i++) {
+			if (chars[i] != '\r') {
+				*bytes++ = (uint8_t)chars[i];
+				continue;
+			}
+			unichar next = (i + 1 < units) ? chars[i + 1] : ((location + i + 1 < length) ? [text characterAtIndex:location + i + 1] : 0);
+			if (next != '\n')
+				*bytes++ = '\n';
+		}
+		location += i;
+	}
+	self.cutTextLocation = location;
+	self.cutTextEncoded += count;
+	
+	self.cutTextChunksInFlight++;
+	[self writeToSocket:chunk Tag:CUT_TEXT_TAG];
+	return YES;
+}
+
+//All of the cut text written out.  Press the paste keys and let the held back send buffer go.
+//Returns the completion to call, outside the lock.  Call within @synchronized(self)
+-(void (^)(BOOL sent))finishCutText {
+	void (^completion)(BOOL sent) = self.cutTextCompletion;
+	NSArray *keysyms = self.cutTextPasteKeysyms;
+	self.cutText = nil;
+	self.cutTextCompletion = nil;
+	self.cutTextPasteKeysyms = nil;
+	
+	for (NSNumber *keysym in keysyms) {
+		KeyMsg keyDownMsg = RFBKeyMsgMake(YES, [keysym unsignedIntValue]);
+		[self appendMessage:&keyDownMsg Length:KeyMsg_Size];
+	}
+	for (NSNumber *keysym in [keysyms reverseObjectEnumerator]) {
+		KeyMsg keyUpMsg = RFBKeyMsgMake(NO, [keysym unsignedIntValue]);
+		[self appendMessage:&keyUpMsg Length:KeyMsg_Size];
+	}
+	[self flushCoalescedWrites];
+	return completion;
+}
+
+//Paste abandoned, eg. disconnected.  Returns the completion to call, outside the lock.  Call within @synchronized(self)
+-(void (^)(BOOL sent))cancelCutText {
+	void (^completion)(BOOL sent) = self.cutTextCompletion;
+	self.cutText = nil;
+	self.cutTextCompletion = nil;
+	self.cutTextPasteKeysyms = nil;
+	self.cutTextChunksInFlight = 0;
+	return completion;
 }
 
 #pragma mark - Wrapper Getters for *SOME* CocoaAsyncSocket properties - Public
@@ -393,7 +1350,22 @@
 - (void)socket:(GCDAsyncSocket *)sock didReadData:(NSData *)data withTag:(long)tag {
 	DLog(@"Received data length: %lu", (unsigned long)data.length);
 	DLog(@"Data: %@", data);
-	self.readBuffer = data;
+	if (tag != RECEIVE_TAG)
+		return;
+	if (self.tls) {
+		[self receiveTLSData:data];
+		return;
+	}
+	
+	BOOL buffered = [self.receiveBuffer appendBytes:[data bytes] Length:data.length];
+	[self.socketReadBuffer setLength:0]; //data points into it, so only reset once copied
+	if (!buffered) {
+		[self.socket disconnect]; //Out of memory, fails the pending reads
+		return;
+	}
+	[self readFromSocket];
+	[self drainPendingReads];
+	[self drainServerMessages];
 }
 
 /*Called when a socket has read in data, but has not yet completed the read. This would occur if using readDataToData: or readDataToLength: methods. It may be used to for things such as updating progress bars.
@@ -411,11 +1383,24 @@
 - (NSTimeInterval)socket:(GCDAsyncSocket *)sock shouldTimeoutReadWithTag:(long)tag
 				 elapsed:(NSTimeInterval)elapsed
 			   bytesDone:(NSUInteger)length {
-	DLogWar(@"Request timed out.  Bytes done %lu, time elapsed: %f", (unsigned long)length, elapsed);
-	//Part of making reads synchronous
-	self.requestReadyOrTimedOut = YES;
+	if (tag == RECEIVE_TAG) {
+		//Receiving never completes while the server is idle, so only time out once a pending read has waited TIMEOUT
+		CFAbsoluteTime oldestQueuedAt = 0;
+		@synchronized(self.pendingReads) {
+			if (self.tlsHandshakeRead)
+				oldestQueuedAt = self.tlsHandshakeRead.queuedAt;
+			else if (self.pendingReads.count > 0)
+				oldestQueuedAt = [[self.pendingReads objectAtIndex:0] queuedAt];
+		}
+		if (oldestQueuedAt == 0)
+			return TIMEOUT;
+		NSTimeInterval remaining = TIMEOUT - (CFAbsoluteTimeGetCurrent() - oldestQueuedAt);
+		if (remaining > 0)
+			return remaining;
+	}
 	
-	return 0; //placeholder
+	DLogWar(@"Request timed out.  Bytes done %lu, time elapsed: %f", (unsigned long)length, elapsed);
+	return 0; //Socket disconnects, failing the pending reads
 }
 
 #pragma mark - CocoaAsyncSocket protocol delegate methods - Private - Writing Data (output)
@@ -424,8 +1409,27 @@
  The tag parameter is the tag you passed when you requested the write operation For example, in the writeData:withTimeout:tag: method.*/
 - (void)socket:(GCDAsyncSocket *)sock didWriteDataWithTag:(long)tag {
 	DLog(@"Data sent");
-	//Part of making reads synchronous
-	//self.writeDoneOrTimedOut = YES;
+	if (tag != WRITE_TAG && tag != CUT_TEXT_TAG && tag < SEND_BUFFER_TAG)
+		return;
+	
+	dispatch_block_t handler = nil;
+	void (^cutTextCompletion)(BOOL sent) = nil;
+	@synchronized(self) {
+		[self completeOldestWriteWithTag:tag];
+		if (tag == CUT_TEXT_TAG && self.cutText) {
+			self.cutTextChunksInFlight--;
+			if (![self writeNextCutTextChunk] && self.cutTextChunksInFlight == 0)
+				cutTextCompletion = [self finishCutText];
+		}
+		if (tag >= SEND_BUFFER_TAG)
+			[self completeLatencySamplesForTag:tag];
+		if (self.outstandingWrites == 0 && self.sendBuffer.length == 0)
+			handler = self.writesCompletedHandler;
+	}
+	if (cutTextCompletion)
+		cutTextCompletion(YES);
+	if (handler)
+		handler();
 }
 
 /*Called when a socket has written some data, but has not yet completed the entire write. It may be used to for things such as updating progress bars.
@@ -504,7 +1508,13 @@
 	DLogInf(@"Disconnected");
     if (error)
         DLogErr(@"error description: %@, reason: %@", [error localizedDescription], [error localizedFailureReason]);
-	//Part of making reads synchronous (for when attempting connection and not connected)
-	self.requestReadyOrTimedOut = YES;
+	for (RFBPendingRead *read in [self closeAndTakePendingReads])
+		read.handler(nil);
+	void (^cutTextCompletion)(BOOL sent) = nil;
+	@synchronized(self) {
+		cutTextCompletion = [self cancelCutText];
+	}
+	if (cutTextCompletion)
+		cutTextCompletion(NO);
 }
 @end
@@ -0,0 +1,61 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  One TLS connection driven through memory BIOs, for running TLS over a socket that's already connected and partway
+//  through the RFB handshake (VeNCrypt).  Ciphertext received is fed in, ciphertext to send is taken out, plaintext goes
+//  in and out of the other side.  Knows nothing about sockets.  Thread safe, one caller at a time.
+//  Client ends use anonymous Diffie-Hellman cipher suites, as VeNCrypt's TLS subtypes do.  That encrypts but doesn't
+//  authenticate the server.  Client sessions are cached by key, eg. the server profile's address and port, and the next
+//  connection with that key offers it, so a reconnect resumes with an abbreviated handshake (one round trip, no key
+//  exchange) instead of a full one.  The cache is in memory, sessions outlive the process by being saved and restored,
+//  eg. with the server profile.
+
+#import <Foundation/Foundation.h>
+
+//openssl libssl
+#import <ssl.h>
+
+@interface RFBTLSSession : NSObject
+//cacheKey nil = no resumption
+-(id)initClientWithCacheKey:(NSString *)cacheKey;
+//Server end, eg. for RFBMockServer.  Sessions resume against context's own cache and ticket keys
+-(id)initServerWithContext:(SSL_CTX *)context;
+//Anonymous DH server context with prime (big endian) and generator 2.  The caller frees it (SSL_CTX_free)
++(SSL_CTX *)newAnonymousServerContextWithPrime:(NSData *)prime;
+
+//Client: produce the ClientHello, take it with takeCiphertext.  Server: nothing to do, wait for it.  NO on error
+-(BOOL)startHandshake;
+//Ciphertext from the peer.  Advances the handshake, then decrypts anything after it into plaintext (appended).
+//NO on a TLS error or once the peer has closed.  Either way there may be ciphertext to send, eg. a reply or an alert
+-(BOOL)receiveCiphertext:(const void *)bytes Length:(NSUInteger)length Plaintext:(NSMutableData *)plaintext;
+//Encrypt plaintext for the peer, once the handshake is complete.  NO on error
+-(BOOL)sendPlaintext:(const void *)bytes Length:(NSUInteger)length;
+//Ciphertext waiting for the peer: handshake records, encrypted plaintext, alerts.  nil if none
+-(NSData *)takeCiphertext;
+
+-(BOOL)isHandshakeComplete;
+-(BOOL)isResumed; //Abbreviated handshake with a cached session
+
+#pragma mark - Session Cache
++(BOOL)hasCachedSessionForKey:(NSString *)cacheKey;
++(void)removeCachedSessionForKey:(NSString *)cacheKey;
++(void)removeAllCachedSessions;
+//DER encoded session and its expiry, for keeping with eg. the server profile.  nil if nothing cached for the key
++(NSDictionary *)savedSessionForKey:(NSString *)cacheKey;
+//Caches a saved session unless it has expired or one is already cached for the key (that one is as new or newer).
+//NO if it wasn't used
++(BOOL)restoreSavedSession:(NSDictionary *)savedSession ForKey:(NSString *)cacheKey;
+@end
@@ -0,0 +1,412 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBTLSSession.h"
+
+#import <pthread.h>
+
+//openssl libcrypto
+#import <bn.h>
+#import <dh.h>
+#import <err.h>
+
+//Anonymous Diffie-Hellman (and ECDH) suites, strongest first.  No certificates, so no trust store is needed
+#define ANONYMOUS_CIPHERS "aNULL:!eNULL:!LOW:!EXPORT:!MD5:@STRENGTH"
+#define READ_CHUNK 16384 //Max TLS record payload
+#define MAX_CACHED_SESSIONS 32
+#define SESSION_LIFETIME (24 * 60 * 60) //Client sessions kept this long (OpenSSL's default is 5 min), servers may expire them sooner
+#define SAVED_SESSION_KEY @"Session"
+#define SAVED_EXPIRY_KEY @"Expires"
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+//OpenSSL 1.0 needs locks from the application once it's used from more than one thread
+static pthread_mutex_t *opensslLocks;
+
+static void opensslLockingCallback(int mode, int type, const char *file, int line) {
+	if (mode & CRYPTO_LOCK)
+		pthread_mutex_lock(&opensslLocks[type]);
+	else
+		pthread_mutex_unlock(&opensslLocks[type]);
+}
+#endif
+
+static void initialiseOpenSSL(void) {
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{
+		SSL_library_init();
+		SSL_load_error_strings();
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+		if (!CRYPTO_get_locking_callback()) {
+			int count = CRYPTO_num_locks();
+			opensslLocks = malloc(sizeof(pthread_mutex_t) * count);
+			if (opensslLocks) {
+				for (int i = 0; i < count; i++)
+					pthread_mutex_init(&opensslLocks[i], NULL);
+				CRYPTO_set_locking_callback(opensslLockingCallback);
+			}
+		}
+#endif
+	});
+}
+
+static void logOpenSSLErrors(NSString *context) {
+	unsigned long error;
+	while ((error = ERR_get_error()) != 0) {
+		char description[256];
+		ERR_error_string_n(error, description, sizeof(description));
+		DLogErr(@"%@: %s", context, description);
+	}
+}
+
+static void configureAnonymous(SSL_CTX *context) {
+	SSL_CTX_set_options(context, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 | SSL_OP_NO_COMPRESSION);
+#ifdef TLS1_3_VERSION
+	SSL_CTX_set_max_proto_version(context, TLS1_2_VERSION); //TLS 1.3 has no anonymous suites
+#endif
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+	SSL_CTX_set_security_level(context, 0); //Anonymous suites are below level 1
+#endif
+	SSL_CTX_set_cipher_list(context, ANONYMOUS_CIPHERS);
+}
+
+#pragma mark - Session Cache
+//Cache key to NSValue wrapped SSL_SESSION *, one reference each.  Guarded by @synchronized on the dictionary
+static NSMutableDictionary *sessionCache(void) {
+	static NSMutableDictionary *cache = nil;
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{
+		cache = [NSMutableDictionary dictionary];
+	});
+	return cache;
+}
+
+//Takes over the reference to session
+static void cacheSession(NSString *cacheKey, SSL_SESSION *session) {
+	NSMutableDictionary *cache = sessionCache();
+	@synchronized(cache) {
+		SSL_SESSION *old = [[cache objectForKey:cacheKey] pointerValue];
+		if (old) {
+			SSL_SESSION_free(old);
+		} else if (cache.count >= MAX_CACHED_SESSIONS) { //Make room, any will do
+			NSString *evicted = [[cache allKeys] objectAtIndex:0];
+			SSL_SESSION_free([[cache objectForKey:evicted] pointerValue]);
+			[cache removeObjectForKey:evicted];
+		}
+		[cache setObject:[NSValue valueWithPointer:session] forKey:cacheKey];
+	}
+}
+
+@interface RFBTLSSession() {
+	SSL *_ssl;
+	BIO *_incoming; //Ciphertext from the peer, read by _ssl
+	BIO *_outgoing; //Ciphertext for the peer, written by _ssl
+}
+@property (copy, nonatomic) NSString *cacheKey;
+@end
+
+//New client session, or a new ticket for one, once the server has sent it
+static int newSessionCallback(SSL *ssl, SSL_SESSION *session) {
+	RFBTLSSession *tls = (__bridge RFBTLSSession *)SSL_get_app_data(ssl);
+	NSString *cacheKey = tls.cacheKey;
+	if (!cacheKey)
+		return 0; //Not kept, OpenSSL frees it
+	cacheSession(cacheKey, session);
+	return 1;
+}
+
+//Shared by every client session, so the session callback is set once
+static SSL_CTX *clientContext(void) {
+	static SSL_CTX *context = NULL;
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{
+		initialiseOpenSSL();
+		context = SSL_CTX_new(SSLv23_client_method());
+		if (!context) {
+			logOpenSSLErrors(@"TLS client context");
+			return;
+		}
+		configureAnonymous(context);
+		SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_set_timeout(context, SESSION_LIFETIME);
+		SSL_CTX_sess_set_new_cb(context, newSessionCallback);
+	});
+	return context;
+}
+
+@implementation RFBTLSSession
+#pragma mark - Init / Dealloc
+//Override, not used
+-(id)init {
+	return [self initClientWithCacheKey:nil];
+}
+
+-(id)initClientWithCacheKey:(NSString *)cacheKey {
+	if ((self = [self initWithContext:clientContext() Server:NO])) {
+		_cacheKey = [cacheKey copy];
+		if (cacheKey) { //Offer the last session with this server
+			NSMutableDictionary *cache = sessionCache();
+			@synchronized(cache) {
+				SSL_SESSION *session = [[cache objectForKey:cacheKey] pointerValue];
+				if (session)
+					SSL_set_session(_ssl, session); //Takes its own reference
+			}
+		}
+	}
+	return self;
+}
+
+-(id)initServerWithContext:(SSL_CTX *)context {
+	return [self initWithContext:context Server:YES];
+}
+
+-(id)initWithContext:(SSL_CTX *)context Server:(BOOL)server {
+	if (!context)
+		return nil;
+	if ((self = [super init])) {
+		SSL *ssl = SSL_new(context);
+		BIO *incoming = BIO_new(BIO_s_mem());
+		BIO *outgoing = BIO_new(BIO_s_mem());
+		if (!ssl || !incoming || !outgoing) {
+			logOpenSSLErrors(@"TLS session");
+			if (ssl)
+				SSL_free(ssl);
+			if (incoming)
+				BIO_free(incoming);
+			if (outgoing)
+				BIO_free(outgoing);
+			return nil;
+		}
+		BIO_set_mem_eof_return(incoming, -1); //Empty means wait for more, not end of stream
+		SSL_set_bio(ssl, incoming, outgoing); //Freed along with ssl
+		SSL_set_app_data(ssl, (__bridge void *)self);
+		if (server)
+			SSL_set_accept_state(ssl);
+		else
+			SSL_set_connect_state(ssl);
+		_ssl = ssl;
+		_incoming = incoming;
+		_outgoing = outgoing;
+	}
+	return self;
+}
+
+-(void)dealloc {
+	if (_ssl)
+		SSL_free(_ssl);
+}
+
++(SSL_CTX *)newAnonymousServerContextWithPrime:(NSData *)prime {
+	initialiseOpenSSL();
+	SSL_CTX *context = SSL_CTX_new(SSLv23_server_method());
+	DH *dh = DH_new();
+	BOOL configured = NO;
+	if (context && dh && prime.length > 0) {
+		dh->p = BN_bin2bn([prime bytes], (int)prime.length, NULL);
+		dh->g = BN_new();
+		configured = (dh->p && dh->g && BN_set_word(dh->g, DH_GENERATOR_2) &&
+					  SSL_CTX_set_tmp_dh(context, dh) == 1); //Copies dh
+	}
+	if (dh)
+		DH_free(dh);
+	if (!configured) {
+		logOpenSSLErrors(@"TLS server context");
+		if (context)
+			SSL_CTX_free(context);
+		return NULL;
+	}
+	
+	configureAnonymous(context);
+	SSL_CTX_set_options(context, SSL_OP_SINGLE_DH_USE); //New key pair per handshake
+	return context;
+}
+
+#pragma mark - TLS - Public
+-(BOOL)startHandshake {
+	@synchronized(self) {
+		return [self advanceHandshake];
+	}
+}
+
+-(BOOL)receiveCiphertext:(const void *)bytes Length:(NSUInteger)length Plaintext:(NSMutableData *)plaintext {
+	@synchronized(self) {
+		if (length > 0 && BIO_write(_incoming, bytes, (int)length) != (int)length) {
+			logOpenSSLErrors(@"TLS receive");
+			return NO;
+		}
+		if (!SSL_is_init_finished(_ssl)) {
+			if (![self advanceHandshake]) {
+				if (self.cacheKey) //Don't offer it again, eg. the server forgot it and then failed
+					[[self class] removeCachedSessionForKey:self.cacheKey];
+				return NO;
+			}
+			if (!SSL_is_init_finished(_ssl))
+				return YES; //Waiting on the peer
+		}
+		
+		//Decrypt straight into plaintext
+		while (YES) {
+			NSUInteger start = plaintext.length;
+			[plaintext setLength:start + READ_CHUNK];
+			int read = SSL_read(_ssl, (uint8_t *)[plaintext mutableBytes] + start, READ_CHUNK);
+			[plaintext setLength:start + MAX(read, 0)];
+			if (read > 0)
+				continue;
+			
+			int error = SSL_get_error(_ssl, read);
+			if (error == SSL_ERROR_WANT_READ)
+				return YES; //Everything received so far is decrypted
+			if (error == SSL_ERROR_ZERO_RETURN)
+				DLogInf(@"TLS closed by peer");
+			else
+				logOpenSSLErrors(@"TLS read");
+			return NO;
+		}
+	}
+}
+
+-(BOOL)sendPlaintext:(const void *)bytes Length:(NSUInteger)length {
+	@synchronized(self) {
+		if (!SSL_is_init_finished(_ssl)) {
+			DLogErr(@"TLS write before the handshake finished");
+			return NO;
+		}
+		const uint8_t *cursor = bytes;
+		while (length > 0) { //Memory BIOs take everything, a write only stops short at INT_MAX
+			int written = SSL_write(_ssl, cursor, (int)MIN(length, INT_MAX));
+			if (written <= 0) {
+				logOpenSSLErrors(@"TLS write");
+				return NO;
+			}
+			cursor += written;
+			length -= written;
+		}
+		return YES;
+	}
+}
+
+-(NSData *)takeCiphertext {
+	@synchronized(self) {
+		size_t pending = BIO_ctrl_pending(_outgoing);
+		if (pending == 0)
+			return nil;
+		NSMutableData *ciphertext = [NSMutableData dataWithLength:pending];
+		int read = BIO_read(_outgoing, [ciphertext mutableBytes], (int)pending);
+		if (read <= 0)
+			return nil;
+		[ciphertext setLength:read];
+		return ciphertext;
+	}
+}
+
+-(BOOL)isHandshakeComplete {
+	@synchronized(self) {
+		return SSL_is_init_finished(_ssl) ? YES : NO;
+	}
+}
+
+-(BOOL)isResumed {
+	@synchronized(self) {
+		return SSL_session_reused(_ssl) ? YES : NO;
+	}
+}
+
+#pragma mark - TLS - Private
+//Within @synchronized(self).  YES when finished or waiting on the peer
+-(BOOL)advanceHandshake {
+	if (SSL_is_init_finished(_ssl))
+		return YES;
+	int result = SSL_do_handshake(_ssl);
+	if (result == 1)
+		return YES;
+	int error = SSL_get_error(_ssl, result);
+	if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE)
+		return YES;
+	logOpenSSLErrors(@"TLS handshake");
+	return NO;
+}
+
+#pragma mark - Session Cache - Public
++(BOOL)hasCachedSessionForKey:(NSString *)cacheKey {
+	if (!cacheKey)
+		return NO;
+	NSMutableDictionary *cache = sessionCache();
+	@synchronized(cache) {
+		return [cache objectForKey:cacheKey] != nil;
+	}
+}
+
++(void)removeCachedSessionForKey:(NSString *)cacheKey {
+	if (!cacheKey)
+		return;
+	NSMutableDictionary *cache = sessionCache();
+	@synchronized(cache) {
+		SSL_SESSION *session = [[cache objectForKey:cacheKey] pointerValue];
+		if (session)
+			SSL_SESSION_free(session);
+		[cache removeObjectForKey:cacheKey];
+	}
+}
+
++(void)removeAllCachedSessions {
+	NSMutableDictionary *cache = sessionCache();
+	@synchronized(cache) {
+		for (NSValue *session in [cache allValues])
+			SSL_SESSION_free([session pointerValue]);
+		[cache removeAllObjects];
+	}
+}
+
++(NSDictionary *)savedSessionForKey:(NSString *)cacheKey {
+	if (!cacheKey)
+		return nil;
+	NSMutableDictionary *cache = sessionCache();
+	@synchronized(cache) {
+		SSL_SESSION *session = [[cache objectForKey:cacheKey] pointerValue];
+		if (!session)
+			return nil;
+		int length = i2d_SSL_SESSION(session, NULL);
+		if (length <= 0)
+			return nil;
+		NSMutableData *encoded = [NSMutableData dataWithLength:length];
+		unsigned char *bytes = encoded.mutableBytes;
+		if (i2d_SSL_SESSION(session, &bytes) != length) {
+			logOpenSSLErrors(@"TLS session save");
+			return nil;
+		}
+		NSDate *expires = [NSDate dateWithTimeIntervalSince1970:(NSTimeInterval)SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session)];
+		return @{SAVED_SESSION_KEY:encoded, SAVED_EXPIRY_KEY:expires};
+	}
+}
+
++(BOOL)restoreSavedSession:(NSDictionary *)savedSession ForKey:(NSString *)cacheKey {
+	NSData *encoded = [savedSession objectForKey:SAVED_SESSION_KEY];
+	NSDate *expires = [savedSession objectForKey:SAVED_EXPIRY_KEY];
+	if (!cacheKey || ![encoded isKindOfClass:[NSData class]] || ![expires isKindOfClass:[NSDate class]])
+		return NO;
+	if ([expires timeIntervalSinceNow] <= 0 || [self hasCachedSessionForKey:cacheKey])
+		return NO;
+	
+	initialiseOpenSSL();
+	const unsigned char *bytes = encoded.bytes;
+	SSL_SESSION *session = d2i_SSL_SESSION(NULL, &bytes, (long)encoded.length);
+	if (!session) {
+		logOpenSSLErrors(@"TLS session restore");
+		return NO;
+	}
+	cacheSession(cacheKey, session);
+	return YES;
+}
+@end
@@ -18,6 +18,7 @@
 //Supported Protocol Versions (ie. 3.3, 3.7, 3.8)
 #define MAX_VERSION 0x0308 //3.8 - hex integer
 #define MIN_VERSION 0x0303 //3.3
+#define RFB_VERSION_DATA_LENGTH 12 //"RFB xxx.yyy\n"
 
 @interface VersionMsg : RFBMessage
 @property (nonatomic, assign) int major;
@@ -28,6 +29,7 @@
 - (id)initWithMajor:(int)major
 			  Minor:(int)minor;
 - (id)initWithData:(NSData *)version;
+- (id)initWithBytes:(const char *)version Length:(NSUInteger)length; //As initWithData, parsed in place
 
 #pragma mark -
 - (NSData *)data;
@@ -15,8 +15,6 @@
 
 #import "VersionMsg.h"
 
-#define RFB_VERSION_DATA_LENGTH 12
-
 @interface VersionMsg()
 
 @end
@@ -43,13 +41,15 @@
 }
 
 - (id)initWithData:(NSData *)version {
-	const char *versionString = [version bytes];
-	
-	if (version.length != RFB_VERSION_DATA_LENGTH) {
+	return [self initWithBytes:[version bytes] Length:version.length];
+}
+
+- (id)initWithBytes:(const char *)versionString Length:(NSUInteger)length {
+	if (length != RFB_VERSION_DATA_LENGTH) {
         /*@throw [NSException exceptionWithName:NSRangeException
 									   reason:@"Error, cannot init Version outside of RFB Version specification."
 									 userInfo:nil];*/
-        DLogErr(@"Error, cannot init Version outside of RFB Version specification.  Data Length: %lu", (unsigned long)version.length);
+        DLogErr(@"Error, cannot init Version outside of RFB Version specification.  Data Length: %lu", (unsigned long)length);
 		return nil;
 	}
 	if (versionString[0] != 'R' || versionString[1] != 'F' || versionString[2] != 'B' || versionString[3] != ' ' || versionString[7] != '.' || versionString[11] != 0x000a) {
@@ -60,12 +60,11 @@
 		return nil;
 	}
 	
-	NSData *majorD = [version subdataWithRange:NSMakeRange(4, 3)];
-	NSData *minorD = [version subdataWithRange:NSMakeRange(8, 3)];
-	int major = [[NSString stringWithCString:[majorD bytes] encoding:NSUTF8StringEncoding] intValue];
-	int minor = [[NSString stringWithCString:[minorD bytes] encoding:NSUTF8StringEncoding] intValue];
+	//3 digit major and minor numbers, "RFB xxx.yyy\n"
+	int major = [[self class] numberFromDigits:versionString + 4];
+	int minor = [[self class] numberFromDigits:versionString + 8];
 	
-	if (major == 0 && minor == 0) {
+	if (major < 0 || minor < 0 || (major == 0 && minor == 0)) {
         /*@throw [NSException exceptionWithName:NSInvalidArgumentException
 									   reason:@"Error, cannot init Version with supplied byte data, invalid RFB Version string."
 									 userInfo:nil];*/
@@ -77,6 +76,18 @@
                          Minor:minor];
 }
 
+#pragma mark - Private Methods
+//Parse 3 ascii digits, -1 if any aren't digits
++ (int)numberFromDigits:(const char *)digits {
+	int number = 0;
+	for (int i = 0; i < 3; i++) {
+		if (digits[i] < '0' || digits[i] > '9')
+			return -1;
+		number = number * 10 + (digits[i] - '0');
+	}
+	return number;
+}
+
 #pragma mark - Other Public Methods
 -(NSData *)data {
 	char buffer[RFB_VERSION_DATA_LENGTH];
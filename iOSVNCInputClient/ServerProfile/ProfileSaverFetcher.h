@@ -23,6 +23,9 @@
 
 @interface ProfileSaverFetcher : NSObject
 +(BOOL)saveServerProfile:(ServerProfile *)serverProfile ToURL:(NSURL *)saveURL Error:(NSError **)error;
+//Rewrite just what a connect refreshes (handshake cache, TLS session) in the saved copy of the profile, found by address,
+//port, username and password.  NO if the profile isn't saved or the write failed
++(BOOL)saveConnectionStateOfServerProfile:(ServerProfile *)serverProfile Error:(NSError **)error;
 +(ServerProfile *)readSavedProfileFromURL:(NSURL *)url Error:(NSError **)error;
 +(BOOL)deleteSavedProfileFromURL:(NSURL*)url Error:(NSError **)error;
 +(NSArray *)fetchSavedProfilesURLList:(NSError **)error;
@@ -15,7 +15,9 @@
 
 #import "ProfileSaverFetcher.h"
 #import "ServerProfile.h"
+#import "RFBHandshakeCache.h"
 #import "Des.h"
+#import "NSData+HexString.h"
 
 #import "ErrorHandlingMacros.h"
 #import "HandleErrors.h"
@@ -23,7 +25,7 @@
 #define SAVE_DIR NSDocumentDirectory
 #define URL_MASK NSUserDomainMask
 //See props in ServerProfile class
-#define PROFILE_DICT_KEYS @"ServerName, ServerVersion, Address, Port, Username, Password, ARD35, MacAuth"
+#define PROFILE_DICT_KEYS @"ServerName, ServerVersion, Address, Port, Username, Password, ARD35, MacAuth, TLS, Handshake, TLSSession"
 
 @implementation ProfileSaverFetcher
 #pragma mark - Private Methods
@@ -97,6 +99,44 @@
     return matchFound;
 }
 
+//URL of the saved copy of profile, nil if there isn't one
++(NSURL *)savedURLForProfile:(ServerProfile *)profile Error:(NSError **)error {
+    NSArray *savedURLs = [[self class] fetchSavedProfilesURLList:error];
+    NSUInteger profileHash = [profile hash];
+    for (NSURL *savedURL in savedURLs) {
+        NSError *readError = nil;
+        ServerProfile *savedProfile = [[self class] readSavedProfileFromURL:savedURL Error:&readError];
+        if (savedProfile && [savedProfile hash] == profileHash)
+            return savedURL;
+    }
+    return nil;
+}
+
+//The saved TLS session holds its master secret, so it's encrypted as the password is: as a property list, hex encoded for
+//Des's text methods.  Empty if there's no session
++(NSString *)encryptedTLSSession:(NSDictionary *)tlsSession {
+	if (tlsSession.count == 0)
+		return @"";
+	NSData *sessionData = [NSPropertyListSerialization dataWithPropertyList:tlsSession
+																	 format:NSPropertyListBinaryFormat_v1_0
+																	options:0
+																	  error:nil];
+	return sessionData ? [Des encryptText:[NSData hexString:sessionData] WithKey:nil] : @"";
+}
+
+//nil if there's none, it won't decrypt, or it was saved unencrypted by an earlier version
++(NSDictionary *)decryptedTLSSession:(id)savedSession {
+	if (![savedSession isKindOfClass:[NSString class]] || [savedSession length] == 0)
+		return nil;
+	NSString *hexSession = [Des decryptText:savedSession WithKey:nil];
+	NSData *sessionData = (hexSession.length > 0) ? [NSData dataFromHexString:hexSession] : nil;
+	NSDictionary *tlsSession = sessionData ? [NSPropertyListSerialization propertyListWithData:sessionData
+																					   options:NSPropertyListImmutable
+																						format:NULL
+																						 error:nil] : nil;
+	return [tlsSession isKindOfClass:[NSDictionary class]] ? tlsSession : nil;
+}
+
 #pragma mark - Public Methods
 //Save/Update Profile Into File
 +(BOOL)saveServerProfile:(ServerProfile *)serverProfile ToURL:(NSURL *)targetUrl Error:(NSError **)error {
@@ -131,7 +171,7 @@
 	}
 	
 	//Extract rest of values from profile object
-	NSArray *profileProps = @[serverProfile.serverName, serverProfile.serverVersion, serverProfile.address, [NSNumber numberWithInt:serverProfile.port], serverProfile.username, encryptedPassword, [NSNumber numberWithBool:serverProfile.ard35Compatibility], [NSNumber numberWithBool:serverProfile.macAuthentication]];
+	NSArray *profileProps = @[serverProfile.serverName, serverProfile.serverVersion, serverProfile.address, [NSNumber numberWithInt:serverProfile.port], serverProfile.username, encryptedPassword, [NSNumber numberWithBool:serverProfile.ard35Compatibility], [NSNumber numberWithBool:serverProfile.macAuthentication], [NSNumber numberWithBool:serverProfile.tlsSecurity], (serverProfile.handshakeCache ? [serverProfile.handshakeCache dictionaryRepresentation] : @{}), [[self class] encryptedTLSSession:serverProfile.tlsSession]];
 	NSArray *profileKeys = [PROFILE_DICT_KEYS componentsSeparatedByString:@", "];
 	NSDictionary *plistDict = [NSDictionary dictionaryWithObjects:profileProps
 														  forKeys:profileKeys];
@@ -157,6 +197,41 @@
 	}
 }
 
+//Update connection state in the saved profile, leaving the user's settings as saved
++(BOOL)saveConnectionStateOfServerProfile:(ServerProfile *)serverProfile Error:(NSError **)error {
+	//Get error handling block
+	HandleError handleE = [HandleErrors handleErrorBlock];
+	
+	NSURL *profileURL = [[self class] savedURLForProfile:serverProfile Error:error];
+	if (!profileURL) {
+		handleE(error, FileErrorDomain, FileExistReadError, [NSString stringWithFormat:@"No saved profile for %@:%i to update", serverProfile.address, serverProfile.port]);
+		return NO;
+	}
+	
+	NSData *plistData = [[self fMg] contentsAtPath:[profileURL path]];
+	NSError *dataErr = nil;
+	NSMutableDictionary *plistDict = plistData ? [NSPropertyListSerialization propertyListWithData:plistData
+																							options:NSPropertyListMutableContainersAndLeaves
+																							 format:NULL
+																							  error:&dataErr] : nil;
+	if (![plistDict isKindOfClass:[NSMutableDictionary class]]) {
+		handleE(error, FileErrorDomain, FileReadError, [NSString stringWithFormat:@"Could not read saved profile at %@: %@", [profileURL path], [dataErr localizedDescription]]);
+		return NO;
+	}
+	[plistDict setObject:(serverProfile.handshakeCache ? [serverProfile.handshakeCache dictionaryRepresentation] : @{}) forKey:@"Handshake"];
+	[plistDict setObject:[[self class] encryptedTLSSession:serverProfile.tlsSession] forKey:@"TLSSession"];
+	
+	plistData = [NSPropertyListSerialization dataWithPropertyList:plistDict
+														   format:NSPropertyListXMLFormat_v1_0
+														  options:0
+															error:&dataErr];
+	if (!plistData || ![plistData writeToURL:profileURL atomically:YES]) {
+		handleE(error, FileErrorDomain, FileSaveError, [NSString stringWithFormat:@"Failed to update server profile at URL %@", profileURL]);
+		return NO;
+	}
+	return YES;
+}
+
 //Restore Profile From File
 +(ServerProfile *)readSavedProfileFromURL:(NSURL *)url Error:(NSError **)error {
 	//Get error handling block
@@ -203,6 +278,9 @@
 		handleError(error, FileErrorDomain, FileReadError, [NSString stringWithFormat:@"Could not restore saved Profile with dict: %@", plistDict]);
 		return nil;
 	}
+	serverProfile.tlsSecurity = [[plistDict objectForKey:@"TLS"] boolValue]; //Missing from profiles saved before it = NO
+	serverProfile.handshakeCache = [[RFBHandshakeCache alloc] initWithDictionary:[plistDict objectForKey:@"Handshake"]]; //nil if never connected
+	serverProfile.tlsSession = [[self class] decryptedTLSSession:[plistDict objectForKey:@"TLSSession"]];
 	
 	return serverProfile;
 }
@@ -23,10 +23,12 @@
 #import "RFBSecurityNone.h"
 #import "RFBConnection.h"
 #import "RFBInputConnManager.h"
+#import "ProfileSaverFetcher.h"
 
 @implementation ServerProfile (Probe)
 #pragma mark - Probe connection - public
 //Result returned as a probeResult Dictionary as well as directly updating values in profile passed in
+//Always connects, so a server that has changed is noticed.  The handshake cache only skips round trips on connect
 + (NSDictionary *)probeServerProfile:(ServerProfile *)serverProfile ProbeType:(ProbeType)type Error:(NSError **)error {
     //Create connection object based on supplied profile details
 	RFBConnection *conn = [RFBInputConnManager createConnectionWithProfile:serverProfile
@@ -64,6 +66,12 @@
         }
     }
     
+    //Server's answers this time, kept for the next connect if the profile is saved.  Off main already
+    serverProfile.handshakeCache = conn.handshakeCache;
+    NSError *saveError = nil;
+    if (![ProfileSaverFetcher saveConnectionStateOfServerProfile:serverProfile Error:&saveError])
+        DLogInf(@"Handshake cache not saved: %@", [saveError localizedDescription]);
+    
 	//Fish results out of RFB Connection object
 	NSDictionary *probeResult = @{ProbeResultKey_Type:[NSNumber numberWithUnsignedInteger:type],
                                ProbeResultKey_ServerProfile:serverProfile,
@@ -16,6 +16,8 @@
 #import <Foundation/Foundation.h>
 #import "VersionMsg.h"
 
+@class RFBHandshakeCache;
+
 @interface ServerProfile : NSObject
 @property (copy, nonatomic) NSString *address;
 @property (nonatomic, assign) int port;
@@ -25,6 +27,9 @@
 @property (nonatomic, copy) NSString *password;
 @property (nonatomic, assign) BOOL ard35Compatibility;
 @property (nonatomic, assign) BOOL macAuthentication;
+@property (nonatomic, assign) BOOL tlsSecurity; //VeNCrypt TLS, resuming the last TLS session with this server
+@property (nonatomic, strong) RFBHandshakeCache *handshakeCache; //Server's answers last time, see RFBConnection
+@property (nonatomic, copy) NSDictionary *tlsSession; //Last TLS session with this server, resumed after a relaunch, see RFBSecurityVeNCrypt.  Saved encrypted
 
 #pragma mark - public methods
 -(id)init;
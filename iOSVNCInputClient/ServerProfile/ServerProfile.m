@@ -114,6 +114,9 @@
                                                                  ServerVersion:self.serverVersion
                                                                          ARD35:self.ard35Compatibility
                                                                        MacAuth:self.macAuthentication];
+    spCopy.tlsSecurity = self.tlsSecurity;
+    spCopy.handshakeCache = self.handshakeCache;
+    spCopy.tlsSession = self.tlsSession;
     return spCopy;
 }
 @end
@@ -31,6 +31,13 @@
 							  Key:(NSData *)key
 						  Encrypt:(BOOL)encrypt;
 
+//Encrypt/Decrypt length bytes in place, ECB.  length must be a multiple of 8, nothing is allocated per block.
+//The key's schedule is worked out once and reused while it's one of the last few keys used.  NO if the key is weak
++(BOOL)cryptBytes:(void *)bytes
+		   Length:(NSUInteger)length
+			  Key:(NSData *)key
+		  Encrypt:(BOOL)encrypt;
+
 #pragma mark - de/encrypt data of variable length - Public Methods
 //Encrypt plaintext (C String) with key and return ciphertext
 //Key must be a DES_cblock key (length 8 bytes) wrapped in a NSData object
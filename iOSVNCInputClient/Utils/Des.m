@@ -17,10 +17,73 @@
 
 #import "NSData+HexString.h"
 
+#import <libkern/OSAtomic.h> //OSSpinLock
+
 //Openssl libcrypto
 #import <des.h>
 //#import <rand.h>
 
+#define KEY_SCHEDULE_CACHE_SIZE 4 //Keys in use at once, eg. the profile key and a VNC password
+
+//Key schedules already worked out, so a key is only checked and expanded once however many blocks it encrypts
+typedef struct {
+	BOOL valid;
+	DES_cblock key;
+	DES_key_schedule schedule;
+} DesCachedSchedule;
+
+static DesCachedSchedule scheduleCache[KEY_SCHEDULE_CACHE_SIZE];
+static NSUInteger scheduleCacheNext; //Oldest entry, replaced next
+static OSSpinLock scheduleCacheLock = OS_SPINLOCK_INIT;
+
+//Schedule for the first 8 bytes of key.  NO if the key is shorter than that or weak
+static BOOL keyScheduleForKey(NSData *key, DES_key_schedule *schedule) {
+	if (key.length < sizeof(DES_cblock)) {
+		DLogErr(@"DES key must be %lu bytes, got %lu", sizeof(DES_cblock), (unsigned long)key.length);
+		return NO;
+	}
+	DES_cblock desKey;
+	memcpy(desKey, [key bytes], sizeof(DES_cblock)); //Grab only the first 8 bytes as required
+	
+	OSSpinLockLock(&scheduleCacheLock);
+	for (NSUInteger i = 0; i < KEY_SCHEDULE_CACHE_SIZE; i++) {
+		if (scheduleCache[i].valid && memcmp(scheduleCache[i].key, desKey, sizeof(DES_cblock)) == 0) {
+			*schedule = scheduleCache[i].schedule;
+			OSSpinLockUnlock(&scheduleCacheLock);
+			return YES;
+		}
+	}
+	OSSpinLockUnlock(&scheduleCacheLock);
+	
+	DES_cblock checkedKey;
+	memcpy(checkedKey, desKey, sizeof(DES_cblock));
+	int checkResult = DES_set_key_checked(&checkedKey, schedule);
+	if (checkResult == -1) { //Optional... Works fine regardless of whether odd parity or not
+		DLogWar(@"Supplied key is not of odd parity: %i", checkResult);
+		DES_set_odd_parity(&checkedKey);
+		checkResult = DES_set_key_checked(&checkedKey, schedule);
+		DLogWar(@"Check result after manually setting parity to odd: %i", checkResult);
+	}
+	if (checkResult != 0) {
+		DLogErr(@"Supplied key is weak: %i", checkResult);
+		return NO;
+	}
+	
+	//Cached under the key as supplied, before any parity fix
+	OSSpinLockLock(&scheduleCacheLock);
+	DesCachedSchedule *entry = &scheduleCache[scheduleCacheNext];
+	scheduleCacheNext = (scheduleCacheNext + 1) % KEY_SCHEDULE_CACHE_SIZE;
+	memcpy(entry->key, desKey, sizeof(DES_cblock));
+	entry->schedule = *schedule;
+	entry->valid = YES;
+	OSSpinLockUnlock(&scheduleCacheLock);
+	return YES;
+}
+
+static NSUInteger roundUpToBlock(NSUInteger length) {
+	return (length + sizeof(DES_cblock) - 1) / sizeof(DES_cblock) * sizeof(DES_cblock);
+}
+
 @implementation Des
 #pragma mark - de/encrypt 64bit blocks - Public Methods
 //Encrypt/Decrypt block using supplied key.  ECB method (each block encrypted with same key).
@@ -34,29 +97,10 @@
 		return nil;
 	}
 	
-	//Set DES key
-	DES_cblock *desKey = malloc(sizeof(DES_cblock));
-	memcpy(desKey, [key bytes], sizeof(DES_cblock)); //Grab only the first 8 bytes as required
-	
-	DES_key_schedule keysched;
-	int checkResult = DES_set_key_checked(desKey, &keysched);
-	if (checkResult == -1) { //Optional... Works fine regardless of whether odd parity or not
-		DLogWar(@"Supplied key is not of odd parity: %i", checkResult);
-		DES_set_odd_parity(desKey);
-		checkResult = DES_set_key_checked(desKey, &keysched);
-		DLogWar(@"Check result after manually setting parity to odd: %i", checkResult);
-	} else if (checkResult != 0) {
-		DLogErr(@"Supplied key is weak: %i", checkResult);
-		return nil;
-	}
-	
-	//Encrypt/decrypt.  YES = DES_ENCRYPT, NO = DES_DECRYPT
 	unsigned char outputM[sizeof(DES_cblock)];
-    DES_cblock *inputM = (DES_cblock *)[msgBlock bytes];
-	DES_ecb_encrypt(inputM, (DES_cblock *)outputM, &keysched, encrypt);
-    
-	//Cleanup
-	free(desKey);
+	memcpy(outputM, [msgBlock bytes], sizeof(outputM));
+	if (![self cryptBytes:outputM Length:sizeof(outputM) Key:key Encrypt:encrypt])
+		return nil;
     
 	return [NSData dataWithBytes:outputM
 						  length:sizeof(outputM)];
@@ -67,41 +111,37 @@
 					MessageOffset:(NSUInteger)offset
 							  Key:(NSData *)key
 						  Encrypt:(BOOL)encrypt {
+	//Extract message given offset, padding with zeros if required.  On the stack, not a copy of the slice
+	unsigned char block[sizeof(DES_cblock)] = {0};
+	if (offset < message.length)
+		memcpy(block, (const unsigned char *)[message bytes] + offset, MIN(sizeof(block), message.length - offset));
 	
-	//Extract message given offset, padding with zeros if required
-	NSData *msgSubset = [[self class] msgBlockForMsg:message
-                                              Offset:offset];
+	//Return blank NSData if en/decrypt fails
+	if (![self cryptBytes:block Length:sizeof(block) Key:key Encrypt:encrypt])
+		return [NSData data];
 	
-	//Encrypt/Decrypt block
-	NSData *cipherSubset = [[self class] encryptBlock:msgSubset
-                                                  Key:key
-                                              Encrypt:encrypt];
-    
-    //Return blank NSData if en/decrypt fails
-	if (!cipherSubset) {
-        cipherSubset = [NSData data];
-    }
-    
-	return cipherSubset;
+	return [NSData dataWithBytes:block
+						  length:sizeof(block)];
 }
 
-#pragma mark - Private Methods
-//Extract 64-bit (8 byte) block of message, padding with zeros if not enough elements in remaining msg up to 8 bytes
-+(NSData *)msgBlockForMsg:(NSData *)message
-                   Offset:(NSUInteger)offset {
-    static const NSUInteger blockSize = 8; //bytes
++(BOOL)cryptBytes:(void *)bytes
+		   Length:(NSUInteger)length
+			  Key:(NSData *)key
+		  Encrypt:(BOOL)encrypt {
+	if (length % sizeof(DES_cblock) != 0) {
+		DLogErr(@"Cannot encrypt/decrypt %lu bytes, not a whole number of DES_cblock blocks (8 bytes)", (unsigned long)length);
+		return NO;
+	}
 	
-    NSUInteger readLength = offset+blockSize;
-    if (readLength <= message.length) {
-        return [message subdataWithRange:NSMakeRange(offset, blockSize)];
-    } else {
-        //Read remaining data that is < 8 bytes in length
-        NSInteger rangeLength = message.length-offset;
-        
-        NSMutableData *subset = [[message subdataWithRange:NSMakeRange(offset, rangeLength)] mutableCopy];
-        [subset setLength:blockSize]; //Pad 0's to blockSize (these don't get included in the original msg)
-        return subset;
-    }
+	DES_key_schedule keysched;
+	if (!keyScheduleForKey(key, &keysched))
+		return NO;
+	
+	//Encrypt/decrypt in place.  YES = DES_ENCRYPT, NO = DES_DECRYPT.  Each block is read in full before it's written
+	unsigned char *block = bytes;
+	for (NSUInteger i = 0; i < length; i += sizeof(DES_cblock))
+		DES_ecb_encrypt((const_DES_cblock *)(block + i), (DES_cblock *)(block + i), &keysched, encrypt);
+	return YES;
 }
 
 #pragma mark - de/encrypt data of variable length - Public Methods
@@ -115,24 +155,10 @@
 		return [NSData data];
     }
     
-	//Encrypt each 8 byte block of the message.
-    BOOL failedEncrypt = NO;
-	NSMutableData *ciphertext = [NSMutableData dataWithCapacity:plaindata.length]; //Extended automatically if padding req.
-	for (uint i = 0; i < plaindata.length; i += 8) {
-        NSData *encryptedBlock = [[self class] encryptBlockForMessage:plaindata
-                                                        MessageOffset:i
-                                                                  Key:key
-                                                              Encrypt:YES];
-        
-        if (encryptedBlock.length == 0 || encryptedBlock == nil) {
-            failedEncrypt = YES;
-            break;
-        }
-        
-		[ciphertext appendData:encryptedBlock];
-	}
-    
-    if (failedEncrypt) {
+	//Copy once, pad with zeros to whole blocks, then encrypt in place
+	NSMutableData *ciphertext = [plaindata mutableCopy];
+	[ciphertext setLength:roundUpToBlock(plaindata.length)];
+	if (![self cryptBytes:[ciphertext mutableBytes] Length:ciphertext.length Key:key Encrypt:YES]) {
         DLogErr(@"Failed to encrypt plain text!");
         return [NSData data];
     }
@@ -149,48 +175,18 @@
 	if (!cipherdata || cipherdata.length == 0 || !key || key.length == 0) {
 		return [NSData data];
     }
-	   
-    //Note: couldn't use NSData's appendData as could not append c string null term after rebuilding string
-    BOOL failedDecryption = NO;
-    unsigned char plaintextBytes[cipherdata.length+1]; //+1 size for null term
-	for (uint i = 0; i < cipherdata.length; i += 8) {
-        NSData *decryptedBlock = [[self class] encryptBlockForMessage:cipherdata
-                                                        MessageOffset:i
-                                                                  Key:key
-                                                              Encrypt:NO];
-        
-        //Break loop and fail if decryption fails
-        if (decryptedBlock.length == 0 || decryptedBlock == nil) {
-            failedDecryption = YES;
-            break;
-        }
-        
-        //Copy decrypted bytes into buffer
-        memccpy(plaintextBytes + i, [decryptedBlock bytes], (unsigned int)[decryptedBlock length], ((unsigned int)[decryptedBlock length] * sizeof(unsigned char)));
-	}
 	
-    //Return empty NSData object if decryption fails
-    if (failedDecryption) {
+	//On the heap, large messages would overflow a stack buffer.  Decrypted in place
+	NSMutableData *plaintext = [cipherdata mutableCopy];
+	[plaintext setLength:roundUpToBlock(cipherdata.length)];
+	if (![self cryptBytes:[plaintext mutableBytes] Length:plaintext.length Key:key Encrypt:NO]) {
         DLogErr(@"Failed to decrypt message block: %@", cipherdata);
         return [NSData data];
     }
     
-    //Append null term to end of c string
-    plaintextBytes[cipherdata.length] = '\0';
-    
-    //!!!!: Temp, remove later
-    /*
-	NSString *debug = [NSString stringWithUTF8String:(char *)plaintextBytes];
-    if (!debug || debug.length == 0) {
-        DLog(@"debug decrypted string: %@", debug);
-        DLog(@"plaintextbytes: %s", (char *)plaintextBytes);
-        DLog(@"");
-    }
-    */
-    
-    //Wrap in NSData
-    NSData *plaintext = [NSData dataWithBytes:plaintextBytes
-                                       length:sizeof(plaintextBytes)];
+    //Trim any padding and append null term to end of c string
+	[plaintext setLength:cipherdata.length + 1];
+	((unsigned char *)[plaintext mutableBytes])[cipherdata.length] = '\0';
     
 	return plaintext;
 }
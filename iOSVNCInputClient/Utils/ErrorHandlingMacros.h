@@ -26,6 +26,8 @@
 #define SocketReadError 100
 #define SocketConnectError 110
 #define SocketSecurityError 120
+#define SocketCancelError 130
+#define SocketEventDroppedError 140
 
 #define FileSaveError 200
 #define FileReadError 210
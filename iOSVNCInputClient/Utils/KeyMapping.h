@@ -19,5 +19,9 @@
 
 //Translate unichar to X11 Key Symbols
 + (UInt32)unicharToX11KeySym:(unichar)ch;
+//As above for any unicode code point, eg. decoded from a surrogate pair
++ (UInt32)codePointToX11KeySym:(UTF32Char)ch;
+//keysymdef.h name without the XK_ prefix (eg. Control_L, Delete, F5), or a single character.  0 (NoSymbol) if unknown
++ (UInt32)keySymForName:(NSString *)name;
 
 @end
@@ -17,11 +17,29 @@
 
 #define XK_MISCELLANY //Needs to be before importing keysymdef for TTY keys in keysymdef.h to function
 #include "keysymdef.h"
+#include "KeySymTable.h" //Generated from keysymdef.h by generate_keysym_table.py
+#include "KeySymNames.h"
+
+//Keysym annotated for ch in keysymdef.h, 0 if none
+static inline UInt32 tableKeySym(UTF32Char ch) {
+    UTF32Char page = ch >> KEYSYM_TABLE_PAGE_BITS;
+    if (page >= KEYSYM_TABLE_FIRST_LEVEL_LENGTH)
+        return 0;
+    return KeySymTablePages[KeySymTableFirstLevel[page]][ch & ((1 << KEYSYM_TABLE_PAGE_BITS) - 1)];
+}
+
+static int compareKeySymName(const void *name, const void *entry) {
+    return strcmp((const char *)name, ((const KeySymName *)entry)->name);
+}
 
 @implementation KeyMapping
 
-//TODO: Implement larger character set?
 + (UInt32)unicharToX11KeySym:(unichar)ch;
+{
+    return [self codePointToX11KeySym:ch];
+}
+
++ (UInt32)codePointToX11KeySym:(UTF32Char)ch;
 {
     UInt32 mappedKeyValue;
     
@@ -30,6 +48,8 @@
         mappedKeyValue = ch;
     } else if (ch == 0x08) {    // backspace
         mappedKeyValue = XK_BackSpace;
+    } else if (ch == 0x09) {    // tab, eg. in pasted text
+        mappedKeyValue = XK_Tab;
     } else if (ch == 0x0A) {    // linefeed
         //FIXME: Not sure if will keep this config but will do so for now.  Needed to Return to work in OS X
         //mappedKeyValue = XK_Linefeed;
@@ -38,7 +58,9 @@
         mappedKeyValue = XK_Return;
     } else if (ch == 0x0F) {    // delete
         mappedKeyValue = XK_Delete;
-    }else {
+    } else if ((mappedKeyValue = tableKeySym(ch))) {
+        // Legacy keysym from keysymdef.h, eg. Greek, Cyrillic, Kana
+    } else {
         // Deal with unichars from extensions of keysym as per below paragraph from keysymdef.h:
 		/*
 		 * For any future extension of the keysyms with characters already
@@ -54,4 +76,23 @@
     return mappedKeyValue;
 }
 
++ (UInt32)keySymForName:(NSString *)name;
+{
+    if (name.length == 0)
+        return 0;
+    
+    const char *cName = [name UTF8String];
+    const KeySymName *entry = bsearch(cName, KeySymNames, KEYSYM_NAMES_LENGTH, sizeof(KeySymName), compareKeySymName);
+    if (entry)
+        return entry->keysym;
+    
+    // A single character stands for itself, eg. "€" or one outside the BMP
+    if (name.length == 1)
+        return [self codePointToX11KeySym:[name characterAtIndex:0]];
+    unichar high = [name characterAtIndex:0];
+    if (name.length == 2 && CFStringIsSurrogateHighCharacter(high) && CFStringIsSurrogateLowCharacter([name characterAtIndex:1]))
+        return [self codePointToX11KeySym:CFStringGetLongCharacterForSurrogatePair(high, [name characterAtIndex:1])];
+    return 0;
+}
+
 @end
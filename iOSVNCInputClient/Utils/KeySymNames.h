@@ -0,0 +1,1693 @@
+//  GENERATED by generate_keysym_table.py from keysymdef.h, do not edit.
+//  1676 XK_* names, sorted by strcmp for binary search.
+
+#ifndef KeySymNames_h
+#define KeySymNames_h
+
+typedef struct {
+    const char *name; //Without the XK_ prefix
+    uint32_t keysym;
+} KeySymName;
+
+#define KEYSYM_NAMES_LENGTH 1676
+
+static const KeySymName KeySymNames[KEYSYM_NAMES_LENGTH] = {
+    { "0", 0x0030 },
+    { "1", 0x0031 },
+    { "2", 0x0032 },
+    { "3", 0x0033 },
+    { "3270_AltCursor", 0xfd10 },
+    { "3270_Attn", 0xfd0e },
+    { "3270_BackTab", 0xfd05 },
+    { "3270_ChangeScreen", 0xfd19 },
+    { "3270_Copy", 0xfd15 },
+    { "3270_CursorBlink", 0xfd0f },
+    { "3270_CursorSelect", 0xfd1c },
+    { "3270_DeleteWord", 0xfd1a },
+    { "3270_Duplicate", 0xfd01 },
+    { "3270_Enter", 0xfd1e },
+    { "3270_EraseEOF", 0xfd06 },
+    { "3270_EraseInput", 0xfd07 },
+    { "3270_ExSelect", 0xfd1b },
+    { "3270_FieldMark", 0xfd02 },
+    { "3270_Ident", 0xfd13 },
+    { "3270_Jump", 0xfd12 },
+    { "3270_KeyClick", 0xfd11 },
+    { "3270_Left2", 0xfd04 },
+    { "3270_PA1", 0xfd0a },
+    { "3270_PA2", 0xfd0b },
+    { "3270_PA3", 0xfd0c },
+    { "3270_Play", 0xfd16 },
+    { "3270_PrintScreen", 0xfd1d },
+    { "3270_Quit", 0xfd09 },
+    { "3270_Record", 0xfd18 },
+    { "3270_Reset", 0xfd08 },
+    { "3270_Right2", 0xfd03 },
+    { "3270_Rule", 0xfd14 },
+    { "3270_Setup", 0xfd17 },
+    { "3270_Test", 0xfd0d },
+    { "4", 0x0034 },
+    { "5", 0x0035 },
+    { "6", 0x0036 },
+    { "7", 0x0037 },
+    { "8", 0x0038 },
+    { "9", 0x0039 },
+    { "A", 0x0041 },
+    { "AE", 0x00c6 },
+    { "Aacute", 0x00c1 },
+    { "Abelowdot", 0x1001ea0 },
+    { "Abreve", 0x01c3 },
+    { "Abreveacute", 0x1001eae },
+    { "Abrevebelowdot", 0x1001eb6 },
+    { "Abrevegrave", 0x1001eb0 },
+    { "Abrevehook", 0x1001eb2 },
+    { "Abrevetilde", 0x1001eb4 },
+    { "AccessX_Enable", 0xfe70 },
+    { "AccessX_Feedback_Enable", 0xfe71 },
+    { "Acircumflex", 0x00c2 },
+    { "Acircumflexacute", 0x1001ea4 },
+    { "Acircumflexbelowdot", 0x1001eac },
+    { "Acircumflexgrave", 0x1001ea6 },
+    { "Acircumflexhook", 0x1001ea8 },
+    { "Acircumflextilde", 0x1001eaa },
+    { "Adiaeresis", 0x00c4 },
+    { "Agrave", 0x00c0 },
+    { "Ahook", 0x1001ea2 },
+    { "Alt_L", 0xffe9 },
+    { "Alt_R", 0xffea },
+    { "Amacron", 0x03c0 },
+    { "Aogonek", 0x01a1 },
+    { "Arabic_0", 0x1000660 },
+    { "Arabic_1", 0x1000661 },
+    { "Arabic_2", 0x1000662 },
+    { "Arabic_3", 0x1000663 },
+    { "Arabic_4", 0x1000664 },
+    { "Arabic_5", 0x1000665 },
+    { "Arabic_6", 0x1000666 },
+    { "Arabic_7", 0x1000667 },
+    { "Arabic_8", 0x1000668 },
+    { "Arabic_9", 0x1000669 },
+    { "Arabic_ain", 0x05d9 },
+    { "Arabic_alef", 0x05c7 },
+    { "Arabic_alefmaksura", 0x05e9 },
+    { "Arabic_beh", 0x05c8 },
+    { "Arabic_comma", 0x05ac },
+    { "Arabic_dad", 0x05d6 },
+    { "Arabic_dal", 0x05cf },
+    { "Arabic_damma", 0x05ef },
+    { "Arabic_dammatan", 0x05ec },
+    { "Arabic_ddal", 0x1000688 },
+    { "Arabic_farsi_yeh", 0x10006cc },
+    { "Arabic_fatha", 0x05ee },
+    { "Arabic_fathatan", 0x05eb },
+    { "Arabic_feh", 0x05e1 },
+    { "Arabic_fullstop", 0x10006d4 },
+    { "Arabic_gaf", 0x10006af },
+    { "Arabic_ghain", 0x05da },
+    { "Arabic_ha", 0x05e7 },
+    { "Arabic_hah", 0x05cd },
+    { "Arabic_hamza", 0x05c1 },
+    { "Arabic_hamza_above", 0x1000654 },
+    { "Arabic_hamza_below", 0x1000655 },
+    { "Arabic_hamzaonalef", 0x05c3 },
+    { "Arabic_hamzaonwaw", 0x05c4 },
+    { "Arabic_hamzaonyeh", 0x05c6 },
+    { "Arabic_hamzaunderalef", 0x05c5 },
+    { "Arabic_heh", 0x05e7 },
+    { "Arabic_heh_doachashmee", 0x10006be },
+    { "Arabic_heh_goal", 0x10006c1 },
+    { "Arabic_jeem", 0x05cc },
+    { "Arabic_jeh", 0x1000698 },
+    { "Arabic_kaf", 0x05e3 },
+    { "Arabic_kasra", 0x05f0 },
+    { "Arabic_kasratan", 0x05ed },
+    { "Arabic_keheh", 0x10006a9 },
+    { "Arabic_khah", 0x05ce },
+    { "Arabic_lam", 0x05e4 },
+    { "Arabic_madda_above", 0x1000653 },
+    { "Arabic_maddaonalef", 0x05c2 },
+    { "Arabic_meem", 0x05e5 },
+    { "Arabic_noon", 0x05e6 },
+    { "Arabic_noon_ghunna", 0x10006ba },
+    { "Arabic_peh", 0x100067e },
+    { "Arabic_percent", 0x100066a },
+    { "Arabic_qaf", 0x05e2 },
+    { "Arabic_question_mark", 0x05bf },
+    { "Arabic_ra", 0x05d1 },
+    { "Arabic_rreh", 0x1000691 },
+    { "Arabic_sad", 0x05d5 },
+    { "Arabic_seen", 0x05d3 },
+    { "Arabic_semicolon", 0x05bb },
+    { "Arabic_shadda", 0x05f1 },
+    { "Arabic_sheen", 0x05d4 },
+    { "Arabic_sukun", 0x05f2 },
+    { "Arabic_superscript_alef", 0x1000670 },
+    { "Arabic_switch", 0xff7e },
+    { "Arabic_tah", 0x05d7 },
+    { "Arabic_tatweel", 0x05e0 },
+    { "Arabic_tcheh", 0x1000686 },
+    { "Arabic_teh", 0x05ca },
+    { "Arabic_tehmarbuta", 0x05c9 },
+    { "Arabic_thal", 0x05d0 },
+    { "Arabic_theh", 0x05cb },
+    { "Arabic_tteh", 0x1000679 },
+    { "Arabic_veh", 0x10006a4 },
+    { "Arabic_waw", 0x05e8 },
+    { "Arabic_yeh", 0x05ea },
+    { "Arabic_yeh_baree", 0x10006d2 },
+    { "Arabic_zah", 0x05d8 },
+    { "Arabic_zain", 0x05d2 },
+    { "Aring", 0x00c5 },
+    { "Armenian_AT", 0x1000538 },
+    { "Armenian_AYB", 0x1000531 },
+    { "Armenian_BEN", 0x1000532 },
+    { "Armenian_CHA", 0x1000549 },
+    { "Armenian_DA", 0x1000534 },
+    { "Armenian_DZA", 0x1000541 },
+    { "Armenian_E", 0x1000537 },
+    { "Armenian_FE", 0x1000556 },
+    { "Armenian_GHAT", 0x1000542 },
+    { "Armenian_GIM", 0x1000533 },
+    { "Armenian_HI", 0x1000545 },
+    { "Armenian_HO", 0x1000540 },
+    { "Armenian_INI", 0x100053b },
+    { "Armenian_JE", 0x100054b },
+    { "Armenian_KE", 0x1000554 },
+    { "Armenian_KEN", 0x100053f },
+    { "Armenian_KHE", 0x100053d },
+    { "Armenian_LYUN", 0x100053c },
+    { "Armenian_MEN", 0x1000544 },
+    { "Armenian_NU", 0x1000546 },
+    { "Armenian_O", 0x1000555 },
+    { "Armenian_PE", 0x100054a },
+    { "Armenian_PYUR", 0x1000553 },
+    { "Armenian_RA", 0x100054c },
+    { "Armenian_RE", 0x1000550 },
+    { "Armenian_SE", 0x100054d },
+    { "Armenian_SHA", 0x1000547 },
+    { "Armenian_TCHE", 0x1000543 },
+    { "Armenian_TO", 0x1000539 },
+    { "Armenian_TSA", 0x100053e },
+    { "Armenian_TSO", 0x1000551 },
+    { "Armenian_TYUN", 0x100054f },
+    { "Armenian_VEV", 0x100054e },
+    { "Armenian_VO", 0x1000548 },
+    { "Armenian_VYUN", 0x1000552 },
+    { "Armenian_YECH", 0x1000535 },
+    { "Armenian_ZA", 0x1000536 },
+    { "Armenian_ZHE", 0x100053a },
+    { "Armenian_accent", 0x100055b },
+    { "Armenian_amanak", 0x100055c },
+    { "Armenian_apostrophe", 0x100055a },
+    { "Armenian_at", 0x1000568 },
+    { "Armenian_ayb", 0x1000561 },
+    { "Armenian_ben", 0x1000562 },
+    { "Armenian_but", 0x100055d },
+    { "Armenian_cha", 0x1000579 },
+    { "Armenian_da", 0x1000564 },
+    { "Armenian_dza", 0x1000571 },
+    { "Armenian_e", 0x1000567 },
+    { "Armenian_exclam", 0x100055c },
+    { "Armenian_fe", 0x1000586 },
+    { "Armenian_full_stop", 0x1000589 },
+    { "Armenian_ghat", 0x1000572 },
+    { "Armenian_gim", 0x1000563 },
+    { "Armenian_hi", 0x1000575 },
+    { "Armenian_ho", 0x1000570 },
+    { "Armenian_hyphen", 0x100058a },
+    { "Armenian_ini", 0x100056b },
+    { "Armenian_je", 0x100057b },
+    { "Armenian_ke", 0x1000584 },
+    { "Armenian_ken", 0x100056f },
+    { "Armenian_khe", 0x100056d },
+    { "Armenian_ligature_ew", 0x1000587 },
+    { "Armenian_lyun", 0x100056c },
+    { "Armenian_men", 0x1000574 },
+    { "Armenian_nu", 0x1000576 },
+    { "Armenian_o", 0x1000585 },
+    { "Armenian_paruyk", 0x100055e },
+    { "Armenian_pe", 0x100057a },
+    { "Armenian_pyur", 0x1000583 },
+    { "Armenian_question", 0x100055e },
+    { "Armenian_ra", 0x100057c },
+    { "Armenian_re", 0x1000580 },
+    { "Armenian_se", 0x100057d },
+    { "Armenian_separation_mark", 0x100055d },
+    { "Armenian_sha", 0x1000577 },
+    { "Armenian_shesht", 0x100055b },
+    { "Armenian_tche", 0x1000573 },
+    { "Armenian_to", 0x1000569 },
+    { "Armenian_tsa", 0x100056e },
+    { "Armenian_tso", 0x1000581 },
+    { "Armenian_tyun", 0x100057f },
+    { "Armenian_verjaket", 0x1000589 },
+    { "Armenian_vev", 0x100057e },
+    { "Armenian_vo", 0x1000578 },
+    { "Armenian_vyun", 0x1000582 },
+    { "Armenian_yech", 0x1000565 },
+    { "Armenian_yentamna", 0x100058a },
+    { "Armenian_za", 0x1000566 },
+    { "Armenian_zhe", 0x100056a },
+    { "Atilde", 0x00c3 },
+    { "AudibleBell_Enable", 0xfe7a },
+    { "B", 0x0042 },
+    { "Babovedot", 0x1001e02 },
+    { "BackSpace", 0xff08 },
+    { "Begin", 0xff58 },
+    { "BounceKeys_Enable", 0xfe74 },
+    { "Break", 0xff6b },
+    { "Byelorussian_SHORTU", 0x06be },
+    { "Byelorussian_shortu", 0x06ae },
+    { "C", 0x0043 },
+    { "Cabovedot", 0x02c5 },
+    { "Cacute", 0x01c6 },
+    { "Cancel", 0xff69 },
+    { "Caps_Lock", 0xffe5 },
+    { "Ccaron", 0x01c8 },
+    { "Ccedilla", 0x00c7 },
+    { "Ccircumflex", 0x02c6 },
+    { "Clear", 0xff0b },
+    { "Codeinput", 0xff37 },
+    { "ColonSign", 0x10020a1 },
+    { "Control_L", 0xffe3 },
+    { "Control_R", 0xffe4 },
+    { "CruzeiroSign", 0x10020a2 },
+    { "Cyrillic_A", 0x06e1 },
+    { "Cyrillic_BE", 0x06e2 },
+    { "Cyrillic_CHE", 0x06fe },
+    { "Cyrillic_CHE_descender", 0x10004b6 },
+    { "Cyrillic_CHE_vertstroke", 0x10004b8 },
+    { "Cyrillic_DE", 0x06e4 },
+    { "Cyrillic_DZHE", 0x06bf },
+    { "Cyrillic_E", 0x06fc },
+    { "Cyrillic_EF", 0x06e6 },
+    { "Cyrillic_EL", 0x06ec },
+    { "Cyrillic_EM", 0x06ed },
+    { "Cyrillic_EN", 0x06ee },
+    { "Cyrillic_EN_descender", 0x10004a2 },
+    { "Cyrillic_ER", 0x06f2 },
+    { "Cyrillic_ES", 0x06f3 },
+    { "Cyrillic_GHE", 0x06e7 },
+    { "Cyrillic_GHE_bar", 0x1000492 },
+    { "Cyrillic_HA", 0x06e8 },
+    { "Cyrillic_HARDSIGN", 0x06ff },
+    { "Cyrillic_HA_descender", 0x10004b2 },
+    { "Cyrillic_I", 0x06e9 },
+    { "Cyrillic_IE", 0x06e5 },
+    { "Cyrillic_IO", 0x06b3 },
+    { "Cyrillic_I_macron", 0x10004e2 },
+    { "Cyrillic_JE", 0x06b8 },
+    { "Cyrillic_KA", 0x06eb },
+    { "Cyrillic_KA_descender", 0x100049a },
+    { "Cyrillic_KA_vertstroke", 0x100049c },
+    { "Cyrillic_LJE", 0x06b9 },
+    { "Cyrillic_NJE", 0x06ba },
+    { "Cyrillic_O", 0x06ef },
+    { "Cyrillic_O_bar", 0x10004e8 },
+    { "Cyrillic_PE", 0x06f0 },
+    { "Cyrillic_SCHWA", 0x10004d8 },
+    { "Cyrillic_SHA", 0x06fb },
+    { "Cyrillic_SHCHA", 0x06fd },
+    { "Cyrillic_SHHA", 0x10004ba },
+    { "Cyrillic_SHORTI", 0x06ea },
+    { "Cyrillic_SOFTSIGN", 0x06f8 },
+    { "Cyrillic_TE", 0x06f4 },
+    { "Cyrillic_TSE", 0x06e3 },
+    { "Cyrillic_U", 0x06f5 },
+    { "Cyrillic_U_macron", 0x10004ee },
+    { "Cyrillic_U_straight", 0x10004ae },
+    { "Cyrillic_U_straight_bar", 0x10004b0 },
+    { "Cyrillic_VE", 0x06f7 },
+    { "Cyrillic_YA", 0x06f1 },
+    { "Cyrillic_YERU", 0x06f9 },
+    { "Cyrillic_YU", 0x06e0 },
+    { "Cyrillic_ZE", 0x06fa },
+    { "Cyrillic_ZHE", 0x06f6 },
+    { "Cyrillic_ZHE_descender", 0x1000496 },
+    { "Cyrillic_a", 0x06c1 },
+    { "Cyrillic_be", 0x06c2 },
+    { "Cyrillic_che", 0x06de },
+    { "Cyrillic_che_descender", 0x10004b7 },
+    { "Cyrillic_che_vertstroke", 0x10004b9 },
+    { "Cyrillic_de", 0x06c4 },
+    { "Cyrillic_dzhe", 0x06af },
+    { "Cyrillic_e", 0x06dc },
+    { "Cyrillic_ef", 0x06c6 },
+    { "Cyrillic_el", 0x06cc },
+    { "Cyrillic_em", 0x06cd },
+    { "Cyrillic_en", 0x06ce },
+    { "Cyrillic_en_descender", 0x10004a3 },
+    { "Cyrillic_er", 0x06d2 },
+    { "Cyrillic_es", 0x06d3 },
+    { "Cyrillic_ghe", 0x06c7 },
+    { "Cyrillic_ghe_bar", 0x1000493 },
+    { "Cyrillic_ha", 0x06c8 },
+    { "Cyrillic_ha_descender", 0x10004b3 },
+    { "Cyrillic_hardsign", 0x06df },
+    { "Cyrillic_i", 0x06c9 },
+    { "Cyrillic_i_macron", 0x10004e3 },
+    { "Cyrillic_ie", 0x06c5 },
+    { "Cyrillic_io", 0x06a3 },
+    { "Cyrillic_je", 0x06a8 },
+    { "Cyrillic_ka", 0x06cb },
+    { "Cyrillic_ka_descender", 0x100049b },
+    { "Cyrillic_ka_vertstroke", 0x100049d },
+    { "Cyrillic_lje", 0x06a9 },
+    { "Cyrillic_nje", 0x06aa },
+    { "Cyrillic_o", 0x06cf },
+    { "Cyrillic_o_bar", 0x10004e9 },
+    { "Cyrillic_pe", 0x06d0 },
+    { "Cyrillic_schwa", 0x10004d9 },
+    { "Cyrillic_sha", 0x06db },
+    { "Cyrillic_shcha", 0x06dd },
+    { "Cyrillic_shha", 0x10004bb },
+    { "Cyrillic_shorti", 0x06ca },
+    { "Cyrillic_softsign", 0x06d8 },
+    { "Cyrillic_te", 0x06d4 },
+    { "Cyrillic_tse", 0x06c3 },
+    { "Cyrillic_u", 0x06d5 },
+    { "Cyrillic_u_macron", 0x10004ef },
+    { "Cyrillic_u_straight", 0x10004af },
+    { "Cyrillic_u_straight_bar", 0x10004b1 },
+    { "Cyrillic_ve", 0x06d7 },
+    { "Cyrillic_ya", 0x06d1 },
+    { "Cyrillic_yeru", 0x06d9 },
+    { "Cyrillic_yu", 0x06c0 },
+    { "Cyrillic_ze", 0x06da },
+    { "Cyrillic_zhe", 0x06d6 },
+    { "Cyrillic_zhe_descender", 0x1000497 },
+    { "D", 0x0044 },
+    { "Dabovedot", 0x1001e0a },
+    { "Dcaron", 0x01cf },
+    { "Delete", 0xffff },
+    { "DongSign", 0x10020ab },
+    { "Down", 0xff54 },
+    { "Dstroke", 0x01d0 },
+    { "E", 0x0045 },
+    { "ENG", 0x03bd },
+    { "ETH", 0x00d0 },
+    { "Eabovedot", 0x03cc },
+    { "Eacute", 0x00c9 },
+    { "Ebelowdot", 0x1001eb8 },
+    { "Ecaron", 0x01cc },
+    { "Ecircumflex", 0x00ca },
+    { "Ecircumflexacute", 0x1001ebe },
+    { "Ecircumflexbelowdot", 0x1001ec6 },
+    { "Ecircumflexgrave", 0x1001ec0 },
+    { "Ecircumflexhook", 0x1001ec2 },
+    { "Ecircumflextilde", 0x1001ec4 },
+    { "EcuSign", 0x10020a0 },
+    { "Ediaeresis", 0x00cb },
+    { "Egrave", 0x00c8 },
+    { "Ehook", 0x1001eba },
+    { "Eisu_Shift", 0xff2f },
+    { "Eisu_toggle", 0xff30 },
+    { "Emacron", 0x03aa },
+    { "End", 0xff57 },
+    { "Eogonek", 0x01ca },
+    { "Escape", 0xff1b },
+    { "Eth", 0x00d0 },
+    { "Etilde", 0x1001ebc },
+    { "EuroSign", 0x20ac },
+    { "Execute", 0xff62 },
+    { "F", 0x0046 },
+    { "F1", 0xffbe },
+    { "F10", 0xffc7 },
+    { "F11", 0xffc8 },
+    { "F12", 0xffc9 },
+    { "F13", 0xffca },
+    { "F14", 0xffcb },
+    { "F15", 0xffcc },
+    { "F16", 0xffcd },
+    { "F17", 0xffce },
+    { "F18", 0xffcf },
+    { "F19", 0xffd0 },
+    { "F2", 0xffbf },
+    { "F20", 0xffd1 },
+    { "F21", 0xffd2 },
+    { "F22", 0xffd3 },
+    { "F23", 0xffd4 },
+    { "F24", 0xffd5 },
+    { "F25", 0xffd6 },
+    { "F26", 0xffd7 },
+    { "F27", 0xffd8 },
+    { "F28", 0xffd9 },
+    { "F29", 0xffda },
+    { "F3", 0xffc0 },
+    { "F30", 0xffdb },
+    { "F31", 0xffdc },
+    { "F32", 0xffdd },
+    { "F33", 0xffde },
+    { "F34", 0xffdf },
+    { "F35", 0xffe0 },
+    { "F4", 0xffc1 },
+    { "F5", 0xffc2 },
+    { "F6", 0xffc3 },
+    { "F7", 0xffc4 },
+    { "F8", 0xffc5 },
+    { "F9", 0xffc6 },
+    { "FFrancSign", 0x10020a3 },
+    { "Fabovedot", 0x1001e1e },
+    { "Farsi_0", 0x10006f0 },
+    { "Farsi_1", 0x10006f1 },
+    { "Farsi_2", 0x10006f2 },
+    { "Farsi_3", 0x10006f3 },
+    { "Farsi_4", 0x10006f4 },
+    { "Farsi_5", 0x10006f5 },
+    { "Farsi_6", 0x10006f6 },
+    { "Farsi_7", 0x10006f7 },
+    { "Farsi_8", 0x10006f8 },
+    { "Farsi_9", 0x10006f9 },
+    { "Farsi_yeh", 0x10006cc },
+    { "Find", 0xff68 },
+    { "First_Virtual_Screen", 0xfed0 },
+    { "G", 0x0047 },
+    { "Gabovedot", 0x02d5 },
+    { "Gbreve", 0x02ab },
+    { "Gcaron", 0x10001e6 },
+    { "Gcedilla", 0x03ab },
+    { "Gcircumflex", 0x02d8 },
+    { "Georgian_an", 0x10010d0 },
+    { "Georgian_ban", 0x10010d1 },
+    { "Georgian_can", 0x10010ea },
+    { "Georgian_char", 0x10010ed },
+    { "Georgian_chin", 0x10010e9 },
+    { "Georgian_cil", 0x10010ec },
+    { "Georgian_don", 0x10010d3 },
+    { "Georgian_en", 0x10010d4 },
+    { "Georgian_fi", 0x10010f6 },
+    { "Georgian_gan", 0x10010d2 },
+    { "Georgian_ghan", 0x10010e6 },
+    { "Georgian_hae", 0x10010f0 },
+    { "Georgian_har", 0x10010f4 },
+    { "Georgian_he", 0x10010f1 },
+    { "Georgian_hie", 0x10010f2 },
+    { "Georgian_hoe", 0x10010f5 },
+    { "Georgian_in", 0x10010d8 },
+    { "Georgian_jhan", 0x10010ef },
+    { "Georgian_jil", 0x10010eb },
+    { "Georgian_kan", 0x10010d9 },
+    { "Georgian_khar", 0x10010e5 },
+    { "Georgian_las", 0x10010da },
+    { "Georgian_man", 0x10010db },
+    { "Georgian_nar", 0x10010dc },
+    { "Georgian_on", 0x10010dd },
+    { "Georgian_par", 0x10010de },
+    { "Georgian_phar", 0x10010e4 },
+    { "Georgian_qar", 0x10010e7 },
+    { "Georgian_rae", 0x10010e0 },
+    { "Georgian_san", 0x10010e1 },
+    { "Georgian_shin", 0x10010e8 },
+    { "Georgian_tan", 0x10010d7 },
+    { "Georgian_tar", 0x10010e2 },
+    { "Georgian_un", 0x10010e3 },
+    { "Georgian_vin", 0x10010d5 },
+    { "Georgian_we", 0x10010f3 },
+    { "Georgian_xan", 0x10010ee },
+    { "Georgian_zen", 0x10010d6 },
+    { "Georgian_zhar", 0x10010df },
+    { "Greek_ALPHA", 0x07c1 },
+    { "Greek_ALPHAaccent", 0x07a1 },
+    { "Greek_BETA", 0x07c2 },
+    { "Greek_CHI", 0x07d7 },
+    { "Greek_DELTA", 0x07c4 },
+    { "Greek_EPSILON", 0x07c5 },
+    { "Greek_EPSILONaccent", 0x07a2 },
+    { "Greek_ETA", 0x07c7 },
+    { "Greek_ETAaccent", 0x07a3 },
+    { "Greek_GAMMA", 0x07c3 },
+    { "Greek_IOTA", 0x07c9 },
+    { "Greek_IOTAaccent", 0x07a4 },
+    { "Greek_IOTAdiaeresis", 0x07a5 },
+    { "Greek_IOTAdieresis", 0x07a5 },
+    { "Greek_KAPPA", 0x07ca },
+    { "Greek_LAMBDA", 0x07cb },
+    { "Greek_LAMDA", 0x07cb },
+    { "Greek_MU", 0x07cc },
+    { "Greek_NU", 0x07cd },
+    { "Greek_OMEGA", 0x07d9 },
+    { "Greek_OMEGAaccent", 0x07ab },
+    { "Greek_OMICRON", 0x07cf },
+    { "Greek_OMICRONaccent", 0x07a7 },
+    { "Greek_PHI", 0x07d6 },
+    { "Greek_PI", 0x07d0 },
+    { "Greek_PSI", 0x07d8 },
+    { "Greek_RHO", 0x07d1 },
+    { "Greek_SIGMA", 0x07d2 },
+    { "Greek_TAU", 0x07d4 },
+    { "Greek_THETA", 0x07c8 },
+    { "Greek_UPSILON", 0x07d5 },
+    { "Greek_UPSILONaccent", 0x07a8 },
+    { "Greek_UPSILONdieresis", 0x07a9 },
+    { "Greek_XI", 0x07ce },
+    { "Greek_ZETA", 0x07c6 },
+    { "Greek_accentdieresis", 0x07ae },
+    { "Greek_alpha", 0x07e1 },
+    { "Greek_alphaaccent", 0x07b1 },
+    { "Greek_beta", 0x07e2 },
+    { "Greek_chi", 0x07f7 },
+    { "Greek_delta", 0x07e4 },
+    { "Greek_epsilon", 0x07e5 },
+    { "Greek_epsilonaccent", 0x07b2 },
+    { "Greek_eta", 0x07e7 },
+    { "Greek_etaaccent", 0x07b3 },
+    { "Greek_finalsmallsigma", 0x07f3 },
+    { "Greek_gamma", 0x07e3 },
+    { "Greek_horizbar", 0x07af },
+    { "Greek_iota", 0x07e9 },
+    { "Greek_iotaaccent", 0x07b4 },
+    { "Greek_iotaaccentdieresis", 0x07b6 },
+    { "Greek_iotadieresis", 0x07b5 },
+    { "Greek_kappa", 0x07ea },
+    { "Greek_lambda", 0x07eb },
+    { "Greek_lamda", 0x07eb },
+    { "Greek_mu", 0x07ec },
+    { "Greek_nu", 0x07ed },
+    { "Greek_omega", 0x07f9 },
+    { "Greek_omegaaccent", 0x07bb },
+    { "Greek_omicron", 0x07ef },
+    { "Greek_omicronaccent", 0x07b7 },
+    { "Greek_phi", 0x07f6 },
+    { "Greek_pi", 0x07f0 },
+    { "Greek_psi", 0x07f8 },
+    { "Greek_rho", 0x07f1 },
+    { "Greek_sigma", 0x07f2 },
+    { "Greek_switch", 0xff7e },
+    { "Greek_tau", 0x07f4 },
+    { "Greek_theta", 0x07e8 },
+    { "Greek_upsilon", 0x07f5 },
+    { "Greek_upsilonaccent", 0x07b8 },
+    { "Greek_upsilonaccentdieresis", 0x07ba },
+    { "Greek_upsilondieresis", 0x07b9 },
+    { "Greek_xi", 0x07ee },
+    { "Greek_zeta", 0x07e6 },
+    { "H", 0x0048 },
+    { "Hangul", 0xff31 },
+    { "Hangul_A", 0x0ebf },
+    { "Hangul_AE", 0x0ec0 },
+    { "Hangul_AraeA", 0x0ef6 },
+    { "Hangul_AraeAE", 0x0ef7 },
+    { "Hangul_Banja", 0xff39 },
+    { "Hangul_Cieuc", 0x0eba },
+    { "Hangul_Codeinput", 0xff37 },
+    { "Hangul_Dikeud", 0x0ea7 },
+    { "Hangul_E", 0x0ec4 },
+    { "Hangul_EO", 0x0ec3 },
+    { "Hangul_EU", 0x0ed1 },
+    { "Hangul_End", 0xff33 },
+    { "Hangul_Hanja", 0xff34 },
+    { "Hangul_Hieuh", 0x0ebe },
+    { "Hangul_I", 0x0ed3 },
+    { "Hangul_Ieung", 0x0eb7 },
+    { "Hangul_J_Cieuc", 0x0eea },
+    { "Hangul_J_Dikeud", 0x0eda },
+    { "Hangul_J_Hieuh", 0x0eee },
+    { "Hangul_J_Ieung", 0x0ee8 },
+    { "Hangul_J_Jieuj", 0x0ee9 },
+    { "Hangul_J_Khieuq", 0x0eeb },
+    { "Hangul_J_Kiyeog", 0x0ed4 },
+    { "Hangul_J_KiyeogSios", 0x0ed6 },
+    { "Hangul_J_KkogjiDalrinIeung", 0x0ef9 },
+    { "Hangul_J_Mieum", 0x0ee3 },
+    { "Hangul_J_Nieun", 0x0ed7 },
+    { "Hangul_J_NieunHieuh", 0x0ed9 },
+    { "Hangul_J_NieunJieuj", 0x0ed8 },
+    { "Hangul_J_PanSios", 0x0ef8 },
+    { "Hangul_J_Phieuf", 0x0eed },
+    { "Hangul_J_Pieub", 0x0ee4 },
+    { "Hangul_J_PieubSios", 0x0ee5 },
+    { "Hangul_J_Rieul", 0x0edb },
+    { "Hangul_J_RieulHieuh", 0x0ee2 },
+    { "Hangul_J_RieulKiyeog", 0x0edc },
+    { "Hangul_J_RieulMieum", 0x0edd },
+    { "Hangul_J_RieulPhieuf", 0x0ee1 },
+    { "Hangul_J_RieulPieub", 0x0ede },
+    { "Hangul_J_RieulSios", 0x0edf },
+    { "Hangul_J_RieulTieut", 0x0ee0 },
+    { "Hangul_J_Sios", 0x0ee6 },
+    { "Hangul_J_SsangKiyeog", 0x0ed5 },
+    { "Hangul_J_SsangSios", 0x0ee7 },
+    { "Hangul_J_Tieut", 0x0eec },
+    { "Hangul_J_YeorinHieuh", 0x0efa },
+    { "Hangul_Jamo", 0xff35 },
+    { "Hangul_Jeonja", 0xff38 },
+    { "Hangul_Jieuj", 0x0eb8 },
+    { "Hangul_Khieuq", 0x0ebb },
+    { "Hangul_Kiyeog", 0x0ea1 },
+    { "Hangul_KiyeogSios", 0x0ea3 },
+    { "Hangul_KkogjiDalrinIeung", 0x0ef3 },
+    { "Hangul_Mieum", 0x0eb1 },
+    { "Hangul_MultipleCandidate", 0xff3d },
+    { "Hangul_Nieun", 0x0ea4 },
+    { "Hangul_NieunHieuh", 0x0ea6 },
+    { "Hangul_NieunJieuj", 0x0ea5 },
+    { "Hangul_O", 0x0ec7 },
+    { "Hangul_OE", 0x0eca },
+    { "Hangul_PanSios", 0x0ef2 },
+    { "Hangul_Phieuf", 0x0ebd },
+    { "Hangul_Pieub", 0x0eb2 },
+    { "Hangul_PieubSios", 0x0eb4 },
+    { "Hangul_PostHanja", 0xff3b },
+    { "Hangul_PreHanja", 0xff3a },
+    { "Hangul_PreviousCandidate", 0xff3e },
+    { "Hangul_Rieul", 0x0ea9 },
+    { "Hangul_RieulHieuh", 0x0eb0 },
+    { "Hangul_RieulKiyeog", 0x0eaa },
+    { "Hangul_RieulMieum", 0x0eab },
+    { "Hangul_RieulPhieuf", 0x0eaf },
+    { "Hangul_RieulPieub", 0x0eac },
+    { "Hangul_RieulSios", 0x0ead },
+    { "Hangul_RieulTieut", 0x0eae },
+    { "Hangul_RieulYeorinHieuh", 0x0eef },
+    { "Hangul_Romaja", 0xff36 },
+    { "Hangul_SingleCandidate", 0xff3c },
+    { "Hangul_Sios", 0x0eb5 },
+    { "Hangul_Special", 0xff3f },
+    { "Hangul_SsangDikeud", 0x0ea8 },
+    { "Hangul_SsangJieuj", 0x0eb9 },
+    { "Hangul_SsangKiyeog", 0x0ea2 },
+    { "Hangul_SsangPieub", 0x0eb3 },
+    { "Hangul_SsangSios", 0x0eb6 },
+    { "Hangul_Start", 0xff32 },
+    { "Hangul_SunkyeongeumMieum", 0x0ef0 },
+    { "Hangul_SunkyeongeumPhieuf", 0x0ef4 },
+    { "Hangul_SunkyeongeumPieub", 0x0ef1 },
+    { "Hangul_Tieut", 0x0ebc },
+    { "Hangul_U", 0x0ecc },
+    { "Hangul_WA", 0x0ec8 },
+    { "Hangul_WAE", 0x0ec9 },
+    { "Hangul_WE", 0x0ece },
+    { "Hangul_WEO", 0x0ecd },
+    { "Hangul_WI", 0x0ecf },
+    { "Hangul_YA", 0x0ec1 },
+    { "Hangul_YAE", 0x0ec2 },
+    { "Hangul_YE", 0x0ec6 },
+    { "Hangul_YEO", 0x0ec5 },
+    { "Hangul_YI", 0x0ed2 },
+    { "Hangul_YO", 0x0ecb },
+    { "Hangul_YU", 0x0ed0 },
+    { "Hangul_YeorinHieuh", 0x0ef5 },
+    { "Hangul_switch", 0xff7e },
+    { "Hankaku", 0xff29 },
+    { "Hcircumflex", 0x02a6 },
+    { "Hebrew_switch", 0xff7e },
+    { "Help", 0xff6a },
+    { "Henkan", 0xff23 },
+    { "Henkan_Mode", 0xff23 },
+    { "Hiragana", 0xff25 },
+    { "Hiragana_Katakana", 0xff27 },
+    { "Home", 0xff50 },
+    { "Hstroke", 0x02a1 },
+    { "Hyper_L", 0xffed },
+    { "Hyper_R", 0xffee },
+    { "I", 0x0049 },
+    { "ISO_Center_Object", 0xfe33 },
+    { "ISO_Continuous_Underline", 0xfe30 },
+    { "ISO_Discontinuous_Underline", 0xfe31 },
+    { "ISO_Emphasize", 0xfe32 },
+    { "ISO_Enter", 0xfe34 },
+    { "ISO_Fast_Cursor_Down", 0xfe2f },
+    { "ISO_Fast_Cursor_Left", 0xfe2c },
+    { "ISO_Fast_Cursor_Right", 0xfe2d },
+    { "ISO_Fast_Cursor_Up", 0xfe2e },
+    { "ISO_First_Group", 0xfe0c },
+    { "ISO_First_Group_Lock", 0xfe0d },
+    { "ISO_Group_Latch", 0xfe06 },
+    { "ISO_Group_Lock", 0xfe07 },
+    { "ISO_Group_Shift", 0xff7e },
+    { "ISO_Last_Group", 0xfe0e },
+    { "ISO_Last_Group_Lock", 0xfe0f },
+    { "ISO_Left_Tab", 0xfe20 },
+    { "ISO_Level2_Latch", 0xfe02 },
+    { "ISO_Level3_Latch", 0xfe04 },
+    { "ISO_Level3_Lock", 0xfe05 },
+    { "ISO_Level3_Shift", 0xfe03 },
+    { "ISO_Lock", 0xfe01 },
+    { "ISO_Move_Line_Down", 0xfe22 },
+    { "ISO_Move_Line_Up", 0xfe21 },
+    { "ISO_Next_Group", 0xfe08 },
+    { "ISO_Next_Group_Lock", 0xfe09 },
+    { "ISO_Partial_Line_Down", 0xfe24 },
+    { "ISO_Partial_Line_Up", 0xfe23 },
+    { "ISO_Partial_Space_Left", 0xfe25 },
+    { "ISO_Partial_Space_Right", 0xfe26 },
+    { "ISO_Prev_Group", 0xfe0a },
+    { "ISO_Prev_Group_Lock", 0xfe0b },
+    { "ISO_Release_Both_Margins", 0xfe2b },
+    { "ISO_Release_Margin_Left", 0xfe29 },
+    { "ISO_Release_Margin_Right", 0xfe2a },
+    { "ISO_Set_Margin_Left", 0xfe27 },
+    { "ISO_Set_Margin_Right", 0xfe28 },
+    { "Iabovedot", 0x02a9 },
+    { "Iacute", 0x00cd },
+    { "Ibelowdot", 0x1001eca },
+    { "Ibreve", 0x100012c },
+    { "Icircumflex", 0x00ce },
+    { "Idiaeresis", 0x00cf },
+    { "Igrave", 0x00cc },
+    { "Ihook", 0x1001ec8 },
+    { "Imacron", 0x03cf },
+    { "Insert", 0xff63 },
+    { "Iogonek", 0x03c7 },
+    { "Itilde", 0x03a5 },
+    { "J", 0x004a },
+    { "Jcircumflex", 0x02ac },
+    { "K", 0x004b },
+    { "KP_0", 0xffb0 },
+    { "KP_1", 0xffb1 },
+    { "KP_2", 0xffb2 },
+    { "KP_3", 0xffb3 },
+    { "KP_4", 0xffb4 },
+    { "KP_5", 0xffb5 },
+    { "KP_6", 0xffb6 },
+    { "KP_7", 0xffb7 },
+    { "KP_8", 0xffb8 },
+    { "KP_9", 0xffb9 },
+    { "KP_Add", 0xffab },
+    { "KP_Begin", 0xff9d },
+    { "KP_Decimal", 0xffae },
+    { "KP_Delete", 0xff9f },
+    { "KP_Divide", 0xffaf },
+    { "KP_Down", 0xff99 },
+    { "KP_End", 0xff9c },
+    { "KP_Enter", 0xff8d },
+    { "KP_Equal", 0xffbd },
+    { "KP_F1", 0xff91 },
+    { "KP_F2", 0xff92 },
+    { "KP_F3", 0xff93 },
+    { "KP_F4", 0xff94 },
+    { "KP_Home", 0xff95 },
+    { "KP_Insert", 0xff9e },
+    { "KP_Left", 0xff96 },
+    { "KP_Multiply", 0xffaa },
+    { "KP_Next", 0xff9b },
+    { "KP_Page_Down", 0xff9b },
+    { "KP_Page_Up", 0xff9a },
+    { "KP_Prior", 0xff9a },
+    { "KP_Right", 0xff98 },
+    { "KP_Separator", 0xffac },
+    { "KP_Space", 0xff80 },
+    { "KP_Subtract", 0xffad },
+    { "KP_Tab", 0xff89 },
+    { "KP_Up", 0xff97 },
+    { "Kana_Lock", 0xff2d },
+    { "Kana_Shift", 0xff2e },
+    { "Kanji", 0xff21 },
+    { "Kanji_Bangou", 0xff37 },
+    { "Katakana", 0xff26 },
+    { "Kcedilla", 0x03d3 },
+    { "Korean_Won", 0x0eff },
+    { "L", 0x004c },
+    { "L1", 0xffc8 },
+    { "L10", 0xffd1 },
+    { "L2", 0xffc9 },
+    { "L3", 0xffca },
+    { "L4", 0xffcb },
+    { "L5", 0xffcc },
+    { "L6", 0xffcd },
+    { "L7", 0xffce },
+    { "L8", 0xffcf },
+    { "L9", 0xffd0 },
+    { "Lacute", 0x01c5 },
+    { "Last_Virtual_Screen", 0xfed4 },
+    { "Lbelowdot", 0x1001e36 },
+    { "Lcaron", 0x01a5 },
+    { "Lcedilla", 0x03a6 },
+    { "Left", 0xff51 },
+    { "Linefeed", 0xff0a },
+    { "LiraSign", 0x10020a4 },
+    { "Lstroke", 0x01a3 },
+    { "M", 0x004d },
+    { "Mabovedot", 0x1001e40 },
+    { "Macedonia_DSE", 0x06b5 },
+    { "Macedonia_GJE", 0x06b2 },
+    { "Macedonia_KJE", 0x06bc },
+    { "Macedonia_dse", 0x06a5 },
+    { "Macedonia_gje", 0x06a2 },
+    { "Macedonia_kje", 0x06ac },
+    { "Mae_Koho", 0xff3e },
+    { "Massyo", 0xff2c },
+    { "Menu", 0xff67 },
+    { "Meta_L", 0xffe7 },
+    { "Meta_R", 0xffe8 },
+    { "MillSign", 0x10020a5 },
+    { "Mode_switch", 0xff7e },
+    { "MouseKeys_Accel_Enable", 0xfe77 },
+    { "MouseKeys_Enable", 0xfe76 },
+    { "Muhenkan", 0xff22 },
+    { "Multi_key", 0xff20 },
+    { "MultipleCandidate", 0xff3d },
+    { "N", 0x004e },
+    { "Nacute", 0x01d1 },
+    { "NairaSign", 0x10020a6 },
+    { "Ncaron", 0x01d2 },
+    { "Ncedilla", 0x03d1 },
+    { "NewSheqelSign", 0x10020aa },
+    { "Next", 0xff56 },
+    { "Next_Virtual_Screen", 0xfed2 },
+    { "Ntilde", 0x00d1 },
+    { "Num_Lock", 0xff7f },
+    { "O", 0x004f },
+    { "OE", 0x13bc },
+    { "Oacute", 0x00d3 },
+    { "Obarred", 0x100019f },
+    { "Obelowdot", 0x1001ecc },
+    { "Ocaron", 0x10001d1 },
+    { "Ocircumflex", 0x00d4 },
+    { "Ocircumflexacute", 0x1001ed0 },
+    { "Ocircumflexbelowdot", 0x1001ed8 },
+    { "Ocircumflexgrave", 0x1001ed2 },
+    { "Ocircumflexhook", 0x1001ed4 },
+    { "Ocircumflextilde", 0x1001ed6 },
+    { "Odiaeresis", 0x00d6 },
+    { "Odoubleacute", 0x01d5 },
+    { "Ograve", 0x00d2 },
+    { "Ohook", 0x1001ece },
+    { "Ohorn", 0x10001a0 },
+    { "Ohornacute", 0x1001eda },
+    { "Ohornbelowdot", 0x1001ee2 },
+    { "Ohorngrave", 0x1001edc },
+    { "Ohornhook", 0x1001ede },
+    { "Ohorntilde", 0x1001ee0 },
+    { "Omacron", 0x03d2 },
+    { "Ooblique", 0x00d8 },
+    { "Oslash", 0x00d8 },
+    { "Otilde", 0x00d5 },
+    { "Overlay1_Enable", 0xfe78 },
+    { "Overlay2_Enable", 0xfe79 },
+    { "P", 0x0050 },
+    { "Pabovedot", 0x1001e56 },
+    { "Page_Down", 0xff56 },
+    { "Page_Up", 0xff55 },
+    { "Pause", 0xff13 },
+    { "PesetaSign", 0x10020a7 },
+    { "Pointer_Accelerate", 0xfefa },
+    { "Pointer_Button1", 0xfee9 },
+    { "Pointer_Button2", 0xfeea },
+    { "Pointer_Button3", 0xfeeb },
+    { "Pointer_Button4", 0xfeec },
+    { "Pointer_Button5", 0xfeed },
+    { "Pointer_Button_Dflt", 0xfee8 },
+    { "Pointer_DblClick1", 0xfeef },
+    { "Pointer_DblClick2", 0xfef0 },
+    { "Pointer_DblClick3", 0xfef1 },
+    { "Pointer_DblClick4", 0xfef2 },
+    { "Pointer_DblClick5", 0xfef3 },
+    { "Pointer_DblClick_Dflt", 0xfeee },
+    { "Pointer_DfltBtnNext", 0xfefb },
+    { "Pointer_DfltBtnPrev", 0xfefc },
+    { "Pointer_Down", 0xfee3 },
+    { "Pointer_DownLeft", 0xfee6 },
+    { "Pointer_DownRight", 0xfee7 },
+    { "Pointer_Drag1", 0xfef5 },
+    { "Pointer_Drag2", 0xfef6 },
+    { "Pointer_Drag3", 0xfef7 },
+    { "Pointer_Drag4", 0xfef8 },
+    { "Pointer_Drag5", 0xfefd },
+    { "Pointer_Drag_Dflt", 0xfef4 },
+    { "Pointer_EnableKeys", 0xfef9 },
+    { "Pointer_Left", 0xfee0 },
+    { "Pointer_Right", 0xfee1 },
+    { "Pointer_Up", 0xfee2 },
+    { "Pointer_UpLeft", 0xfee4 },
+    { "Pointer_UpRight", 0xfee5 },
+    { "Prev_Virtual_Screen", 0xfed1 },
+    { "PreviousCandidate", 0xff3e },
+    { "Print", 0xff61 },
+    { "Prior", 0xff55 },
+    { "Q", 0x0051 },
+    { "R", 0x0052 },
+    { "R1", 0xffd2 },
+    { "R10", 0xffdb },
+    { "R11", 0xffdc },
+    { "R12", 0xffdd },
+    { "R13", 0xffde },
+    { "R14", 0xffdf },
+    { "R15", 0xffe0 },
+    { "R2", 0xffd3 },
+    { "R3", 0xffd4 },
+    { "R4", 0xffd5 },
+    { "R5", 0xffd6 },
+    { "R6", 0xffd7 },
+    { "R7", 0xffd8 },
+    { "R8", 0xffd9 },
+    { "R9", 0xffda },
+    { "Racute", 0x01c0 },
+    { "Rcaron", 0x01d8 },
+    { "Rcedilla", 0x03a3 },
+    { "Redo", 0xff66 },
+    { "RepeatKeys_Enable", 0xfe72 },
+    { "Return", 0xff0d },
+    { "Right", 0xff53 },
+    { "Romaji", 0xff24 },
+    { "RupeeSign", 0x10020a8 },
+    { "S", 0x0053 },
+    { "SCHWA", 0x100018f },
+    { "Sabovedot", 0x1001e60 },
+    { "Sacute", 0x01a6 },
+    { "Scaron", 0x01a9 },
+    { "Scedilla", 0x01aa },
+    { "Scircumflex", 0x02de },
+    { "Scroll_Lock", 0xff14 },
+    { "Select", 0xff60 },
+    { "Serbian_DJE", 0x06b1 },
+    { "Serbian_DZE", 0x06bf },
+    { "Serbian_JE", 0x06b8 },
+    { "Serbian_LJE", 0x06b9 },
+    { "Serbian_NJE", 0x06ba },
+    { "Serbian_TSHE", 0x06bb },
+    { "Serbian_dje", 0x06a1 },
+    { "Serbian_dze", 0x06af },
+    { "Serbian_je", 0x06a8 },
+    { "Serbian_lje", 0x06a9 },
+    { "Serbian_nje", 0x06aa },
+    { "Serbian_tshe", 0x06ab },
+    { "Shift_L", 0xffe1 },
+    { "Shift_Lock", 0xffe6 },
+    { "Shift_R", 0xffe2 },
+    { "SingleCandidate", 0xff3c },
+    { "SlowKeys_Enable", 0xfe73 },
+    { "StickyKeys_Enable", 0xfe75 },
+    { "Super_L", 0xffeb },
+    { "Super_R", 0xffec },
+    { "Sys_Req", 0xff15 },
+    { "T", 0x0054 },
+    { "THORN", 0x00de },
+    { "Tab", 0xff09 },
+    { "Tabovedot", 0x1001e6a },
+    { "Tcaron", 0x01ab },
+    { "Tcedilla", 0x01de },
+    { "Terminate_Server", 0xfed5 },
+    { "Thai_baht", 0x0ddf },
+    { "Thai_bobaimai", 0x0dba },
+    { "Thai_chochan", 0x0da8 },
+    { "Thai_chochang", 0x0daa },
+    { "Thai_choching", 0x0da9 },
+    { "Thai_chochoe", 0x0dac },
+    { "Thai_dochada", 0x0dae },
+    { "Thai_dodek", 0x0db4 },
+    { "Thai_fofa", 0x0dbd },
+    { "Thai_fofan", 0x0dbf },
+    { "Thai_hohip", 0x0dcb },
+    { "Thai_honokhuk", 0x0dce },
+    { "Thai_khokhai", 0x0da2 },
+    { "Thai_khokhon", 0x0da5 },
+    { "Thai_khokhuat", 0x0da3 },
+    { "Thai_khokhwai", 0x0da4 },
+    { "Thai_khorakhang", 0x0da6 },
+    { "Thai_kokai", 0x0da1 },
+    { "Thai_lakkhangyao", 0x0de5 },
+    { "Thai_lekchet", 0x0df7 },
+    { "Thai_lekha", 0x0df5 },
+    { "Thai_lekhok", 0x0df6 },
+    { "Thai_lekkao", 0x0df9 },
+    { "Thai_leknung", 0x0df1 },
+    { "Thai_lekpaet", 0x0df8 },
+    { "Thai_leksam", 0x0df3 },
+    { "Thai_leksi", 0x0df4 },
+    { "Thai_leksong", 0x0df2 },
+    { "Thai_leksun", 0x0df0 },
+    { "Thai_lochula", 0x0dcc },
+    { "Thai_loling", 0x0dc5 },
+    { "Thai_lu", 0x0dc6 },
+    { "Thai_maichattawa", 0x0deb },
+    { "Thai_maiek", 0x0de8 },
+    { "Thai_maihanakat", 0x0dd1 },
+    { "Thai_maihanakat_maitho", 0x0dde },
+    { "Thai_maitaikhu", 0x0de7 },
+    { "Thai_maitho", 0x0de9 },
+    { "Thai_maitri", 0x0dea },
+    { "Thai_maiyamok", 0x0de6 },
+    { "Thai_moma", 0x0dc1 },
+    { "Thai_ngongu", 0x0da7 },
+    { "Thai_nikhahit", 0x0ded },
+    { "Thai_nonen", 0x0db3 },
+    { "Thai_nonu", 0x0db9 },
+    { "Thai_oang", 0x0dcd },
+    { "Thai_paiyannoi", 0x0dcf },
+    { "Thai_phinthu", 0x0dda },
+    { "Thai_phophan", 0x0dbe },
+    { "Thai_phophung", 0x0dbc },
+    { "Thai_phosamphao", 0x0dc0 },
+    { "Thai_popla", 0x0dbb },
+    { "Thai_rorua", 0x0dc3 },
+    { "Thai_ru", 0x0dc4 },
+    { "Thai_saraa", 0x0dd0 },
+    { "Thai_saraaa", 0x0dd2 },
+    { "Thai_saraae", 0x0de1 },
+    { "Thai_saraaimaimalai", 0x0de4 },
+    { "Thai_saraaimaimuan", 0x0de3 },
+    { "Thai_saraam", 0x0dd3 },
+    { "Thai_sarae", 0x0de0 },
+    { "Thai_sarai", 0x0dd4 },
+    { "Thai_saraii", 0x0dd5 },
+    { "Thai_sarao", 0x0de2 },
+    { "Thai_sarau", 0x0dd8 },
+    { "Thai_saraue", 0x0dd6 },
+    { "Thai_sarauee", 0x0dd7 },
+    { "Thai_sarauu", 0x0dd9 },
+    { "Thai_sorusi", 0x0dc9 },
+    { "Thai_sosala", 0x0dc8 },
+    { "Thai_soso", 0x0dab },
+    { "Thai_sosua", 0x0dca },
+    { "Thai_thanthakhat", 0x0dec },
+    { "Thai_thonangmontho", 0x0db1 },
+    { "Thai_thophuthao", 0x0db2 },
+    { "Thai_thothahan", 0x0db7 },
+    { "Thai_thothan", 0x0db0 },
+    { "Thai_thothong", 0x0db8 },
+    { "Thai_thothung", 0x0db6 },
+    { "Thai_topatak", 0x0daf },
+    { "Thai_totao", 0x0db5 },
+    { "Thai_wowaen", 0x0dc7 },
+    { "Thai_yoyak", 0x0dc2 },
+    { "Thai_yoying", 0x0dad },
+    { "Thorn", 0x00de },
+    { "Touroku", 0xff2b },
+    { "Tslash", 0x03ac },
+    { "U", 0x0055 },
+    { "Uacute", 0x00da },
+    { "Ubelowdot", 0x1001ee4 },
+    { "Ubreve", 0x02dd },
+    { "Ucircumflex", 0x00db },
+    { "Udiaeresis", 0x00dc },
+    { "Udoubleacute", 0x01db },
+    { "Ugrave", 0x00d9 },
+    { "Uhook", 0x1001ee6 },
+    { "Uhorn", 0x10001af },
+    { "Uhornacute", 0x1001ee8 },
+    { "Uhornbelowdot", 0x1001ef0 },
+    { "Uhorngrave", 0x1001eea },
+    { "Uhornhook", 0x1001eec },
+    { "Uhorntilde", 0x1001eee },
+    { "Ukrainian_GHE_WITH_UPTURN", 0x06bd },
+    { "Ukrainian_I", 0x06b6 },
+    { "Ukrainian_IE", 0x06b4 },
+    { "Ukrainian_YI", 0x06b7 },
+    { "Ukrainian_ghe_with_upturn", 0x06ad },
+    { "Ukrainian_i", 0x06a6 },
+    { "Ukrainian_ie", 0x06a4 },
+    { "Ukrainian_yi", 0x06a7 },
+    { "Ukranian_I", 0x06b6 },
+    { "Ukranian_JE", 0x06b4 },
+    { "Ukranian_YI", 0x06b7 },
+    { "Ukranian_i", 0x06a6 },
+    { "Ukranian_je", 0x06a4 },
+    { "Ukranian_yi", 0x06a7 },
+    { "Umacron", 0x03de },
+    { "Undo", 0xff65 },
+    { "Uogonek", 0x03d9 },
+    { "Up", 0xff52 },
+    { "Uring", 0x01d9 },
+    { "Utilde", 0x03dd },
+    { "V", 0x0056 },
+    { "VoidSymbol", 0xffffff },
+    { "W", 0x0057 },
+    { "Wacute", 0x1001e82 },
+    { "Wcircumflex", 0x1000174 },
+    { "Wdiaeresis", 0x1001e84 },
+    { "Wgrave", 0x1001e80 },
+    { "WonSign", 0x10020a9 },
+    { "X", 0x0058 },
+    { "Xabovedot", 0x1001e8a },
+    { "Y", 0x0059 },
+    { "Yacute", 0x00dd },
+    { "Ybelowdot", 0x1001ef4 },
+    { "Ycircumflex", 0x1000176 },
+    { "Ydiaeresis", 0x13be },
+    { "Ygrave", 0x1001ef2 },
+    { "Yhook", 0x1001ef6 },
+    { "Ytilde", 0x1001ef8 },
+    { "Z", 0x005a },
+    { "Zabovedot", 0x01af },
+    { "Zacute", 0x01ac },
+    { "Zcaron", 0x01ae },
+    { "Zen_Koho", 0xff3d },
+    { "Zenkaku", 0xff28 },
+    { "Zenkaku_Hankaku", 0xff2a },
+    { "Zstroke", 0x10001b5 },
+    { "a", 0x0061 },
+    { "aacute", 0x00e1 },
+    { "abelowdot", 0x1001ea1 },
+    { "abovedot", 0x01ff },
+    { "abreve", 0x01e3 },
+    { "abreveacute", 0x1001eaf },
+    { "abrevebelowdot", 0x1001eb7 },
+    { "abrevegrave", 0x1001eb1 },
+    { "abrevehook", 0x1001eb3 },
+    { "abrevetilde", 0x1001eb5 },
+    { "acircumflex", 0x00e2 },
+    { "acircumflexacute", 0x1001ea5 },
+    { "acircumflexbelowdot", 0x1001ead },
+    { "acircumflexgrave", 0x1001ea7 },
+    { "acircumflexhook", 0x1001ea9 },
+    { "acircumflextilde", 0x1001eab },
+    { "acute", 0x00b4 },
+    { "adiaeresis", 0x00e4 },
+    { "ae", 0x00e6 },
+    { "agrave", 0x00e0 },
+    { "ahook", 0x1001ea3 },
+    { "amacron", 0x03e0 },
+    { "ampersand", 0x0026 },
+    { "aogonek", 0x01b1 },
+    { "apostrophe", 0x0027 },
+    { "approximate", 0x08c8 },
+    { "aring", 0x00e5 },
+    { "asciicircum", 0x005e },
+    { "asciitilde", 0x007e },
+    { "asterisk", 0x002a },
+    { "at", 0x0040 },
+    { "atilde", 0x00e3 },
+    { "b", 0x0062 },
+    { "babovedot", 0x1001e03 },
+    { "backslash", 0x005c },
+    { "ballotcross", 0x0af4 },
+    { "bar", 0x007c },
+    { "blank", 0x09df },
+    { "botintegral", 0x08a5 },
+    { "botleftparens", 0x08ac },
+    { "botleftsqbracket", 0x08a8 },
+    { "botleftsummation", 0x08b2 },
+    { "botrightparens", 0x08ae },
+    { "botrightsqbracket", 0x08aa },
+    { "botrightsummation", 0x08b6 },
+    { "bott", 0x09f6 },
+    { "botvertsummationconnector", 0x08b4 },
+    { "braceleft", 0x007b },
+    { "braceright", 0x007d },
+    { "bracketleft", 0x005b },
+    { "bracketright", 0x005d },
+    { "breve", 0x01a2 },
+    { "brokenbar", 0x00a6 },
+    { "c", 0x0063 },
+    { "cabovedot", 0x02e5 },
+    { "cacute", 0x01e6 },
+    { "careof", 0x0ab8 },
+    { "caret", 0x0afc },
+    { "caron", 0x01b7 },
+    { "ccaron", 0x01e8 },
+    { "ccedilla", 0x00e7 },
+    { "ccircumflex", 0x02e6 },
+    { "cedilla", 0x00b8 },
+    { "cent", 0x00a2 },
+    { "checkerboard", 0x09e1 },
+    { "checkmark", 0x0af3 },
+    { "circle", 0x0bcf },
+    { "club", 0x0aec },
+    { "colon", 0x003a },
+    { "comma", 0x002c },
+    { "copyright", 0x00a9 },
+    { "cr", 0x09e4 },
+    { "crossinglines", 0x09ee },
+    { "currency", 0x00a4 },
+    { "cursor", 0x0aff },
+    { "d", 0x0064 },
+    { "dabovedot", 0x1001e0b },
+    { "dagger", 0x0af1 },
+    { "dcaron", 0x01ef },
+    { "dead_abovedot", 0xfe56 },
+    { "dead_abovering", 0xfe58 },
+    { "dead_acute", 0xfe51 },
+    { "dead_belowdot", 0xfe60 },
+    { "dead_breve", 0xfe55 },
+    { "dead_caron", 0xfe5a },
+    { "dead_cedilla", 0xfe5b },
+    { "dead_circumflex", 0xfe52 },
+    { "dead_diaeresis", 0xfe57 },
+    { "dead_doubleacute", 0xfe59 },
+    { "dead_grave", 0xfe50 },
+    { "dead_hook", 0xfe61 },
+    { "dead_horn", 0xfe62 },
+    { "dead_iota", 0xfe5d },
+    { "dead_macron", 0xfe54 },
+    { "dead_ogonek", 0xfe5c },
+    { "dead_semivoiced_sound", 0xfe5f },
+    { "dead_tilde", 0xfe53 },
+    { "dead_voiced_sound", 0xfe5e },
+    { "decimalpoint", 0x0abd },
+    { "degree", 0x00b0 },
+    { "diaeresis", 0x00a8 },
+    { "diamond", 0x0aed },
+    { "digitspace", 0x0aa5 },
+    { "division", 0x00f7 },
+    { "dollar", 0x0024 },
+    { "doubbaselinedot", 0x0aaf },
+    { "doubleacute", 0x01bd },
+    { "doubledagger", 0x0af2 },
+    { "doublelowquotemark", 0x0afe },
+    { "downarrow", 0x08fe },
+    { "downcaret", 0x0ba8 },
+    { "downshoe", 0x0bd6 },
+    { "downstile", 0x0bc4 },
+    { "downtack", 0x0bc2 },
+    { "dstroke", 0x01f0 },
+    { "e", 0x0065 },
+    { "eabovedot", 0x03ec },
+    { "eacute", 0x00e9 },
+    { "ebelowdot", 0x1001eb9 },
+    { "ecaron", 0x01ec },
+    { "ecircumflex", 0x00ea },
+    { "ecircumflexacute", 0x1001ebf },
+    { "ecircumflexbelowdot", 0x1001ec7 },
+    { "ecircumflexgrave", 0x1001ec1 },
+    { "ecircumflexhook", 0x1001ec3 },
+    { "ecircumflextilde", 0x1001ec5 },
+    { "ediaeresis", 0x00eb },
+    { "egrave", 0x00e8 },
+    { "ehook", 0x1001ebb },
+    { "ellipsis", 0x0aae },
+    { "em3space", 0x0aa3 },
+    { "em4space", 0x0aa4 },
+    { "emacron", 0x03ba },
+    { "emdash", 0x0aa9 },
+    { "emfilledcircle", 0x0ade },
+    { "emfilledrect", 0x0adf },
+    { "emopencircle", 0x0ace },
+    { "emopenrectangle", 0x0acf },
+    { "emspace", 0x0aa1 },
+    { "endash", 0x0aaa },
+    { "enfilledcircbullet", 0x0ae6 },
+    { "enfilledsqbullet", 0x0ae7 },
+    { "eng", 0x03bf },
+    { "enopencircbullet", 0x0ae0 },
+    { "enopensquarebullet", 0x0ae1 },
+    { "enspace", 0x0aa2 },
+    { "eogonek", 0x01ea },
+    { "equal", 0x003d },
+    { "eth", 0x00f0 },
+    { "etilde", 0x1001ebd },
+    { "exclam", 0x0021 },
+    { "exclamdown", 0x00a1 },
+    { "f", 0x0066 },
+    { "fabovedot", 0x1001e1f },
+    { "femalesymbol", 0x0af8 },
+    { "ff", 0x09e3 },
+    { "figdash", 0x0abb },
+    { "filledlefttribullet", 0x0adc },
+    { "filledrectbullet", 0x0adb },
+    { "filledrighttribullet", 0x0add },
+    { "filledtribulletdown", 0x0ae9 },
+    { "filledtribulletup", 0x0ae8 },
+    { "fiveeighths", 0x0ac5 },
+    { "fivesixths", 0x0ab7 },
+    { "fourfifths", 0x0ab5 },
+    { "function", 0x08f6 },
+    { "g", 0x0067 },
+    { "gabovedot", 0x02f5 },
+    { "gbreve", 0x02bb },
+    { "gcaron", 0x10001e7 },
+    { "gcedilla", 0x03bb },
+    { "gcircumflex", 0x02f8 },
+    { "grave", 0x0060 },
+    { "greater", 0x003e },
+    { "greaterthanequal", 0x08be },
+    { "guillemotleft", 0x00ab },
+    { "guillemotright", 0x00bb },
+    { "h", 0x0068 },
+    { "hairspace", 0x0aa8 },
+    { "hcircumflex", 0x02b6 },
+    { "heart", 0x0aee },
+    { "hebrew_aleph", 0x0ce0 },
+    { "hebrew_ayin", 0x0cf2 },
+    { "hebrew_bet", 0x0ce1 },
+    { "hebrew_beth", 0x0ce1 },
+    { "hebrew_chet", 0x0ce7 },
+    { "hebrew_dalet", 0x0ce3 },
+    { "hebrew_daleth", 0x0ce3 },
+    { "hebrew_doublelowline", 0x0cdf },
+    { "hebrew_finalkaph", 0x0cea },
+    { "hebrew_finalmem", 0x0ced },
+    { "hebrew_finalnun", 0x0cef },
+    { "hebrew_finalpe", 0x0cf3 },
+    { "hebrew_finalzade", 0x0cf5 },
+    { "hebrew_finalzadi", 0x0cf5 },
+    { "hebrew_gimel", 0x0ce2 },
+    { "hebrew_gimmel", 0x0ce2 },
+    { "hebrew_he", 0x0ce4 },
+    { "hebrew_het", 0x0ce7 },
+    { "hebrew_kaph", 0x0ceb },
+    { "hebrew_kuf", 0x0cf7 },
+    { "hebrew_lamed", 0x0cec },
+    { "hebrew_mem", 0x0cee },
+    { "hebrew_nun", 0x0cf0 },
+    { "hebrew_pe", 0x0cf4 },
+    { "hebrew_qoph", 0x0cf7 },
+    { "hebrew_resh", 0x0cf8 },
+    { "hebrew_samech", 0x0cf1 },
+    { "hebrew_samekh", 0x0cf1 },
+    { "hebrew_shin", 0x0cf9 },
+    { "hebrew_taf", 0x0cfa },
+    { "hebrew_taw", 0x0cfa },
+    { "hebrew_tet", 0x0ce8 },
+    { "hebrew_teth", 0x0ce8 },
+    { "hebrew_waw", 0x0ce5 },
+    { "hebrew_yod", 0x0ce9 },
+    { "hebrew_zade", 0x0cf6 },
+    { "hebrew_zadi", 0x0cf6 },
+    { "hebrew_zain", 0x0ce6 },
+    { "hebrew_zayin", 0x0ce6 },
+    { "hexagram", 0x0ada },
+    { "horizconnector", 0x08a3 },
+    { "horizlinescan1", 0x09ef },
+    { "horizlinescan3", 0x09f0 },
+    { "horizlinescan5", 0x09f1 },
+    { "horizlinescan7", 0x09f2 },
+    { "horizlinescan9", 0x09f3 },
+    { "hstroke", 0x02b1 },
+    { "ht", 0x09e2 },
+    { "hyphen", 0x00ad },
+    { "i", 0x0069 },
+    { "iacute", 0x00ed },
+    { "ibelowdot", 0x1001ecb },
+    { "ibreve", 0x100012d },
+    { "icircumflex", 0x00ee },
+    { "identical", 0x08cf },
+    { "idiaeresis", 0x00ef },
+    { "idotless", 0x02b9 },
+    { "ifonlyif", 0x08cd },
+    { "igrave", 0x00ec },
+    { "ihook", 0x1001ec9 },
+    { "imacron", 0x03ef },
+    { "implies", 0x08ce },
+    { "includedin", 0x08da },
+    { "includes", 0x08db },
+    { "infinity", 0x08c2 },
+    { "integral", 0x08bf },
+    { "intersection", 0x08dc },
+    { "iogonek", 0x03e7 },
+    { "itilde", 0x03b5 },
+    { "j", 0x006a },
+    { "jcircumflex", 0x02bc },
+    { "jot", 0x0bca },
+    { "k", 0x006b },
+    { "kana_A", 0x04b1 },
+    { "kana_CHI", 0x04c1 },
+    { "kana_E", 0x04b4 },
+    { "kana_FU", 0x04cc },
+    { "kana_HA", 0x04ca },
+    { "kana_HE", 0x04cd },
+    { "kana_HI", 0x04cb },
+    { "kana_HO", 0x04ce },
+    { "kana_HU", 0x04cc },
+    { "kana_I", 0x04b2 },
+    { "kana_KA", 0x04b6 },
+    { "kana_KE", 0x04b9 },
+    { "kana_KI", 0x04b7 },
+    { "kana_KO", 0x04ba },
+    { "kana_KU", 0x04b8 },
+    { "kana_MA", 0x04cf },
+    { "kana_ME", 0x04d2 },
+    { "kana_MI", 0x04d0 },
+    { "kana_MO", 0x04d3 },
+    { "kana_MU", 0x04d1 },
+    { "kana_N", 0x04dd },
+    { "kana_NA", 0x04c5 },
+    { "kana_NE", 0x04c8 },
+    { "kana_NI", 0x04c6 },
+    { "kana_NO", 0x04c9 },
+    { "kana_NU", 0x04c7 },
+    { "kana_O", 0x04b5 },
+    { "kana_RA", 0x04d7 },
+    { "kana_RE", 0x04da },
+    { "kana_RI", 0x04d8 },
+    { "kana_RO", 0x04db },
+    { "kana_RU", 0x04d9 },
+    { "kana_SA", 0x04bb },
+    { "kana_SE", 0x04be },
+    { "kana_SHI", 0x04bc },
+    { "kana_SO", 0x04bf },
+    { "kana_SU", 0x04bd },
+    { "kana_TA", 0x04c0 },
+    { "kana_TE", 0x04c3 },
+    { "kana_TI", 0x04c1 },
+    { "kana_TO", 0x04c4 },
+    { "kana_TSU", 0x04c2 },
+    { "kana_TU", 0x04c2 },
+    { "kana_U", 0x04b3 },
+    { "kana_WA", 0x04dc },
+    { "kana_WO", 0x04a6 },
+    { "kana_YA", 0x04d4 },
+    { "kana_YO", 0x04d6 },
+    { "kana_YU", 0x04d5 },
+    { "kana_a", 0x04a7 },
+    { "kana_closingbracket", 0x04a3 },
+    { "kana_comma", 0x04a4 },
+    { "kana_conjunctive", 0x04a5 },
+    { "kana_e", 0x04aa },
+    { "kana_fullstop", 0x04a1 },
+    { "kana_i", 0x04a8 },
+    { "kana_middledot", 0x04a5 },
+    { "kana_o", 0x04ab },
+    { "kana_openingbracket", 0x04a2 },
+    { "kana_switch", 0xff7e },
+    { "kana_tsu", 0x04af },
+    { "kana_tu", 0x04af },
+    { "kana_u", 0x04a9 },
+    { "kana_ya", 0x04ac },
+    { "kana_yo", 0x04ae },
+    { "kana_yu", 0x04ad },
+    { "kappa", 0x03a2 },
+    { "kcedilla", 0x03f3 },
+    { "kra", 0x03a2 },
+    { "l", 0x006c },
+    { "lacute", 0x01e5 },
+    { "latincross", 0x0ad9 },
+    { "lbelowdot", 0x1001e37 },
+    { "lcaron", 0x01b5 },
+    { "lcedilla", 0x03b6 },
+    { "leftanglebracket", 0x0abc },
+    { "leftarrow", 0x08fb },
+    { "leftcaret", 0x0ba3 },
+    { "leftdoublequotemark", 0x0ad2 },
+    { "leftmiddlecurlybrace", 0x08af },
+    { "leftopentriangle", 0x0acc },
+    { "leftpointer", 0x0aea },
+    { "leftradical", 0x08a1 },
+    { "leftshoe", 0x0bda },
+    { "leftsinglequotemark", 0x0ad0 },
+    { "leftt", 0x09f4 },
+    { "lefttack", 0x0bdc },
+    { "less", 0x003c },
+    { "lessthanequal", 0x08bc },
+    { "lf", 0x09e5 },
+    { "logicaland", 0x08de },
+    { "logicalor", 0x08df },
+    { "lowleftcorner", 0x09ed },
+    { "lowrightcorner", 0x09ea },
+    { "lstroke", 0x01b3 },
+    { "m", 0x006d },
+    { "mabovedot", 0x1001e41 },
+    { "macron", 0x00af },
+    { "malesymbol", 0x0af7 },
+    { "maltesecross", 0x0af0 },
+    { "marker", 0x0abf },
+    { "masculine", 0x00ba },
+    { "minus", 0x002d },
+    { "minutes", 0x0ad6 },
+    { "mu", 0x00b5 },
+    { "multiply", 0x00d7 },
+    { "musicalflat", 0x0af6 },
+    { "musicalsharp", 0x0af5 },
+    { "n", 0x006e },
+    { "nabla", 0x08c5 },
+    { "nacute", 0x01f1 },
+    { "ncaron", 0x01f2 },
+    { "ncedilla", 0x03f1 },
+    { "nl", 0x09e8 },
+    { "nobreakspace", 0x00a0 },
+    { "notequal", 0x08bd },
+    { "notsign", 0x00ac },
+    { "ntilde", 0x00f1 },
+    { "numbersign", 0x0023 },
+    { "numerosign", 0x06b0 },
+    { "o", 0x006f },
+    { "oacute", 0x00f3 },
+    { "obarred", 0x1000275 },
+    { "obelowdot", 0x1001ecd },
+    { "ocaron", 0x10001d2 },
+    { "ocircumflex", 0x00f4 },
+    { "ocircumflexacute", 0x1001ed1 },
+    { "ocircumflexbelowdot", 0x1001ed9 },
+    { "ocircumflexgrave", 0x1001ed3 },
+    { "ocircumflexhook", 0x1001ed5 },
+    { "ocircumflextilde", 0x1001ed7 },
+    { "odiaeresis", 0x00f6 },
+    { "odoubleacute", 0x01f5 },
+    { "oe", 0x13bd },
+    { "ogonek", 0x01b2 },
+    { "ograve", 0x00f2 },
+    { "ohook", 0x1001ecf },
+    { "ohorn", 0x10001a1 },
+    { "ohornacute", 0x1001edb },
+    { "ohornbelowdot", 0x1001ee3 },
+    { "ohorngrave", 0x1001edd },
+    { "ohornhook", 0x1001edf },
+    { "ohorntilde", 0x1001ee1 },
+    { "omacron", 0x03f2 },
+    { "oneeighth", 0x0ac3 },
+    { "onefifth", 0x0ab2 },
+    { "onehalf", 0x00bd },
+    { "onequarter", 0x00bc },
+    { "onesixth", 0x0ab6 },
+    { "onesuperior", 0x00b9 },
+    { "onethird", 0x0ab0 },
+    { "ooblique", 0x00f8 },
+    { "openrectbullet", 0x0ae2 },
+    { "openstar", 0x0ae5 },
+    { "opentribulletdown", 0x0ae4 },
+    { "opentribulletup", 0x0ae3 },
+    { "ordfeminine", 0x00aa },
+    { "oslash", 0x00f8 },
+    { "otilde", 0x00f5 },
+    { "overbar", 0x0bc0 },
+    { "overline", 0x047e },
+    { "p", 0x0070 },
+    { "pabovedot", 0x1001e57 },
+    { "paragraph", 0x00b6 },
+    { "parenleft", 0x0028 },
+    { "parenright", 0x0029 },
+    { "partialderivative", 0x08ef },
+    { "percent", 0x0025 },
+    { "period", 0x002e },
+    { "periodcentered", 0x00b7 },
+    { "phonographcopyright", 0x0afb },
+    { "plus", 0x002b },
+    { "plusminus", 0x00b1 },
+    { "prescription", 0x0ad4 },
+    { "prolongedsound", 0x04b0 },
+    { "punctspace", 0x0aa6 },
+    { "q", 0x0071 },
+    { "quad", 0x0bcc },
+    { "question", 0x003f },
+    { "questiondown", 0x00bf },
+    { "quotedbl", 0x0022 },
+    { "quoteleft", 0x0060 },
+    { "quoteright", 0x0027 },
+    { "r", 0x0072 },
+    { "racute", 0x01e0 },
+    { "radical", 0x08d6 },
+    { "rcaron", 0x01f8 },
+    { "rcedilla", 0x03b3 },
+    { "registered", 0x00ae },
+    { "rightanglebracket", 0x0abe },
+    { "rightarrow", 0x08fd },
+    { "rightcaret", 0x0ba6 },
+    { "rightdoublequotemark", 0x0ad3 },
+    { "rightmiddlecurlybrace", 0x08b0 },
+    { "rightmiddlesummation", 0x08b7 },
+    { "rightopentriangle", 0x0acd },
+    { "rightpointer", 0x0aeb },
+    { "rightshoe", 0x0bd8 },
+    { "rightsinglequotemark", 0x0ad1 },
+    { "rightt", 0x09f5 },
+    { "righttack", 0x0bfc },
+    { "s", 0x0073 },
+    { "sabovedot", 0x1001e61 },
+    { "sacute", 0x01b6 },
+    { "scaron", 0x01b9 },
+    { "scedilla", 0x01ba },
+    { "schwa", 0x1000259 },
+    { "scircumflex", 0x02fe },
+    { "script_switch", 0xff7e },
+    { "seconds", 0x0ad7 },
+    { "section", 0x00a7 },
+    { "semicolon", 0x003b },
+    { "semivoicedsound", 0x04df },
+    { "seveneighths", 0x0ac6 },
+    { "signaturemark", 0x0aca },
+    { "signifblank", 0x0aac },
+    { "similarequal", 0x08c9 },
+    { "singlelowquotemark", 0x0afd },
+    { "slash", 0x002f },
+    { "soliddiamond", 0x09e0 },
+    { "space", 0x0020 },
+    { "ssharp", 0x00df },
+    { "sterling", 0x00a3 },
+    { "t", 0x0074 },
+    { "tabovedot", 0x1001e6b },
+    { "tcaron", 0x01bb },
+    { "tcedilla", 0x01fe },
+    { "telephone", 0x0af9 },
+    { "telephonerecorder", 0x0afa },
+    { "therefore", 0x08c0 },
+    { "thinspace", 0x0aa7 },
+    { "thorn", 0x00fe },
+    { "threeeighths", 0x0ac4 },
+    { "threefifths", 0x0ab4 },
+    { "threequarters", 0x00be },
+    { "threesuperior", 0x00b3 },
+    { "topintegral", 0x08a4 },
+    { "topleftparens", 0x08ab },
+    { "topleftradical", 0x08a2 },
+    { "topleftsqbracket", 0x08a7 },
+    { "topleftsummation", 0x08b1 },
+    { "toprightparens", 0x08ad },
+    { "toprightsqbracket", 0x08a9 },
+    { "toprightsummation", 0x08b5 },
+    { "topt", 0x09f7 },
+    { "topvertsummationconnector", 0x08b3 },
+    { "trademark", 0x0ac9 },
+    { "trademarkincircle", 0x0acb },
+    { "tslash", 0x03bc },
+    { "twofifths", 0x0ab3 },
+    { "twosuperior", 0x00b2 },
+    { "twothirds", 0x0ab1 },
+    { "u", 0x0075 },
+    { "uacute", 0x00fa },
+    { "ubelowdot", 0x1001ee5 },
+    { "ubreve", 0x02fd },
+    { "ucircumflex", 0x00fb },
+    { "udiaeresis", 0x00fc },
+    { "udoubleacute", 0x01fb },
+    { "ugrave", 0x00f9 },
+    { "uhook", 0x1001ee7 },
+    { "uhorn", 0x10001b0 },
+    { "uhornacute", 0x1001ee9 },
+    { "uhornbelowdot", 0x1001ef1 },
+    { "uhorngrave", 0x1001eeb },
+    { "uhornhook", 0x1001eed },
+    { "uhorntilde", 0x1001eef },
+    { "umacron", 0x03fe },
+    { "underbar", 0x0bc6 },
+    { "underscore", 0x005f },
+    { "union", 0x08dd },
+    { "uogonek", 0x03f9 },
+    { "uparrow", 0x08fc },
+    { "upcaret", 0x0ba9 },
+    { "upleftcorner", 0x09ec },
+    { "uprightcorner", 0x09eb },
+    { "upshoe", 0x0bc3 },
+    { "upstile", 0x0bd3 },
+    { "uptack", 0x0bce },
+    { "uring", 0x01f9 },
+    { "utilde", 0x03fd },
+    { "v", 0x0076 },
+    { "variation", 0x08c1 },
+    { "vertbar", 0x09f8 },
+    { "vertconnector", 0x08a6 },
+    { "voicedsound", 0x04de },
+    { "vt", 0x09e9 },
+    { "w", 0x0077 },
+    { "wacute", 0x1001e83 },
+    { "wcircumflex", 0x1000175 },
+    { "wdiaeresis", 0x1001e85 },
+    { "wgrave", 0x1001e81 },
+    { "x", 0x0078 },
+    { "xabovedot", 0x1001e8b },
+    { "y", 0x0079 },
+    { "yacute", 0x00fd },
+    { "ybelowdot", 0x1001ef5 },
+    { "ycircumflex", 0x1000177 },
+    { "ydiaeresis", 0x00ff },
+    { "yen", 0x00a5 },
+    { "ygrave", 0x1001ef3 },
+    { "yhook", 0x1001ef7 },
+    { "ytilde", 0x1001ef9 },
+    { "z", 0x007a },
+    { "zabovedot", 0x01bf },
+    { "zacute", 0x01bc },
+    { "zcaron", 0x01be },
+    { "zstroke", 0x10001b6 },
+};
+
+#endif
@@ -0,0 +1,182 @@
+#!/usr/bin/env python
+# Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+# Licensed under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License. You may obtain a copy of
+# the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+# License for the specific language governing permissions and limitations under
+# the License.
+
+# Generates KeySymTable.h, a dense two level Unicode code point -> X11 keysym table, from the /* U+XXXX */ annotations
+# in keysymdef.h, and KeySymNames.h, its XK_* names sorted for binary search.  Run by the "Generate KeySymTable.h" build
+# phase whenever keysymdef.h changes:
+#   generate_keysym_table.py <keysymdef.h> <KeySymTable.h> <KeySymNames.h>
+# Only exact (unparenthesised) annotations are used.  Where several keysyms share a code point the first listed wins,
+# the rest are legacy duplicates.  Unicode keysyms (0x01000000 + code point) are left out, they're the fallback anyway.
+# Every annotation is checked against the generated table, and every name against the name table, before they're written.
+# 'rfbdrive check' compares +[KeyMapping codePointToX11KeySym:] with keysymdef.h itself for every code point.
+
+import re
+import sys
+
+PAGE_BITS = 8
+PAGE_SIZE = 1 << PAGE_BITS
+MAX_CODE_POINT = 0x10FFFF
+UNICODE_KEYSYM_BASE = 0x01000000
+
+DEFINE = re.compile(r'^#define XK_([a-zA-Z_0-9]+)\s+0x([0-9a-f]+)\s*/\* U\+([0-9A-F]{4,6}) (.*) \*/\s*$')
+NAME = re.compile(r'^#define XK_([a-zA-Z_0-9]+)\s+0x([0-9a-f]+)\b')
+
+
+def parse(path):
+    mapping = {}
+    with open(path) as header:
+        for line in header:
+            match = DEFINE.match(line)
+            if not match:
+                continue
+            keysym = int(match.group(2), 16)
+            code_point = int(match.group(3), 16)
+            if keysym >= UNICODE_KEYSYM_BASE or code_point > MAX_CODE_POINT:
+                continue
+            mapping.setdefault(code_point, keysym)
+    return mapping
+
+
+def parse_names(path):
+    names = {}
+    with open(path) as header:
+        for line in header:
+            match = NAME.match(line)
+            if match:
+                names.setdefault(match.group(1), int(match.group(2), 16))
+    return names
+
+
+def build(mapping):
+    # Page 0 is all zeroes, shared by every code point range without a mapping
+    pages = [[0] * PAGE_SIZE]
+    page_of = {}
+    for code_point in sorted(mapping):
+        index = code_point >> PAGE_BITS
+        if index not in page_of:
+            page_of[index] = len(pages)
+            pages.append([0] * PAGE_SIZE)
+        pages[page_of[index]][code_point & (PAGE_SIZE - 1)] = mapping[code_point]
+    first_level_length = (max(mapping) >> PAGE_BITS) + 1
+    first_level = [page_of.get(i, 0) for i in range(first_level_length)]
+    return first_level, pages
+
+
+def lookup(first_level, pages, code_point):
+    index = code_point >> PAGE_BITS
+    if index >= len(first_level):
+        return 0
+    return pages[first_level[index]][code_point & (PAGE_SIZE - 1)]
+
+
+def verify(mapping, first_level, pages):
+    for code_point in range(MAX_CODE_POINT + 1):
+        expected = mapping.get(code_point, 0)
+        found = lookup(first_level, pages, code_point)
+        if found != expected:
+            raise SystemExit('U+%04X maps to 0x%x, expected 0x%x' % (code_point, found, expected))
+
+
+def verify_names(names, sorted_names):
+    # Binary search, as the lookup does it
+    for name, keysym in names.items():
+        low, high = 0, len(sorted_names)
+        while low < high:
+            middle = (low + high) // 2
+            if sorted_names[middle][0] < name:
+                low = middle + 1
+            else:
+                high = middle
+        if low == len(sorted_names) or sorted_names[low] != (name, keysym):
+            raise SystemExit('XK_%s not found by binary search' % name)
+
+
+def emit(path, mapping, first_level, pages):
+    page_type = 'uint8_t' if len(pages) <= 0xFF else 'uint16_t'
+    lines = [
+        '//  GENERATED by generate_keysym_table.py from keysymdef.h, do not edit.',
+        '//  %d code points, %d pages of %d keysyms.' % (len(mapping), len(pages), PAGE_SIZE),
+        '',
+        '#ifndef KeySymTable_h',
+        '#define KeySymTable_h',
+        '',
+        '#define KEYSYM_TABLE_PAGE_BITS %d' % PAGE_BITS,
+        '#define KEYSYM_TABLE_FIRST_LEVEL_LENGTH %d' % len(first_level),
+        '',
+        '//Page of each run of %d code points, page 0 has no mappings' % PAGE_SIZE,
+        'static const %s KeySymTableFirstLevel[KEYSYM_TABLE_FIRST_LEVEL_LENGTH] = {' % page_type,
+    ]
+    for start in range(0, len(first_level), 16):
+        lines.append('    ' + ', '.join('%d' % page for page in first_level[start:start + 16]) + ',')
+    lines.append('};')
+    lines.append('')
+    lines.append('//Keysym of each code point in the page, 0 = none')
+    lines.append('static const uint32_t KeySymTablePages[%d][%d] = {' % (len(pages), PAGE_SIZE))
+    for page in pages:
+        lines.append('    {')
+        for start in range(0, PAGE_SIZE, 8):
+            lines.append('        ' + ', '.join('0x%04x' % keysym for keysym in page[start:start + 8]) + ',')
+        lines.append('    },')
+    lines.append('};')
+    lines.append('')
+    lines.append('#endif')
+    with open(path, 'w') as output:
+        output.write('\n'.join(lines) + '\n')
+
+
+def emit_names(path, sorted_names):
+    lines = [
+        '//  GENERATED by generate_keysym_table.py from keysymdef.h, do not edit.',
+        '//  %d XK_* names, sorted by strcmp for binary search.' % len(sorted_names),
+        '',
+        '#ifndef KeySymNames_h',
+        '#define KeySymNames_h',
+        '',
+        'typedef struct {',
+        '    const char *name; //Without the XK_ prefix',
+        '    uint32_t keysym;',
+        '} KeySymName;',
+        '',
+        '#define KEYSYM_NAMES_LENGTH %d' % len(sorted_names),
+        '',
+        'static const KeySymName KeySymNames[KEYSYM_NAMES_LENGTH] = {',
+    ]
+    for name, keysym in sorted_names:
+        lines.append('    { "%s", 0x%04x },' % (name, keysym))
+    lines.append('};')
+    lines.append('')
+    lines.append('#endif')
+    with open(path, 'w') as output:
+        output.write('\n'.join(lines) + '\n')
+
+
+def main():
+    if len(sys.argv) != 4:
+        raise SystemExit('usage: generate_keysym_table.py <keysymdef.h> <KeySymTable.h> <KeySymNames.h>')
+    mapping = parse(sys.argv[1])
+    if not mapping:
+        raise SystemExit('no U+XXXX annotations found in %s' % sys.argv[1])
+    first_level, pages = build(mapping)
+    verify(mapping, first_level, pages)
+    emit(sys.argv[2], mapping, first_level, pages)
+    names = parse_names(sys.argv[1])
+
+    # Plain byte order, same as strcmp on ASCII
+    sorted_names = sorted(names.items())
+    verify_names(names, sorted_names)
+    emit_names(sys.argv[3], sorted_names)
+
+
+if __name__ == '__main__':
+    main()
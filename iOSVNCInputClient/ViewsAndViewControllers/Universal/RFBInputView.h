@@ -25,5 +25,7 @@
 @protocol KeyboardInputDelegate <NSObject>
 
 -(void)rfbInputView:(RFBInputView *)view receivedKey:(unichar)keycode;
+//More than one character at once, eg. pasted or dictated text
+-(void)rfbInputView:(RFBInputView *)view receivedText:(NSString *)text;
 
 @end
@@ -47,10 +47,15 @@
 #pragma mark - UIKeyInput Protocol Methods
 //UIKeyInput protocol to capture keyboard input in view
 -(void)insertText:(NSString *)text {
+	if (text.length == 0)
+		return;
 	DLog(@"Key pressed: %@, Number: %hu", text, [text characterAtIndex:0]);
-	//Pass key input as keycode to delegate if set
+	//Pass key input as keycode to delegate if set, whole text if more than one character
 	if (self.delegate) {
-		[self.delegate rfbInputView:self receivedKey:[text characterAtIndex:0]];
+		if (text.length == 1)
+			[self.delegate rfbInputView:self receivedKey:[text characterAtIndex:0]];
+		else
+			[self.delegate rfbInputView:self receivedText:text];
 	}
 }
 
@@ -27,6 +27,7 @@
 
 #import "RFBEvent.h"
 #import "RFBKeyEvent.h"
+#import "RFBTextEvent.h"
 #import "RFBPointerEvent.h"
 
 #define HELPMSG_TAG 1000
@@ -210,6 +211,12 @@
     [self.rfbInputConnMgr sendEvent:keyEvent];
 }
 
+-(void)rfbInputView:(RFBInputView *)view receivedText:(NSString *)text {
+    //Typed as a whole, in one write
+    RFBTextEvent *textEvent = [[RFBTextEvent alloc] initWithText:text];
+    [self.rfbInputConnMgr sendEvent:textEvent];
+}
+
 #pragma mark - RFB Connection - RFBInputConnManagerDelegate protocol methods
 //Basically used to inform when to start / stop certain animations, display errors etc
 -(void)rfbInputConnManager:(RFBInputConnManager *)inputConnMgr performedAction:(ActionList)action encounteredError:(NSError *)error {
@@ -0,0 +1,57 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+//  Runs rfbdrive input commands, one per line, against a connected RFBConnection.  Each command is parsed once into
+//  an RFBEventRecord and sent through -[RFBConnection sendEventRecord:Error:], the same path the app's gestures take.
+//
+//    move <dx> <dy>            Pointer motion, in server pixels
+//    click [count]             Left button, count clicks (default 1)
+//    rclick [count]            Right button
+//    scroll <lines>            Negative scrolls up
+//    type <text>               Rest of the line, as typed text
+//    chord <macro>             RFBKeyMacro string, eg. Control_L+Alt_L+Delete
+//    repeat <count> [@<ms>] <command>
+//                              Run command count times, every ms milliseconds if given, otherwise back to back
+//    sleep <ms>
+//    wait                      Until everything sent so far has been written out
+//    record [file]             Append every event sent from here on to an RFBEventLog file (replaced if it exists),
+//                              until the next record.  Without a file, stops recording
+//    replay <file> [realtime]  Send the events in an RFBEventLog file, back to back or at the recorded pace
+//
+//  Blank lines and lines starting with # are ignored.
+
+#import <Foundation/Foundation.h>
+
+@class RFBConnection;
+
+@interface RFBCommandRunner : NSObject
+//Seconds wait gives up after
+@property (assign, nonatomic) NSTimeInterval waitTimeout;
+
+-(id)initWithConnection:(RFBConnection *)connection;
+
+//NO with error for an unknown command, bad arguments or a send that failed
+-(BOOL)runLine:(NSString *)line Error:(NSError **)error;
+//NO if still backlogged after waitTimeout
+-(BOOL)waitUntilSent;
+//Closes the log a record command opened, if any
+-(void)stopRecording;
+
+#pragma mark - Stats
+-(unsigned long long)commandsRun;
+-(unsigned long long)eventsSent;
+//Time spent in sendEventRecord:Error:, one line per command name
+-(NSString *)summary;
+@end
@@ -0,0 +1,362 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+#import "RFBCommandRunner.h"
+
+#import <mach/mach_time.h>
+
+#import "ErrorHandlingMacros.h"
+#import "HandleErrors.h"
+
+#import "RFBConnection.h"
+#import "RFBEvent.h"
+#import "RFBEventLog.h"
+#import "RFBEventLogReplayer.h"
+#import "RFBKeyMacro.h"
+#import "RFBLatencyHistogram.h"
+
+#define DEFAULT_WAIT_TIMEOUT 30 //seconds
+//Pointer speed that -[RFBConnection handlePointerRecord:Error:] scales motion by 1, so dx and dy are in pixels
+#define UNSCALED_VELOCITY 100
+
+typedef enum {
+	CommandEvent,
+	CommandSleep,
+	CommandWait,
+	CommandRecord,
+	CommandReplay
+} RFBCommandKind;
+
+typedef struct {
+	RFBCommandKind kind;
+	RFBEventRecord record; //CommandEvent
+	uint64_t milliseconds; //CommandSleep
+	CFStringRef path; //CommandRecord (NULL stops recording) and CommandReplay
+	BOOL realTime; //CommandReplay
+} RFBCommand;
+
+@interface RFBCommandRunner ()
+@property (strong, nonatomic) RFBConnection *connection;
+@property (strong, nonatomic) NSMutableDictionary *sendTimes; //Command name -> RFBLatencyHistogram
+@property (assign, nonatomic) dispatch_semaphore_t sendCompleted;
+@property (assign, nonatomic) unsigned long long commandsRun;
+@property (assign, nonatomic) unsigned long long eventsSent;
+@end
+
+@implementation RFBCommandRunner
+#pragma mark - Init
+//Override
+-(id)init {
+	return [self initWithConnection:nil];
+}
+
+-(id)initWithConnection:(RFBConnection *)connection {
+	if (!connection)
+		return nil;
+	if ((self = [super init])) {
+		_connection = connection;
+		_sendTimes = [NSMutableDictionary dictionary];
+		_waitTimeout = DEFAULT_WAIT_TIMEOUT;
+		_sendCompleted = dispatch_semaphore_create(0);
+
+		dispatch_semaphore_t sendCompleted = _sendCompleted; //Outlived by the connection's handler, cleared in dealloc
+		_connection.sendCompletedHandler = ^{
+			dispatch_semaphore_signal(sendCompleted);
+		};
+	}
+	return self;
+}
+
+-(void)dealloc {
+	self.connection.sendCompletedHandler = nil;
+	if (_sendCompleted)
+		dispatch_release(_sendCompleted);
+}
+
+#pragma mark - Commands - Public
+-(BOOL)runLine:(NSString *)line Error:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+
+	NSString *rest = nil;
+	NSString *name = [self splitFirstWord:line Rest:&rest];
+	if (name.length == 0 || [name hasPrefix:@"#"])
+		return YES;
+
+	NSUInteger count = 1;
+	uint64_t interval = 0;
+	if ([name isEqualToString:@"repeat"]) {
+		NSInteger parsed;
+		if (![self scanInteger:[self splitFirstWord:rest Rest:&rest] Value:&parsed] || parsed < 0) {
+			he(error, ObjectErrorDomain, ObjectInitError, @"repeat needs a count");
+			return NO;
+		}
+		count = parsed;
+		NSString *word = [self splitFirstWord:rest Rest:&rest];
+		if ([word hasPrefix:@"@"]) {
+			if (![self scanInteger:[word substringFromIndex:1] Value:&parsed] || parsed < 0) {
+				he(error, ObjectErrorDomain, ObjectInitError, [NSString stringWithFormat:@"Bad repeat interval %@", word]);
+				return NO;
+			}
+			interval = parsed;
+			word = [self splitFirstWord:rest Rest:&rest];
+		}
+		name = word;
+		if ([name isEqualToString:@"repeat"]) {
+			he(error, ObjectErrorDomain, ObjectInitError, @"repeat can't be nested");
+			return NO;
+		}
+	}
+
+	//Parsed once however many times it's run, so a long repeat profiles the send path rather than parsing
+	RFBCommand command;
+	if (![self parseCommand:name Arguments:rest Command:&command Error:error])
+		return NO;
+
+	BOOL success = YES;
+	uint64_t next = mach_absolute_time();
+	for (NSUInteger i = 0; i < count && success; i++) {
+		if (interval > 0 && i > 0) {
+			next += [self machTimeFromMilliseconds:interval];
+			mach_wait_until(next);
+		}
+		success = [self runCommand:&command Name:name Error:error];
+	}
+	if (command.kind == CommandEvent)
+		RFBEventRecordRelease(&command.record);
+	if (command.path)
+		CFRelease(command.path);
+	return success;
+}
+
+-(BOOL)waitUntilSent {
+	dispatch_time_t deadline = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.waitTimeout * NSEC_PER_SEC));
+	//Signals left over from earlier writes only cause another check
+	while ([self.connection isSendBacklogged]) {
+		if (dispatch_semaphore_wait(self.sendCompleted, deadline) != 0)
+			return ![self.connection isSendBacklogged];
+	}
+	return YES;
+}
+
+-(void)stopRecording {
+	RFBEventLog *eventLog = self.connection.eventLog;
+	self.connection.eventLog = nil;
+	if (eventLog)
+		DLogInf(@"Recorded %llu events, %llu bytes to %@", [eventLog recordsWritten], [eventLog bytesWritten], eventLog.path);
+	[eventLog close];
+}
+
+#pragma mark - Stats - Public
+-(NSString *)summary {
+	NSMutableString *summary = [NSMutableString string];
+	for (NSString *name in [[self.sendTimes allKeys] sortedArrayUsingSelector:@selector(compare:)])
+		[summary appendFormat:@"  %-7@ %@\n", name, [[self.sendTimes objectForKey:name] summary]];
+	return summary;
+}
+
+#pragma mark - Commands - Private
+-(BOOL)parseCommand:(NSString *)name Arguments:(NSString *)arguments Command:(RFBCommand *)command Error:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	memset(command, 0, sizeof(*command));
+	command->kind = CommandEvent;
+	RFBEventRecord *record = &command->record;
+	NSArray *numbers = [self integersFromArguments:arguments];
+
+	if ([name isEqualToString:@"move"]) {
+		if (numbers.count != 2) {
+			he(error, ObjectErrorDomain, ObjectInitError, @"move needs dx and dy");
+			return NO;
+		}
+		record->type = RFBEventRecordPointer;
+		record->pointer.dx = [[numbers objectAtIndex:0] floatValue];
+		record->pointer.dy = [[numbers objectAtIndex:1] floatValue];
+		record->pointer.v = CGPointMake(UNSCALED_VELOCITY, UNSCALED_VELOCITY);
+	} else if ([name isEqualToString:@"click"] || [name isEqualToString:@"rclick"]) {
+		NSInteger clicks = (numbers.count > 0) ? [[numbers objectAtIndex:0] integerValue] : 1;
+		if (!numbers || numbers.count > 1 || clicks < 1 || clicks > INT8_MAX) {
+			he(error, ObjectErrorDomain, ObjectInitError, [NSString stringWithFormat:@"%@ takes a count from 1 to %i", name, INT8_MAX]);
+			return NO;
+		}
+		record->type = RFBEventRecordPointer;
+		if ([name isEqualToString:@"click"])
+			record->pointer.button1 = YES;
+		else
+			record->pointer.button2 = YES;
+		record->pointer.buttonIterations = (int8_t)clicks;
+	} else if ([name isEqualToString:@"scroll"]) {
+		if (numbers.count != 1) {
+			he(error, ObjectErrorDomain, ObjectInitError, @"scroll needs a number of lines");
+			return NO;
+		}
+		//One line per sensitivity's worth of distance
+		record->type = RFBEventRecordPointer;
+		record->pointer.sy = [[numbers objectAtIndex:0] floatValue];
+		record->pointer.scrollSensitivity = 1;
+	} else if ([name isEqualToString:@"type"]) {
+		if (arguments.length == 0) {
+			he(error, ObjectErrorDomain, ObjectInitError, @"type needs some text");
+			return NO;
+		}
+		record->type = RFBEventRecordText;
+		record->text.text = (CFStringRef)CFBridgingRetain([arguments copy]);
+	} else if ([name isEqualToString:@"chord"]) {
+		RFBKeyMacro *macro = [RFBKeyMacro macroWithString:arguments Error:error];
+		if (!macro)
+			return NO;
+		record->type = RFBEventRecordKeyMacro;
+		record->keyMacro.messages = (CFDataRef)CFBridgingRetain(macro.messages);
+	} else if ([name isEqualToString:@"sleep"]) {
+		if (numbers.count != 1 || [[numbers objectAtIndex:0] integerValue] < 0) {
+			he(error, ObjectErrorDomain, ObjectInitError, @"sleep needs a number of milliseconds");
+			return NO;
+		}
+		command->kind = CommandSleep;
+		command->milliseconds = [[numbers objectAtIndex:0] unsignedLongLongValue];
+	} else if ([name isEqualToString:@"wait"]) {
+		command->kind = CommandWait;
+	} else if ([name isEqualToString:@"record"]) {
+		command->kind = CommandRecord;
+		if (arguments.length > 0)
+			command->path = (CFStringRef)CFBridgingRetain([arguments stringByExpandingTildeInPath]);
+	} else if ([name isEqualToString:@"replay"]) {
+		NSString *pace = nil;
+		NSString *path = [self splitFirstWord:arguments Rest:&pace];
+		if (path.length == 0 || !(pace.length == 0 || [pace isEqualToString:@"realtime"])) {
+			he(error, ObjectErrorDomain, ObjectInitError, @"replay needs an event log file, and optionally realtime");
+			return NO;
+		}
+		command->kind = CommandReplay;
+		command->path = (CFStringRef)CFBridgingRetain([path stringByExpandingTildeInPath]);
+		command->realTime = (pace.length > 0);
+	} else {
+		he(error, ObjectErrorDomain, ObjectNotFoundError, [NSString stringWithFormat:@"Unknown command %@", name]);
+		return NO;
+	}
+	return YES;
+}
+
+-(BOOL)runCommand:(RFBCommand *)command Name:(NSString *)name Error:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	self.commandsRun++;
+	switch (command->kind) {
+		case CommandSleep:
+			mach_wait_until(mach_absolute_time() + [self machTimeFromMilliseconds:command->milliseconds]);
+			return YES;
+		case CommandWait:
+			if (![self waitUntilSent]) {
+				he(error, SocketErrorDomain, SocketConnectError, [NSString stringWithFormat:@"Still sending after %.0f seconds", self.waitTimeout]);
+				return NO;
+			}
+			return YES;
+		case CommandRecord:
+			return [self recordToPath:(__bridge NSString *)command->path Error:error];
+		case CommandReplay:
+			return [self replayPath:(__bridge NSString *)command->path RealTime:command->realTime Error:error];
+		case CommandEvent:
+			break;
+	}
+
+	RFBLatencyHistogram *sendTime = [self.sendTimes objectForKey:name];
+	if (!sendTime) {
+		sendTime = [[RFBLatencyHistogram alloc] init];
+		[self.sendTimes setObject:sendTime forKey:name];
+	}
+
+	uint64_t start = mach_absolute_time();
+	command->record.capturedAt = start;
+	command->record.enqueuedAt = start;
+	if (![self.connection sendEventRecord:&command->record Error:error])
+		return NO;
+	[sendTime recordNanoseconds:[self nanosecondsFromMachTime:mach_absolute_time() - start]];
+	self.eventsSent++;
+	return YES;
+}
+
+#pragma mark - Event Log - Private
+//nil path just stops recording
+-(BOOL)recordToPath:(NSString *)path Error:(NSError **)error {
+	RFBEventLog *eventLog = nil;
+	if (path && !(eventLog = [[RFBEventLog alloc] initWithPath:path Error:error]))
+		return NO;
+	[self stopRecording];
+	self.connection.eventLog = eventLog;
+	return YES;
+}
+
+//Blocking, on this thread like every other command, so it can't interleave with them
+-(BOOL)replayPath:(NSString *)path RealTime:(BOOL)realTime Error:(NSError **)error {
+	RFBEventLogReplayer *replayer = [[RFBEventLogReplayer alloc] initWithPath:path Error:error];
+	if (!replayer)
+		return NO;
+	NSError *replayError = nil;
+	self.eventsSent += [replayer replayOnConnection:self.connection RealTime:realTime Error:&replayError];
+	if (replayError) {
+		if (error)
+			*error = replayError;
+		return NO;
+	}
+	return YES;
+}
+
+#pragma mark - Parsing - Private
+//First whitespace separated word of string, and everything after it (trimmed)
+-(NSString *)splitFirstWord:(NSString *)string Rest:(NSString **)rest {
+	NSCharacterSet *whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+	NSString *trimmed = [string stringByTrimmingCharactersInSet:whitespace];
+	NSRange space = [trimmed rangeOfCharacterFromSet:whitespace];
+	if (space.location == NSNotFound) {
+		*rest = @"";
+		return trimmed;
+	}
+	*rest = [[trimmed substringFromIndex:space.location] stringByTrimmingCharactersInSet:whitespace];
+	return [trimmed substringToIndex:space.location];
+}
+
+//nil if any argument isn't a whole number
+-(NSArray *)integersFromArguments:(NSString *)arguments {
+	NSMutableArray *integers = [NSMutableArray array];
+	for (NSString *argument in [arguments componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceCharacterSet]]) {
+		if (argument.length == 0)
+			continue;
+		NSInteger value;
+		if (![self scanInteger:argument Value:&value])
+			return nil;
+		[integers addObject:[NSNumber numberWithInteger:value]];
+	}
+	return integers;
+}
+
+-(BOOL)scanInteger:(NSString *)string Value:(NSInteger *)value {
+	if (string.length == 0)
+		return NO;
+	NSScanner *scanner = [NSScanner scannerWithString:string];
+	return [scanner scanInteger:value] && [scanner isAtEnd];
+}
+
+#pragma mark - Time - Private
+-(uint64_t)machTimeFromMilliseconds:(uint64_t)milliseconds {
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0)
+		mach_timebase_info(&timebase);
+	return milliseconds * NSEC_PER_MSEC * timebase.denom / timebase.numer;
+}
+
+-(uint64_t)nanosecondsFromMachTime:(uint64_t)machTime {
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0)
+		mach_timebase_info(&timebase);
+	return machTime * timebase.numer / timebase.denom;
+}
+@end
@@ -0,0 +1,52 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  TCP proxy on the loopback interface that impairs the link between the client and a server, eg. RFBMockServer, to
+//  reproduce bad Wi-Fi on demand.  Each direction is impaired independently: every chunk read is held back by the
+//  delay plus random jitter and its transmission time at the bandwidth cap.  Now and then a chunk is stalled, as a lost
+//  segment would be, and everything behind it waits too (head of line blocking).  Byte order is always kept, as TCP would.
+//  The impairment can be changed at any time, eg. between phases of a benchmark.
+
+#import <Foundation/Foundation.h>
+
+typedef struct {
+	NSTimeInterval delay;         //One way, seconds
+	NSTimeInterval jitter;        //Up to this much more per chunk, uniformly random
+	NSUInteger bandwidth;         //Bytes per second each way, 0 = unlimited
+	double stallProbability;      //Per chunk, 0-1
+	NSTimeInterval stallDuration; //How long a stalled chunk, and everything behind it, is held
+} RFBImpairment;
+
+@interface RFBImpairmentProxy : NSObject
+@property (assign, nonatomic) RFBImpairment impairment; //Thread safe, applies to chunks read from then on
+
+//Forwards connections accepted on localhost to host:port
+-(id)initWithHost:(NSString *)host Port:(uint16_t)port;
+-(BOOL)start:(NSError **)error;
+-(void)stop; //Drops every connection
+-(uint16_t)port; //Picked when started
+-(NSString *)host;
+
+#pragma mark - Scenarios
+//Named presets: "none", "lan", "cafe", "hotel", "congested".  None for unknown names
++(RFBImpairment)impairmentNamed:(NSString *)name;
++(NSArray *)impairmentNames;
+
+#pragma mark - Stats
+-(unsigned long long)bytesToServer;
+-(unsigned long long)bytesToClient;
+-(NSUInteger)stallsInjected;
+@end
@@ -0,0 +1,337 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBImpairmentProxy.h"
+
+#import <mach/mach_time.h>
+
+#import "GCDAsyncSocket.h"
+#import "ErrorHandlingMacros.h"
+#import "HandleErrors.h"
+
+#define LOOPBACK_INTERFACE @"localhost"
+#define READ_TIMEOUT -1 //No timeout
+#define WRITE_TIMEOUT -1
+#define CONNECT_TIMEOUT 10
+
+static NSTimeInterval secondsNow(void) {
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0)
+		mach_timebase_info(&timebase);
+	return (double)mach_absolute_time() * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+//One direction of a proxied connection.  Chunks wait in order until they're due
+@interface RFBProxyPipe : NSObject
+@property (weak, nonatomic) GCDAsyncSocket *source;
+@property (weak, nonatomic) GCDAsyncSocket *destination;
+@property (strong, nonatomic) NSMutableArray *chunks; //NSData, each due at the matching dueTimes entry
+@property (strong, nonatomic) NSMutableArray *dueTimes;
+@property (assign, nonatomic) NSTimeInterval lastDue;
+@property (assign, nonatomic) NSTimeInterval linkFreeAt; //Bandwidth, when the previous chunk has been sent
+@property (assign, nonatomic) BOOL sourceClosed;
+@end
+
+@implementation RFBProxyPipe
+-(id)init {
+	if ((self = [super init])) {
+		_chunks = [NSMutableArray array];
+		_dueTimes = [NSMutableArray array];
+	}
+	return self;
+}
+@end
+
+//A client connection and the one made to the server for it
+@interface RFBProxyLink : NSObject
+@property (strong, nonatomic) GCDAsyncSocket *client;
+@property (strong, nonatomic) GCDAsyncSocket *server;
+@property (strong, nonatomic) RFBProxyPipe *toServer;
+@property (strong, nonatomic) RFBProxyPipe *toClient;
+@end
+
+@implementation RFBProxyLink
+@end
+
+@interface RFBImpairmentProxy() {
+	RFBImpairment _impairment;
+	unsigned long long _bytesToServer;
+	unsigned long long _bytesToClient;
+	NSUInteger _stallsInjected;
+}
+@property (copy, nonatomic) NSString *targetHost;
+@property (assign, nonatomic) uint16_t targetPort;
+@property (strong, nonatomic) GCDAsyncSocket *listener;
+@property (assign, nonatomic) dispatch_queue_t proxyQueue;
+@property (strong, nonatomic) NSMutableArray *links;
+@end
+
+@implementation RFBImpairmentProxy
+#pragma mark - Init / Dealloc
+//Override, needs a target
+-(id)init {
+	return [self initWithHost:nil Port:0];
+}
+
+-(id)initWithHost:(NSString *)host Port:(uint16_t)port {
+	if ((self = [super init])) {
+		_targetHost = [host copy];
+		_targetPort = port;
+		_proxyQueue = dispatch_queue_create("RFBImpairmentProxy.proxy", DISPATCH_QUEUE_SERIAL);
+		_links = [NSMutableArray array];
+	}
+	return self;
+}
+
+-(void)dealloc {
+	[_listener disconnect];
+	for (RFBProxyLink *link in _links) { //Nothing else can be on the queue by now
+		[link.client disconnect];
+		[link.server disconnect];
+	}
+	if (_proxyQueue)
+		dispatch_release(_proxyQueue);
+}
+
+#pragma mark - Proxy - Public
+-(BOOL)start:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	if (self.targetHost.length == 0) {
+		he(error, SocketErrorDomain, SocketConnectError, NSLocalizedString(@"Proxy has nowhere to forward to", @"RFBImpairmentProxy no target error text"));
+		return NO;
+	}
+	
+	self.listener = [[GCDAsyncSocket alloc] initWithDelegate:self delegateQueue:self.proxyQueue];
+	NSError *listenError = nil;
+	if (![self.listener acceptOnInterface:LOOPBACK_INTERFACE port:0 error:&listenError]) {
+		DLogErr(@"Proxy couldn't listen: %@", listenError);
+		he(error, SocketErrorDomain, SocketConnectError, NSLocalizedString(@"Proxy couldn't listen on localhost", @"RFBImpairmentProxy listen error text"));
+		self.listener = nil;
+		return NO;
+	}
+	return YES;
+}
+
+-(void)stop {
+	[self.listener disconnect];
+	self.listener = nil;
+	dispatch_sync(self.proxyQueue, ^{
+		for (RFBProxyLink *link in self.links) {
+			[link.client disconnect];
+			[link.server disconnect];
+		}
+		[self.links removeAllObjects];
+	});
+}
+
+-(uint16_t)port {
+	return [self.listener localPort];
+}
+
+-(NSString *)host {
+	return LOOPBACK_INTERFACE;
+}
+
+-(RFBImpairment)impairment {
+	__block RFBImpairment impairment;
+	dispatch_sync(self.proxyQueue, ^{
+		impairment = _impairment;
+	});
+	return impairment;
+}
+
+-(void)setImpairment:(RFBImpairment)impairment {
+	dispatch_sync(self.proxyQueue, ^{
+		_impairment = impairment;
+	});
+}
+
+#pragma mark - Scenarios - Public
++(NSArray *)impairmentNames {
+	return @[@"none", @"lan", @"cafe", @"hotel", @"congested"];
+}
+
++(RFBImpairment)impairmentNamed:(NSString *)name {
+	RFBImpairment impairment = { 0, 0, 0, 0, 0 };
+	if ([name isEqualToString:@"lan"]) {
+		impairment.delay = 0.001;
+		impairment.jitter = 0.001;
+	} else if ([name isEqualToString:@"cafe"]) { //Busy but decent Wi-Fi
+		impairment.delay = 0.020;
+		impairment.jitter = 0.030;
+		impairment.bandwidth = 256 * 1024;
+		impairment.stallProbability = 0.01;
+		impairment.stallDuration = 0.200;
+	} else if ([name isEqualToString:@"hotel"]) { //Shared, rate limited, lossy
+		impairment.delay = 0.060;
+		impairment.jitter = 0.080;
+		impairment.bandwidth = 32 * 1024;
+		impairment.stallProbability = 0.03;
+		impairment.stallDuration = 0.400;
+	} else if ([name isEqualToString:@"congested"]) { //Bufferbloat, long stalls
+		impairment.delay = 0.150;
+		impairment.jitter = 0.150;
+		impairment.bandwidth = 8 * 1024;
+		impairment.stallProbability = 0.05;
+		impairment.stallDuration = 1.0;
+	}
+	return impairment;
+}
+
+#pragma mark - Stats - Public
+-(unsigned long long)bytesToServer {
+	__block unsigned long long bytes;
+	dispatch_sync(self.proxyQueue, ^{
+		bytes = _bytesToServer;
+	});
+	return bytes;
+}
+
+-(unsigned long long)bytesToClient {
+	__block unsigned long long bytes;
+	dispatch_sync(self.proxyQueue, ^{
+		bytes = _bytesToClient;
+	});
+	return bytes;
+}
+
+-(NSUInteger)stallsInjected {
+	__block NSUInteger stalls;
+	dispatch_sync(self.proxyQueue, ^{
+		stalls = _stallsInjected;
+	});
+	return stalls;
+}
+
+#pragma mark - Forwarding - Private
+//All on the proxy queue
+-(RFBProxyPipe *)pipeFromSocket:(GCDAsyncSocket *)sock Link:(RFBProxyLink **)foundLink {
+	for (RFBProxyLink *link in self.links) {
+		if (link.client == sock || link.server == sock) {
+			if (foundLink)
+				*foundLink = link;
+			return (link.client == sock) ? link.toServer : link.toClient;
+		}
+	}
+	return nil;
+}
+
+//Work out when the chunk is due.  Never before the one ahead of it, so a stall holds up everything behind it
+-(void)enqueueChunk:(NSData *)chunk Pipe:(RFBProxyPipe *)pipe {
+	NSTimeInterval now = secondsNow();
+	RFBImpairment impairment = _impairment;
+	
+	NSTimeInterval sent = now;
+	if (impairment.bandwidth > 0) {
+		sent = MAX(now, pipe.linkFreeAt) + (double)chunk.length / impairment.bandwidth;
+		pipe.linkFreeAt = sent;
+	}
+	NSTimeInterval due = sent + impairment.delay;
+	if (impairment.jitter > 0)
+		due += impairment.jitter * arc4random_uniform(1001) / 1000.0;
+	if (impairment.stallProbability > 0 && arc4random_uniform(1000000) < impairment.stallProbability * 1000000) {
+		due += impairment.stallDuration;
+		_stallsInjected++;
+	}
+	due = MAX(due, pipe.lastDue);
+	pipe.lastDue = due;
+	
+	[pipe.chunks addObject:chunk];
+	[pipe.dueTimes addObject:[NSNumber numberWithDouble:due]];
+	if (pipe.chunks.count == 1)
+		[self scheduleDeliveryForPipe:pipe];
+}
+
+-(void)scheduleDeliveryForPipe:(RFBProxyPipe *)pipe {
+	NSTimeInterval wait = [[pipe.dueTimes objectAtIndex:0] doubleValue] - secondsNow();
+	__weak RFBImpairmentProxy *blockSafeSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MAX(wait, 0) * NSEC_PER_SEC)), self.proxyQueue, ^{
+		[blockSafeSelf deliverDueChunksForPipe:pipe];
+	});
+}
+
+-(void)deliverDueChunksForPipe:(RFBProxyPipe *)pipe {
+	NSTimeInterval now = secondsNow();
+	while (pipe.chunks.count > 0 && [[pipe.dueTimes objectAtIndex:0] doubleValue] <= now) {
+		NSData *chunk = [pipe.chunks objectAtIndex:0];
+		[pipe.destination writeData:chunk withTimeout:WRITE_TIMEOUT tag:0];
+		[pipe.chunks removeObjectAtIndex:0];
+		[pipe.dueTimes removeObjectAtIndex:0];
+	}
+	if (pipe.chunks.count > 0)
+		[self scheduleDeliveryForPipe:pipe];
+	else if (pipe.sourceClosed) //Everything sent before the close has arrived
+		[pipe.destination disconnectAfterWriting];
+}
+
+#pragma mark - GCDAsyncSocket Delegate Methods
+- (void)socket:(GCDAsyncSocket *)sock didAcceptNewSocket:(GCDAsyncSocket *)newSocket {
+	RFBProxyLink *link = [[RFBProxyLink alloc] init];
+	link.client = newSocket;
+	link.server = [[GCDAsyncSocket alloc] initWithDelegate:self delegateQueue:self.proxyQueue];
+	link.toServer = [[RFBProxyPipe alloc] init];
+	link.toServer.source = link.client;
+	link.toServer.destination = link.server;
+	link.toClient = [[RFBProxyPipe alloc] init];
+	link.toClient.source = link.server;
+	link.toClient.destination = link.client;
+	
+	NSError *error = nil;
+	if (![link.server connectToHost:self.targetHost onPort:self.targetPort withTimeout:CONNECT_TIMEOUT error:&error]) {
+		DLogErr(@"Proxy couldn't connect to %@:%i: %@", self.targetHost, self.targetPort, error);
+		[newSocket disconnect];
+		return;
+	}
+	[self.links addObject:link];
+	//Writes to the server are queued until it's connected
+	[link.client readDataWithTimeout:READ_TIMEOUT tag:0];
+	[link.server readDataWithTimeout:READ_TIMEOUT tag:0];
+}
+
+- (void)socket:(GCDAsyncSocket *)sock didReadData:(NSData *)data withTag:(long)tag {
+	RFBProxyLink *link = nil;
+	RFBProxyPipe *pipe = [self pipeFromSocket:sock Link:&link];
+	if (!pipe)
+		return;
+	if (pipe == link.toServer)
+		_bytesToServer += data.length;
+	else
+		_bytesToClient += data.length;
+	
+	[self enqueueChunk:data Pipe:pipe];
+	[sock readDataWithTimeout:READ_TIMEOUT tag:0];
+}
+
+- (void)socketDidDisconnect:(GCDAsyncSocket *)sock withError:(NSError *)err {
+	RFBProxyLink *link = nil;
+	RFBProxyPipe *pipe = [self pipeFromSocket:sock Link:&link];
+	if (!pipe)
+		return;
+	
+	//Whatever it sent still arrives, then the other side is closed too
+	pipe.sourceClosed = YES;
+	if (pipe.chunks.count == 0)
+		[pipe.destination disconnectAfterWriting];
+	
+	//Nowhere left to deliver anything heading its way
+	RFBProxyPipe *otherPipe = (pipe == link.toServer) ? link.toClient : link.toServer;
+	[otherPipe.chunks removeAllObjects];
+	[otherPipe.dueTimes removeAllObjects];
+	
+	if ([link.client isDisconnected] && [link.server isDisconnected])
+		[self.links removeObject:link];
+}
+@end
@@ -0,0 +1,26 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Client side input throughput against a stand-in server on the loopback interface.  The server accepts one connection
+//  and discards everything it's sent, there's no RFB handshake, so only the client's encoding and writing is measured.
+
+#import <Foundation/Foundation.h>
+
+@interface RFBLoopbackBenchmark : NSObject
+//Type length characters as key events, then paste the same text as ClientCutText.  Chars per second of each, 0 = failed.
+//Completion is called on the main queue
++(void)compareTypingAndPasteForLength:(NSUInteger)length Completion:(void (^)(double typedCharsPerSecond, double pastedCharsPerSecond))completion;
+@end
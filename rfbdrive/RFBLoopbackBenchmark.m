@@ -0,0 +1,140 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBLoopbackBenchmark.h"
+
+#import <mach/mach_time.h>
+
+#import "GCDAsyncSocket.h"
+#import "RFBSocket.h"
+
+#define LOOPBACK_INTERFACE @"localhost"
+#define DISCARD_READ_TIMEOUT -1 //No timeout
+#define SAMPLE_TEXT @"The quick brown fox jumps over the lazy dog 0123456789.\n"
+
+@interface RFBLoopbackBenchmark()
+@property (strong, nonatomic) GCDAsyncSocket *server;
+@property (strong, nonatomic) GCDAsyncSocket *serverConnection;
+@property (strong, nonatomic) RFBSocket *client;
+@property (assign, nonatomic) dispatch_queue_t serverQueue;
+@property (strong, nonatomic) NSString *text;
+@property (copy, nonatomic) void (^completion)(double typedCharsPerSecond, double pastedCharsPerSecond);
+@property (assign, nonatomic) uint64_t start;
+@property (assign, nonatomic) double typedCharsPerSecond;
+@end
+
+@implementation RFBLoopbackBenchmark
+#pragma mark - Benchmark - Public
++(void)compareTypingAndPasteForLength:(NSUInteger)length Completion:(void (^)(double typedCharsPerSecond, double pastedCharsPerSecond))completion {
+	if (length == 0) {
+		if (completion)
+			dispatch_async(dispatch_get_main_queue(), ^{
+				completion(0, 0);
+			});
+		return;
+	}
+	
+	RFBLoopbackBenchmark *benchmark = [[self alloc] init];
+	benchmark.completion = completion;
+	
+	NSMutableString *text = [NSMutableString stringWithCapacity:length + SAMPLE_TEXT.length];
+	while (text.length < length)
+		[text appendString:SAMPLE_TEXT];
+	benchmark.text = [text substringToIndex:length];
+	
+	[benchmark run]; //Keeps itself alive through the client's handlers until finished
+}
+
+#pragma mark - Init / Dealloc
+-(id)init {
+	if ((self = [super init])) {
+		_serverQueue = dispatch_queue_create("RFBLoopbackBenchmark.server", DISPATCH_QUEUE_SERIAL);
+	}
+	return self;
+}
+
+-(void)dealloc {
+	if (_serverQueue)
+		dispatch_release(_serverQueue);
+}
+
+#pragma mark - Benchmark - Private
+-(void)run {
+	NSError *error = nil;
+	self.server = [[GCDAsyncSocket alloc] initWithDelegate:self delegateQueue:self.serverQueue];
+	if (![self.server acceptOnInterface:LOOPBACK_INTERFACE port:0 error:&error]) {
+		DLogErr(@"Stand-in server couldn't listen: %@", error);
+		[self finishWithPastedCharsPerSecond:0];
+		return;
+	}
+	
+	self.client = [[RFBSocket alloc] initWithAddress:LOOPBACK_INTERFACE Port:[self.server localPort]];
+	if (![self.client connect:&error]) {
+		DLogErr(@"Couldn't connect to stand-in server: %@", error);
+		[self finishWithPastedCharsPerSecond:0];
+		return;
+	}
+	
+	//Typing, timed until the single write carrying every key event has been taken by the network stack
+	__block RFBLoopbackBenchmark *strongSelf = self; //Released once finished
+	self.client.writesCompletedHandler = ^{
+		strongSelf.client.writesCompletedHandler = nil;
+		strongSelf.typedCharsPerSecond = [strongSelf charsPerSecondSinceStart];
+		[strongSelf paste];
+		strongSelf = nil;
+	};
+	self.start = mach_absolute_time();
+	[self.client sendText:self.text ChunkLength:0 Interval:0];
+}
+
+-(void)paste {
+	self.start = mach_absolute_time();
+	[self.client sendCutText:self.text PasteKeysyms:nil Completion:^(BOOL sent) {
+		[self finishWithPastedCharsPerSecond:(sent ? [self charsPerSecondSinceStart] : 0)];
+	}];
+}
+
+-(void)finishWithPastedCharsPerSecond:(double)pastedCharsPerSecond {
+	double typedCharsPerSecond = self.typedCharsPerSecond;
+	void (^completion)(double, double) = self.completion;
+	DLogInf(@"%lu chars typed at %.0f chars/s, pasted at %.0f chars/s", (unsigned long)self.text.length, typedCharsPerSecond, pastedCharsPerSecond);
+	
+	[self.client disconnect];
+	[self.serverConnection disconnect];
+	[self.server disconnect];
+	if (completion)
+		dispatch_async(dispatch_get_main_queue(), ^{
+			completion(typedCharsPerSecond, pastedCharsPerSecond);
+		});
+}
+
+-(double)charsPerSecondSinceStart {
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info(&timebase);
+	double seconds = (double)(mach_absolute_time() - self.start) * timebase.numer / timebase.denom / NSEC_PER_SEC;
+	return seconds > 0 ? self.text.length / seconds : 0;
+}
+
+#pragma mark - GCDAsyncSocket Delegate Methods (stand-in server)
+- (void)socket:(GCDAsyncSocket *)sock didAcceptNewSocket:(GCDAsyncSocket *)newSocket {
+	self.serverConnection = newSocket;
+	[newSocket readDataWithTimeout:DISCARD_READ_TIMEOUT tag:0];
+}
+
+- (void)socket:(GCDAsyncSocket *)sock didReadData:(NSData *)data withTag:(long)tag {
+	[sock readDataWithTimeout:DISCARD_READ_TIMEOUT tag:0]; //Discard, keep reading
+}
+@end
@@ -0,0 +1,70 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Stand-in RFB server on the loopback interface, for benchmarks and checking the client without a real Mac or VNC
+//  server.  Speaks protocol 3.3, 3.7, 3.8 and Apple's 3.889, with security types None, VNC, ARD and VeNCrypt (the
+//  anonymous TLS subtypes, resuming sessions clients offer), then sends ServerInit and records every client to server
+//  message with the time it arrived.  Nothing is ever sent after ServerInit.  Any number of clients can be connected at
+//  once, messages from all of them go in the one log.
+
+#import <Foundation/Foundation.h>
+
+@class VersionMsg;
+
+//Client to server message types
+#define SetPixelFormat_MsgType 0
+#define SetEncodings_MsgType 2
+#define FramebufferUpdateRequest_MsgType 3
+#define KeyEvent_MsgType 4
+#define PointerEvent_MsgType 5
+#define ClientCutText_MsgType 6
+
+typedef struct {
+	uint8_t type;
+	uint64_t receivedAt; //mach_absolute_time the message was complete
+	NSUInteger offset; //Of the whole message, type byte included, in receivedMessageBytes
+	NSUInteger length;
+} RFBMockClientMessage;
+
+@interface RFBMockServer : NSObject
+//Set before start
+@property (strong, nonatomic) VersionMsg *version; //3.8 by default.  3.889 behaves as Apple's server
+//Security type numbers offered, in order.  3.3 has the server pick, the first one is used.  Default None
+@property (copy, nonatomic) NSArray *securityTypes;
+@property (copy, nonatomic) NSString *username; //ARD and VeNCrypt TLSPlain
+@property (copy, nonatomic) NSString *password; //VNC, ARD and VeNCrypt.  Auth fails unless the client's matches
+@property (copy, nonatomic) NSString *desktopName;
+@property (assign, nonatomic) uint16_t width;
+@property (assign, nonatomic) uint16_t height;
+//Called on the server's queue with each message, after it's been recorded.  Keep it short
+@property (copy, nonatomic) void (^messageHandler)(RFBMockClientMessage message);
+
+-(BOOL)start:(NSError **)error; //Listens on localhost
+-(void)stop; //Disconnects every client
+-(uint16_t)port; //Picked when started
+-(NSString *)host;
+
+#pragma mark - Recorded - Thread safe
+-(NSUInteger)messageCount;
+-(RFBMockClientMessage)messageAtIndex:(NSUInteger)index;
+-(NSData *)receivedMessageBytes; //Every message recorded, back to back
+-(unsigned long long)bytesReceived; //Handshakes included
+-(NSUInteger)handshakesCompleted; //Up to ServerInit
+-(NSUInteger)authFailures;
+-(NSUInteger)tlsResumptions; //VeNCrypt handshakes that resumed a TLS session
+-(BOOL)lostSync; //A client sent a message type that can't be framed, the rest of its data wasn't recorded
+-(void)clearRecorded;
+@end
@@ -0,0 +1,718 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBMockServer.h"
+
+#import <mach/mach_time.h>
+#import <Security/Security.h> //SecRandomCopyBytes
+
+//openssl libcrypto, for ARD
+#import <bn.h>
+#import <dh.h>
+#import <md5.h>
+#import <evp.h>
+
+#import "GCDAsyncSocket.h"
+#import "ErrorHandlingMacros.h"
+#import "HandleErrors.h"
+
+#import "VersionMsg.h"
+#import "Des.h"
+#import "RFBSecurityNone.h"
+#import "RFBSecurityVNC.h"
+#import "RFBSecurityARD.h"
+#import "RFBSecurityVeNCrypt.h"
+#import "RFBTLSSession.h"
+
+#define LOOPBACK_INTERFACE @"localhost"
+#define READ_TIMEOUT -1 //No timeout
+#define WRITE_TIMEOUT -1
+
+//Each read tag is the handshake step it's waiting on
+#define TAG_CLIENT_VERSION 1
+#define TAG_SECURITY_TYPE 2
+#define TAG_VNC_RESPONSE 3
+#define TAG_ARD_RESPONSE 4
+#define TAG_CLIENT_INIT 5
+#define TAG_MESSAGES 6
+#define TAG_VENCRYPT_VERSION 7
+#define TAG_VENCRYPT_SUBTYPE 8
+#define TAG_PLAIN_LENGTHS 9
+#define TAG_PLAIN_CREDENTIALS 10
+#define TAG_TLS_RECORDS 11 //Raw ciphertext, the step waiting on the plaintext is the session's readTag
+
+#define VNC_CHALLENGE_LENGTH 16
+#define ARD_CREDENTIALS_LENGTH 128
+#define ARD_KEY_LENGTH 128
+#define ARD_GENERATOR 2
+//RFC 2409 Oakley group 2, 1024 bit MODP prime
+#define ARD_PRIME "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B139B22514A08798E3404DDEF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7EDEE386BFB5A899FA5AE9F24117C4B1FE649286651ECE65381FFFFFFFFFFFFFFFF"
+
+#define SECURITY_RESULT_OK 0
+#define SECURITY_RESULT_FAILED 1
+
+//One connected client
+@interface RFBMockSession : NSObject
+@property (strong, nonatomic) GCDAsyncSocket *socket;
+@property (assign, nonatomic) uint8_t securityType;
+@property (strong, nonatomic) NSData *challenge; //VNC
+@property (assign, nonatomic) DH *dh; //ARD, server key pair
+@property (strong, nonatomic) NSMutableData *pending; //Received after ServerInit, not yet a whole message
+@property (assign, nonatomic) BOOL lostSync;
+//VeNCrypt, once the subtype is picked everything goes through tls
+@property (assign, nonatomic) uint32_t subtype;
+@property (strong, nonatomic) RFBTLSSession *tls;
+@property (strong, nonatomic) NSMutableData *tlsPlaintext; //Decrypted, not yet read
+@property (assign, nonatomic) NSUInteger readLength; //Plaintext the next step wants, 0 = any
+@property (assign, nonatomic) long readTag; //0 = none wanted yet
+@property (assign, nonatomic) NSUInteger plainUsernameLength; //TLSPlain
+@end
+
+@implementation RFBMockSession
+-(void)dealloc {
+	if (_dh)
+		DH_free(_dh);
+}
+@end
+
+@interface RFBMockServer() {
+	unsigned long long _bytesReceived;
+	NSUInteger _handshakesCompleted;
+	NSUInteger _authFailures;
+	NSUInteger _tlsResumptions;
+	BOOL _lostSync;
+	SSL_CTX *_tlsContext; //VeNCrypt server end
+}
+@property (strong, nonatomic) GCDAsyncSocket *listener;
+@property (assign, nonatomic) dispatch_queue_t serverQueue;
+@property (strong, nonatomic) NSMutableArray *sessions;
+@property (strong, nonatomic) NSMutableData *messages; //RFBMockClientMessage structs
+@property (strong, nonatomic) NSMutableData *messageBytes;
+@end
+
+@implementation RFBMockServer
+#pragma mark - Init / Dealloc
+-(id)init {
+	if ((self = [super init])) {
+		_version = [[VersionMsg alloc] initWithVersion:MAX_VERSION];
+		_securityTypes = @[[NSNumber numberWithUnsignedChar:[RFBSecurityNone type]]];
+		_desktopName = @"RFBMockServer";
+		_width = 1024;
+		_height = 768;
+		_serverQueue = dispatch_queue_create("RFBMockServer.server", DISPATCH_QUEUE_SERIAL);
+		_sessions = [NSMutableArray array];
+		_messages = [NSMutableData data];
+		_messageBytes = [NSMutableData data];
+	}
+	return self;
+}
+
+-(void)dealloc {
+	[_listener disconnect];
+	for (RFBMockSession *session in _sessions) //Nothing else can be on the queue by now
+		[session.socket disconnect];
+	if (_serverQueue)
+		dispatch_release(_serverQueue);
+	if (_tlsContext)
+		SSL_CTX_free(_tlsContext);
+}
+
+#pragma mark - Server - Public
+-(BOOL)start:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	if (self.securityTypes.count == 0) {
+		he(error, SocketErrorDomain, SocketSecurityError, NSLocalizedString(@"Mock server needs at least one security type", @"RFBMockServer no security types error text"));
+		return NO;
+	}
+	if (!_tlsContext && [self.securityTypes containsObject:[NSNumber numberWithUnsignedChar:[RFBSecurityVeNCrypt type]]]) {
+		BIGNUM *prime = NULL;
+		BN_hex2bn(&prime, ARD_PRIME);
+		NSMutableData *primeBytes = [NSMutableData dataWithLength:BN_num_bytes(prime)];
+		BN_bn2bin(prime, primeBytes.mutableBytes);
+		BN_free(prime);
+		_tlsContext = [RFBTLSSession newAnonymousServerContextWithPrime:primeBytes];
+		if (!_tlsContext) {
+			he(error, SocketErrorDomain, SocketSecurityError, NSLocalizedString(@"Mock server couldn't set up TLS", @"RFBMockServer TLS context error text"));
+			return NO;
+		}
+	}
+	
+	self.listener = [[GCDAsyncSocket alloc] initWithDelegate:self delegateQueue:self.serverQueue];
+	NSError *listenError = nil;
+	if (![self.listener acceptOnInterface:LOOPBACK_INTERFACE port:0 error:&listenError]) {
+		DLogErr(@"Mock server couldn't listen: %@", listenError);
+		he(error, SocketErrorDomain, SocketConnectError, NSLocalizedString(@"Mock server couldn't listen on localhost", @"RFBMockServer listen error text"));
+		self.listener = nil;
+		return NO;
+	}
+	return YES;
+}
+
+-(void)stop {
+	[self.listener disconnect];
+	self.listener = nil;
+	dispatch_sync(self.serverQueue, ^{
+		for (RFBMockSession *session in self.sessions)
+			[session.socket disconnect];
+		[self.sessions removeAllObjects];
+	});
+}
+
+-(uint16_t)port {
+	return [self.listener localPort];
+}
+
+-(NSString *)host {
+	return LOOPBACK_INTERFACE;
+}
+
+#pragma mark - Recorded - Public
+-(NSUInteger)messageCount {
+	__block NSUInteger count;
+	dispatch_sync(self.serverQueue, ^{
+		count = self.messages.length / sizeof(RFBMockClientMessage);
+	});
+	return count;
+}
+
+-(RFBMockClientMessage)messageAtIndex:(NSUInteger)index {
+	__block RFBMockClientMessage message;
+	memset(&message, 0, sizeof(message));
+	dispatch_sync(self.serverQueue, ^{
+		if (index < self.messages.length / sizeof(RFBMockClientMessage))
+			message = ((const RFBMockClientMessage *)self.messages.bytes)[index];
+	});
+	return message;
+}
+
+-(NSData *)receivedMessageBytes {
+	__block NSData *bytes;
+	dispatch_sync(self.serverQueue, ^{
+		bytes = [self.messageBytes copy];
+	});
+	return bytes;
+}
+
+-(unsigned long long)bytesReceived {
+	__block unsigned long long bytes;
+	dispatch_sync(self.serverQueue, ^{
+		bytes = _bytesReceived;
+	});
+	return bytes;
+}
+
+-(NSUInteger)handshakesCompleted {
+	__block NSUInteger handshakes;
+	dispatch_sync(self.serverQueue, ^{
+		handshakes = _handshakesCompleted;
+	});
+	return handshakes;
+}
+
+-(NSUInteger)authFailures {
+	__block NSUInteger failures;
+	dispatch_sync(self.serverQueue, ^{
+		failures = _authFailures;
+	});
+	return failures;
+}
+
+-(NSUInteger)tlsResumptions {
+	__block NSUInteger resumptions;
+	dispatch_sync(self.serverQueue, ^{
+		resumptions = _tlsResumptions;
+	});
+	return resumptions;
+}
+
+-(BOOL)lostSync {
+	__block BOOL lostSync;
+	dispatch_sync(self.serverQueue, ^{
+		lostSync = _lostSync;
+	});
+	return lostSync;
+}
+
+-(void)clearRecorded {
+	dispatch_sync(self.serverQueue, ^{
+		[self.messages setLength:0];
+		[self.messageBytes setLength:0];
+		_bytesReceived = 0;
+		_handshakesCompleted = 0;
+		_authFailures = 0;
+		_tlsResumptions = 0;
+		_lostSync = NO;
+	});
+}
+
+#pragma mark - Handshake - Private
+//All on the server queue
+-(RFBMockSession *)sessionForSocket:(GCDAsyncSocket *)sock {
+	for (RFBMockSession *session in self.sessions)
+		if (session.socket == sock)
+			return session;
+	return nil;
+}
+
+-(void)write:(NSData *)data Session:(RFBMockSession *)session {
+	if (session.tls) {
+		if (![session.tls sendPlaintext:data.bytes Length:data.length]) {
+			[session.socket disconnect];
+			return;
+		}
+		[self writeTLSCiphertextForSession:session];
+		return;
+	}
+	[session.socket writeData:data withTimeout:WRITE_TIMEOUT tag:0];
+}
+
+//Handshake step tag's data, length bytes of it (0 = whatever has arrived).  From the socket, or the decrypted plaintext once TLS is up
+-(void)readLength:(NSUInteger)length Tag:(long)tag Session:(RFBMockSession *)session {
+	if (!session.tls) {
+		if (length == 0)
+			[session.socket readDataWithTimeout:READ_TIMEOUT tag:tag];
+		else
+			[session.socket readDataToLength:length withTimeout:READ_TIMEOUT tag:tag];
+		return;
+	}
+	session.readLength = length;
+	session.readTag = tag;
+	[self deliverTLSPlaintextForSession:session];
+}
+
+-(void)writeUInt32:(uint32_t)value Session:(RFBMockSession *)session {
+	value = CFSwapInt32HostToBig(value);
+	[self write:[NSData dataWithBytes:&value length:sizeof(value)] Session:session];
+}
+
+-(void)writeString:(NSString *)string Session:(RFBMockSession *)session {
+	NSData *utf8 = [string dataUsingEncoding:NSUTF8StringEncoding];
+	[self writeUInt32:(uint32_t)utf8.length Session:session];
+	[self write:utf8 Session:session];
+}
+
+//3.8 semantics: a SecurityResult after every security type, a reason string after a failure.  Apple's 3.889 works the same
+-(BOOL)isVersion38 {
+	return [self.version intValue] >= MAX_VERSION;
+}
+
+-(void)handleClientVersion:(NSData *)data Session:(RFBMockSession *)session {
+	if (![[VersionMsg alloc] initWithData:data]) {
+		[session.socket disconnect];
+		return;
+	}
+	
+	if ([self.version intValue] < 0x0307) { //Server picks the type, no reply from the client
+		session.securityType = [[self.securityTypes objectAtIndex:0] unsignedCharValue];
+		[self writeUInt32:session.securityType Session:session];
+		[self startAuthForSession:session];
+		return;
+	}
+	
+	NSMutableData *list = [NSMutableData dataWithCapacity:self.securityTypes.count + 1];
+	uint8_t count = (uint8_t)self.securityTypes.count;
+	[list appendBytes:&count length:sizeof(count)];
+	for (NSNumber *type in self.securityTypes) {
+		uint8_t securityType = [type unsignedCharValue];
+		[list appendBytes:&securityType length:sizeof(securityType)];
+	}
+	[self write:list Session:session];
+	[self readLength:1 Tag:TAG_SECURITY_TYPE Session:session];
+}
+
+-(void)handleSecurityType:(NSData *)data Session:(RFBMockSession *)session {
+	session.securityType = *(const uint8_t *)data.bytes;
+	if (![self.securityTypes containsObject:[NSNumber numberWithUnsignedChar:session.securityType]]) {
+		[self failAuthForSession:session Reason:@"Security type not offered"];
+		return;
+	}
+	[self startAuthForSession:session];
+}
+
+-(void)startAuthForSession:(RFBMockSession *)session {
+	if (session.securityType == [RFBSecurityNone type]) {
+		if ([self isVersion38])
+			[self writeUInt32:SECURITY_RESULT_OK Session:session];
+		[self readLength:1 Tag:TAG_CLIENT_INIT Session:session];
+	} else if (session.securityType == [RFBSecurityVNC type]) {
+		[self startVNCChallengeForSession:session];
+	} else if (session.securityType == [RFBSecurityVeNCrypt type]) {
+		uint8_t version[2] = {0, 2};
+		[self write:[NSData dataWithBytes:version length:sizeof(version)] Session:session];
+		[self readLength:sizeof(version) Tag:TAG_VENCRYPT_VERSION Session:session];
+	} else if (session.securityType == [RFBSecurityARD type]) {
+		NSData *parameters = [self startARDForSession:session];
+		if (!parameters) {
+			[session.socket disconnect];
+			return;
+		}
+		[self write:parameters Session:session];
+		[self readLength:ARD_CREDENTIALS_LENGTH + ARD_KEY_LENGTH Tag:TAG_ARD_RESPONSE Session:session];
+	} else {
+		[self failAuthForSession:session Reason:@"Security type not supported by the mock server"];
+	}
+}
+
+-(void)startVNCChallengeForSession:(RFBMockSession *)session {
+	uint8_t challenge[VNC_CHALLENGE_LENGTH];
+	SecRandomCopyBytes(kSecRandomDefault, sizeof(challenge), challenge);
+	session.challenge = [NSData dataWithBytes:challenge length:sizeof(challenge)];
+	[self write:session.challenge Session:session];
+	[self readLength:VNC_CHALLENGE_LENGTH Tag:TAG_VNC_RESPONSE Session:session];
+}
+
+-(void)handleVNCResponse:(NSData *)response Session:(RFBMockSession *)session {
+	NSData *expected = [Des encryptChallenge:session.challenge withPassword:(self.password ? self.password : @"")];
+	if (![response isEqualToData:expected]) {
+		[self failAuthForSession:session Reason:@"Password incorrect"];
+		return;
+	}
+	[self writeUInt32:SECURITY_RESULT_OK Session:session];
+	[self readLength:1 Tag:TAG_CLIENT_INIT Session:session];
+}
+
+//Generator, key length, prime and the server's public key, as RFBSecurityARD reads them
+-(NSData *)startARDForSession:(RFBMockSession *)session {
+	DH *dh = DH_new();
+	if (!dh)
+		return nil;
+	BN_hex2bn(&dh->p, ARD_PRIME);
+	dh->g = BN_new();
+	BN_set_word(dh->g, ARD_GENERATOR);
+	session.dh = dh;
+	if (!DH_generate_key(dh))
+		return nil;
+	
+	NSMutableData *parameters = [NSMutableData dataWithLength:4 + ARD_KEY_LENGTH * 2];
+	uint8_t *bytes = parameters.mutableBytes;
+	bytes[0] = 0;
+	bytes[1] = ARD_GENERATOR;
+	bytes[2] = ARD_KEY_LENGTH >> 8;
+	bytes[3] = ARD_KEY_LENGTH & 0xFF;
+	BN_bn2bin(dh->p, bytes + 4);
+	//Left padded with zeros to the key length
+	int publicKeyLength = BN_num_bytes(dh->pub_key);
+	BN_bn2bin(dh->pub_key, bytes + 4 + ARD_KEY_LENGTH + (ARD_KEY_LENGTH - publicKeyLength));
+	return parameters;
+}
+
+//Ciphertext of username[64]:password[64] with AES128(MD5(shared secret)), then the client's public key
+-(void)handleARDResponse:(NSData *)response Session:(RFBMockSession *)session {
+	const uint8_t *bytes = response.bytes;
+	uint8_t secret[ARD_KEY_LENGTH];
+	uint8_t key[MD5_DIGEST_LENGTH];
+	uint8_t credentials[ARD_CREDENTIALS_LENGTH + EVP_MAX_BLOCK_LENGTH];
+	int credentialsLength = 0;
+	
+	BIGNUM *clientKey = BN_bin2bn(bytes + ARD_CREDENTIALS_LENGTH, ARD_KEY_LENGTH, NULL);
+	int secretLength = DH_compute_key(secret, clientKey, session.dh);
+	BN_free(clientKey);
+	
+	BOOL decrypted = NO;
+	if (secretLength > 0) {
+		//Hashed at the full key length, leading zero bytes put back
+		memmove(secret + (ARD_KEY_LENGTH - secretLength), secret, secretLength);
+		memset(secret, 0, ARD_KEY_LENGTH - secretLength);
+		MD5(secret, ARD_KEY_LENGTH, key);
+		EVP_CIPHER_CTX ctx;
+		EVP_CIPHER_CTX_init(&ctx);
+		decrypted = (EVP_DecryptInit_ex(&ctx, EVP_aes_128_ecb(), NULL, key, NULL) &&
+					 EVP_CIPHER_CTX_set_padding(&ctx, 0) &&
+					 EVP_DecryptUpdate(&ctx, credentials, &credentialsLength, bytes, ARD_CREDENTIALS_LENGTH) &&
+					 credentialsLength == ARD_CREDENTIALS_LENGTH);
+		EVP_CIPHER_CTX_cleanup(&ctx);
+	}
+	
+	if (decrypted) {
+		credentials[ARD_CREDENTIALS_LENGTH / 2 - 1] = '\0'; //Both are null terminated within their half
+		credentials[ARD_CREDENTIALS_LENGTH - 1] = '\0';
+		NSString *username = [NSString stringWithUTF8String:(const char *)credentials];
+		NSString *password = [NSString stringWithUTF8String:(const char *)credentials + ARD_CREDENTIALS_LENGTH / 2];
+		decrypted = [username isEqualToString:(self.username ? self.username : @"")] && [password isEqualToString:(self.password ? self.password : @"")];
+	}
+	if (!decrypted) {
+		[self failAuthForSession:session Reason:nil]; //ARD never gives a reason
+		return;
+	}
+	[self writeUInt32:SECURITY_RESULT_OK Session:session];
+	[self readLength:1 Tag:TAG_CLIENT_INIT Session:session];
+}
+
+-(void)failAuthForSession:(RFBMockSession *)session Reason:(NSString *)reason {
+	_authFailures++;
+	[self writeUInt32:SECURITY_RESULT_FAILED Session:session];
+	if (reason && session.securityType != [RFBSecurityARD type] &&
+		([self isVersion38] || session.securityType == [RFBSecurityVeNCrypt type])) //VeNCrypt always gives a reason
+		[self writeString:reason Session:session];
+	[session.socket disconnectAfterWriting];
+}
+
+#pragma mark - VeNCrypt - Private
+//0.2 only.  Acknowledged, then the subtypes offered: the anonymous TLS ones
+-(void)handleVeNCryptVersion:(NSData *)data Session:(RFBMockSession *)session {
+	const uint8_t *version = data.bytes;
+	uint8_t ack = (version[0] == 0 && version[1] == 2) ? 0 : 1;
+	[self write:[NSData dataWithBytes:&ack length:sizeof(ack)] Session:session];
+	if (ack != 0) {
+		[session.socket disconnectAfterWriting];
+		return;
+	}
+	
+	uint32_t subtypes[3] = {CFSwapInt32HostToBig(VENCRYPT_TLS_PLAIN), CFSwapInt32HostToBig(VENCRYPT_TLS_VNC), CFSwapInt32HostToBig(VENCRYPT_TLS_NONE)};
+	uint8_t count = 3;
+	NSMutableData *list = [NSMutableData dataWithBytes:&count length:sizeof(count)];
+	[list appendBytes:subtypes length:sizeof(subtypes)];
+	[self write:list Session:session];
+	[self readLength:sizeof(uint32_t) Tag:TAG_VENCRYPT_SUBTYPE Session:session];
+}
+
+//Accepted, then the TLS handshake.  The subtype's auth starts once it's done, see handleTLSRecords
+-(void)handleVeNCryptSubtype:(NSData *)data Session:(RFBMockSession *)session {
+	uint32_t subtype;
+	memcpy(&subtype, data.bytes, sizeof(subtype));
+	subtype = CFSwapInt32BigToHost(subtype);
+	uint8_t accepted = (subtype == VENCRYPT_TLS_NONE || subtype == VENCRYPT_TLS_VNC || subtype == VENCRYPT_TLS_PLAIN) ? 1 : 0;
+	[self write:[NSData dataWithBytes:&accepted length:sizeof(accepted)] Session:session];
+	if (!accepted) {
+		_authFailures++;
+		[session.socket disconnectAfterWriting];
+		return;
+	}
+	
+	RFBTLSSession *tls = [[RFBTLSSession alloc] initServerWithContext:_tlsContext];
+	if (!tls || ![tls startHandshake]) {
+		[session.socket disconnect];
+		return;
+	}
+	session.subtype = subtype;
+	session.tls = tls;
+	session.tlsPlaintext = [NSMutableData data];
+	session.readTag = 0;
+	[session.socket readDataWithTimeout:READ_TIMEOUT tag:TAG_TLS_RECORDS];
+}
+
+-(void)handleTLSRecords:(NSData *)data Session:(RFBMockSession *)session {
+	BOOL wasComplete = [session.tls isHandshakeComplete];
+	BOOL ok = [session.tls receiveCiphertext:data.bytes Length:data.length Plaintext:session.tlsPlaintext];
+	[self writeTLSCiphertextForSession:session];
+	if (!ok) {
+		[session.socket disconnectAfterWriting];
+		return;
+	}
+	[session.socket readDataWithTimeout:READ_TIMEOUT tag:TAG_TLS_RECORDS];
+	
+	if (!wasComplete && [session.tls isHandshakeComplete]) {
+		if ([session.tls isResumed])
+			_tlsResumptions++;
+		[self startSubtypeAuthForSession:session];
+	} else {
+		[self deliverTLSPlaintextForSession:session];
+	}
+}
+
+-(void)writeTLSCiphertextForSession:(RFBMockSession *)session {
+	NSData *ciphertext = [session.tls takeCiphertext];
+	if (ciphertext)
+		[session.socket writeData:ciphertext withTimeout:WRITE_TIMEOUT tag:0];
+}
+
+//Hand the step waiting on plaintext its data, if enough has been decrypted
+-(void)deliverTLSPlaintextForSession:(RFBMockSession *)session {
+	NSUInteger available = session.tlsPlaintext.length;
+	if (session.readTag == 0 || available == 0 || available < session.readLength)
+		return;
+	NSUInteger length = (session.readLength == 0) ? available : session.readLength;
+	NSData *data = [session.tlsPlaintext subdataWithRange:NSMakeRange(0, length)];
+	[session.tlsPlaintext replaceBytesInRange:NSMakeRange(0, length) withBytes:NULL length:0];
+	long tag = session.readTag;
+	session.readTag = 0;
+	[self handleData:data Tag:tag Session:session]; //May ask for more, and be handed it straight away
+}
+
+//VeNCrypt servers send SecurityResult and a failure reason whatever the RFB version
+-(void)startSubtypeAuthForSession:(RFBMockSession *)session {
+	switch (session.subtype) {
+		case VENCRYPT_TLS_VNC:
+			[self startVNCChallengeForSession:session];
+			break;
+		case VENCRYPT_TLS_PLAIN:
+			[self readLength:2 * sizeof(uint32_t) Tag:TAG_PLAIN_LENGTHS Session:session];
+			break;
+		default:
+			[self writeUInt32:SECURITY_RESULT_OK Session:session];
+			[self readLength:1 Tag:TAG_CLIENT_INIT Session:session];
+			break;
+	}
+}
+
+-(void)handlePlainLengths:(NSData *)data Session:(RFBMockSession *)session {
+	uint32_t lengths[2];
+	memcpy(lengths, data.bytes, sizeof(lengths));
+	NSUInteger usernameLength = CFSwapInt32BigToHost(lengths[0]);
+	NSUInteger passwordLength = CFSwapInt32BigToHost(lengths[1]);
+	if (usernameLength + passwordLength == 0 || usernameLength > 1024 || passwordLength > 1024) {
+		[self failAuthForSession:session Reason:@"Username and password required"];
+		return;
+	}
+	session.plainUsernameLength = usernameLength;
+	[self readLength:usernameLength + passwordLength Tag:TAG_PLAIN_CREDENTIALS Session:session];
+}
+
+-(void)handlePlainCredentials:(NSData *)data Session:(RFBMockSession *)session {
+	NSUInteger usernameLength = session.plainUsernameLength;
+	NSString *username = [[NSString alloc] initWithBytes:data.bytes length:usernameLength encoding:NSUTF8StringEncoding];
+	NSString *password = [[NSString alloc] initWithBytes:(const uint8_t *)data.bytes + usernameLength length:data.length - usernameLength encoding:NSUTF8StringEncoding];
+	if (![username isEqualToString:(self.username ? self.username : @"")] || ![password isEqualToString:(self.password ? self.password : @"")]) {
+		[self failAuthForSession:session Reason:@"Username or password incorrect"];
+		return;
+	}
+	[self writeUInt32:SECURITY_RESULT_OK Session:session];
+	[self readLength:1 Tag:TAG_CLIENT_INIT Session:session];
+}
+
+//Shared flag received, send ServerInit: size, 32 bit true colour pixel format, name
+-(void)handleClientInitSession:(RFBMockSession *)session {
+	uint8_t serverInit[20] = {
+		self.width >> 8, self.width & 0xFF, self.height >> 8, self.height & 0xFF,
+		32, 24, 0, 1,   //Bits per pixel, depth, big endian, true colour
+		0, 255, 0, 255, 0, 255, //Red, green, blue max
+		16, 8, 0,       //Red, green, blue shift
+		0, 0, 0         //Padding
+	};
+	[self write:[NSData dataWithBytes:serverInit length:sizeof(serverInit)] Session:session];
+	[self writeString:self.desktopName Session:session];
+	_handshakesCompleted++;
+	
+	session.pending = [NSMutableData data];
+	[self readLength:0 Tag:TAG_MESSAGES Session:session];
+}
+
+#pragma mark - Client Messages - Private
+//Record every whole message in pending, keep the rest for next time
+-(void)recordMessagesFromSession:(RFBMockSession *)session {
+	const uint8_t *bytes = session.pending.bytes;
+	NSUInteger available = session.pending.length;
+	NSUInteger position = 0;
+	uint64_t receivedAt = mach_absolute_time();
+	
+	while (!session.lostSync && position < available) {
+		NSUInteger length = [self lengthOfMessage:bytes + position Available:available - position Session:session];
+		if (length == 0 || position + length > available)
+			break;
+		
+		RFBMockClientMessage message = { bytes[position], receivedAt, self.messageBytes.length, length };
+		[self.messageBytes appendBytes:bytes + position length:length];
+		[self.messages appendBytes:&message length:sizeof(message)];
+		position += length;
+		if (self.messageHandler)
+			self.messageHandler(message);
+	}
+	[session.pending replaceBytesInRange:NSMakeRange(0, position) withBytes:NULL length:0];
+}
+
+//Whole length of the message starting at bytes, 0 if more is needed to tell
+-(NSUInteger)lengthOfMessage:(const uint8_t *)bytes Available:(NSUInteger)available Session:(RFBMockSession *)session {
+	switch (bytes[0]) {
+		case SetPixelFormat_MsgType:
+			return 20;
+		case SetEncodings_MsgType:
+			return (available < 4) ? 0 : 4 + 4 * (NSUInteger)((bytes[2] << 8) | bytes[3]);
+		case FramebufferUpdateRequest_MsgType:
+			return 10;
+		case KeyEvent_MsgType:
+			return 8;
+		case PointerEvent_MsgType:
+			return 6;
+		case ClientCutText_MsgType: {
+			if (available < 8)
+				return 0;
+			uint32_t textLength;
+			memcpy(&textLength, bytes + 4, sizeof(textLength));
+			return 8 + (NSUInteger)CFSwapInt32BigToHost(textLength);
+		}
+		default:
+			DLogErr(@"Mock server can't frame client message type %i, ignoring the rest", bytes[0]);
+			session.lostSync = YES;
+			_lostSync = YES;
+			return 0;
+	}
+}
+
+#pragma mark - Read Dispatch - Private
+-(void)handleData:(NSData *)data Tag:(long)tag Session:(RFBMockSession *)session {
+	switch (tag) {
+		case TAG_CLIENT_VERSION:
+			[self handleClientVersion:data Session:session];
+			break;
+		case TAG_SECURITY_TYPE:
+			[self handleSecurityType:data Session:session];
+			break;
+		case TAG_VNC_RESPONSE:
+			[self handleVNCResponse:data Session:session];
+			break;
+		case TAG_ARD_RESPONSE:
+			[self handleARDResponse:data Session:session];
+			break;
+		case TAG_CLIENT_INIT:
+			[self handleClientInitSession:session];
+			break;
+		case TAG_VENCRYPT_VERSION:
+			[self handleVeNCryptVersion:data Session:session];
+			break;
+		case TAG_VENCRYPT_SUBTYPE:
+			[self handleVeNCryptSubtype:data Session:session];
+			break;
+		case TAG_PLAIN_LENGTHS:
+			[self handlePlainLengths:data Session:session];
+			break;
+		case TAG_PLAIN_CREDENTIALS:
+			[self handlePlainCredentials:data Session:session];
+			break;
+		case TAG_TLS_RECORDS:
+			[self handleTLSRecords:data Session:session];
+			break;
+		case TAG_MESSAGES:
+			[session.pending appendData:data];
+			[self recordMessagesFromSession:session];
+			[self readLength:0 Tag:TAG_MESSAGES Session:session];
+			break;
+	}
+}
+
+#pragma mark - GCDAsyncSocket Delegate Methods
+- (void)socket:(GCDAsyncSocket *)sock didAcceptNewSocket:(GCDAsyncSocket *)newSocket {
+	RFBMockSession *session = [[RFBMockSession alloc] init];
+	session.socket = newSocket;
+	[self.sessions addObject:session];
+	
+	[self write:[self.version data] Session:session];
+	[newSocket readDataToLength:RFB_VERSION_DATA_LENGTH withTimeout:READ_TIMEOUT tag:TAG_CLIENT_VERSION];
+}
+
+- (void)socket:(GCDAsyncSocket *)sock didReadData:(NSData *)data withTag:(long)tag {
+	RFBMockSession *session = [self sessionForSocket:sock];
+	if (!session)
+		return;
+	_bytesReceived += data.length;
+	[self handleData:data Tag:tag Session:session];
+}
+
+- (void)socketDidDisconnect:(GCDAsyncSocket *)sock withError:(NSError *)err {
+	RFBMockSession *session = [self sessionForSocket:sock];
+	if (session)
+		[self.sessions removeObject:session];
+}
+@end
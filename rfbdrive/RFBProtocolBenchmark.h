@@ -0,0 +1,53 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Protocol benchmarks for RFBSocket/RFBConnection against RFBMockServer on the loopback interface, so they run
+//  without a network or a real server.  Covers handshake latency for each protocol version and security type, input
+//  events per second through the live encoding path, and bytes on the wire for both.  Pointer lag and click delivery
+//  are also measured through RFBImpairmentProxy for each of its named scenarios.  Micro benchmarks of the pieces on the
+//  send path (DES, encoding into RFBSocket's send buffer, keysym lookup) run without a server.
+
+#import <Foundation/Foundation.h>
+
+@interface RFBProtocolBenchmark : NSObject
+//Every benchmark in turn, on a background queue.  Results are NSNumbers keyed by name, eg. "handshake 3.8 VNC ms",
+//missing if that benchmark failed.  Completion is called on the main queue
++(void)runWithIterations:(NSUInteger)iterations Completion:(void (^)(NSDictionary *results))completion;
+
+//Individual benchmarks, blocking, don't call on the main thread
++(NSDictionary *)benchmarkHandshakesWithIterations:(NSUInteger)iterations;
+//ARD handshakes with key pairs generated ahead of time (RFBDHKeyPool) and without
++(NSDictionary *)benchmarkARDKeyPoolWithIterations:(NSUInteger)iterations;
+//Back to back ARD logins against the mock server
++(NSDictionary *)benchmarkARDHandshakesWithCount:(NSUInteger)count;
+//VeNCrypt handshakes with a full TLS handshake each time, then resuming the cached TLS session
++(NSDictionary *)benchmarkVeNCryptResumptionWithIterations:(NSUInteger)iterations;
+//VNC handshakes over the impairment proxy's "cafe" link, without and with a handshake cache
++(NSDictionary *)benchmarkHandshakeCacheWithIterations:(NSUInteger)iterations;
++(NSDictionary *)benchmarkEventsWithCount:(NSUInteger)count;
+//Pointer motion at 60 Hz then clicks at 4 Hz, as a finger would send them, through the proxy with the named impairment.
+//Capture to server arrival lag percentiles for each (ms)
++(NSDictionary *)benchmarkInputLagWithImpairmentNamed:(NSString *)name Moves:(NSUInteger)moves Clicks:(NSUInteger)clicks;
+
+#pragma mark - Micro benchmarks
+//MB/s of +[Des encryptMessage:withKey:] on messages of length bytes, +[Des decryptMessage:withKey:] MB/s in decryptRate
++(double)benchmarkDesMessagesOfLength:(NSUInteger)length Iterations:(NSUInteger)iterations DecryptRate:(double *)decryptRate;
+//Alternating pointer and key messages encoded into RFBSocket's send buffer, without a socket.  Returns messages per second.
+//heapBlocksPerMessage = net heap blocks allocated per message, from malloc_zone_statistics.  0 when the hot path doesn't allocate
++(double)benchmarkEncodingMessages:(NSUInteger)messages HeapBlocksPerMessage:(double *)heapBlocksPerMessage;
+//Nanoseconds per +[KeyMapping codePointToX11KeySym:], mapping every code point up to U+100FF iterations times
++(double)benchmarkKeySymLookups:(NSUInteger)iterations;
+@end
@@ -0,0 +1,592 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBProtocolBenchmark.h"
+
+#import <mach/mach_time.h>
+#import <malloc/malloc.h> //malloc_zone_statistics
+
+#import "RFBMockServer.h"
+#import "RFBImpairmentProxy.h"
+#import "RFBLatencyHistogram.h"
+#import "RFBConnection.h"
+#import "RFBSecurity.h"
+#import "RFBSecurityNone.h"
+#import "RFBSecurityVNC.h"
+#import "RFBSecurityARD.h"
+#import "RFBSecurityVeNCrypt.h"
+#import "RFBTLSSession.h"
+#import "VersionMsg.h"
+#import "Des.h"
+#import "RFBDHKeyPool.h"
+#import "RFBHandshakeCache.h"
+#import "RFBSocket.h"
+#import "KeyMapping.h"
+#import "keysymdef.h"
+
+#define BENCHMARK_USERNAME @"bench"
+#define BENCHMARK_PASSWORD @"benchpw"
+#define EVENTS_TIMEOUT 30 //seconds to wait for every event to reach the server
+#define MOVE_INTERVAL (1.0 / 60) //seconds, touch sample rate
+#define CLICK_INTERVAL 0.25
+#define KEY_POOL_FILL_WAIT 0.1 //seconds, for the pool to fill after the first ARD login, as it would between logins
+#define HANDSHAKE_CACHE_IMPAIRMENT @"cafe" //Round trips have to cost something for the cache to show
+
+//RFBSocket's send buffer path, private to it.  Call within @synchronized(socket), as it does
+@interface RFBSocket (SendBuffer)
+-(NSMutableData *)sendBuffer;
+-(void)appendMessage:(const void *)message Length:(NSUInteger)length;
+@end
+
+static double secondsFromMachTime(uint64_t machTime) {
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0)
+		mach_timebase_info(&timebase);
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+@implementation RFBProtocolBenchmark
+#pragma mark - Benchmark - Public
++(void)runWithIterations:(NSUInteger)iterations Completion:(void (^)(NSDictionary *results))completion {
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		NSMutableDictionary *results = [NSMutableDictionary dictionary];
+		[results addEntriesFromDictionary:[self benchmarkHandshakesWithIterations:iterations]];
+		[results addEntriesFromDictionary:[self benchmarkARDKeyPoolWithIterations:iterations]];
+		[results addEntriesFromDictionary:[self benchmarkARDHandshakesWithCount:iterations * 10]];
+		[results addEntriesFromDictionary:[self benchmarkVeNCryptResumptionWithIterations:iterations]];
+		[results addEntriesFromDictionary:[self benchmarkHandshakeCacheWithIterations:iterations]];
+		[results addEntriesFromDictionary:[self benchmarkEventsWithCount:iterations * 1000]];
+		for (NSString *name in [RFBImpairmentProxy impairmentNames])
+			[results addEntriesFromDictionary:[self benchmarkInputLagWithImpairmentNamed:name Moves:iterations * 12 Clicks:iterations]];
+		double decryptRate = 0;
+		double encryptRate = [self benchmarkDesMessagesOfLength:1024 * 1024 Iterations:iterations DecryptRate:&decryptRate];
+		[results setObject:@(encryptRate) forKey:@"des encrypt 1MB MB/s"];
+		[results setObject:@(decryptRate) forKey:@"des decrypt 1MB MB/s"];
+		double heapBlocksPerMessage = 0;
+		[results setObject:@([self benchmarkEncodingMessages:iterations * 100000 HeapBlocksPerMessage:&heapBlocksPerMessage]) forKey:@"encode messages per second"];
+		[results setObject:@(heapBlocksPerMessage) forKey:@"encode heap blocks per message"];
+		[results setObject:@([self benchmarkKeySymLookups:iterations]) forKey:@"keysym lookup ns"];
+		
+		NSMutableString *summary = [NSMutableString string];
+		for (NSString *name in [[results allKeys] sortedArrayUsingSelector:@selector(compare:)])
+			[summary appendFormat:@"\n  %@: %.3f", name, [[results objectForKey:name] doubleValue]];
+		DLogInf(@"Protocol benchmark:%@", summary);
+		
+		if (completion)
+			dispatch_async(dispatch_get_main_queue(), ^{
+				completion(results);
+			});
+	});
+}
+
+//Average connect time and client to server bytes per handshake, for each version and security type the client supports
++(NSDictionary *)benchmarkHandshakesWithIterations:(NSUInteger)iterations {
+	NSArray *cases = @[
+		@[@"3.3 None", @3, @3, [NSNumber numberWithUnsignedChar:[RFBSecurityNone type]]],
+		@[@"3.7 None", @3, @7, [NSNumber numberWithUnsignedChar:[RFBSecurityNone type]]],
+		@[@"3.8 None", @3, @8, [NSNumber numberWithUnsignedChar:[RFBSecurityNone type]]],
+		@[@"3.3 VNC", @3, @3, [NSNumber numberWithUnsignedChar:[RFBSecurityVNC type]]],
+		@[@"3.7 VNC", @3, @7, [NSNumber numberWithUnsignedChar:[RFBSecurityVNC type]]],
+		@[@"3.8 VNC", @3, @8, [NSNumber numberWithUnsignedChar:[RFBSecurityVNC type]]],
+		@[@"3.889 ARD", @3, @889, [NSNumber numberWithUnsignedChar:[RFBSecurityARD type]]]
+	];
+	
+	NSMutableDictionary *results = [NSMutableDictionary dictionary];
+	for (NSArray *benchmarkCase in cases) {
+		NSString *name = [benchmarkCase objectAtIndex:0];
+		uint8_t securityType = [[benchmarkCase objectAtIndex:3] unsignedCharValue];
+		RFBMockServer *server = [self serverWithMajor:[[benchmarkCase objectAtIndex:1] intValue]
+												Minor:[[benchmarkCase objectAtIndex:2] intValue]
+										 SecurityType:securityType];
+		if (!server)
+			continue;
+		
+		NSUInteger connected = 0;
+		uint64_t total = 0;
+		for (NSUInteger i = 0; i < iterations; i++) {
+			RFBConnection *connection = [self connectionToServer:server SecurityType:securityType];
+			NSError *error = nil;
+			uint64_t start = mach_absolute_time();
+			BOOL success = [connection connect:&error];
+			uint64_t elapsed = mach_absolute_time() - start;
+			[connection disconnect];
+			if (!success) {
+				DLogErr(@"Handshake %@ failed: %@", name, error);
+				break;
+			}
+			connected++;
+			total += elapsed;
+		}
+		[server stop];
+		
+		if (connected == iterations && connected > 0) {
+			[results setObject:[NSNumber numberWithDouble:secondsFromMachTime(total) * 1000 / connected] forKey:[NSString stringWithFormat:@"handshake %@ ms", name]];
+			[results setObject:[NSNumber numberWithDouble:(double)[server bytesReceived] / connected] forKey:[NSString stringWithFormat:@"handshake %@ bytes", name]];
+		}
+	}
+	return results;
+}
+
+//ARD handshake time with key pairs from RFBDHKeyPool and without, pool hits, and key pair generation time (ms)
++(NSDictionary *)benchmarkARDKeyPoolWithIterations:(NSUInteger)iterations {
+	NSMutableDictionary *results = [NSMutableDictionary dictionary];
+	RFBMockServer *server = [self serverWithMajor:3 Minor:889 SecurityType:[RFBSecurityARD type]];
+	if (!server)
+		return results;
+	
+	RFBDHKeyPool *pool = [RFBDHKeyPool sharedPool];
+	BOOL wasEnabled = pool.enabled;
+	for (NSUInteger pass = 0; pass < 2; pass++) {
+		BOOL pooled = (pass == 1);
+		pool.enabled = pooled;
+		if (pooled) { //The first login with a prime always generates inline
+			RFBConnection *connection = [self connectionToServer:server SecurityType:[RFBSecurityARD type]];
+			[connection connect:nil];
+			[connection disconnect];
+			[NSThread sleepForTimeInterval:KEY_POOL_FILL_WAIT];
+		}
+		
+		unsigned long long hits = pool.hits;
+		NSUInteger connected = 0;
+		uint64_t total = 0;
+		for (NSUInteger i = 0; i < iterations; i++) {
+			RFBConnection *connection = [self connectionToServer:server SecurityType:[RFBSecurityARD type]];
+			NSError *error = nil;
+			uint64_t start = mach_absolute_time();
+			BOOL success = [connection connect:&error];
+			uint64_t elapsed = mach_absolute_time() - start;
+			[connection disconnect];
+			if (!success) {
+				DLogErr(@"ARD handshake failed: %@", error);
+				break;
+			}
+			connected++;
+			total += elapsed;
+		}
+		
+		if (connected == iterations && connected > 0) {
+			NSString *name = pooled ? @"handshake ARD key pool ms" : @"handshake ARD no key pool ms";
+			[results setObject:[NSNumber numberWithDouble:secondsFromMachTime(total) * 1000 / connected] forKey:name];
+			if (pooled)
+				[results setObject:[NSNumber numberWithDouble:(double)(pool.hits - hits) / connected] forKey:@"handshake ARD key pool hit rate"];
+		}
+	}
+	pool.enabled = wasEnabled;
+	[server stop];
+	
+	if ([pool.generationTimes count] > 0)
+		[results setObject:[NSNumber numberWithDouble:[pool.generationTimes mean] * 1000] forKey:@"ARD key pair generation ms"];
+	return results;
+}
+
+//Back to back ARD logins, each a new connection, for handshakes per second including the server's side
++(NSDictionary *)benchmarkARDHandshakesWithCount:(NSUInteger)count {
+	NSMutableDictionary *results = [NSMutableDictionary dictionary];
+	RFBMockServer *server = [self serverWithMajor:3 Minor:889 SecurityType:[RFBSecurityARD type]];
+	if (!server || count == 0)
+		return results;
+	
+	uint64_t start = mach_absolute_time();
+	NSUInteger connected = 0;
+	for (; connected < count; connected++) {
+		RFBConnection *connection = [self connectionToServer:server SecurityType:[RFBSecurityARD type]];
+		NSError *error = nil;
+		BOOL success = [connection connect:&error];
+		[connection disconnect];
+		if (!success) {
+			DLogErr(@"ARD handshake failed: %@", error);
+			break;
+		}
+	}
+	double seconds = secondsFromMachTime(mach_absolute_time() - start);
+	[server stop];
+	
+	if (connected == count && seconds > 0)
+		[results setObject:[NSNumber numberWithDouble:count / seconds] forKey:@"ARD handshakes per second"];
+	return results;
+}
+
+//VeNCrypt TLSVnc handshake time with every TLS session forgotten first, then resumed (ms), and how many resumed
++(NSDictionary *)benchmarkVeNCryptResumptionWithIterations:(NSUInteger)iterations {
+	NSMutableDictionary *results = [NSMutableDictionary dictionary];
+	RFBMockServer *server = [self serverWithMajor:3 Minor:8 SecurityType:[RFBSecurityVeNCrypt type]];
+	if (!server)
+		return results;
+	
+	for (NSUInteger pass = 0; pass < 2; pass++) {
+		BOOL resumed = (pass == 1);
+		[RFBTLSSession removeAllCachedSessions];
+		if (resumed) { //Cache a session to resume
+			RFBConnection *connection = [self connectionToServer:server SecurityType:[RFBSecurityVeNCrypt type]];
+			[connection connect:nil];
+			[connection disconnect];
+		}
+		
+		NSUInteger resumptions = [server tlsResumptions];
+		NSUInteger connected = 0;
+		uint64_t total = 0;
+		for (NSUInteger i = 0; i < iterations; i++) {
+			if (!resumed)
+				[RFBTLSSession removeAllCachedSessions];
+			RFBConnection *connection = [self connectionToServer:server SecurityType:[RFBSecurityVeNCrypt type]];
+			NSError *error = nil;
+			uint64_t start = mach_absolute_time();
+			BOOL success = [connection connect:&error];
+			uint64_t elapsed = mach_absolute_time() - start;
+			[connection disconnect];
+			if (!success) {
+				DLogErr(@"VeNCrypt handshake failed: %@", error);
+				break;
+			}
+			connected++;
+			total += elapsed;
+		}
+		
+		if (connected == iterations && connected > 0) {
+			NSString *name = resumed ? @"handshake VeNCrypt TLS resumed ms" : @"handshake VeNCrypt TLS full ms";
+			[results setObject:[NSNumber numberWithDouble:secondsFromMachTime(total) * 1000 / connected] forKey:name];
+			if (resumed)
+				[results setObject:[NSNumber numberWithDouble:(double)([server tlsResumptions] - resumptions) / connected] forKey:@"handshake VeNCrypt TLS resumption rate"];
+		}
+	}
+	[RFBTLSSession removeAllCachedSessions];
+	[server stop];
+	return results;
+}
+
+//Alternating pointer motion and key presses through -[RFBConnection sendEventRecord:Error:], timed until the server has
+//every key event.  Also bytes on the wire per event and messages per event, as coalescing can't merge messages
++(NSDictionary *)benchmarkEventsWithCount:(NSUInteger)count {
+	NSMutableDictionary *results = [NSMutableDictionary dictionary];
+	if (count == 0)
+		return results;
+	
+	RFBMockServer *server = [self serverWithMajor:3 Minor:8 SecurityType:[RFBSecurityNone type]];
+	if (!server)
+		return results;
+	
+	NSUInteger keyPresses = count / 2; //Every other event
+	__block NSUInteger keyMessages = 0;
+	dispatch_semaphore_t allReceived = dispatch_semaphore_create(0);
+	server.messageHandler = ^(RFBMockClientMessage message) { //On the server queue
+		if (message.type == KeyEvent_MsgType && ++keyMessages == keyPresses * 2)
+			dispatch_semaphore_signal(allReceived);
+	};
+	
+	RFBConnection *connection = [self connectionToServer:server SecurityType:[RFBSecurityNone type]];
+	NSError *error = nil;
+	if (![connection connect:&error]) {
+		DLogErr(@"Events benchmark couldn't connect: %@", error);
+		[server stop];
+		dispatch_release(allReceived);
+		return results;
+	}
+	[server clearRecorded];
+	
+	RFBEventRecord pointer;
+	memset(&pointer, 0, sizeof(pointer));
+	pointer.type = RFBEventRecordPointer;
+	pointer.pointer.dt = 0.01;
+	pointer.pointer.v = CGPointMake(100, 100);
+	RFBEventRecord key;
+	memset(&key, 0, sizeof(key));
+	key.type = RFBEventRecordKey;
+	key.key.keyPress = 'a';
+	
+	uint64_t start = mach_absolute_time();
+	for (NSUInteger i = 0; i < count; i++) {
+		if (i % 2 == 1) {
+			[connection sendEventRecord:&key Error:nil];
+		} else {
+			pointer.pointer.dx = (i % 4 == 0) ? 1 : -1; //Back and forth, never pinned to an edge
+			pointer.pointer.dy = pointer.pointer.dx;
+			[connection sendEventRecord:&pointer Error:nil];
+		}
+	}
+	BOOL received = (keyPresses == 0 || dispatch_semaphore_wait(allReceived, dispatch_time(DISPATCH_TIME_NOW, EVENTS_TIMEOUT * NSEC_PER_SEC)) == 0);
+	uint64_t elapsed = mach_absolute_time() - start;
+	
+	[connection disconnect];
+	[server stop];
+	server.messageHandler = nil;
+	dispatch_release(allReceived);
+	
+	if (!received) {
+		DLogErr(@"Events benchmark timed out, server received %lu of %lu key events", (unsigned long)[server messageCount], (unsigned long)keyPresses * 2);
+		return results;
+	}
+	double seconds = secondsFromMachTime(elapsed);
+	NSUInteger messages = [server messageCount];
+	[results setObject:[NSNumber numberWithDouble:(seconds > 0 ? count / seconds : 0)] forKey:@"events per second"];
+	[results setObject:[NSNumber numberWithDouble:(double)[server receivedMessageBytes].length / count] forKey:@"bytes per event"];
+	[results setObject:[NSNumber numberWithDouble:(double)messages / count] forKey:@"messages per event"];
+	return results;
+}
+
+//3.8 VNC handshake time over an impaired link (ms) with no cache, then sending ahead from the first handshake's cache
++(NSDictionary *)benchmarkHandshakeCacheWithIterations:(NSUInteger)iterations {
+	NSMutableDictionary *results = [NSMutableDictionary dictionary];
+	RFBMockServer *server = [self serverWithMajor:3 Minor:8 SecurityType:[RFBSecurityVNC type]];
+	if (!server)
+		return results;
+	RFBImpairmentProxy *proxy = [[RFBImpairmentProxy alloc] initWithHost:[server host] Port:[server port]];
+	NSError *error = nil;
+	if (![proxy start:&error]) {
+		DLogErr(@"Impairment proxy didn't start: %@", error);
+		[server stop];
+		return results;
+	}
+	proxy.impairment = [RFBImpairmentProxy impairmentNamed:HANDSHAKE_CACHE_IMPAIRMENT];
+	
+	RFBHandshakeCache *cache = nil;
+	for (NSUInteger pass = 0; pass < 2; pass++) {
+		BOOL cached = (pass == 1);
+		NSUInteger connected = 0, sentAhead = 0;
+		uint64_t total = 0;
+		for (NSUInteger i = 0; i < iterations; i++) {
+			RFBConnection *connection = [[RFBConnection alloc] initWithHostname:[proxy host] Port:[proxy port] Security:[[RFBSecurityVNC alloc] initWithPassword:BENCHMARK_PASSWORD]];
+			connection.handshakeCache = cached ? cache : nil;
+			uint64_t start = mach_absolute_time();
+			BOOL success = [connection connect:&error];
+			uint64_t elapsed = mach_absolute_time() - start;
+			[connection disconnect];
+			if (!success) {
+				DLogErr(@"Handshake cache benchmark couldn't connect: %@", error);
+				break;
+			}
+			if (!cache)
+				cache = connection.handshakeCache;
+			connected++;
+			sentAhead += [connection usedHandshakeCache] ? 1 : 0;
+			total += elapsed;
+		}
+		
+		if (connected == iterations && connected > 0) {
+			NSString *name = cached ? @"handshake cache on ms" : @"handshake cache off ms";
+			[results setObject:[NSNumber numberWithDouble:secondsFromMachTime(total) * 1000 / connected] forKey:name];
+			if (cached)
+				[results setObject:[NSNumber numberWithDouble:(double)sentAhead / connected] forKey:@"handshake cache hit rate"];
+		}
+	}
+	[proxy stop];
+	[server stop];
+	return results;
+}
+
++(NSDictionary *)benchmarkInputLagWithImpairmentNamed:(NSString *)name Moves:(NSUInteger)moves Clicks:(NSUInteger)clicks {
+	NSMutableDictionary *results = [NSMutableDictionary dictionary];
+	RFBMockServer *server = [self serverWithMajor:3 Minor:8 SecurityType:[RFBSecurityNone type]];
+	if (!server)
+		return results;
+	RFBImpairmentProxy *proxy = [[RFBImpairmentProxy alloc] initWithHost:[server host] Port:[server port]];
+	NSError *error = nil;
+	if (![proxy start:&error]) {
+		DLogErr(@"Impairment proxy didn't start: %@", error);
+		[server stop];
+		return results;
+	}
+	
+	//Handshake unimpaired, only input is measured
+	RFBConnection *connection = [[RFBConnection alloc] initWithHostname:[proxy host] Port:[proxy port] Security:[[RFBSecurityNone alloc] init]];
+	if (![connection connect:&error]) {
+		DLogErr(@"Input lag benchmark couldn't connect: %@", error);
+		[proxy stop];
+		[server stop];
+		return results;
+	}
+	proxy.impairment = [RFBImpairmentProxy impairmentNamed:name];
+	
+	//Messages arrive in the order sent.  Each move is one message, each click a press and a release, timed by the press
+	NSUInteger expected = moves + clicks * 2;
+	uint64_t *sentAt = calloc(MAX(moves + clicks, 1), sizeof(uint64_t));
+	RFBLatencyHistogram *moveLag = [[RFBLatencyHistogram alloc] init];
+	RFBLatencyHistogram *clickLag = [[RFBLatencyHistogram alloc] init];
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0)
+		mach_timebase_info(&timebase);
+	__block NSUInteger received = 0;
+	dispatch_semaphore_t allReceived = dispatch_semaphore_create(0);
+	server.messageHandler = ^(RFBMockClientMessage message) { //On the server queue
+		if (message.type != PointerEvent_MsgType || received >= expected)
+			return;
+		NSUInteger index = received;
+		received++;
+		if (index < moves)
+			[moveLag recordNanoseconds:(message.receivedAt - sentAt[index]) * timebase.numer / timebase.denom];
+		else if ((index - moves) % 2 == 0)
+			[clickLag recordNanoseconds:(message.receivedAt - sentAt[moves + (index - moves) / 2]) * timebase.numer / timebase.denom];
+		if (received == expected)
+			dispatch_semaphore_signal(allReceived);
+	};
+	
+	RFBEventRecord record;
+	memset(&record, 0, sizeof(record));
+	record.type = RFBEventRecordPointer;
+	uint64_t next = mach_absolute_time();
+	for (NSUInteger i = 0; i < moves + clicks; i++) {
+		BOOL click = (i >= moves);
+		next += (uint64_t)((click ? CLICK_INTERVAL : MOVE_INTERVAL) * NSEC_PER_SEC) * timebase.denom / timebase.numer;
+		mach_wait_until(next);
+		
+		if (click) {
+			record.pointer.dx = 0;
+			record.pointer.dy = 0;
+			record.pointer.button1 = YES;
+			record.pointer.buttonIterations = 1;
+		} else {
+			record.pointer.dt = MOVE_INTERVAL;
+			record.pointer.dx = (i % 2 == 0) ? 4 : -4; //Back and forth, never pinned to an edge
+			record.pointer.dy = record.pointer.dx;
+			record.pointer.v = CGPointMake(200, 200);
+		}
+		sentAt[i] = mach_absolute_time();
+		record.capturedAt = sentAt[i];
+		record.enqueuedAt = sentAt[i];
+		[connection sendEventRecord:&record Error:nil];
+	}
+	BOOL allArrived = (dispatch_semaphore_wait(allReceived, dispatch_time(DISPATCH_TIME_NOW, EVENTS_TIMEOUT * NSEC_PER_SEC)) == 0);
+	
+	[connection disconnect];
+	NSUInteger stalls = [proxy stallsInjected];
+	[proxy stop];
+	[server stop];
+	server.messageHandler = nil;
+	dispatch_release(allReceived);
+	free(sentAt);
+	
+	if (!allArrived)
+		DLogErr(@"Input lag benchmark %@ timed out, %lu of %lu pointer messages arrived", name, (unsigned long)received, (unsigned long)expected);
+	DLogInf(@"Input lag %@, %lu stalls injected\n  moves: %@\n  clicks: %@", name, (unsigned long)stalls, [moveLag summary], [clickLag summary]);
+	NSString *prefix = [NSString stringWithFormat:@"lag %@", name];
+	if ([moveLag count] > 0) {
+		[results setObject:[NSNumber numberWithDouble:[moveLag percentile:50] * 1000] forKey:[prefix stringByAppendingString:@" move p50 ms"]];
+		[results setObject:[NSNumber numberWithDouble:[moveLag percentile:95] * 1000] forKey:[prefix stringByAppendingString:@" move p95 ms"]];
+	}
+	if ([clickLag count] > 0) {
+		[results setObject:[NSNumber numberWithDouble:[clickLag percentile:50] * 1000] forKey:[prefix stringByAppendingString:@" click p50 ms"]];
+		[results setObject:[NSNumber numberWithDouble:[clickLag max] * 1000] forKey:[prefix stringByAppendingString:@" click max ms"]];
+	}
+	[results setObject:[NSNumber numberWithDouble:(expected > 0 ? (double)received / expected : 0)] forKey:[prefix stringByAppendingString:@" delivered"]];
+	return results;
+}
+
+#pragma mark - Micro benchmarks - Public
++(double)benchmarkDesMessagesOfLength:(NSUInteger)length Iterations:(NSUInteger)iterations DecryptRate:(double *)decryptRate {
+	NSMutableData *message = [NSMutableData dataWithLength:length];
+	unsigned char *bytes = [message mutableBytes];
+	for (NSUInteger i = 0; i < length; i++)
+		bytes[i] = (unsigned char)(i * 31 + 7);
+	const unsigned char keyBytes[8] = {0x13, 0x34, 0x57, 0x79, 0x9B, 0xBC, 0xDF, 0xF1};
+	NSData *key = [NSData dataWithBytes:keyBytes length:sizeof(keyBytes)];
+	double megabytes = (double)length * iterations / (1024 * 1024);
+	
+	NSData *ciphertext = nil;
+	uint64_t start = mach_absolute_time();
+	for (NSUInteger i = 0; i < iterations; i++) {
+		@autoreleasepool {
+			ciphertext = [Des encryptMessage:message withKey:key];
+		}
+	}
+	double encryptSeconds = secondsFromMachTime(mach_absolute_time() - start);
+	
+	NSData *plaintext = nil;
+	start = mach_absolute_time();
+	for (NSUInteger i = 0; i < iterations; i++) {
+		@autoreleasepool {
+			plaintext = [Des decryptMessage:ciphertext withKey:key];
+		}
+	}
+	double decryptSeconds = secondsFromMachTime(mach_absolute_time() - start);
+	
+	if (plaintext.length != length + 1 || memcmp([plaintext bytes], bytes, length) != 0)
+		DLogErr(@"DES benchmark round trip mismatch");
+	if (decryptRate)
+		*decryptRate = (decryptSeconds > 0) ? megabytes / decryptSeconds : 0;
+	return (encryptSeconds > 0) ? megabytes / encryptSeconds : 0;
+}
+
++(double)benchmarkEncodingMessages:(NSUInteger)messages HeapBlocksPerMessage:(double *)heapBlocksPerMessage {
+	RFBSocket *rfbSocket = [[RFBSocket alloc] initWithAddress:nil Port:0];
+	NSUInteger flushLength = rfbSocket.coalescingThreshold;
+	
+	malloc_statistics_t heapBefore, heapAfter;
+	malloc_zone_statistics(NULL, &heapBefore);
+	uint64_t start = mach_absolute_time();
+	
+	//As the send path, minus the socket write: alternate pointer and key messages, "flushing" by reusing the buffer
+	@synchronized(rfbSocket) {
+		for (NSUInteger i = 0; i < messages; i++) {
+			if (i & 1) {
+				KeyMsg keyMsg = RFBKeyMsgMake(i & 2, XK_a);
+				[rfbSocket appendMessage:&keyMsg Length:KeyMsg_Size];
+			} else {
+				PointerMsg pointerMsg = RFBPointerMsgMake(0, i & 0x7FF, i & 0x3FF);
+				[rfbSocket appendMessage:&pointerMsg Length:PointerMsg_Size];
+			}
+			if ([rfbSocket sendBuffer].length >= flushLength)
+				[[rfbSocket sendBuffer] setLength:0];
+		}
+	}
+	
+	double seconds = secondsFromMachTime(mach_absolute_time() - start);
+	malloc_zone_statistics(NULL, &heapAfter);
+	if (heapBlocksPerMessage)
+		*heapBlocksPerMessage = messages ? ((double)heapAfter.blocks_in_use - (double)heapBefore.blocks_in_use) / messages : 0;
+	return seconds > 0 ? messages / seconds : 0;
+}
+
++(double)benchmarkKeySymLookups:(NSUInteger)iterations {
+	//Every BMP code point plus the supplementary planes' first page, so table hits, misses and the fallback are all covered
+	UInt32 checksum = 0;
+	uint64_t start = mach_absolute_time();
+	for (NSUInteger i = 0; i < iterations; i++) {
+		for (UTF32Char ch = 0; ch <= 0x100FF; ch++)
+			checksum += [KeyMapping codePointToX11KeySym:ch];
+	}
+	double nanoseconds = secondsFromMachTime(mach_absolute_time() - start) * NSEC_PER_SEC;
+	double lookups = (double)iterations * 0x10100;
+	DLogInf(@"%.0f keysym lookups in %.1f ms (checksum %x)", lookups, nanoseconds / 1e6, (unsigned int)checksum);
+	return lookups > 0 ? nanoseconds / lookups : 0;
+}
+
+#pragma mark - Benchmark - Private
++(RFBMockServer *)serverWithMajor:(int)major Minor:(int)minor SecurityType:(uint8_t)securityType {
+	RFBMockServer *server = [[RFBMockServer alloc] init];
+	server.version = [[VersionMsg alloc] initWithMajor:major Minor:minor];
+	server.securityTypes = @[[NSNumber numberWithUnsignedChar:securityType]];
+	server.username = BENCHMARK_USERNAME;
+	server.password = BENCHMARK_PASSWORD;
+	NSError *error = nil;
+	if (![server start:&error]) {
+		DLogErr(@"Mock server didn't start: %@", error);
+		return nil;
+	}
+	return server;
+}
+
++(RFBConnection *)connectionToServer:(RFBMockServer *)server SecurityType:(uint8_t)securityType {
+	RFBSecurity *security;
+	if (securityType == [RFBSecurityVNC type])
+		security = [[RFBSecurityVNC alloc] initWithPassword:BENCHMARK_PASSWORD];
+	else if (securityType == [RFBSecurityARD type])
+		security = [[RFBSecurityARD alloc] initWithUsername:BENCHMARK_USERNAME Password:BENCHMARK_PASSWORD];
+	else if (securityType == [RFBSecurityVeNCrypt type])
+		security = [[RFBSecurityVeNCrypt alloc] initWithUsername:nil Password:BENCHMARK_PASSWORD]; //TLSVnc
+	else
+		security = [[RFBSecurityNone alloc] init];
+	return [[RFBConnection alloc] initWithHostname:[server host] Port:[server port] Security:security];
+}
+@end
@@ -0,0 +1,33 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+//  Self checks for 'rfbdrive check', for what a connection to a real server can't show.  Each returns NO with an error
+//  describing the first thing that was wrong.
+
+#import <Foundation/Foundation.h>
+
+@interface RFBSelfCheck : NSObject
+//+[KeyMapping codePointToX11KeySym:] for every code point, U+0000 to U+10FFFF, against the exact U+XXXX annotations in
+//the keysymdef.h at path: Latin-1 maps to itself, the control codes to their named keysyms, annotated code points to the
+//first keysym listed for them, and everything else to the Unicode keysym
++(BOOL)checkKeyMappingWithKeySymDef:(NSString *)path Error:(NSError **)error;
+//VeNCrypt against RFBMockServer: the first connect does a full TLS handshake and caches the session, the second offers
+//it (saved and restored first, as a relaunch would) and the server resumes it
++(BOOL)checkVeNCryptResumption:(NSError **)error;
+//RFBLoadGenerator clients on a one worker event loop, sending ahead from a handshake cache the server no longer matches.
+//Every client has to handshake again without it, on a new socket from the same loop, and connect
++(BOOL)checkHandshakeCacheMismatchOnEventLoop:(NSError **)error;
+@end
@@ -0,0 +1,225 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+
+#import "RFBSelfCheck.h"
+
+#import "ErrorHandlingMacros.h"
+#import "HandleErrors.h"
+
+#import "KeyMapping.h"
+#import "RFBConnection.h"
+#import "RFBSecurityVeNCrypt.h"
+#import "RFBTLSSession.h"
+#import "RFBSecurityNone.h"
+#import "RFBHandshakeCache.h"
+#import "RFBLoadGenerator.h"
+#import "VersionMsg.h"
+#import "RFBMockServer.h"
+
+#define MAX_CODE_POINT 0x10FFFF
+#define UNICODE_KEYSYM_BASE 0x01000000
+#define MISMATCHES_SHOWN 8
+#define CHECK_PASSWORD @"checkpw"
+#define MISMATCH_CLIENTS 4
+#define MISMATCH_DURATION 0.5 //Seconds of input once connected
+#define MISMATCH_TIMEOUT 30 //Seconds, a deadlocked restart never finishes
+
+//Control codes +[KeyMapping codePointToX11KeySym:] maps ahead of the annotations, by keysymdef.h name
+static const struct {
+	UTF32Char codePoint;
+	const char *name;
+} ControlKeySyms[] = {
+	{ 0x08, "BackSpace" }, { 0x09, "Tab" }, { 0x0A, "Return" }, { 0x0D, "Return" }, { 0x0F, "Delete" }
+};
+
+@implementation RFBSelfCheck
+#pragma mark - Checks - Public
++(BOOL)checkKeyMappingWithKeySymDef:(NSString *)path Error:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	NSError *readError = nil;
+	NSString *header = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:&readError];
+	if (!header) {
+		he(error, FileErrorDomain, FileExistReadError, [NSString stringWithFormat:@"Can't read %@: %@", path, [readError localizedDescription]]);
+		return NO;
+	}
+	
+	//Same rules as generate_keysym_table.py, read straight from keysymdef.h rather than from the table it generated
+	NSRegularExpression *define = [NSRegularExpression regularExpressionWithPattern:@"^#define XK_([a-zA-Z_0-9]+)\\s+0x([0-9a-f]+)\\b(?:\\s*/\\* U\\+([0-9A-F]{4,6}) .* \\*/\\s*$)?" options:0 error:nil];
+	uint32_t *annotated = calloc(MAX_CODE_POINT + 1, sizeof(uint32_t)); //0 = none
+	NSMutableDictionary *names = [NSMutableDictionary dictionary];
+	__block NSUInteger annotations = 0;
+	[header enumerateLinesUsingBlock:^(NSString *line, BOOL *stop) {
+		NSTextCheckingResult *match = [define firstMatchInString:line options:0 range:NSMakeRange(0, line.length)];
+		if (!match)
+			return;
+		NSString *name = [line substringWithRange:[match rangeAtIndex:1]];
+		uint32_t keysym = (uint32_t)strtoul([[line substringWithRange:[match rangeAtIndex:2]] UTF8String], NULL, 16);
+		if (![names objectForKey:name])
+			[names setObject:[NSNumber numberWithUnsignedInt:keysym] forKey:name];
+		if ([match rangeAtIndex:3].location == NSNotFound || keysym >= UNICODE_KEYSYM_BASE)
+			return;
+		unsigned long codePoint = strtoul([[line substringWithRange:[match rangeAtIndex:3]] UTF8String], NULL, 16);
+		if (codePoint <= MAX_CODE_POINT && annotated[codePoint] == 0) { //First listed wins
+			annotated[codePoint] = keysym;
+			annotations++;
+		}
+	}];
+	if (annotations == 0) {
+		free(annotated);
+		he(error, FileErrorDomain, FileReadError, [NSString stringWithFormat:@"No U+XXXX annotations in %@", path]);
+		return NO;
+	}
+	for (NSUInteger i = 0; i < sizeof(ControlKeySyms) / sizeof(ControlKeySyms[0]); i++) {
+		NSNumber *keysym = [names objectForKey:[NSString stringWithUTF8String:ControlKeySyms[i].name]];
+		if (!keysym) {
+			free(annotated);
+			he(error, FileErrorDomain, FileReadError, [NSString stringWithFormat:@"XK_%s missing from %@", ControlKeySyms[i].name, path]);
+			return NO;
+		}
+		annotated[ControlKeySyms[i].codePoint] = [keysym unsignedIntValue];
+	}
+	
+	NSUInteger mismatches = 0;
+	NSMutableString *shown = [NSMutableString string];
+	for (UTF32Char ch = 0; ch <= MAX_CODE_POINT; ch++) {
+		UInt32 expected;
+		if ((ch >= 0x20 && ch <= 0x7E) || (ch >= 0xA0 && ch <= 0xFF))
+			expected = ch;
+		else if (annotated[ch])
+			expected = annotated[ch];
+		else
+			expected = ch | UNICODE_KEYSYM_BASE;
+		UInt32 mapped = [KeyMapping codePointToX11KeySym:ch];
+		if (mapped != expected && mismatches++ < MISMATCHES_SHOWN)
+			[shown appendFormat:@"\n  U+%04X maps to 0x%x, keysymdef.h says 0x%x", (unsigned int)ch, (unsigned int)mapped, (unsigned int)expected];
+	}
+	free(annotated);
+	
+	if (mismatches > 0) {
+		he(error, ObjectErrorDomain, ObjectMethodReturnError, [NSString stringWithFormat:@"%lu code points map to the wrong keysym, regenerate KeySymTable.h%@", (unsigned long)mismatches, shown]);
+		return NO;
+	}
+	return YES;
+}
+
++(BOOL)checkVeNCryptResumption:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	RFBMockServer *server = [self serverWithSecurityType:[RFBSecurityVeNCrypt type] Error:error];
+	if (!server)
+		return NO;
+	NSString *cacheKey = [NSString stringWithFormat:@"%@:%i", [server host], [server port]];
+	[RFBTLSSession removeAllCachedSessions];
+	
+	//Full handshake, nothing to offer
+	RFBSecurityVeNCrypt *security = nil;
+	BOOL connected = [self connectToServer:server CacheKey:cacheKey Security:&security Error:error];
+	if (connected && (security.resumedSession || [server tlsResumptions] > 0 || ![RFBTLSSession hasCachedSessionForKey:cacheKey])) {
+		he(error, SecurityErrorDomain, SocketSecurityError, [NSString stringWithFormat:@"First handshake: resumed %i, server resumptions %lu, session cached %i, expected a full handshake with the session cached after",
+															 security.resumedSession, (unsigned long)[server tlsResumptions], [RFBTLSSession hasCachedSessionForKey:cacheKey]]);
+		connected = NO;
+	}
+	
+	//Across a relaunch: only what was saved is left to offer
+	NSDictionary *savedSession = connected ? [RFBSecurityVeNCrypt savedSessionForCacheKey:cacheKey] : nil;
+	if (connected && !savedSession) {
+		he(error, SecurityErrorDomain, SocketSecurityError, @"No session to save after the first handshake");
+		connected = NO;
+	}
+	if (connected) {
+		[RFBTLSSession removeAllCachedSessions];
+		[RFBSecurityVeNCrypt restoreSavedSession:savedSession ForCacheKey:cacheKey];
+		connected = [self connectToServer:server CacheKey:cacheKey Security:&security Error:error];
+	}
+	if (connected && (!security.resumedSession || [server tlsResumptions] != 1)) {
+		he(error, SecurityErrorDomain, SocketSecurityError, [NSString stringWithFormat:@"Second handshake: resumed %i, server resumptions %lu, expected the restored session to be resumed",
+															 security.resumedSession, (unsigned long)[server tlsResumptions]]);
+		connected = NO;
+	}
+	
+	[RFBTLSSession removeAllCachedSessions];
+	[server stop];
+	return connected;
+}
+
++(BOOL)checkHandshakeCacheMismatchOnEventLoop:(NSError **)error {
+	HandleError he = [HandleErrors handleErrorBlock];
+	RFBMockServer *server = [self serverWithSecurityType:[RFBSecurityNone type] Error:error];
+	if (!server)
+		return NO;
+	
+	//Fresh for the server and has its security type, so it's sent ahead, but the version is a step behind
+	uint8_t securityType = [RFBSecurityNone type];
+	RFBHandshakeCache *stale = [[RFBHandshakeCache alloc] initWithAddress:[server host]
+																	 Port:[server port]
+															ServerVersion:[[VersionMsg alloc] initWithMajor:3 Minor:7]
+															SecurityTypes:[NSData dataWithBytes:&securityType length:1]];
+	RFBLoadGenerator *generator = [[RFBLoadGenerator alloc] initWithHostname:[server host] Port:[server port] SecurityFactory:^RFBSecurity *{
+		return [[RFBSecurityNone alloc] init];
+	}];
+	generator.clients = MISMATCH_CLIENTS;
+	generator.workers = 1;
+	generator.duration = MISMATCH_DURATION;
+	generator.handshakeCache = stale;
+	
+	//Off this thread so a deadlock shows as a timeout
+	dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+	__block BOOL ran = NO;
+	__block NSError *runError = nil;
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		NSError *blockError = nil;
+		ran = [generator run:&blockError];
+		runError = blockError;
+		dispatch_semaphore_signal(finished);
+	});
+	BOOL timedOut = (dispatch_semaphore_wait(finished, dispatch_time(DISPATCH_TIME_NOW, MISMATCH_TIMEOUT * NSEC_PER_SEC)) != 0);
+	if (timedOut) { //Left hanging, the process is about to exit
+		he(error, SocketErrorDomain, SocketConnectError, [NSString stringWithFormat:@"Load run didn't finish in %i seconds, handshake restart deadlocked?", MISMATCH_TIMEOUT]);
+		return NO;
+	}
+	dispatch_release(finished);
+	[server stop];
+	
+	if (!ran) {
+		if (error)
+			*error = runError;
+		return NO;
+	}
+	if ([generator clientsConnected] != MISMATCH_CLIENTS) {
+		he(error, SocketErrorDomain, SocketConnectError, [NSString stringWithFormat:@"%lu of %i clients connected after the handshake cache mismatch", (unsigned long)[generator clientsConnected], MISMATCH_CLIENTS]);
+		return NO;
+	}
+	return YES;
+}
+
+#pragma mark - Checks - Private
++(RFBMockServer *)serverWithSecurityType:(uint8_t)securityType Error:(NSError **)error {
+	RFBMockServer *server = [[RFBMockServer alloc] init];
+	server.version = [[VersionMsg alloc] initWithMajor:3 Minor:8];
+	server.securityTypes = @[[NSNumber numberWithUnsignedChar:securityType]];
+	server.password = CHECK_PASSWORD;
+	return [server start:error] ? server : nil;
+}
+
+//TLSVnc, the security is returned to see how the handshake went.  Disconnects once connected
++(BOOL)connectToServer:(RFBMockServer *)server CacheKey:(NSString *)cacheKey Security:(RFBSecurityVeNCrypt **)security Error:(NSError **)error {
+	*security = [[RFBSecurityVeNCrypt alloc] initWithUsername:nil Password:CHECK_PASSWORD];
+	(*security).sessionCacheKey = cacheKey;
+	RFBConnection *connection = [[RFBConnection alloc] initWithHostname:[server host] Port:[server port] Security:*security];
+	BOOL connected = [connection connect:error];
+	[connection disconnect];
+	return connected;
+}
+@end
@@ -0,0 +1,470 @@
+/*
+ Copyright 2013 V Wong <vwong122013 (at) gmail.com>
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+ */
+
+//  rfbdrive, headless driver for the RFB input core.  Connects with a server profile, runs input commands (see
+//  RFBCommandRunner.h) from a script file or stdin, then prints timing stats.  For soak and throughput runs, and for
+//  profiling the send path with Instruments or dtrace without the app in the way.
+//  With -n it's a load generator instead, see RFBLoadGenerator.  "rfbdrive bench" runs the protocol benchmarks against
+//  RFBMockServer on the loopback interface, no server needed.  "rfbdrive impair" puts RFBImpairmentProxy in front of a
+//  server, to try the app or a script over bad Wi-Fi.  "rfbdrive check" runs RFBSelfCheck's checks, nonzero exit if any fail.
+
+#import <Foundation/Foundation.h>
+
+#include <getopt.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <mach/mach_time.h>
+
+#import "ServerProfile.h"
+#import "ProfileSaverFetcher.h"
+#import "RFBConnection.h"
+#import "RFBSecurity.h"
+#import "RFBSecurityARD.h"
+#import "RFBSecurityNone.h"
+#import "RFBSecurityVNC.h"
+#import "RFBSecurityVeNCrypt.h"
+#import "RFBInputLatency.h"
+#import "RFBCommandRunner.h"
+#import "RFBLoadGenerator.h"
+#import "RFBProtocolBenchmark.h"
+#import "RFBLoopbackBenchmark.h"
+#import "RFBImpairmentProxy.h"
+#import "RFBSelfCheck.h"
+
+#define PASSWORD_ENVIRONMENT_VARIABLE "RFBDRIVE_PASSWORD" //Kept out of the process list
+#define BENCH_ITERATIONS 10
+#define BENCH_TYPING_LENGTH 10000 //Characters typed, then pasted
+#define KEYSYMDEF_PATH "iOSVNCInputClient/3rdParty/KeySymDef/keysymdef.h" //From the top of the source tree
+
+typedef enum {
+	ExitSuccess = 0,
+	ExitCommandFailed = 1,
+	ExitConnectFailed = 2,
+	ExitUsage = 64 //EX_USAGE
+} RFBDriveExitCode;
+
+static void printUsage(void) {
+	fprintf(stderr,
+			"usage: rfbdrive [-f profile] [-H host] [-p port] [-u username] [-w password] [-m] [-T] [-3]\n"
+			"                [-c coalescing ms] [-t wait seconds] [-k] [script]\n"
+			"       rfbdrive <connection options> -n clients [-r rate] [-d seconds] [-x mix] [-C concurrency] [-W workers]\n"
+			"       rfbdrive bench [-i iterations] [-l length]\n"
+			"       rfbdrive impair -H host [-p port] [-d seconds] scenario\n"
+			"       rfbdrive check [-k keysymdef.h]\n"
+			"  -f  saved server profile (plist written by the app), other options override it\n"
+			"  -H  server address, -p port (default %i)\n"
+			"  -u  username and -m Mac authentication, -w password (or $" PASSWORD_ENVIRONMENT_VARIABLE ")\n"
+			"  -T  VeNCrypt TLS security, reconnects resume the TLS session\n"
+			"  -3  ARD 3.5 right button compatibility\n"
+			"  -c  write coalescing window in milliseconds, default off\n"
+			"  -t  seconds to wait for sends to finish, default 30\n"
+			"  -k  carry on after a command fails\n"
+			"  script defaults to stdin\n"
+			"  -n  load generator, clients connections sending a synthetic mix of input instead of a script\n"
+			"  -r  events per second per client, default 60\n"
+			"  -d  seconds of input once connected, default 10\n"
+			"  -x  mix weights, default pointer=70,click=5,scroll=10,key=15\n"
+			"  -C  handshakes in flight at once, default 32\n"
+			"  -W  share an event loop of this many worker queues between all clients, default a queue each\n"
+			"  bench  protocol benchmarks against a stand-in server on the loopback interface\n"
+			"  -i  iterations of each benchmark, default %i\n"
+			"  -l  characters to type then paste, default %i\n"
+			"  impair  forward a port on localhost to host:port through an impaired link until interrupted, or for -d seconds.\n"
+			"          scenario is one of none, lan, cafe, hotel, congested\n"
+			"  check  self checks, -k keysymdef.h to check keysym mapping against, default the source tree's\n",
+			[RFBConnection DEFAULT_PORT], BENCH_ITERATIONS, BENCH_TYPING_LENGTH);
+}
+
+static void printError(NSString *context, NSError *error) {
+	fprintf(stderr, "rfbdrive: %s: %s\n", [context UTF8String], [[error localizedDescription] UTF8String]);
+}
+
+static double secondsFromMachTime(uint64_t machTime) {
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0)
+		mach_timebase_info(&timebase);
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+//Same choice as +[RFBInputConnManager createConnectionWithProfile:Error:], which can't be built without UIKit
+static RFBSecurity *securityWithProfile(ServerProfile *profile) {
+	if (profile.tlsSecurity) {
+		RFBSecurityVeNCrypt *tls = [[RFBSecurityVeNCrypt alloc] initWithUsername:profile.username Password:profile.password];
+		tls.sessionCacheKey = [NSString stringWithFormat:@"%@:%i", profile.address, profile.port];
+		return tls;
+	}
+	if (profile.macAuthentication)
+		return [[RFBSecurityARD alloc] initWithUsername:profile.username Password:profile.password];
+	if (profile.password.length > 0)
+		return [[RFBSecurityVNC alloc] initWithPassword:profile.password];
+	return [[RFBSecurityNone alloc] init];
+}
+
+static RFBConnection *connectionWithProfile(ServerProfile *profile) {
+	RFBConnection *connection = [[RFBConnection alloc] initWithHostname:profile.address
+																   Port:profile.port
+															   Security:securityWithProfile(profile)];
+	connection.ard35Compatibility = profile.ard35Compatibility;
+	connection.handshakeCache = profile.handshakeCache;
+	return connection;
+}
+
+//One socket per client, the default soft limit (256 on OS X) runs out first
+static void raiseOpenFileLimit(NSUInteger clients) {
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur >= clients * 2 + 64)
+		return;
+	limit.rlim_cur = MIN(limit.rlim_max, (rlim_t)(clients * 2 + 64));
+	if (setrlimit(RLIMIT_NOFILE, &limit) != 0)
+		fprintf(stderr, "rfbdrive: couldn't raise the open file limit: %s\n", strerror(errno));
+}
+
+static int runLoad(RFBLoadGenerator *generator) {
+	raiseOpenFileLimit(generator.clients);
+	NSError *error = nil;
+	if (![generator run:&error]) {
+		printError(@"Load generator", error);
+		return ExitConnectFailed;
+	}
+	printf("%s", [[generator report] UTF8String]);
+	return ([generator clientsConnected] == generator.clients) ? ExitSuccess : ExitCommandFailed;
+}
+
+//Results are printed as they're known, exits once both benchmarks have finished
+static int runBench(int argc, char *argv[]) {
+	long iterations = BENCH_ITERATIONS, typingLength = BENCH_TYPING_LENGTH;
+	int option;
+	while ((option = getopt(argc, argv, "i:l:h")) != -1) {
+		switch (option) {
+			case 'i':
+				iterations = atol(optarg);
+				break;
+			case 'l':
+				typingLength = atol(optarg);
+				break;
+			default:
+				printUsage();
+				return ExitUsage;
+		}
+	}
+	if (iterations <= 0 || typingLength <= 0 || optind < argc) {
+		printUsage();
+		return ExitUsage;
+	}
+
+	[RFBProtocolBenchmark runWithIterations:(NSUInteger)iterations Completion:^(NSDictionary *results) {
+		for (NSString *name in [[results allKeys] sortedArrayUsingSelector:@selector(compare:)])
+			printf("%-44s %.3f\n", [name UTF8String], [[results objectForKey:name] doubleValue]);
+		[RFBLoopbackBenchmark compareTypingAndPasteForLength:(NSUInteger)typingLength Completion:^(double typedCharsPerSecond, double pastedCharsPerSecond) {
+			printf("%-44s %.0f\n", "typed chars/s", typedCharsPerSecond);
+			printf("%-44s %.0f\n", "pasted chars/s", pastedCharsPerSecond);
+			exit(([results count] > 0 && typedCharsPerSecond > 0 && pastedCharsPerSecond > 0) ? ExitSuccess : ExitCommandFailed);
+		}];
+	}];
+	dispatch_main(); //Completions come on the main queue
+}
+
+//Runs until interrupted (or the duration is up), then prints what the proxy carried
+static int runImpair(int argc, char *argv[]) {
+	NSString *host = nil;
+	int port = [RFBConnection DEFAULT_PORT];
+	double duration = 0;
+	int option;
+	while ((option = getopt(argc, argv, "H:p:d:h")) != -1) {
+		switch (option) {
+			case 'H':
+				host = [NSString stringWithUTF8String:optarg];
+				break;
+			case 'p':
+				port = atoi(optarg);
+				break;
+			case 'd':
+				duration = atof(optarg);
+				break;
+			default:
+				printUsage();
+				return ExitUsage;
+		}
+	}
+	NSString *name = (optind == argc - 1) ? [NSString stringWithUTF8String:argv[optind]] : nil;
+	if (host.length == 0 || port <= 0 || port > UINT16_MAX || ![[RFBImpairmentProxy impairmentNames] containsObject:name]) {
+		printUsage();
+		return ExitUsage;
+	}
+
+	RFBImpairmentProxy *proxy = [[RFBImpairmentProxy alloc] initWithHost:host Port:(uint16_t)port];
+	proxy.impairment = [RFBImpairmentProxy impairmentNamed:name];
+	NSError *error = nil;
+	if (![proxy start:&error]) {
+		printError(@"Proxy didn't start", error);
+		return ExitConnectFailed;
+	}
+	RFBImpairment impairment = proxy.impairment;
+	printf("forwarding %s:%i to %s:%i as %s: %.0f ms delay, %.0f ms jitter, %lu bytes/s, %.1f%% stalls of %.0f ms\n",
+		   [[proxy host] UTF8String], [proxy port], [host UTF8String], port, [name UTF8String], impairment.delay * 1000,
+		   impairment.jitter * 1000, (unsigned long)impairment.bandwidth, impairment.stallProbability * 100, impairment.stallDuration * 1000);
+	fflush(stdout); //For scripts waiting on the port
+
+	void (^finish)(void) = ^{
+		[proxy stop];
+		printf("to server %llu bytes, to client %llu bytes, %lu stalls injected\n", [proxy bytesToServer], [proxy bytesToClient], (unsigned long)[proxy stallsInjected]);
+		exit(ExitSuccess);
+	};
+	signal(SIGINT, SIG_IGN); //Handled on the main queue instead
+	dispatch_source_t interrupt = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, SIGINT, 0, dispatch_get_main_queue());
+	dispatch_source_set_event_handler(interrupt, finish);
+	dispatch_resume(interrupt);
+	if (duration > 0)
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(duration * NSEC_PER_SEC)), dispatch_get_main_queue(), finish);
+	dispatch_main();
+}
+
+static BOOL reportCheck(const char *name, BOOL passed, NSError *error) {
+	printf("%-24s %s\n", name, passed ? "ok" : "FAILED");
+	if (!passed)
+		printError([NSString stringWithUTF8String:name], error);
+	return passed;
+}
+
+//Every check runs, even after one fails
+static int runCheck(int argc, char *argv[]) {
+	NSString *sourceRoot = [[[NSString stringWithUTF8String:__FILE__] stringByDeletingLastPathComponent] stringByDeletingLastPathComponent];
+	NSString *keySymDefPath = [sourceRoot stringByAppendingPathComponent:@KEYSYMDEF_PATH];
+	int option;
+	while ((option = getopt(argc, argv, "k:h")) != -1) {
+		switch (option) {
+			case 'k':
+				keySymDefPath = [NSString stringWithUTF8String:optarg];
+				break;
+			default:
+				printUsage();
+				return ExitUsage;
+		}
+	}
+	if (optind < argc) {
+		printUsage();
+		return ExitUsage;
+	}
+
+	BOOL passed = YES;
+	NSError *error = nil;
+	passed &= reportCheck("keysym mapping", [RFBSelfCheck checkKeyMappingWithKeySymDef:keySymDefPath Error:&error], error);
+	error = nil;
+	passed &= reportCheck("VeNCrypt resumption", [RFBSelfCheck checkVeNCryptResumption:&error], error);
+	error = nil;
+	passed &= reportCheck("cache mismatch, 1 worker", [RFBSelfCheck checkHandshakeCacheMismatchOnEventLoop:&error], error);
+	return passed ? ExitSuccess : ExitCommandFailed;
+}
+
+int main(int argc, char *argv[]) {
+	@autoreleasepool {
+		//Subcommands take their own options
+		if (argc > 1 && strcmp(argv[1], "bench") == 0)
+			return runBench(argc - 1, argv + 1);
+		if (argc > 1 && strcmp(argv[1], "impair") == 0)
+			return runImpair(argc - 1, argv + 1);
+		if (argc > 1 && strcmp(argv[1], "check") == 0)
+			return runCheck(argc - 1, argv + 1);
+
+		ServerProfile *profile = [[ServerProfile alloc] init];
+		profile.port = [RFBConnection DEFAULT_PORT];
+		NSString *address = nil, *username = nil, *password = nil;
+		int port = -1;
+		BOOL macAuthentication = NO, tlsSecurity = NO, ard35 = NO, keepGoing = NO;
+		double coalescingMilliseconds = 0, waitTimeout = 30;
+		NSUInteger clients = 0, connectConcurrency = 0, workers = 0;
+		double eventsPerSecond = 0, duration = 0;
+		RFBLoadMix mix = {70, 5, 10, 15};
+
+		const char *environmentPassword = getenv(PASSWORD_ENVIRONMENT_VARIABLE);
+		if (environmentPassword)
+			password = [NSString stringWithUTF8String:environmentPassword];
+
+		int option;
+		while ((option = getopt(argc, argv, "f:H:p:u:w:mT3c:t:kn:r:d:x:C:W:h")) != -1) {
+			switch (option) {
+				case 'f': {
+					NSError *error = nil;
+					NSURL *url = [NSURL fileURLWithPath:[NSString stringWithUTF8String:optarg]];
+					profile = [ProfileSaverFetcher readSavedProfileFromURL:url Error:&error];
+					if (!profile) {
+						printError(@"Couldn't read profile", error);
+						return ExitUsage;
+					}
+					break;
+				}
+				case 'H':
+					address = [NSString stringWithUTF8String:optarg];
+					break;
+				case 'p':
+					port = atoi(optarg);
+					break;
+				case 'u':
+					username = [NSString stringWithUTF8String:optarg];
+					break;
+				case 'w':
+					password = [NSString stringWithUTF8String:optarg];
+					break;
+				case 'm':
+					macAuthentication = YES;
+					break;
+				case 'T':
+					tlsSecurity = YES;
+					break;
+				case '3':
+					ard35 = YES;
+					break;
+				case 'c':
+					coalescingMilliseconds = atof(optarg);
+					break;
+				case 't':
+					waitTimeout = atof(optarg);
+					break;
+				case 'k':
+					keepGoing = YES;
+					break;
+				case 'n':
+					clients = (NSUInteger)MAX(atol(optarg), 0);
+					break;
+				case 'r':
+					eventsPerSecond = atof(optarg);
+					break;
+				case 'd':
+					duration = atof(optarg);
+					break;
+				case 'x':
+					if (![RFBLoadGenerator parseMix:[NSString stringWithUTF8String:optarg] Mix:&mix]) {
+						fprintf(stderr, "rfbdrive: bad mix %s\n", optarg);
+						return ExitUsage;
+					}
+					break;
+				case 'C':
+					connectConcurrency = (NSUInteger)MAX(atol(optarg), 0);
+					break;
+				case 'W':
+					workers = (NSUInteger)MAX(atol(optarg), 0);
+					break;
+				default:
+					printUsage();
+					return ExitUsage;
+			}
+		}
+
+		//Command line overrides the profile file
+		if (address)
+			profile.address = address;
+		if (port > 0)
+			profile.port = port;
+		if (username)
+			profile.username = username;
+		if (password)
+			profile.password = password;
+		if (macAuthentication)
+			profile.macAuthentication = YES;
+		if (tlsSecurity)
+			profile.tlsSecurity = YES;
+		if (ard35)
+			profile.ard35Compatibility = YES;
+		if (profile.address.length == 0 || argc - optind > (clients > 0 ? 0 : 1)) {
+			printUsage();
+			return ExitUsage;
+		}
+
+		if (clients > 0) {
+			RFBLoadGenerator *generator = [[RFBLoadGenerator alloc] initWithHostname:profile.address
+																				Port:profile.port
+																	 SecurityFactory:^RFBSecurity *{
+																		 return securityWithProfile(profile);
+																	 }];
+			generator.clients = clients;
+			generator.mix = mix;
+			generator.writeCoalescingWindow = coalescingMilliseconds / 1000;
+			generator.drainTimeout = waitTimeout;
+			generator.workers = workers;
+			generator.handshakeCache = profile.handshakeCache;
+			if (eventsPerSecond > 0)
+				generator.eventsPerSecond = eventsPerSecond;
+			if (duration > 0)
+				generator.duration = duration;
+			if (connectConcurrency > 0)
+				generator.connectConcurrency = connectConcurrency;
+			return runLoad(generator);
+		}
+
+		FILE *script = stdin;
+		if (optind < argc && strcmp(argv[optind], "-") != 0) {
+			script = fopen(argv[optind], "r");
+			if (!script) {
+				fprintf(stderr, "rfbdrive: can't open %s: %s\n", argv[optind], strerror(errno));
+				return ExitUsage;
+			}
+		}
+
+		RFBConnection *connection = connectionWithProfile(profile);
+		connection.writeCoalescingWindow = coalescingMilliseconds / 1000;
+		NSError *error = nil;
+		if (![connection connect:&error]) {
+			printError([NSString stringWithFormat:@"Couldn't connect to %@:%i", profile.address, profile.port], error);
+			return ExitConnectFailed;
+		}
+		fprintf(stderr, "rfbdrive: connected to \"%s\" %.0fx%.0f%s\n", [[connection serverName] UTF8String],
+				[connection serverDisplaySize].width, [connection serverDisplaySize].height,
+				[connection usedHandshakeCache] ? ", sent ahead from the profile's handshake cache" : "");
+
+		RFBCommandRunner *runner = [[RFBCommandRunner alloc] initWithConnection:connection];
+		runner.waitTimeout = waitTimeout;
+		RFBDriveExitCode exitCode = ExitSuccess;
+		uint64_t start = mach_absolute_time();
+
+		char *line = NULL;
+		size_t capacity = 0;
+		unsigned long lineNumber = 0;
+		while (getline(&line, &capacity, script) != -1) {
+			lineNumber++;
+			@autoreleasepool {
+				NSString *command = [[NSString alloc] initWithUTF8String:line];
+				if (!command) {
+					fprintf(stderr, "rfbdrive: line %lu: not UTF-8\n", lineNumber);
+					exitCode = ExitCommandFailed;
+				} else if (![runner runLine:command Error:&error]) {
+					printError([NSString stringWithFormat:@"line %lu", lineNumber], error);
+					exitCode = ExitCommandFailed;
+				}
+			}
+			if (exitCode != ExitSuccess && (!keepGoing || ![connection isConnected]))
+				break;
+		}
+		free(line);
+		if (script != stdin)
+			fclose(script);
+
+		if (![runner waitUntilSent]) {
+			fprintf(stderr, "rfbdrive: still sending after %.0f seconds\n", waitTimeout);
+			exitCode = ExitCommandFailed;
+		}
+		[runner stopRecording];
+		double seconds = secondsFromMachTime(mach_absolute_time() - start);
+
+		printf("handshake        %.2f ms wall, %.2f ms cpu\n", [connection handshakeDuration] * 1000, [connection handshakeCPUTime] * 1000);
+		printf("commands         %llu\n", [runner commandsRun]);
+		printf("events           %llu in %.3f s, %.0f/s\n", [runner eventsSent], seconds, (seconds > 0 ? [runner eventsSent] / seconds : 0));
+		printf("coalescing       %llu writes saved, %.2f ms average delay\n", [connection writesSavedByCoalescing], [connection averageCoalescingDelay] * 1000);
+		printf("server messages  %llu, %llu bytes\n", [connection messagesDrained], [connection bytesDrained]);
+		printf("send time per command\n%s", [[runner summary] UTF8String]);
+		printf("input latency\n%s\n", [[[connection inputLatency] dump] UTF8String]);
+		[connection disconnect]; //Stats go with the socket
+		return exitCode;
+	}
+}